@@ -0,0 +1,24 @@
+-- Уведомления об изменении справочных таблиц через LISTEN/NOTIFY.
+-- Backend слушает каналы <таблица>_changed (postgres::NotifyListener)
+-- и сбрасывает кэш справочных данных.
+
+CREATE OR REPLACE FUNCTION notify_table_changed() RETURNS trigger AS $$
+BEGIN
+    PERFORM pg_notify(TG_TABLE_NAME || '_changed', TG_OP);
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DO $$
+DECLARE
+    tbl TEXT;
+BEGIN
+    FOREACH tbl IN ARRAY ARRAY['hub', 'server', 'nas_ip', 'trunk', 'pricelist', 'tarif'] LOOP
+        EXECUTE format('DROP TRIGGER IF EXISTS %I ON %I', tbl || '_changed_notify', tbl);
+        EXECUTE format(
+            'CREATE TRIGGER %I AFTER INSERT OR UPDATE OR DELETE OR TRUNCATE ON %I
+                 FOR EACH STATEMENT EXECUTE FUNCTION notify_table_changed()',
+            tbl || '_changed_notify', tbl);
+    END LOOP;
+END;
+$$;
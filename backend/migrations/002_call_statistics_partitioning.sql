@@ -0,0 +1,111 @@
+-- Перевод call_statistics на помесячные секции по call_time (PARTITION BY RANGE).
+-- Запросы с границами по времени затрагивают только нужные секции,
+-- а старые месяцы удаляются или архивируются целиком, без DELETE.
+--
+-- Секции называются call_statistics_YYYY_MM, границы месяцев считаются в UTC.
+-- Backend (postgres::PartitionMaintenance) периодически вызывает
+-- ensure_call_statistics_partitions и drop_call_statistics_partitions.
+--
+-- Триггеры, созданные на старой таблице вне этих миграций (например, для
+-- синхронизации), нужно пересоздать на новой таблице после применения.
+
+BEGIN;
+
+CREATE OR REPLACE FUNCTION create_call_statistics_partition(month DATE) RETURNS TEXT AS $$
+DECLARE
+    from_date DATE := date_trunc('month', month)::DATE;
+    to_date DATE := (date_trunc('month', month) + INTERVAL '1 month')::DATE;
+    partition_name TEXT := 'call_statistics_' || to_char(from_date, 'YYYY_MM');
+BEGIN
+    EXECUTE format(
+        'CREATE TABLE IF NOT EXISTS %I PARTITION OF call_statistics FOR VALUES FROM (%L) TO (%L)',
+        partition_name,
+        from_date::TIMESTAMP AT TIME ZONE 'UTC',
+        to_date::TIMESTAMP AT TIME ZONE 'UTC');
+    RETURN partition_name;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Создаёт недостающие секции для текущего месяца и months_ahead следующих.
+-- Возвращает количество проверенных месяцев
+CREATE OR REPLACE FUNCTION ensure_call_statistics_partitions(months_ahead INT) RETURNS INT AS $$
+DECLARE
+    current_month DATE := date_trunc('month', now() AT TIME ZONE 'UTC')::DATE;
+    i INT;
+BEGIN
+    FOR i IN 0..months_ahead LOOP
+        PERFORM create_call_statistics_partition((current_month + make_interval(months => i))::DATE);
+    END LOOP;
+    RETURN months_ahead + 1;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Убирает секции старше retention_months полных месяцев.
+-- archive = true: секция отсоединяется и переименовывается в
+-- call_statistics_archive_YYYY_MM (её можно выгрузить и удалить вручную),
+-- иначе удаляется. Возвращает имена обработанных секций
+CREATE OR REPLACE FUNCTION drop_call_statistics_partitions(retention_months INT, archive BOOLEAN)
+RETURNS SETOF TEXT AS $$
+DECLARE
+    cutoff TEXT := to_char(date_trunc('month', now() AT TIME ZONE 'UTC')
+                           - make_interval(months => retention_months), 'YYYY_MM');
+    partition_name TEXT;
+BEGIN
+    FOR partition_name IN
+        SELECT c.relname
+        FROM pg_inherits i
+        JOIN pg_class c ON c.oid = i.inhrelid
+        WHERE i.inhparent = 'call_statistics'::REGCLASS
+          AND c.relname ~ '^call_statistics_[0-9]{4}_[0-9]{2}$'
+          AND substring(c.relname FROM 17) < cutoff
+        ORDER BY c.relname
+    LOOP
+        IF archive THEN
+            EXECUTE format('ALTER TABLE call_statistics DETACH PARTITION %I', partition_name);
+            EXECUTE format('ALTER TABLE %I RENAME TO %I', partition_name,
+                           'call_statistics_archive_' || substring(partition_name FROM 17));
+        ELSE
+            EXECUTE format('DROP TABLE %I', partition_name);
+        END IF;
+        RETURN NEXT partition_name;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+ALTER TABLE call_statistics RENAME TO call_statistics_unpartitioned;
+
+-- Первичный ключ секционированной таблицы обязан включать ключ секционирования
+CREATE TABLE call_statistics (
+    id BIGINT GENERATED BY DEFAULT AS IDENTITY,
+    call_id VARCHAR(100) NOT NULL,
+    trunk_id INT NOT NULL REFERENCES trunk(id),
+    tarif_id INT NOT NULL REFERENCES tarif(id),
+    duration_seconds INT DEFAULT 0,
+    cost DECIMAL(10, 6) DEFAULT 0,
+    call_time TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT CURRENT_TIMESTAMP,
+    PRIMARY KEY (id, call_time)
+) PARTITION BY RANGE (call_time);
+
+CREATE INDEX call_statistics_trunk_time_idx ON call_statistics (trunk_id, call_time);
+CREATE INDEX call_statistics_tarif_time_idx ON call_statistics (tarif_id, call_time);
+
+-- Звонки вне созданных месяцев не теряются, а попадают в секцию по умолчанию
+CREATE TABLE call_statistics_default PARTITION OF call_statistics DEFAULT;
+
+SELECT create_call_statistics_partition(month)
+FROM (SELECT DISTINCT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE AS month
+      FROM call_statistics_unpartitioned
+      WHERE call_time IS NOT NULL) months;
+
+SELECT ensure_call_statistics_partitions(2);
+
+INSERT INTO call_statistics (id, call_id, trunk_id, tarif_id, duration_seconds, cost, call_time)
+SELECT id, call_id, trunk_id, tarif_id, duration_seconds, cost, COALESCE(call_time, CURRENT_TIMESTAMP)
+FROM call_statistics_unpartitioned;
+
+SELECT setval(pg_get_serial_sequence('call_statistics', 'id'),
+              COALESCE((SELECT MAX(id) FROM call_statistics), 0) + 1, false);
+
+DROP TABLE call_statistics_unpartitioned;
+
+COMMIT;
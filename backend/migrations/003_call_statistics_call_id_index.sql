@@ -0,0 +1,8 @@
+-- Индекс по call_id для идемпотентной загрузки звонков: при проигрывании
+-- локального журнала (app::CallSpool) уже сохранённые call_id пропускаются
+-- через INSERT ... WHERE NOT EXISTS.
+--
+-- Уникальное ограничение на секционированной таблице обязано включать
+-- call_time, поэтому дубликаты отсекаются запросом, а не ограничением.
+
+CREATE INDEX IF NOT EXISTS call_statistics_call_id_idx ON call_statistics (call_id);
@@ -0,0 +1,134 @@
+-- Помесячные итоги call_statistics: число звонков, длительность и выручка.
+-- /api/system/stats читает несколько строк этой таблицы вместо обхода всех звонков.
+--
+-- Итоги поддерживаются триггерами уровня оператора с таблицами переходов:
+-- пакет звонков (INSERT, COPY) меняет итоги одним оператором, а не построчно.
+-- Строка итогов соответствует месячной секции (месяц call_time в UTC), поэтому
+-- drop_call_statistics_partitions пересчитывает её после удаления секции.
+-- Счётчики BIGINT, выручка NUMERIC: переполнения int и ошибок округления нет.
+
+BEGIN;
+
+CREATE TABLE IF NOT EXISTS call_statistics_totals (
+    month DATE PRIMARY KEY,
+    calls BIGINT NOT NULL DEFAULT 0,
+    duration_seconds BIGINT NOT NULL DEFAULT 0,
+    revenue NUMERIC(20, 6) NOT NULL DEFAULT 0
+);
+
+-- Добавленные строки (new_calls) увеличивают итоги своего месяца, удалённые
+-- (old_calls) - уменьшают; UPDATE - и то и другое. Месяцы обновляются по
+-- возрастанию: одновременные операторы блокируют строки в одном порядке
+CREATE OR REPLACE FUNCTION call_statistics_totals_apply() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP = 'TRUNCATE' THEN
+        DELETE FROM call_statistics_totals;
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        INSERT INTO call_statistics_totals AS t (month, calls, duration_seconds, revenue)
+        SELECT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE,
+               COUNT(*), COALESCE(SUM(duration_seconds), 0), COALESCE(SUM(cost), 0)
+        FROM new_calls
+        GROUP BY 1
+        ORDER BY 1
+        ON CONFLICT (month) DO UPDATE
+        SET calls = t.calls + EXCLUDED.calls,
+            duration_seconds = t.duration_seconds + EXCLUDED.duration_seconds,
+            revenue = t.revenue + EXCLUDED.revenue;
+    END IF;
+
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        INSERT INTO call_statistics_totals AS t (month, calls, duration_seconds, revenue)
+        SELECT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE,
+               -COUNT(*), -COALESCE(SUM(duration_seconds), 0), -COALESCE(SUM(cost), 0)
+        FROM old_calls
+        GROUP BY 1
+        ORDER BY 1
+        ON CONFLICT (month) DO UPDATE
+        SET calls = t.calls + EXCLUDED.calls,
+            duration_seconds = t.duration_seconds + EXCLUDED.duration_seconds,
+            revenue = t.revenue + EXCLUDED.revenue;
+    END IF;
+
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Итоги одного месяца заново по звонкам (после удаления или отсоединения секции
+-- в call_statistics остаются только звонки этого месяца из секции по умолчанию)
+CREATE OR REPLACE FUNCTION refresh_call_statistics_totals(totals_month DATE) RETURNS VOID AS $$
+DECLARE
+    from_date DATE := date_trunc('month', totals_month)::DATE;
+    to_date DATE := (date_trunc('month', totals_month) + INTERVAL '1 month')::DATE;
+BEGIN
+    DELETE FROM call_statistics_totals WHERE month = from_date;
+    INSERT INTO call_statistics_totals (month, calls, duration_seconds, revenue)
+    SELECT from_date, COUNT(*), COALESCE(SUM(duration_seconds), 0), COALESCE(SUM(cost), 0)
+    FROM call_statistics
+    WHERE call_time >= from_date::TIMESTAMP AT TIME ZONE 'UTC'
+      AND call_time < to_date::TIMESTAMP AT TIME ZONE 'UTC'
+    HAVING COUNT(*) > 0;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Как в 002, но итоги месяца пересчитываются после удаления секции: DROP TABLE
+-- и DETACH PARTITION не вызывают триггеров на строках
+CREATE OR REPLACE FUNCTION drop_call_statistics_partitions(retention_months INT, archive BOOLEAN)
+RETURNS SETOF TEXT AS $$
+DECLARE
+    cutoff TEXT := to_char(date_trunc('month', now() AT TIME ZONE 'UTC')
+                           - make_interval(months => retention_months), 'YYYY_MM');
+    partition_name TEXT;
+BEGIN
+    FOR partition_name IN
+        SELECT c.relname
+        FROM pg_inherits i
+        JOIN pg_class c ON c.oid = i.inhrelid
+        WHERE i.inhparent = 'call_statistics'::REGCLASS
+          AND c.relname ~ '^call_statistics_[0-9]{4}_[0-9]{2}$'
+          AND substring(c.relname FROM 17) < cutoff
+        ORDER BY c.relname
+    LOOP
+        IF archive THEN
+            EXECUTE format('ALTER TABLE call_statistics DETACH PARTITION %I', partition_name);
+            EXECUTE format('ALTER TABLE %I RENAME TO %I', partition_name,
+                           'call_statistics_archive_' || substring(partition_name FROM 17));
+        ELSE
+            EXECUTE format('DROP TABLE %I', partition_name);
+        END IF;
+        PERFORM refresh_call_statistics_totals(to_date(substring(partition_name FROM 17), 'YYYY_MM'));
+        RETURN NEXT partition_name;
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Запись звонков ждёт заполнения итогов: ни один звонок не учитывается дважды и не теряется
+LOCK TABLE call_statistics IN SHARE ROW EXCLUSIVE MODE;
+
+DROP TRIGGER IF EXISTS call_statistics_totals_insert ON call_statistics;
+DROP TRIGGER IF EXISTS call_statistics_totals_update ON call_statistics;
+DROP TRIGGER IF EXISTS call_statistics_totals_delete ON call_statistics;
+DROP TRIGGER IF EXISTS call_statistics_totals_truncate ON call_statistics;
+
+CREATE TRIGGER call_statistics_totals_insert AFTER INSERT ON call_statistics
+    REFERENCING NEW TABLE AS new_calls
+    FOR EACH STATEMENT EXECUTE FUNCTION call_statistics_totals_apply();
+CREATE TRIGGER call_statistics_totals_update AFTER UPDATE ON call_statistics
+    REFERENCING OLD TABLE AS old_calls NEW TABLE AS new_calls
+    FOR EACH STATEMENT EXECUTE FUNCTION call_statistics_totals_apply();
+CREATE TRIGGER call_statistics_totals_delete AFTER DELETE ON call_statistics
+    REFERENCING OLD TABLE AS old_calls
+    FOR EACH STATEMENT EXECUTE FUNCTION call_statistics_totals_apply();
+CREATE TRIGGER call_statistics_totals_truncate AFTER TRUNCATE ON call_statistics
+    FOR EACH STATEMENT EXECUTE FUNCTION call_statistics_totals_apply();
+
+DELETE FROM call_statistics_totals;
+INSERT INTO call_statistics_totals (month, calls, duration_seconds, revenue)
+SELECT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE,
+       COUNT(*), COALESCE(SUM(duration_seconds), 0), COALESCE(SUM(cost), 0)
+FROM call_statistics
+GROUP BY 1;
+
+COMMIT;
@@ -0,0 +1,61 @@
+-- Создание месячной секции, когда звонки этого месяца уже лежат в секции по умолчанию.
+--
+-- Звонок с call_time за пределами созданных секций (например, в будущем дальше
+-- ensure_call_statistics_partitions) попадает в call_statistics_default. Из-за
+-- такой строки CREATE TABLE ... PARTITION OF для её месяца завершался ошибкой,
+-- и секция не создавалась до ручного вмешательства.
+--
+-- Теперь строки месяца переносятся в новую секцию: секция по умолчанию на время
+-- переноса отсоединяется, новая секция заполняется как обычная таблица и
+-- присоединяется вместе с секцией по умолчанию. Отсоединённые таблицы не
+-- вызывают триггеров call_statistics, поэтому перенос не выглядит для них
+-- удалением и вставкой звонков; итоги call_statistics_totals (по месяцу
+-- call_time) не меняются. Запись звонков на время переноса ждёт блокировки
+-- call_statistics. Без строк месяца в секции по умолчанию секция создаётся
+-- как раньше, без переноса.
+
+BEGIN;
+
+CREATE OR REPLACE FUNCTION create_call_statistics_partition(month DATE) RETURNS TEXT AS $$
+DECLARE
+    from_date DATE := date_trunc('month', month)::DATE;
+    to_date DATE := (date_trunc('month', month) + INTERVAL '1 month')::DATE;
+    from_time TIMESTAMPTZ := from_date::TIMESTAMP AT TIME ZONE 'UTC';
+    to_time TIMESTAMPTZ := to_date::TIMESTAMP AT TIME ZONE 'UTC';
+    partition_name TEXT := 'call_statistics_' || to_char(from_date, 'YYYY_MM');
+    bounds_name TEXT := partition_name || '_bounds';
+BEGIN
+    IF to_regclass(partition_name) IS NOT NULL THEN
+        RETURN partition_name;
+    END IF;
+
+    IF to_regclass('call_statistics_default') IS NULL
+       OR NOT EXISTS (SELECT 1 FROM call_statistics_default
+                      WHERE call_time >= from_time AND call_time < to_time) THEN
+        EXECUTE format('CREATE TABLE %I PARTITION OF call_statistics FOR VALUES FROM (%L) TO (%L)',
+                       partition_name, from_time, to_time);
+        RETURN partition_name;
+    END IF;
+
+    ALTER TABLE call_statistics DETACH PARTITION call_statistics_default;
+
+    EXECUTE format('CREATE TABLE %I (LIKE call_statistics INCLUDING DEFAULTS)', partition_name);
+    EXECUTE format('WITH moved AS (DELETE FROM call_statistics_default
+                                   WHERE call_time >= %L AND call_time < %L RETURNING *)
+                    INSERT INTO %I SELECT * FROM moved',
+                   from_time, to_time, partition_name);
+
+    -- Ограничение по границам избавляет ATTACH от повторной проверки всех строк
+    EXECUTE format('ALTER TABLE %I ADD CONSTRAINT %I CHECK (call_time >= %L AND call_time < %L)',
+                   partition_name, bounds_name, from_time, to_time);
+    EXECUTE format('ALTER TABLE call_statistics ATTACH PARTITION %I FOR VALUES FROM (%L) TO (%L)',
+                   partition_name, from_time, to_time);
+    EXECUTE format('ALTER TABLE %I DROP CONSTRAINT %I', partition_name, bounds_name);
+
+    ALTER TABLE call_statistics ATTACH PARTITION call_statistics_default DEFAULT;
+
+    RETURN partition_name;
+END;
+$$ LANGUAGE plpgsql;
+
+COMMIT;
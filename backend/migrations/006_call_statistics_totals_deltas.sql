@@ -0,0 +1,94 @@
+-- Итоги call_statistics без общей блокировки строки месяца.
+--
+-- В 004 триггер каждого оператора обновлял строку текущего месяца в
+-- call_statistics_totals (INSERT ... ON CONFLICT DO UPDATE): все одновременные
+-- писатели (очередь записи, API, пересчёт стоимости, другие экземпляры) ждали
+-- блокировку этой строки до конца своих транзакций.
+--
+-- Теперь триггер только дописывает строки изменений в call_statistics_totals_delta,
+-- не конфликтуя с другими писателями. compact_call_statistics_totals() сворачивает
+-- зафиксированные изменения в call_statistics_totals (backend вызывает её по
+-- расписанию, см. call_statistics.totals_compact_seconds); итоги - сумма обеих таблиц.
+
+BEGIN;
+
+CREATE TABLE IF NOT EXISTS call_statistics_totals_delta (
+    month DATE NOT NULL,
+    calls BIGINT NOT NULL,
+    duration_seconds BIGINT NOT NULL,
+    revenue NUMERIC(20, 6) NOT NULL
+);
+
+CREATE OR REPLACE FUNCTION call_statistics_totals_apply() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP = 'TRUNCATE' THEN
+        DELETE FROM call_statistics_totals_delta;
+        DELETE FROM call_statistics_totals;
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP IN ('INSERT', 'UPDATE') THEN
+        INSERT INTO call_statistics_totals_delta (month, calls, duration_seconds, revenue)
+        SELECT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE,
+               COUNT(*), COALESCE(SUM(duration_seconds), 0), COALESCE(SUM(cost), 0)
+        FROM new_calls
+        GROUP BY 1;
+    END IF;
+
+    IF TG_OP IN ('UPDATE', 'DELETE') THEN
+        INSERT INTO call_statistics_totals_delta (month, calls, duration_seconds, revenue)
+        SELECT date_trunc('month', call_time AT TIME ZONE 'UTC')::DATE,
+               -COUNT(*), -COALESCE(SUM(duration_seconds), 0), -COALESCE(SUM(cost), 0)
+        FROM old_calls
+        GROUP BY 1;
+    END IF;
+
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Перенести зафиксированные изменения в помесячные итоги. DELETE видит только
+-- зафиксированные строки, а одновременный вызов пропускает уже удалённые,
+-- поэтому изменение учитывается один раз. Месяцы обновляются по возрастанию
+CREATE OR REPLACE FUNCTION compact_call_statistics_totals() RETURNS BIGINT AS $$
+DECLARE
+    compacted BIGINT;
+BEGIN
+    WITH moved AS (
+        DELETE FROM call_statistics_totals_delta RETURNING *
+    ), summed AS (
+        INSERT INTO call_statistics_totals AS t (month, calls, duration_seconds, revenue)
+        SELECT month, SUM(calls), SUM(duration_seconds), SUM(revenue)
+        FROM moved
+        GROUP BY month
+        ORDER BY month
+        ON CONFLICT (month) DO UPDATE
+        SET calls = t.calls + EXCLUDED.calls,
+            duration_seconds = t.duration_seconds + EXCLUDED.duration_seconds,
+            revenue = t.revenue + EXCLUDED.revenue
+        RETURNING 1
+    )
+    SELECT COUNT(*) INTO compacted FROM moved;
+
+    RETURN compacted;
+END;
+$$ LANGUAGE plpgsql;
+
+-- Как в 004, но вместе с итогами месяца удаляются и его несвёрнутые изменения
+CREATE OR REPLACE FUNCTION refresh_call_statistics_totals(totals_month DATE) RETURNS VOID AS $$
+DECLARE
+    from_date DATE := date_trunc('month', totals_month)::DATE;
+    to_date DATE := (date_trunc('month', totals_month) + INTERVAL '1 month')::DATE;
+BEGIN
+    DELETE FROM call_statistics_totals_delta WHERE month = from_date;
+    DELETE FROM call_statistics_totals WHERE month = from_date;
+    INSERT INTO call_statistics_totals (month, calls, duration_seconds, revenue)
+    SELECT from_date, COUNT(*), COALESCE(SUM(duration_seconds), 0), COALESCE(SUM(cost), 0)
+    FROM call_statistics
+    WHERE call_time >= from_date::TIMESTAMP AT TIME ZONE 'UTC'
+      AND call_time < to_date::TIMESTAMP AT TIME ZONE 'UTC'
+    HAVING COUNT(*) > 0;
+END;
+$$ LANGUAGE plpgsql;
+
+COMMIT;
@@ -0,0 +1,66 @@
+#!/bin/bash
+# Проверка сброса кэша справочников через LISTEN/NOTIFY (миграция 001).
+#
+# Меняет название хаба напрямую в БД, минуя backend, и ждёт, пока
+# GET /api/get/hub вернёт новое название. Без уведомления backend отдавал бы
+# прежнее значение из кэша. Исходное название восстанавливается при выходе.
+#
+# Нужны запущенный backend, psql и python3:
+#   DB_URL=postgresql://... [API_URL=http://localhost:8080] [TIMEOUT_SECONDS=5] \
+#       backend/scripts/check_reference_notify.sh
+# Без DB_URL проверка пропускается (код 0).
+
+set -euo pipefail
+
+if [ -z "${DB_URL:-}" ]; then
+    echo "SKIP: DB_URL is not set"
+    exit 0
+fi
+
+API_URL="${API_URL:-http://localhost:8080}"
+TIMEOUT_SECONDS="${TIMEOUT_SECONDS:-5}"
+
+# Название хаба с данным id из ответа /api/get/hub (пустая строка - хаба нет)
+hub_name() {
+    curl -fsS "$API_URL/api/get/hub" | python3 -c '
+import json, sys
+hub_id = int(sys.argv[1])
+print(next((hub["name"] for hub in json.load(sys.stdin) if hub["id"] == hub_id), ""))
+' "$1"
+}
+
+HUB_ID=$(psql "$DB_URL" -Atc "SELECT id FROM hub ORDER BY id LIMIT 1")
+if [ -z "$HUB_ID" ]; then
+    echo "SKIP: table hub is empty"
+    exit 0
+fi
+
+ORIGINAL=$(psql "$DB_URL" -Atc "SELECT name FROM hub WHERE id = $HUB_ID")
+MARKED="$ORIGINAL [notify-check $$]"
+
+# Кэш заполнен прежним значением до изменения
+if [ "$(hub_name "$HUB_ID")" != "$ORIGINAL" ]; then
+    echo "FAIL: /api/get/hub does not return hub $HUB_ID as stored in the database"
+    exit 1
+fi
+
+# Название передаётся переменной psql: в -c подстановка :'name' не выполняется
+set_hub_name() {
+    echo "UPDATE hub SET name = :'name' WHERE id = $HUB_ID;" \
+        | psql "$DB_URL" -q -v ON_ERROR_STOP=1 -v name="$1" >/dev/null
+}
+
+trap 'set_hub_name "$ORIGINAL"' EXIT
+set_hub_name "$MARKED"
+
+DEADLINE=$((SECONDS + TIMEOUT_SECONDS))
+while [ "$SECONDS" -le "$DEADLINE" ]; do
+    if [ "$(hub_name "$HUB_ID")" = "$MARKED" ]; then
+        echo "OK: reference cache invalidated after UPDATE hub"
+        exit 0
+    fi
+    sleep 0.2
+done
+
+echo "FAIL: /api/get/hub still returns the cached name of hub $HUB_ID after ${TIMEOUT_SECONDS}s"
+exit 1
@@ -1,44 +1,135 @@
 #include "analytics.h"
+#include "compute_pool.h"
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <numeric>
 #include <map>
+#include <stdexcept>
+#include <unordered_map>
 
 namespace analytics {
 
-std::vector<TrunkAnalytics> AnalyticsCalculator::CalculateByTrunk(
-    const std::vector<ui::detail::CallStatisticsInfo>& calls,
-    const std::vector<ui::detail::TrunkInfo>& trunks
-) {
-    std::map<int, TrunkAnalytics> trunk_map;
-
-    // Инициализируем данные для каждого транка
-    for (const auto& trunk : trunks) {
-        trunk_map[trunk.id] = TrunkAnalytics{
-            trunk.id,
-            trunk.name,
-            0, 0.0, 0, 0.0, 0.0
-        };
+namespace {
+
+// Части целиком вне окна не обходятся; для частей целиком внутри окна
+// время строк не проверяется (call_times == nullptr)
+bool ChunkColumns(const CallChunk& chunk, const std::vector<int32_t>& keys, const TimeWindow& window,
+                  GroupByColumns& columns) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return false;
     }
 
-    // Агрегируем данные по звонкам
-    for (const auto& call : calls) {
-        if (trunk_map.find(call.trunk_id) != trunk_map.end()) {
-            auto& analytics = trunk_map[call.trunk_id];
-            analytics.total_calls++;
-            analytics.total_revenue += call.cost;
-            analytics.total_duration_seconds += call.duration_seconds;
-        }
+    bool inside = window.Contains(chunk.min_call_time) && window.Contains(chunk.max_call_time);
+    columns.keys = keys.data();
+    columns.durations = chunk.durations.data();
+    columns.costs = chunk.costs.data();
+    columns.call_times = inside ? nullptr : chunk.call_times.data();
+    columns.size = chunk.Size();
+    return true;
+}
+
+// Группы по возрастанию id (повторный id заменяет прежний, как и раньше в std::map)
+template <typename Analytics, typename Info, typename Make>
+std::vector<Analytics> MakeGroups(const std::vector<Info>& infos, Make make) {
+    std::map<int, Analytics> by_id;
+    for (const auto& info : infos) {
+        by_id[info.id] = make(info);
+    }
+
+    std::vector<Analytics> groups;
+    groups.reserve(by_id.size());
+    for (auto& [id, analytics] : by_id) {
+        groups.push_back(std::move(analytics));
+    }
+    return groups;
+}
+
+template <typename Analytics, typename IdOf>
+DenseIndex IndexGroups(const std::vector<Analytics>& groups, IdOf id_of) {
+    std::vector<std::pair<int32_t, int32_t>> id_to_slot;
+    id_to_slot.reserve(groups.size());
+    for (size_t slot = 0; slot < groups.size(); ++slot) {
+        id_to_slot.emplace_back(id_of(groups[slot]), static_cast<int32_t>(slot));
+    }
+    return DenseIndex(id_to_slot);
+}
+
+inline void AddTotals(GroupTotals& totals, int duration_seconds, domain::Money cost) {
+    ++totals.calls;
+    totals.duration_seconds += duration_seconds;
+    totals.cost += cost.Micros();
+}
+
+inline void AddTotals(GroupTotals& totals, const GroupTotals& other) {
+    totals.calls += other.calls;
+    totals.duration_seconds += other.duration_seconds;
+    totals.cost += other.cost;
+}
+
+void MergeTotals(std::vector<GroupTotals>& totals, const std::vector<GroupTotals>& other) {
+    for (size_t slot = 0; slot < totals.size() && slot < other.size(); ++slot) {
+        AddTotals(totals[slot], other[slot]);
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// TrunkAggregator
+// ============================================================================
+
+TrunkAggregator::TrunkAggregator(const std::vector<ui::detail::TrunkInfo>& trunks)
+    : groups_(MakeGroups<TrunkAnalytics>(trunks, [](const ui::detail::TrunkInfo& trunk) {
+          return TrunkAnalytics{trunk.id, trunk.name, 0, {}, 0, 0.0, {}};
+      }))
+    , index_(IndexGroups(groups_, [](const TrunkAnalytics& analytics) {
+          return analytics.trunk_id;
+      }))
+    , totals_(groups_.size()) {}
+
+void TrunkAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    Add(call.trunk_id, call.duration_seconds, call.cost);
+}
+
+void TrunkAggregator::Add(int trunk_id, int duration_seconds, domain::Money cost) {
+    int32_t slot = index_.Slot(trunk_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], duration_seconds, cost);
+    }
+}
+
+void TrunkAggregator::Add(int trunk_id, const GroupTotals& totals) {
+    int32_t slot = index_.Slot(trunk_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], totals);
+    }
+}
+
+void TrunkAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    GroupByColumns columns;
+    if (ChunkColumns(chunk, chunk.trunk_ids, window, columns)) {
+        AccumulateGroups(columns, window.from, window.to, index_, totals_);
     }
+}
 
-    // Рассчитываем средние значения
-    std::vector<TrunkAnalytics> result;
-    for (auto& [id, analytics] : trunk_map) {
-        if (analytics.total_calls > 0) {
-            analytics.avg_duration_seconds = 
-                static_cast<double>(analytics.total_duration_seconds) / analytics.total_calls;
-            analytics.avg_cost = analytics.total_revenue / analytics.total_calls;
+void TrunkAggregator::Merge(const TrunkAggregator& other) {
+    MergeTotals(totals_, other.totals_);
+}
+
+std::vector<TrunkAnalytics> TrunkAggregator::Finish() {
+    // Переносим суммы и рассчитываем средние значения
+    std::vector<TrunkAnalytics> result = std::move(groups_);
+    for (size_t slot = 0; slot < result.size(); ++slot) {
+        auto& analytics = result[slot];
+        const auto& totals = totals_[slot];
+        analytics.total_calls = totals.calls;
+        analytics.total_revenue = domain::Money::FromMicros(totals.cost);
+        analytics.total_duration_seconds = totals.duration_seconds;
+        if (totals.calls > 0) {
+            analytics.avg_duration_seconds = static_cast<double>(totals.duration_seconds) / totals.calls;
+            analytics.avg_cost = analytics.total_revenue.MulDiv(1, totals.calls);
         }
-        result.push_back(analytics);
     }
 
     // Сортируем по выручке (убывание)
@@ -50,38 +141,60 @@ std::vector<TrunkAnalytics> AnalyticsCalculator::CalculateByTrunk(
     return result;
 }
 
-std::vector<TarifAnalytics> AnalyticsCalculator::CalculateByTarif(
-    const std::vector<ui::detail::CallStatisticsInfo>& calls,
-    const std::vector<ui::detail::TarifInfo>& tarifs
-) {
-    std::map<int, TarifAnalytics> tarif_map;
-
-    // Инициализируем данные для каждого тарифа
-    for (const auto& tarif : tarifs) {
-        tarif_map[tarif.id] = TarifAnalytics{
-            tarif.id,
-            tarif.name,
-            0, 0.0, 0, 0.0
-        };
+// ============================================================================
+// TarifAggregator
+// ============================================================================
+
+TarifAggregator::TarifAggregator(const std::vector<ui::detail::TarifInfo>& tarifs)
+    : groups_(MakeGroups<TarifAnalytics>(tarifs, [](const ui::detail::TarifInfo& tarif) {
+          return TarifAnalytics{tarif.id, tarif.name, 0, {}, 0, {}};
+      }))
+    , index_(IndexGroups(groups_, [](const TarifAnalytics& analytics) {
+          return analytics.tarif_id;
+      }))
+    , totals_(groups_.size()) {}
+
+void TarifAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    Add(call.tarif_id, call.duration_seconds, call.cost);
+}
+
+void TarifAggregator::Add(int tarif_id, int duration_seconds, domain::Money cost) {
+    int32_t slot = index_.Slot(tarif_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], duration_seconds, cost);
     }
+}
 
-    // Агрегируем данные по звонкам
-    for (const auto& call : calls) {
-        if (tarif_map.find(call.tarif_id) != tarif_map.end()) {
-            auto& analytics = tarif_map[call.tarif_id];
-            analytics.total_calls++;
-            analytics.total_revenue += call.cost;
-            analytics.total_duration_seconds += call.duration_seconds;
-        }
+void TarifAggregator::Add(int tarif_id, const GroupTotals& totals) {
+    int32_t slot = index_.Slot(tarif_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], totals);
+    }
+}
+
+void TarifAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    GroupByColumns columns;
+    if (ChunkColumns(chunk, chunk.tarif_ids, window, columns)) {
+        AccumulateGroups(columns, window.from, window.to, index_, totals_);
     }
+}
 
-    // Рассчитываем средние значения
-    std::vector<TarifAnalytics> result;
-    for (auto& [id, analytics] : tarif_map) {
-        if (analytics.total_calls > 0) {
-            analytics.avg_cost = analytics.total_revenue / analytics.total_calls;
+void TarifAggregator::Merge(const TarifAggregator& other) {
+    MergeTotals(totals_, other.totals_);
+}
+
+std::vector<TarifAnalytics> TarifAggregator::Finish() {
+    // Переносим суммы и рассчитываем средние значения
+    std::vector<TarifAnalytics> result = std::move(groups_);
+    for (size_t slot = 0; slot < result.size(); ++slot) {
+        auto& analytics = result[slot];
+        const auto& totals = totals_[slot];
+        analytics.total_calls = totals.calls;
+        analytics.total_revenue = domain::Money::FromMicros(totals.cost);
+        analytics.total_duration_seconds = totals.duration_seconds;
+        if (totals.calls > 0) {
+            analytics.avg_cost = analytics.total_revenue.MulDiv(1, totals.calls);
         }
-        result.push_back(analytics);
     }
 
     // Сортируем по выручке (убывание)
@@ -93,65 +206,85 @@ std::vector<TarifAnalytics> AnalyticsCalculator::CalculateByTarif(
     return result;
 }
 
-std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
-    const std::vector<ui::detail::CallStatisticsInfo>& calls,
-    const std::vector<ui::detail::HubInfo>& hubs,
-    const std::vector<ui::detail::ServerInfo>& servers,
-    const std::vector<ui::detail::TrunkInfo>& trunks
-) {
-    std::map<int, HubAnalytics> hub_map;
-
-    // Инициализируем данные для каждого хаба
-    for (const auto& hub : hubs) {
-        hub_map[hub.id] = HubAnalytics{
-            hub.id,
-            hub.name,
-            0, 0.0, 0, 0
-        };
+// ============================================================================
+// HubAggregator
+// ============================================================================
+
+HubAggregator::HubAggregator(const std::vector<ui::detail::HubInfo>& hubs,
+                             const std::vector<ui::detail::ServerInfo>& servers,
+                             const std::vector<ui::detail::TrunkInfo>& trunks)
+    : HubAggregator(topology::NetworkTopology(hubs, servers, trunks)) {
+}
+
+HubAggregator::HubAggregator(const topology::NetworkTopology& topology)
+    : groups_(MakeGroups<HubAnalytics>(topology.Hubs(), [](const ui::detail::HubInfo& hub) {
+          return HubAnalytics{hub.id, hub.name, 0, {}, 0, 0};
+      })) {
+    std::unordered_map<int, int32_t> hub_slots;
+    hub_slots.reserve(groups_.size());
+    for (size_t slot = 0; slot < groups_.size(); ++slot) {
+        auto& analytics = groups_[slot];
+        hub_slots[analytics.hub_id] = static_cast<int32_t>(slot);
+        analytics.server_count = static_cast<int>(topology.ServersOfHub(analytics.hub_id).size());
+        analytics.trunk_count = topology.TrunkCountOfHub(analytics.hub_id);
     }
 
-    // Подсчитываем серверы и транки для каждого хаба
-    for (const auto& server : servers) {
-        if (hub_map.find(server.hub_id) != hub_map.end()) {
-            hub_map[server.hub_id].server_count++;
-            
-            // Подсчитываем транки для этого сервера
-            for (const auto& trunk : trunks) {
-                if (trunk.server_id == server.id) {
-                    hub_map[server.hub_id].trunk_count++;
-                }
-            }
+    // Маппинг trunk_id -> номер группы хаба (через первый сервер транка)
+    std::map<int, int32_t> trunk_to_slot;
+    for (const auto& trunk : topology.Trunks()) {
+        const auto* server = topology.FindServer(trunk.server_id);
+        if (!server) {
+            continue;
+        }
+        auto it = hub_slots.find(server->hub_id);
+        if (it != hub_slots.end()) {
+            trunk_to_slot[trunk.id] = it->second;
+        }
+        else {
+            trunk_to_slot.erase(trunk.id);
         }
     }
 
-    // Создаем маппинг trunk_id -> hub_id
-    std::map<int, int> trunk_to_hub;
-    for (const auto& trunk : trunks) {
-        for (const auto& server : servers) {
-            if (trunk.server_id == server.id) {
-                trunk_to_hub[trunk.id] = server.hub_id;
-                break;
-            }
-        }
+    index_ = DenseIndex(std::vector<std::pair<int32_t, int32_t>>(trunk_to_slot.begin(), trunk_to_slot.end()));
+    totals_.resize(groups_.size());
+}
+
+void HubAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    Add(call.trunk_id, call.cost);
+}
+
+void HubAggregator::Add(int trunk_id, domain::Money cost) {
+    int32_t slot = index_.Slot(trunk_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], 0, cost);
     }
+}
 
-    // Агрегируем данные по звонкам
-    for (const auto& call : calls) {
-        auto it = trunk_to_hub.find(call.trunk_id);
-        if (it != trunk_to_hub.end()) {
-            int hub_id = it->second;
-            if (hub_map.find(hub_id) != hub_map.end()) {
-                auto& analytics = hub_map[hub_id];
-                analytics.total_calls++;
-                analytics.total_revenue += call.cost;
-            }
-        }
+void HubAggregator::Add(int trunk_id, const GroupTotals& totals) {
+    int32_t slot = index_.Slot(trunk_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        AddTotals(totals_[slot], totals);
+    }
+}
+
+void HubAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    GroupByColumns columns;
+    if (ChunkColumns(chunk, chunk.trunk_ids, window, columns)) {
+        columns.durations = nullptr;
+        AccumulateGroups(columns, window.from, window.to, index_, totals_);
     }
+}
 
+void HubAggregator::Merge(const HubAggregator& other) {
+    MergeTotals(totals_, other.totals_);
+}
+
+std::vector<HubAnalytics> HubAggregator::Finish() {
     // Собираем результат
-    std::vector<HubAnalytics> result;
-    for (const auto& [id, analytics] : hub_map) {
-        result.push_back(analytics);
+    std::vector<HubAnalytics> result = std::move(groups_);
+    for (size_t slot = 0; slot < result.size(); ++slot) {
+        result[slot].total_calls = totals_[slot].calls;
+        result[slot].total_revenue = domain::Money::FromMicros(totals_[slot].cost);
     }
 
     // Сортируем по выручке (убывание)
@@ -163,72 +296,729 @@ std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
     return result;
 }
 
-std::vector<RevenueAnalytics> AnalyticsCalculator::CalculateRevenueByHour(
-    const std::vector<ui::detail::CallStatisticsInfo>& calls
-) {
-    std::map<std::string, RevenueAnalytics> hour_map;
-
-    for (const auto& call : calls) {
-        // Извлекаем час из call_time (формат: "YYYY-MM-DD HH:MM:SS")
-        if (call.call_time.length() >= 13) {
-            std::string hour = call.call_time.substr(11, 2);
-            
-            if (hour_map.find(hour) == hour_map.end()) {
-                hour_map[hour] = RevenueAnalytics{hour + ":00", 0.0, 0};
-            }
-            
-            hour_map[hour].revenue += call.cost;
-            hour_map[hour].call_count++;
+// ============================================================================
+// RevenueAggregator
+// ============================================================================
+
+RevenueAggregator::RevenueAggregator(RevenuePeriod period)
+    : period_(period) {}
+
+void RevenueAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    Add(call.call_time, call.cost);
+}
+
+void RevenueAggregator::Add(int64_t call_time, domain::Money cost) {
+    Add(call_time, GroupTotals{1, 0, cost.Micros()});
+}
+
+void RevenueAggregator::Add(int64_t call_time, const GroupTotals& totals) {
+    // Ключ - номер часа суток или номер дня от эпохи (UTC), подпись строится в Finish()
+    int64_t key = period_ == RevenuePeriod::HOUR
+                  ? domain::FloorDiv(call_time, domain::MICROS_PER_HOUR) % 24
+                  : domain::FloorDiv(call_time, domain::MICROS_PER_DAY);
+
+    auto& analytics = period_map_[key];
+    analytics.revenue += domain::Money::FromMicros(totals.cost);
+    analytics.call_count += totals.calls;
+}
+
+void RevenueAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return;
+    }
+
+    bool inside = window.Contains(chunk.min_call_time) && window.Contains(chunk.max_call_time);
+    size_t size = chunk.Size();
+    for (size_t row = 0; row < size; ++row) {
+        if (inside || window.Contains(chunk.call_times[row])) {
+            Add(chunk.call_times[row], domain::Money::FromMicros(chunk.costs[row]));
         }
     }
+}
+
+void RevenueAggregator::Merge(const RevenueAggregator& other) {
+    for (const auto& [key, analytics] : other.period_map_) {
+        auto& total = period_map_[key];
+        total.revenue += analytics.revenue;
+        total.call_count += analytics.call_count;
+    }
+}
 
+std::vector<RevenueAnalytics> RevenueAggregator::Finish() {
+    // map упорядочен по ключу, поэтому периоды уже идут по возрастанию
     std::vector<RevenueAnalytics> result;
-    for (const auto& [hour, analytics] : hour_map) {
+    result.reserve(period_map_.size());
+    for (auto& [key, analytics] : period_map_) {
+        char label[10];
+        if (period_ == RevenuePeriod::HOUR) {
+            label[0] = static_cast<char>('0' + key / 10);
+            label[1] = static_cast<char>('0' + key % 10);
+            analytics.period.assign(label, 2).append(":00");
+        } else {
+            analytics.period.assign(label, domain::FormatDate(key, label));
+        }
         result.push_back(analytics);
     }
 
-    // Сортируем по часу
+    return result;
+}
+
+// ============================================================================
+// DistributionAggregator
+// ============================================================================
+
+namespace {
+
+const std::vector<double> SUMMARY_QUANTILES = {0.5, 0.95, 0.99};
+
+QuantileSummary Summarize(const QuantileSketch& sketch) {
+    auto quantiles = sketch.Quantiles(SUMMARY_QUANTILES);
+    return QuantileSummary{sketch.Min(), quantiles[0], quantiles[1], quantiles[2], sketch.Max()};
+}
+
+} // namespace
+
+DistributionAggregator::DistributionAggregator(const std::vector<ui::detail::TrunkInfo>& trunks)
+    : by_trunk_(true)
+    , groups_(MakeGroups<DistributionAnalytics>(trunks, [](const ui::detail::TrunkInfo& trunk) {
+          return DistributionAnalytics{trunk.id, trunk.name, 0, 0, {}, {}};
+      }))
+    , index_(IndexGroups(groups_, [](const DistributionAnalytics& analytics) {
+          return analytics.id;
+      }))
+    , sketches_(groups_.size()) {}
+
+DistributionAggregator::DistributionAggregator(const std::vector<ui::detail::TarifInfo>& tarifs)
+    : by_trunk_(false)
+    , groups_(MakeGroups<DistributionAnalytics>(tarifs, [](const ui::detail::TarifInfo& tarif) {
+          return DistributionAnalytics{tarif.id, tarif.name, 0, 0, {}, {}};
+      }))
+    , index_(IndexGroups(groups_, [](const DistributionAnalytics& analytics) {
+          return analytics.id;
+      }))
+    , sketches_(groups_.size()) {}
+
+void DistributionAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    int32_t slot = index_.Slot(by_trunk_ ? call.trunk_id : call.tarif_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        Add(slot, HashCallId(call.call_id), call.duration_seconds, call.cost.Micros());
+    }
+}
+
+void DistributionAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return;
+    }
+
+    // call_id хранятся словарём: каждая строка хешируется один раз на часть
+    std::vector<uint64_t> hashes(chunk.call_id_offsets.empty() ? 0 : chunk.call_id_offsets.size() - 1);
+    std::string_view chars = chunk.call_id_chars;
+    for (size_t code = 0; code < hashes.size(); ++code) {
+        hashes[code] = HashCallId(chars.substr(chunk.call_id_offsets[code],
+                                               chunk.call_id_offsets[code + 1] - chunk.call_id_offsets[code]));
+    }
+
+    const auto& keys = by_trunk_ ? chunk.trunk_ids : chunk.tarif_ids;
+    bool inside = window.Contains(chunk.min_call_time) && window.Contains(chunk.max_call_time);
+    size_t size = chunk.Size();
+    for (size_t row = 0; row < size; ++row) {
+        if (!inside && !window.Contains(chunk.call_times[row])) {
+            continue;
+        }
+        int32_t slot = index_.Slot(keys[row]);
+        if (slot != DenseIndex::NO_SLOT) {
+            Add(slot, hashes[chunk.call_id_codes[row]], chunk.durations[row], chunk.costs[row]);
+        }
+    }
+}
+
+void DistributionAggregator::Add(int32_t slot, uint64_t call_id_hash, int duration_seconds, int64_t cost) {
+    auto& sketch = sketches_[slot];
+    ++sketch.calls;
+    sketch.distinct_calls.Add(call_id_hash);
+    sketch.durations.Add(duration_seconds);
+    sketch.costs.Add(cost);
+}
+
+void DistributionAggregator::Merge(const DistributionAggregator& other) {
+    for (size_t slot = 0; slot < sketches_.size() && slot < other.sketches_.size(); ++slot) {
+        auto& sketch = sketches_[slot];
+        const auto& partial = other.sketches_[slot];
+        sketch.calls += partial.calls;
+        sketch.distinct_calls.Merge(partial.distinct_calls);
+        sketch.durations.Merge(partial.durations);
+        sketch.costs.Merge(partial.costs);
+    }
+}
+
+std::vector<DistributionAnalytics> DistributionAggregator::Finish() {
+    std::vector<DistributionAnalytics> result = std::move(groups_);
+    for (size_t slot = 0; slot < result.size(); ++slot) {
+        auto& analytics = result[slot];
+        const auto& sketch = sketches_[slot];
+        analytics.calls = static_cast<int64_t>(sketch.calls);
+        // Оценка не должна превышать точное число звонков группы
+        analytics.distinct_calls = static_cast<int64_t>(std::min(sketch.distinct_calls.Estimate(), sketch.calls));
+        analytics.duration_seconds = Summarize(sketch.durations);
+        analytics.cost = Summarize(sketch.costs);
+    }
+
+    // Сортируем по числу звонков (убывание)
     std::sort(result.begin(), result.end(),
-        [](const RevenueAnalytics& a, const RevenueAnalytics& b) {
-            return a.period < b.period;
+        [](const DistributionAnalytics& a, const DistributionAnalytics& b) {
+            return a.calls > b.calls;
         });
 
     return result;
 }
 
-std::vector<RevenueAnalytics> AnalyticsCalculator::CalculateRevenueByDay(
-    const std::vector<ui::detail::CallStatisticsInfo>& calls
-) {
-    std::map<std::string, RevenueAnalytics> day_map;
-
-    for (const auto& call : calls) {
-        // Извлекаем дату из call_time (формат: "YYYY-MM-DD HH:MM:SS")
-        if (call.call_time.length() >= 10) {
-            std::string day = call.call_time.substr(0, 10);
-            
-            if (day_map.find(day) == day_map.end()) {
-                day_map[day] = RevenueAnalytics{day, 0.0, 0};
-            }
-            
-            day_map[day].revenue += call.cost;
-            day_map[day].call_count++;
+// ============================================================================
+// UtilizationAggregator
+// ============================================================================
+
+UtilizationAggregator::UtilizationAggregator(const topology::NetworkTopology& topology, const TimeWindow& window,
+                                             double saturation_threshold)
+    : window_(window)
+    , threshold_(saturation_threshold)
+    , groups_(MakeGroups<TrunkUtilization>(topology.Trunks(), [&topology, &window](const ui::detail::TrunkInfo& trunk) {
+          const auto* hub = topology.HubOfTrunk(trunk.id);
+          return TrunkUtilization{trunk.id, trunk.name, trunk.server_id, hub ? hub->id : 0, trunk.capacity,
+                                  0, 0, window.from, 0.0, 0.0, 0.0, 0, false};
+      }))
+    , index_(IndexGroups(groups_, [](const TrunkUtilization& utilization) {
+          return utilization.trunk_id;
+      }))
+    , events_(groups_.size()) {
+    if (window.from == std::numeric_limits<int64_t>::min() || window.to == std::numeric_limits<int64_t>::max()
+        || window.from >= window.to) {
+        throw std::invalid_argument("Для загрузки транков нужно окно с началом и концом"s);
+    }
+}
+
+TimeWindow UtilizationAggregator::ScanWindow(const TimeWindow& window) {
+    return TimeWindow{window.from - MAX_CALL_DURATION_US, window.to};
+}
+
+void UtilizationAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    int32_t slot = index_.Slot(call.trunk_id);
+    if (slot != DenseIndex::NO_SLOT) {
+        Add(slot, call.call_time, call.duration_seconds);
+    }
+}
+
+void UtilizationAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return;
+    }
+
+    // Звонки вне окна отсекаются обрезкой интервала в Add(slot, ...)
+    size_t size = chunk.Size();
+    for (size_t row = 0; row < size; ++row) {
+        int32_t slot = index_.Slot(chunk.trunk_ids[row]);
+        if (slot != DenseIndex::NO_SLOT) {
+            Add(slot, chunk.call_times[row], chunk.durations[row]);
         }
     }
+}
 
-    std::vector<RevenueAnalytics> result;
-    for (const auto& [day, analytics] : day_map) {
-        result.push_back(analytics);
+void UtilizationAggregator::Add(int32_t slot, int64_t call_time, int64_t duration_seconds) {
+    int64_t start = std::max(call_time, window_.from);
+    int64_t end = std::min(call_time + duration_seconds * domain::MICROS_PER_SECOND, window_.to);
+    if (start >= end) {
+        return;
+    }
+
+    auto& events = events_[slot];
+    events.starts.push_back(start);
+    events.ends.push_back(end);
+}
+
+void UtilizationAggregator::Merge(const UtilizationAggregator& other) {
+    for (size_t slot = 0; slot < events_.size() && slot < other.events_.size(); ++slot) {
+        auto& events = events_[slot];
+        const auto& partial = other.events_[slot];
+        events.starts.insert(events.starts.end(), partial.starts.begin(), partial.starts.end());
+        events.ends.insert(events.ends.end(), partial.ends.begin(), partial.ends.end());
     }
+}
+
+void UtilizationAggregator::Sweep(size_t slot) {
+    auto& utilization = groups_[slot];
+    auto& [starts, ends] = events_[slot];
+    std::sort(starts.begin(), starts.end());
+    std::sort(ends.begin(), ends.end());
+
+    // Порог насыщения в каналах: не меньше одного, без ёмкости - не достигается
+    int64_t limit = utilization.capacity > 0
+                    ? std::max<int64_t>(1, static_cast<int64_t>(std::ceil(threshold_ * utilization.capacity)))
+                    : std::numeric_limits<int64_t>::max();
 
-    // Сортируем по дате
+    int64_t current = 0;
+    int64_t last = window_.from;
+    double channel_time = 0.0; // канало-микросекунды (в int64 переполнились бы на длинных окнах)
+    size_t next_start = 0;
+    size_t next_end = 0;
+    while (next_end < ends.size()) {
+        int64_t now = next_start < starts.size() && starts[next_start] < ends[next_end]
+                      ? starts[next_start]
+                      : ends[next_end];
+        channel_time += static_cast<double>(current) * static_cast<double>(now - last);
+        if (current >= limit) {
+            utilization.saturated_us += now - last;
+        }
+        last = now;
+
+        while (next_end < ends.size() && ends[next_end] == now) {
+            --current;
+            ++next_end;
+        }
+        while (next_start < starts.size() && starts[next_start] == now) {
+            ++current;
+            ++next_start;
+        }
+        if (current > utilization.peak_channels) {
+            utilization.peak_channels = current;
+            utilization.peak_time = now;
+        }
+    }
+
+    utilization.calls = static_cast<int64_t>(starts.size());
+    utilization.avg_channels = channel_time / static_cast<double>(window_.to - window_.from);
+    if (utilization.capacity > 0) {
+        utilization.utilization = utilization.avg_channels / utilization.capacity;
+        utilization.peak_utilization = static_cast<double>(utilization.peak_channels) / utilization.capacity;
+    }
+    utilization.saturated = utilization.peak_channels >= limit;
+
+    // События больше не нужны: память освобождается сразу, не дожидаясь остальных транков
+    std::vector<int64_t>().swap(starts);
+    std::vector<int64_t>().swap(ends);
+}
+
+std::vector<TrunkUtilization> UtilizationAggregator::Finish() {
+    g_compute_pool.ParallelFor(groups_.size(), [this](size_t slot) {
+        Sweep(slot);
+    });
+
+    std::vector<TrunkUtilization> result = std::move(groups_);
+
+    // Сортируем по средней загрузке (убывание)
     std::sort(result.begin(), result.end(),
-        [](const RevenueAnalytics& a, const RevenueAnalytics& b) {
-            return a.period < b.period;
+        [](const TrunkUtilization& a, const TrunkUtilization& b) {
+            return a.utilization != b.utilization ? a.utilization > b.utilization : a.trunk_id < b.trunk_id;
         });
 
     return result;
 }
 
+// ============================================================================
+// TimeSeriesAggregator
+// ============================================================================
+
+TimeSeriesAggregator::TimeSeriesAggregator(const TimeBuckets& buckets)
+    : buckets_(&buckets)
+    , totals_(buckets.Size()) {}
+
+void TimeSeriesAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    if (auto index = buckets_->Find(call.call_time)) {
+        AddTotals(totals_[*index], call.duration_seconds, call.cost);
+    }
+}
+
+void TimeSeriesAggregator::Add(int64_t call_time, const GroupTotals& totals) {
+    if (auto index = buckets_->Find(call_time)) {
+        AddTotals(totals_[*index], totals);
+    }
+}
+
+void TimeSeriesAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    TimeWindow bounded{std::max(window.from, buckets_->From()), std::min(window.to, buckets_->To())};
+    if (chunk.Size() == 0 || chunk.max_call_time < bounded.from || chunk.min_call_time >= bounded.to) {
+        return;
+    }
+
+    bool inside = bounded.Contains(chunk.min_call_time) && bounded.Contains(chunk.max_call_time);
+    size_t size = chunk.Size();
+    int64_t from = buckets_->From();
+    int64_t step = buckets_->FixedStep();
+    for (size_t row = 0; row < size; ++row) {
+        int64_t call_time = chunk.call_times[row];
+        if (!inside && !bounded.Contains(call_time)) {
+            continue;
+        }
+        // Фиксированный шаг - одно деление, месяцы - двоичный поиск по границам
+        size_t index = step != 0 ? static_cast<size_t>((call_time - from) / step) : buckets_->IndexOf(call_time);
+        auto& totals = totals_[index];
+        ++totals.calls;
+        totals.duration_seconds += chunk.durations[row];
+        totals.cost += chunk.costs[row];
+    }
+}
+
+void TimeSeriesAggregator::Merge(const TimeSeriesAggregator& other) {
+    MergeTotals(totals_, other.totals_);
+}
+
+std::vector<TimeSeriesPoint> TimeSeriesAggregator::Finish() {
+    std::vector<TimeSeriesPoint> result;
+    result.reserve(totals_.size());
+    for (size_t index = 0; index < totals_.size(); ++index) {
+        const auto& totals = totals_[index];
+        result.push_back({buckets_->Start(index), totals.calls, totals.duration_seconds,
+                          domain::Money::FromMicros(totals.cost)});
+    }
+    return result;
+}
+
+// ============================================================================
+// TopCallsAggregator
+// ============================================================================
+
+TopCallsAggregator::TopCallsAggregator(size_t capacity)
+    : top_(capacity) {}
+
+void TopCallsAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    top_.Push(CallLeader{call.id, call.call_id, call.call_time, call.trunk_id, call.tarif_id,
+                         call.duration_seconds, call.cost});
+}
+
+void TopCallsAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return;
+    }
+
+    bool inside = window.Contains(chunk.min_call_time) && window.Contains(chunk.max_call_time);
+    size_t size = chunk.Size();
+    CallLeader candidate{};
+    for (size_t row = 0; row < size; ++row) {
+        if (!inside && !window.Contains(chunk.call_times[row])) {
+            continue;
+        }
+        // Сначала сравниваются стоимость и id, строка call_id собирается только для принятых
+        candidate.id = chunk.ids[row];
+        candidate.cost = domain::Money::FromMicros(chunk.costs[row]);
+        if (!top_.Accepts(candidate)) {
+            continue;
+        }
+        top_.Push(CallLeader{chunk.ids[row], std::string(chunk.CallId(row)), chunk.call_times[row],
+                             chunk.trunk_ids[row], chunk.tarif_ids[row], chunk.durations[row], candidate.cost});
+    }
+}
+
+void TopCallsAggregator::Merge(const TopCallsAggregator& other) {
+    top_.Merge(other.top_);
+}
+
+std::vector<CallLeader> TopCallsAggregator::Top(size_t limit) const {
+    return top_.Sorted(limit);
+}
+
+// ============================================================================
+// DashboardAggregator
+// ============================================================================
+
+namespace {
+
+// Номер интервала гистограммы: число границ, не превосходящих value
+template <size_t N>
+size_t HistogramBin(const std::array<int64_t, N>& bounds, int64_t value) {
+    return static_cast<size_t>(std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+}
+
+template <size_t N>
+void MergeTotals(std::array<GroupTotals, N>& totals, const std::array<GroupTotals, N>& other) {
+    for (size_t i = 0; i < N; ++i) {
+        AddTotals(totals[i], other[i]);
+    }
+}
+
+} // namespace
+
+DashboardAggregator::DashboardAggregator(const std::vector<ui::detail::TrunkInfo>& trunks,
+                                         const std::vector<ui::detail::TarifInfo>& tarifs,
+                                         int64_t tz_offset, size_t recent_calls)
+    : trunks_(trunks)
+    , tarifs_(tarifs)
+    , tz_offset_(tz_offset)
+    , recent_(recent_calls) {}
+
+void DashboardAggregator::Add(const ui::detail::CallStatisticsInfo& call) {
+    trunks_.Add(call);
+    tarifs_.Add(call);
+    Add(call.call_time, call.duration_seconds, call.cost.Micros());
+    recent_.Push(CallLeader{call.id, call.call_id, call.call_time, call.trunk_id, call.tarif_id,
+                            call.duration_seconds, call.cost});
+}
+
+void DashboardAggregator::Add(int64_t call_time, int duration_seconds, int64_t cost) {
+    GroupTotals call{1, duration_seconds, cost};
+    AddTotals(totals_, call);
+    int64_t local = call_time + tz_offset_;
+    auto hour = static_cast<size_t>((local - domain::FloorDiv(local, domain::MICROS_PER_DAY) * domain::MICROS_PER_DAY)
+                                    / domain::MICROS_PER_HOUR);
+    AddTotals(by_hour_[hour], call);
+    AddTotals(duration_histogram_[HistogramBin(DURATION_BOUNDS, duration_seconds)], call);
+    AddTotals(cost_histogram_[HistogramBin(COST_BOUNDS, cost)], call);
+}
+
+void DashboardAggregator::Add(const CallChunk& chunk, const TimeWindow& window) {
+    if (chunk.Size() == 0 || chunk.max_call_time < window.from || chunk.min_call_time >= window.to) {
+        return;
+    }
+
+    trunks_.Add(chunk, window);
+    tarifs_.Add(chunk, window);
+
+    bool inside = window.Contains(chunk.min_call_time) && window.Contains(chunk.max_call_time);
+    size_t size = chunk.Size();
+    for (size_t row = 0; row < size; ++row) {
+        if (inside || window.Contains(chunk.call_times[row])) {
+            Add(chunk.call_times[row], chunk.durations[row], chunk.costs[row]);
+        }
+    }
+
+    // Строки части идут по возрастанию id: с конца куча заполняется сразу,
+    // и более старые строки отбрасываются одним сравнением
+    CallLeader candidate{};
+    for (size_t row = size; row-- > 0;) {
+        if (!inside && !window.Contains(chunk.call_times[row])) {
+            continue;
+        }
+        candidate.id = chunk.ids[row];
+        if (recent_.Accepts(candidate)) {
+            recent_.Push(CallLeader{chunk.ids[row], std::string(chunk.CallId(row)), chunk.call_times[row],
+                                    chunk.trunk_ids[row], chunk.tarif_ids[row], chunk.durations[row],
+                                    domain::Money::FromMicros(chunk.costs[row])});
+        }
+    }
+}
+
+void DashboardAggregator::Merge(const DashboardAggregator& other) {
+    trunks_.Merge(other.trunks_);
+    tarifs_.Merge(other.tarifs_);
+    AddTotals(totals_, other.totals_);
+    MergeTotals(by_hour_, other.by_hour_);
+    MergeTotals(duration_histogram_, other.duration_histogram_);
+    MergeTotals(cost_histogram_, other.cost_histogram_);
+    recent_.Merge(other.recent_);
+}
+
+DashboardSummary DashboardAggregator::Finish() {
+    DashboardSummary result;
+    result.totals = totals_;
+    result.by_trunk = trunks_.Finish();
+    result.by_tarif = tarifs_.Finish();
+    result.by_hour.assign(by_hour_.begin(), by_hour_.end());
+    result.duration_histogram.assign(duration_histogram_.begin(), duration_histogram_.end());
+    result.cost_histogram.assign(cost_histogram_.begin(), cost_histogram_.end());
+    result.recent_calls = recent_.Sorted(recent_.Capacity());
+    return result;
+}
+
+// ============================================================================
+// AnalyticsCalculator
+// ============================================================================
+
+namespace {
+
+// Параллельная агрегация: items (звонки или части хранилища) делятся на непрерывные
+// диапазоны, каждый диапазон считает своя копия агрегатора, копии сливаются по порядку.
+// Суммы целочисленные (Money в миллионных долях), поэтому результат точный
+// и не зависит от числа потоков
+template <typename Aggregator, typename AddRange>
+Aggregator ParallelAggregate(Aggregator aggregator, size_t items, size_t rows, AddRange add_range) {
+    size_t parts = std::min(g_compute_pool.Partitions(rows), items);
+    if (parts <= 1) {
+        // Одна задача тоже считается в пуле, а не в потоке Asio
+        g_compute_pool.ParallelFor(1, [&](size_t) {
+            add_range(aggregator, 0, items);
+        });
+        return aggregator;
+    }
+
+    std::vector<Aggregator> partials(parts, aggregator);
+    g_compute_pool.ParallelFor(parts, [&](size_t part) {
+        add_range(partials[part], items * part / parts, items * (part + 1) / parts);
+    });
+
+    for (const auto& partial : partials) {
+        aggregator.Merge(partial);
+    }
+    return aggregator;
+}
+
+template <typename Aggregator>
+Aggregator AggregateCalls(Aggregator aggregator, const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    return ParallelAggregate(std::move(aggregator), calls.size(), calls.size(),
+        [&calls](Aggregator& partial, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.Add(calls[i]);
+            }
+        });
+}
+
+// Части снимка, пересекающиеся с window, делятся между потоками целиком
+template <typename Aggregator>
+Aggregator AggregateChunks(Aggregator aggregator, const CallColumns& calls, const TimeWindow& window) {
+    std::vector<const CallChunk*> chunks;
+    size_t rows = 0;
+    for (const auto& chunk : calls.chunks) {
+        if (chunk->Size() > 0 && chunk->max_call_time >= window.from && chunk->min_call_time < window.to) {
+            chunks.push_back(chunk.get());
+            rows += chunk->Size();
+        }
+    }
+
+    return ParallelAggregate(std::move(aggregator), chunks.size(), rows,
+        [&chunks, &window](Aggregator& partial, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                partial.Add(*chunks[i], window);
+            }
+        });
+}
+
+} // namespace
+
+std::vector<TrunkAnalytics> AnalyticsCalculator::CalculateByTrunk(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls,
+    const std::vector<ui::detail::TrunkInfo>& trunks
+) {
+    return AggregateCalls(TrunkAggregator(trunks), calls).Finish();
+}
+
+std::vector<TarifAnalytics> AnalyticsCalculator::CalculateByTarif(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls,
+    const std::vector<ui::detail::TarifInfo>& tarifs
+) {
+    return AggregateCalls(TarifAggregator(tarifs), calls).Finish();
+}
+
+std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls,
+    const std::vector<ui::detail::HubInfo>& hubs,
+    const std::vector<ui::detail::ServerInfo>& servers,
+    const std::vector<ui::detail::TrunkInfo>& trunks
+) {
+    return CalculateByHub(calls, topology::NetworkTopology(hubs, servers, trunks));
+}
+
+std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls,
+    const topology::NetworkTopology& topology
+) {
+    return AggregateCalls(HubAggregator(topology), calls).Finish();
+}
+
+std::vector<RevenueAnalytics> AnalyticsCalculator::CalculateRevenueByHour(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls
+) {
+    return AggregateCalls(RevenueAggregator(RevenuePeriod::HOUR), calls).Finish();
+}
+
+std::vector<RevenueAnalytics> AnalyticsCalculator::CalculateRevenueByDay(
+    const std::vector<ui::detail::CallStatisticsInfo>& calls
+) {
+    return AggregateCalls(RevenueAggregator(RevenuePeriod::DAY), calls).Finish();
+}
+
+// ============================================================================
+// AnalyticsCalculator: колоночное хранилище
+// ============================================================================
+
+std::vector<TrunkAnalytics> AnalyticsCalculator::CalculateByTrunk(
+    const CallColumns& calls,
+    const std::vector<ui::detail::TrunkInfo>& trunks,
+    const TimeWindow& window
+) {
+    return AggregateChunks(TrunkAggregator(trunks), calls, window).Finish();
+}
+
+std::vector<TarifAnalytics> AnalyticsCalculator::CalculateByTarif(
+    const CallColumns& calls,
+    const std::vector<ui::detail::TarifInfo>& tarifs,
+    const TimeWindow& window
+) {
+    return AggregateChunks(TarifAggregator(tarifs), calls, window).Finish();
+}
+
+std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
+    const CallColumns& calls,
+    const std::vector<ui::detail::HubInfo>& hubs,
+    const std::vector<ui::detail::ServerInfo>& servers,
+    const std::vector<ui::detail::TrunkInfo>& trunks,
+    const TimeWindow& window
+) {
+    return CalculateByHub(calls, topology::NetworkTopology(hubs, servers, trunks), window);
+}
+
+std::vector<HubAnalytics> AnalyticsCalculator::CalculateByHub(
+    const CallColumns& calls,
+    const topology::NetworkTopology& topology,
+    const TimeWindow& window
+) {
+    return AggregateChunks(HubAggregator(topology), calls, window).Finish();
+}
+
+std::vector<RevenueAnalytics> AnalyticsCalculator::CalculateRevenue(
+    const CallColumns& calls,
+    RevenuePeriod period,
+    const TimeWindow& window
+) {
+    return AggregateChunks(RevenueAggregator(period), calls, window).Finish();
+}
+
+std::vector<DistributionAnalytics> AnalyticsCalculator::CalculateDistributionByTrunk(
+    const CallColumns& calls,
+    const std::vector<ui::detail::TrunkInfo>& trunks,
+    const TimeWindow& window
+) {
+    return AggregateChunks(DistributionAggregator(trunks), calls, window).Finish();
+}
+
+std::vector<DistributionAnalytics> AnalyticsCalculator::CalculateDistributionByTarif(
+    const CallColumns& calls,
+    const std::vector<ui::detail::TarifInfo>& tarifs,
+    const TimeWindow& window
+) {
+    return AggregateChunks(DistributionAggregator(tarifs), calls, window).Finish();
+}
+
+std::vector<TrunkUtilization> AnalyticsCalculator::CalculateUtilization(
+    const CallColumns& calls,
+    const topology::NetworkTopology& topology,
+    const TimeWindow& window,
+    double saturation_threshold
+) {
+    return AggregateChunks(UtilizationAggregator(topology, window, saturation_threshold), calls,
+                           UtilizationAggregator::ScanWindow(window)).Finish();
+}
+
+std::vector<CallLeader> AnalyticsCalculator::CalculateTopCalls(
+    const CallColumns& calls,
+    size_t limit,
+    const TimeWindow& window
+) {
+    return AggregateChunks(TopCallsAggregator(limit), calls, window).Top(limit);
+}
+
+std::vector<TimeSeriesPoint> AnalyticsCalculator::CalculateTimeSeries(
+    const CallColumns& calls,
+    const TimeBuckets& buckets
+) {
+    return AggregateChunks(TimeSeriesAggregator(buckets), calls, TimeWindow{buckets.From(), buckets.To()}).Finish();
+}
+
+DashboardSummary AnalyticsCalculator::CalculateDashboard(
+    const CallColumns& calls,
+    const std::vector<ui::detail::TrunkInfo>& trunks,
+    const std::vector<ui::detail::TarifInfo>& tarifs,
+    int64_t tz_offset,
+    size_t recent_calls,
+    const TimeWindow& window
+) {
+    return AggregateChunks(DashboardAggregator(trunks, tarifs, tz_offset, recent_calls), calls, window).Finish();
+}
+
 // Конвертация в JSON
 json::value AnalyticsCalculator::ToJson(const std::vector<TrunkAnalytics>& data) {
     json::array arr;
@@ -237,10 +1027,10 @@ json::value AnalyticsCalculator::ToJson(const std::vector<TrunkAnalytics>& data)
             {"trunk_id"s, item.trunk_id},
             {"trunk_name"s, item.trunk_name},
             {"total_calls"s, item.total_calls},
-            {"total_revenue"s, item.total_revenue},
+            {"total_revenue"s, item.total_revenue.ToDouble()},
             {"total_duration_seconds"s, item.total_duration_seconds},
             {"avg_duration_seconds"s, item.avg_duration_seconds},
-            {"avg_cost"s, item.avg_cost}
+            {"avg_cost"s, item.avg_cost.ToDouble()}
         });
     }
     return arr;
@@ -253,9 +1043,9 @@ json::value AnalyticsCalculator::ToJson(const std::vector<TarifAnalytics>& data)
             {"tarif_id"s, item.tarif_id},
             {"tarif_name"s, item.tarif_name},
             {"total_calls"s, item.total_calls},
-            {"total_revenue"s, item.total_revenue},
+            {"total_revenue"s, item.total_revenue.ToDouble()},
             {"total_duration_seconds"s, item.total_duration_seconds},
-            {"avg_cost"s, item.avg_cost}
+            {"avg_cost"s, item.avg_cost.ToDouble()}
         });
     }
     return arr;
@@ -268,7 +1058,7 @@ json::value AnalyticsCalculator::ToJson(const std::vector<HubAnalytics>& data) {
             {"hub_id"s, item.hub_id},
             {"hub_name"s, item.hub_name},
             {"total_calls"s, item.total_calls},
-            {"total_revenue"s, item.total_revenue},
+            {"total_revenue"s, item.total_revenue.ToDouble()},
             {"server_count"s, item.server_count},
             {"trunk_count"s, item.trunk_count}
         });
@@ -281,11 +1071,158 @@ json::value AnalyticsCalculator::ToJson(const std::vector<RevenueAnalytics>& dat
     for (const auto& item : data) {
         arr.push_back(json::object{
             {"period"s, item.period},
-            {"revenue"s, item.revenue},
+            {"revenue"s, item.revenue.ToDouble()},
             {"call_count"s, item.call_count}
         });
     }
     return arr;
 }
 
+json::value AnalyticsCalculator::ToJson(const std::vector<DistributionAnalytics>& data) {
+    auto summary = [](const QuantileSummary& quantiles, auto convert) {
+        return json::object{
+            {"min"s, convert(quantiles.min)},
+            {"p50"s, convert(quantiles.p50)},
+            {"p95"s, convert(quantiles.p95)},
+            {"p99"s, convert(quantiles.p99)},
+            {"max"s, convert(quantiles.max)}
+        };
+    };
+    auto seconds = [](int64_t value) {
+        return value;
+    };
+    auto money = [](int64_t micros) {
+        return domain::Money::FromMicros(micros).ToDouble();
+    };
+
+    json::array arr;
+    for (const auto& item : data) {
+        arr.push_back(json::object{
+            {"id"s, item.id},
+            {"name"s, item.name},
+            {"calls"s, item.calls},
+            {"distinct_calls"s, item.distinct_calls},
+            {"duration_seconds"s, summary(item.duration_seconds, seconds)},
+            {"cost"s, summary(item.cost, money)}
+        });
+    }
+    return arr;
+}
+
+json::value AnalyticsCalculator::ToJson(const std::vector<TrunkUtilization>& data) {
+    json::array arr;
+    for (const auto& item : data) {
+        arr.push_back(json::object{
+            {"trunk_id"s, item.trunk_id},
+            {"trunk_name"s, item.trunk_name},
+            {"server_id"s, item.server_id},
+            {"hub_id"s, item.hub_id},
+            {"capacity"s, item.capacity},
+            {"calls"s, item.calls},
+            {"peak_channels"s, item.peak_channels},
+            {"peak_time"s, domain::FormatTimestamp(item.peak_time)},
+            {"avg_channels"s, item.avg_channels},
+            {"utilization"s, item.utilization},
+            {"peak_utilization"s, item.peak_utilization},
+            {"saturated_seconds"s, static_cast<double>(item.saturated_us) / domain::MICROS_PER_SECOND},
+            {"saturated"s, item.saturated}
+        });
+    }
+    return arr;
+}
+
+json::value AnalyticsCalculator::ToJson(const std::vector<CallLeader>& data) {
+    json::array arr;
+    arr.reserve(data.size());
+    for (const auto& item : data) {
+        arr.push_back(json::object{
+            {"id"s, item.id},
+            {"call_id"s, item.call_id},
+            {"call_time"s, domain::FormatTimestamp(item.call_time)},
+            {"trunk_id"s, item.trunk_id},
+            {"tarif_id"s, item.tarif_id},
+            {"duration_seconds"s, item.duration_seconds},
+            {"cost"s, item.cost.ToDouble()}
+        });
+    }
+    return arr;
+}
+
+json::value AnalyticsCalculator::ToJson(const TimeBuckets& buckets, const std::vector<TimeSeriesPoint>& data) {
+    std::string offset = FormatUtcOffset(buckets.TzOffset());
+
+    json::array points;
+    points.reserve(data.size());
+    for (const auto& item : data) {
+        // "YYYY-MM-DD HH:MM:SS" местного времени + смещение: "2024-05-01T00:00:00+03:00"
+        std::string time = domain::FormatTimestamp(item.start + buckets.TzOffset()).substr(0, 19);
+        time[10] = 'T';
+        points.push_back(json::object{
+            {"time"s, time + offset},
+            {"calls"s, item.calls},
+            {"duration_seconds"s, item.duration_seconds},
+            {"revenue"s, item.revenue.ToDouble()}
+        });
+    }
+
+    return json::object{
+        {"from"s, domain::FormatTimestamp(buckets.From())},
+        {"to"s, domain::FormatTimestamp(buckets.To())},
+        {"step"s, ToString(buckets.Step())},
+        {"tz"s, offset},
+        {"points"s, std::move(points)}
+    };
+}
+
+json::value AnalyticsCalculator::ToJson(const DashboardSummary& data) {
+    auto totals = [](const GroupTotals& item) {
+        return json::object{
+            {"calls"s, item.calls},
+            {"revenue"s, domain::Money::FromMicros(item.cost).ToDouble()},
+            {"duration_seconds"s, item.duration_seconds}
+        };
+    };
+    // Интервалы с границами: у первого нижняя граница 0, у последнего верхней нет (null)
+    auto histogram = [&totals](const std::vector<GroupTotals>& bins, const auto& bounds, auto convert) {
+        json::array arr;
+        arr.reserve(bins.size());
+        for (size_t i = 0; i < bins.size(); ++i) {
+            json::object bin = totals(bins[i]);
+            bin["from"s] = i == 0 ? convert(0) : convert(bounds[i - 1]);
+            bin["to"s] = i < bounds.size() ? json::value(convert(bounds[i])) : json::value(nullptr);
+            arr.push_back(std::move(bin));
+        }
+        return arr;
+    };
+    auto seconds = [](int64_t value) {
+        return json::value(value);
+    };
+    auto money = [](int64_t micros) {
+        return json::value(domain::Money::FromMicros(micros).ToDouble());
+    };
+
+    json::array by_hour;
+    by_hour.reserve(data.by_hour.size());
+    for (size_t hour = 0; hour < data.by_hour.size(); ++hour) {
+        json::object item = totals(data.by_hour[hour]);
+        item["hour"s] = hour;
+        by_hour.push_back(std::move(item));
+    }
+
+    return json::object{
+        {"calls"s, {
+            {"total"s, data.totals.calls},
+            {"total_revenue"s, domain::Money::FromMicros(data.totals.cost).ToDouble()},
+            {"total_duration_seconds"s, data.totals.duration_seconds},
+            {"total_duration_minutes"s, data.totals.duration_seconds / 60}
+        }},
+        {"by_trunk"s, ToJson(data.by_trunk)},
+        {"by_tarif"s, ToJson(data.by_tarif)},
+        {"by_hour"s, std::move(by_hour)},
+        {"duration_histogram"s, histogram(data.duration_histogram, DashboardAggregator::DURATION_BOUNDS, seconds)},
+        {"cost_histogram"s, histogram(data.cost_histogram, DashboardAggregator::COST_BOUNDS, money)},
+        {"recent_calls"s, ToJson(data.recent_calls)}
+    };
+}
+
 } // namespace analytics
@@ -1,7 +1,16 @@
 #pragma once
 
+#include "call_columns.h"
+#include "group_by.h"
+#include "sketches.h"
+#include "time_buckets.h"
+#include "top_k.h"
+#include "../topology/topology.h"
 #include "../ui/view.h"
 #include <boost/json.hpp>
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <vector>
 #include <map>
 #include <string>
@@ -15,38 +24,360 @@ using namespace std::literals;
 struct TrunkAnalytics {
     int trunk_id;
     std::string trunk_name;
-    int total_calls;
-    double total_revenue;
-    int total_duration_seconds;
+    int64_t total_calls;
+    domain::Money total_revenue; // точная сумма в миллионных долях
+    int64_t total_duration_seconds;
     double avg_duration_seconds;
-    double avg_cost;
+    domain::Money avg_cost;
 };
 
 // Структура для аналитики по тарифам
 struct TarifAnalytics {
     int tarif_id;
     std::string tarif_name;
-    int total_calls;
-    double total_revenue;
-    int total_duration_seconds;
-    double avg_cost;
+    int64_t total_calls;
+    domain::Money total_revenue; // точная сумма в миллионных долях
+    int64_t total_duration_seconds;
+    domain::Money avg_cost;
 };
 
 // Структура для аналитики по хабам
 struct HubAnalytics {
     int hub_id;
     std::string hub_name;
-    int total_calls;
-    double total_revenue;
+    int64_t total_calls;
+    domain::Money total_revenue; // точная сумма в миллионных долях
     int server_count;
     int trunk_count;
 };
 
+// Период группировки выручки
+enum class RevenuePeriod {
+    HOUR,
+    DAY
+};
+
 // Структура для аналитики выручки по периодам
 struct RevenueAnalytics {
     std::string period; // hour, day, month
-    double revenue;
-    int call_count;
+    domain::Money revenue;
+    int64_t call_count;
+};
+
+// Точные крайние значения и приближённые квантили распределения
+struct QuantileSummary {
+    int64_t min;
+    int64_t p50;
+    int64_t p95;
+    int64_t p99;
+    int64_t max;
+};
+
+// Распределение звонков группы (транка или тарифа) по скетчам: память на группу ограничена
+struct DistributionAnalytics {
+    int id;
+    std::string name;
+    int64_t calls;
+    int64_t distinct_calls;           // оценка HyperLogLog по call_id
+    QuantileSummary duration_seconds;
+    QuantileSummary cost;             // domain::Money в миллионных долях
+};
+
+// Загрузка транка в окне: одновременно занятые каналы по событиям начала и конца звонков
+struct TrunkUtilization {
+    int trunk_id;
+    std::string trunk_name;
+    int server_id;
+    int hub_id;              // 0 - хаб транка не найден
+    int capacity;            // число каналов транка
+    int64_t calls;           // звонки, занимавшие канал внутри окна
+    int64_t peak_channels;
+    int64_t peak_time;       // начало первого пика, микросекунды от эпохи (UTC)
+    double avg_channels;     // среднее по времени окна
+    double utilization;      // avg_channels / capacity (0 - ёмкость не задана)
+    double peak_utilization; // peak_channels / capacity
+    int64_t saturated_us;    // сколько времени загрузка была не ниже порога
+    bool saturated;          // порог достигался хотя бы раз
+};
+
+// Звонок из рейтинга самых дорогих
+struct CallLeader {
+    int64_t id;
+    std::string call_id;
+    int64_t call_time;  // микросекунды от эпохи (UTC)
+    int trunk_id;
+    int tarif_id;
+    int duration_seconds;
+    domain::Money cost;
+};
+
+// Точка временного ряда: суммы звонков одного интервала TimeBuckets
+struct TimeSeriesPoint {
+    int64_t start;              // начало интервала, микросекунды от эпохи (UTC)
+    int64_t calls;
+    int64_t duration_seconds;
+    domain::Money revenue;
+};
+
+// Полуинтервал времени звонка [from, to) в микросекундах от эпохи (UTC)
+struct TimeWindow {
+    int64_t from = std::numeric_limits<int64_t>::min();
+    int64_t to = std::numeric_limits<int64_t>::max();
+
+    bool Contains(int64_t call_time) const noexcept {
+        return call_time >= from && call_time < to;
+    }
+};
+
+// Сводка панели мониторинга за окно: итоги, группы по транкам и тарифам,
+// часы суток, гистограммы длительности и стоимости и последние звонки
+struct DashboardSummary {
+    GroupTotals totals;
+    std::vector<TrunkAnalytics> by_trunk;
+    std::vector<TarifAnalytics> by_tarif;
+    std::vector<GroupTotals> by_hour;            // 24 часа суток местного времени
+    std::vector<GroupTotals> duration_histogram; // интервалы DashboardAggregator::DURATION_BOUNDS
+    std::vector<GroupTotals> cost_histogram;     // интервалы DashboardAggregator::COST_BOUNDS
+    std::vector<CallLeader> recent_calls;        // по убыванию id
+};
+
+// Потоковые агрегаторы: звонки добавляются по одному через Add(),
+// память O(число групп) независимо от количества звонков.
+// Add() по отдельным полям используется при обходе колоночного хранилища,
+// Add() части целиком - векторное ядро группировки (group_by.h).
+// Группы нумеруются подряд по возрастанию id, суммы копятся в плоском массиве.
+// Merge() складывает частичный результат копии, построенной по тем же справочникам:
+// суммы целочисленные, поэтому итог не зависит от разбиения и порядка слияния.
+// Add() готовых сумм группы - для поддерживаемых агрегатов (app/call_aggregates.h)
+
+// Агрегатор по транкам
+class TrunkAggregator {
+public:
+    explicit TrunkAggregator(const std::vector<ui::detail::TrunkInfo>& trunks);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(int trunk_id, int duration_seconds, domain::Money cost);
+    void Add(int trunk_id, const GroupTotals& totals);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const TrunkAggregator& other);
+    std::vector<TrunkAnalytics> Finish();
+
+private:
+    std::vector<TrunkAnalytics> groups_;
+    DenseIndex index_;
+    std::vector<GroupTotals> totals_;
+};
+
+// Агрегатор по тарифам
+class TarifAggregator {
+public:
+    explicit TarifAggregator(const std::vector<ui::detail::TarifInfo>& tarifs);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(int tarif_id, int duration_seconds, domain::Money cost);
+    void Add(int tarif_id, const GroupTotals& totals);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const TarifAggregator& other);
+    std::vector<TarifAnalytics> Finish();
+
+private:
+    std::vector<TarifAnalytics> groups_;
+    DenseIndex index_;
+    std::vector<GroupTotals> totals_;
+};
+
+// Агрегатор по хабам
+class HubAggregator {
+public:
+    HubAggregator(const std::vector<ui::detail::HubInfo>& hubs,
+                  const std::vector<ui::detail::ServerInfo>& servers,
+                  const std::vector<ui::detail::TrunkInfo>& trunks);
+    // Счётчики серверов и транков и привязка транков к хабам берутся из готовой топологии
+    explicit HubAggregator(const topology::NetworkTopology& topology);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(int trunk_id, domain::Money cost);
+    void Add(int trunk_id, const GroupTotals& totals);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const HubAggregator& other);
+    std::vector<HubAnalytics> Finish();
+
+private:
+    std::vector<HubAnalytics> groups_;
+    DenseIndex index_; // trunk_id -> номер группы хаба
+    std::vector<GroupTotals> totals_;
+};
+
+// Агрегатор выручки по часам или по дням
+class RevenueAggregator {
+public:
+    explicit RevenueAggregator(RevenuePeriod period);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(int64_t call_time, domain::Money cost);
+    void Add(int64_t call_time, const GroupTotals& totals);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const RevenueAggregator& other);
+    std::vector<RevenueAnalytics> Finish();
+
+private:
+    RevenuePeriod period_;
+    // Номер часа суток (0..23) или дня от эпохи -> выручка за период
+    std::map<int64_t, RevenueAnalytics> period_map_;
+};
+
+// Агрегатор распределений по транкам или тарифам: на группу HyperLogLog по call_id
+// и квантильные скетчи длительности и стоимости. Скетчи сливаются через Merge(),
+// поэтому расчёт делится между потоками так же, как точные суммы
+class DistributionAggregator {
+public:
+    explicit DistributionAggregator(const std::vector<ui::detail::TrunkInfo>& trunks);
+    explicit DistributionAggregator(const std::vector<ui::detail::TarifInfo>& tarifs);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const DistributionAggregator& other);
+    std::vector<DistributionAnalytics> Finish();
+
+private:
+    struct GroupSketch {
+        uint64_t calls = 0;
+        HyperLogLog distinct_calls;
+        QuantileSketch durations;
+        QuantileSketch costs;
+    };
+
+    void Add(int32_t slot, uint64_t call_id_hash, int duration_seconds, int64_t cost);
+
+    bool by_trunk_;
+    std::vector<DistributionAnalytics> groups_;
+    DenseIndex index_;
+    std::vector<GroupSketch> sketches_;
+};
+
+// Агрегатор загрузки транков (sweep line). Звонок занимает канал на [call_time,
+// call_time + duration), интервал обрезается по окну. Add() копит моменты начала
+// и конца по транкам, Finish() сортирует их и проходит по событиям: в равный момент
+// конец обрабатывается раньше начала, поэтому смежные звонки не пересекаются.
+// Транки обходятся параллельно в g_compute_pool; память - O(звонков окна)
+class UtilizationAggregator {
+public:
+    // Звонки длиннее не учитываются до своего начала: окно обхода хранилища
+    // расширяется назад на столько (ScanWindow)
+    static constexpr int64_t MAX_CALL_DURATION_US = 24 * domain::MICROS_PER_HOUR;
+
+    // window должно быть ограничено с обеих сторон (std::invalid_argument);
+    // saturation_threshold - доля ёмкости, с которой транк считается перегруженным
+    UtilizationAggregator(const topology::NetworkTopology& topology, const TimeWindow& window,
+                          double saturation_threshold = 1.0);
+
+    // Окно времени начала звонков, которые могут пересекаться с window
+    static TimeWindow ScanWindow(const TimeWindow& window);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const UtilizationAggregator& other);
+    std::vector<TrunkUtilization> Finish();
+
+private:
+    struct Events {
+        std::vector<int64_t> starts;
+        std::vector<int64_t> ends;
+    };
+
+    void Add(int32_t slot, int64_t call_time, int64_t duration_seconds);
+    void Sweep(size_t slot);
+
+    TimeWindow window_;
+    double threshold_;
+    std::vector<TrunkUtilization> groups_;
+    DenseIndex index_;
+    std::vector<Events> events_;
+};
+
+// Агрегатор временного ряда: суммы по интервалам TimeBuckets в плоском массиве,
+// Finish() возвращает все интервалы подряд, пустые - с нулями.
+// Звонки вне [buckets.From(), buckets.To()) пропускаются; buckets должен жить дольше агрегатора
+class TimeSeriesAggregator {
+public:
+    explicit TimeSeriesAggregator(const TimeBuckets& buckets);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(int64_t call_time, const GroupTotals& totals);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const TimeSeriesAggregator& other);
+    std::vector<TimeSeriesPoint> Finish();
+
+private:
+    const TimeBuckets* buckets_;
+    std::vector<GroupTotals> totals_;
+};
+
+// Самые дорогие звонки: по убыванию стоимости, при равной стоимости - по возрастанию id.
+// Ограниченная куча TopK: O(log capacity) на звонок, память O(capacity);
+// call_id копируется только у звонков, попавших в отобранные
+class TopCallsAggregator {
+public:
+    explicit TopCallsAggregator(size_t capacity);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const TopCallsAggregator& other);
+    // Первые limit отобранных (не больше Capacity())
+    std::vector<CallLeader> Top(size_t limit) const;
+
+    size_t Capacity() const noexcept {
+        return top_.Capacity();
+    }
+
+private:
+    struct MoreExpensive {
+        bool operator()(const CallLeader& lhs, const CallLeader& rhs) const noexcept {
+            return lhs.cost != rhs.cost ? lhs.cost > rhs.cost : lhs.id < rhs.id;
+        }
+    };
+
+    TopK<CallLeader, MoreExpensive> top_;
+};
+
+// Все суммы панели мониторинга за один проход по звонкам: группы по транкам и тарифам -
+// векторным ядром, остальное - в одном цикле по строкам части. Последние звонки -
+// ограниченная куча TopK по id, call_id копируется только у отобранных
+class DashboardAggregator {
+public:
+    static constexpr size_t HOURS_PER_DAY = 24;
+    // Интервал i гистограммы - [BOUNDS[i - 1], BOUNDS[i]), первый открыт снизу
+    // (отрицательная стоимость сторно попадает в него), последний - сверху
+    static constexpr std::array<int64_t, 5> DURATION_BOUNDS{30, 60, 120, 300, 600};
+    // domain::Money в миллионных долях: 1, 5, 10, 20 и 50 рублей
+    static constexpr std::array<int64_t, 5> COST_BOUNDS{1'000'000, 5'000'000, 10'000'000, 20'000'000, 50'000'000};
+
+    DashboardAggregator(const std::vector<ui::detail::TrunkInfo>& trunks,
+                        const std::vector<ui::detail::TarifInfo>& tarifs,
+                        int64_t tz_offset, size_t recent_calls);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+    void Add(const CallChunk& chunk, const TimeWindow& window);
+    void Merge(const DashboardAggregator& other);
+    DashboardSummary Finish();
+
+private:
+    struct Newer {
+        bool operator()(const CallLeader& lhs, const CallLeader& rhs) const noexcept {
+            return lhs.id > rhs.id;
+        }
+    };
+
+    void Add(int64_t call_time, int duration_seconds, int64_t cost);
+
+    TrunkAggregator trunks_;
+    TarifAggregator tarifs_;
+    int64_t tz_offset_;
+    GroupTotals totals_;
+    std::array<GroupTotals, HOURS_PER_DAY> by_hour_{};
+    std::array<GroupTotals, DURATION_BOUNDS.size() + 1> duration_histogram_{};
+    std::array<GroupTotals, COST_BOUNDS.size() + 1> cost_histogram_{};
+    TopK<CallLeader, Newer> recent_;
 };
 
 class AnalyticsCalculator {
@@ -71,6 +402,11 @@ public:
         const std::vector<ui::detail::TrunkInfo>& trunks
     );
 
+    static std::vector<HubAnalytics> CalculateByHub(
+        const std::vector<ui::detail::CallStatisticsInfo>& calls,
+        const topology::NetworkTopology& topology
+    );
+
     // Аналитика выручки по часам
     static std::vector<RevenueAnalytics> CalculateRevenueByHour(
         const std::vector<ui::detail::CallStatisticsInfo>& calls
@@ -81,11 +417,96 @@ public:
         const std::vector<ui::detail::CallStatisticsInfo>& calls
     );
 
+    // Те же расчёты по колоночному хранилищу: читаются только нужные столбцы,
+    // звонки вне window пропускаются (части целиком - по границам call_time).
+    // Большие объёмы делятся между потоками g_compute_pool (compute_pool.h)
+    static std::vector<TrunkAnalytics> CalculateByTrunk(
+        const CallColumns& calls,
+        const std::vector<ui::detail::TrunkInfo>& trunks,
+        const TimeWindow& window = {}
+    );
+
+    static std::vector<TarifAnalytics> CalculateByTarif(
+        const CallColumns& calls,
+        const std::vector<ui::detail::TarifInfo>& tarifs,
+        const TimeWindow& window = {}
+    );
+
+    static std::vector<HubAnalytics> CalculateByHub(
+        const CallColumns& calls,
+        const std::vector<ui::detail::HubInfo>& hubs,
+        const std::vector<ui::detail::ServerInfo>& servers,
+        const std::vector<ui::detail::TrunkInfo>& trunks,
+        const TimeWindow& window = {}
+    );
+
+    static std::vector<HubAnalytics> CalculateByHub(
+        const CallColumns& calls,
+        const topology::NetworkTopology& topology,
+        const TimeWindow& window = {}
+    );
+
+    static std::vector<RevenueAnalytics> CalculateRevenue(
+        const CallColumns& calls,
+        RevenuePeriod period,
+        const TimeWindow& window = {}
+    );
+
+    // Распределения по транкам и тарифам (скетчи, см. DistributionAggregator)
+    static std::vector<DistributionAnalytics> CalculateDistributionByTrunk(
+        const CallColumns& calls,
+        const std::vector<ui::detail::TrunkInfo>& trunks,
+        const TimeWindow& window = {}
+    );
+
+    static std::vector<DistributionAnalytics> CalculateDistributionByTarif(
+        const CallColumns& calls,
+        const std::vector<ui::detail::TarifInfo>& tarifs,
+        const TimeWindow& window = {}
+    );
+
+    // Загрузка транков в ограниченном окне (см. UtilizationAggregator)
+    static std::vector<TrunkUtilization> CalculateUtilization(
+        const CallColumns& calls,
+        const topology::NetworkTopology& topology,
+        const TimeWindow& window,
+        double saturation_threshold = 1.0
+    );
+
+    // Временной ряд по интервалам buckets (окно - [buckets.From(), buckets.To()))
+    static std::vector<TimeSeriesPoint> CalculateTimeSeries(
+        const CallColumns& calls,
+        const TimeBuckets& buckets
+    );
+
+    // Первые limit самых дорогих звонков окна
+    static std::vector<CallLeader> CalculateTopCalls(
+        const CallColumns& calls,
+        size_t limit,
+        const TimeWindow& window = {}
+    );
+
+    // Сводка панели мониторинга; recent_calls - сколько последних звонков вернуть
+    static DashboardSummary CalculateDashboard(
+        const CallColumns& calls,
+        const std::vector<ui::detail::TrunkInfo>& trunks,
+        const std::vector<ui::detail::TarifInfo>& tarifs,
+        int64_t tz_offset,
+        size_t recent_calls,
+        const TimeWindow& window = {}
+    );
+
     // Конвертация в JSON
     static json::value ToJson(const std::vector<TrunkAnalytics>& data);
     static json::value ToJson(const std::vector<TarifAnalytics>& data);
     static json::value ToJson(const std::vector<HubAnalytics>& data);
     static json::value ToJson(const std::vector<RevenueAnalytics>& data);
+    static json::value ToJson(const std::vector<DistributionAnalytics>& data);
+    static json::value ToJson(const std::vector<TrunkUtilization>& data);
+    static json::value ToJson(const std::vector<CallLeader>& data);
+    static json::value ToJson(const DashboardSummary& data);
+    // Ряд с параметрами разбиения; время точек - местное, со смещением пояса
+    static json::value ToJson(const TimeBuckets& buckets, const std::vector<TimeSeriesPoint>& data);
 };
 
 } // namespace analytics
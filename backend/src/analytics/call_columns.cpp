@@ -0,0 +1,105 @@
+#include "call_columns.h"
+
+#include <algorithm>
+
+namespace analytics {
+
+namespace {
+
+template <typename T>
+size_t VectorBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+} // namespace
+
+ui::detail::CallStatisticsInfo CallChunk::Row(size_t row) const {
+    return {
+        ids[row],
+        std::string(CallId(row)),
+        trunk_ids[row],
+        tarif_ids[row],
+        durations[row],
+        domain::Money::FromMicros(costs[row]),
+        call_times[row]
+    };
+}
+
+size_t CallChunk::MemoryBytes() const noexcept {
+    return VectorBytes(ids) + VectorBytes(call_times) + VectorBytes(trunk_ids) + VectorBytes(tarif_ids)
+           + VectorBytes(durations) + VectorBytes(costs) + VectorBytes(call_id_codes)
+           + VectorBytes(call_id_offsets) + call_id_chars.capacity();
+}
+
+CallChunkBuilder::CallChunkBuilder(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1))
+    , chunk_(std::make_shared<CallChunk>()) {
+    chunk_->ids.reserve(capacity_);
+    chunk_->call_times.reserve(capacity_);
+    chunk_->trunk_ids.reserve(capacity_);
+    chunk_->tarif_ids.reserve(capacity_);
+    chunk_->durations.reserve(capacity_);
+    chunk_->costs.reserve(capacity_);
+    chunk_->call_id_codes.reserve(capacity_);
+    chunk_->call_id_offsets.reserve(capacity_ + 1);
+    chunk_->call_id_offsets.push_back(0);
+    dictionary_.reserve(capacity_);
+}
+
+CallChunkBuilder::CallChunkBuilder(const CallChunk& base, size_t capacity)
+    : CallChunkBuilder(std::max(capacity, base.Size())) {
+    auto& chunk = *chunk_;
+    chunk.ids = base.ids;
+    chunk.call_times = base.call_times;
+    chunk.trunk_ids = base.trunk_ids;
+    chunk.tarif_ids = base.tarif_ids;
+    chunk.durations = base.durations;
+    chunk.costs = base.costs;
+    chunk.call_id_codes = base.call_id_codes;
+    chunk.call_id_offsets = base.call_id_offsets;
+    chunk.call_id_chars = base.call_id_chars;
+    chunk.min_call_time = base.min_call_time;
+    chunk.max_call_time = base.max_call_time;
+
+    for (uint32_t code = 0; code + 1 < chunk.call_id_offsets.size(); ++code) {
+        dictionary_.emplace(chunk.call_id_chars.substr(chunk.call_id_offsets[code],
+                                                       chunk.call_id_offsets[code + 1] - chunk.call_id_offsets[code]),
+                            code);
+    }
+}
+
+void CallChunkBuilder::Add(const ui::detail::CallStatisticsInfo& call) {
+    auto& chunk = *chunk_;
+
+    auto [it, inserted] = dictionary_.try_emplace(call.call_id, static_cast<uint32_t>(dictionary_.size()));
+    if (inserted) {
+        chunk.call_id_chars += call.call_id;
+        chunk.call_id_offsets.push_back(static_cast<uint32_t>(chunk.call_id_chars.size()));
+    }
+
+    chunk.ids.push_back(call.id);
+    chunk.call_times.push_back(call.call_time);
+    chunk.trunk_ids.push_back(call.trunk_id);
+    chunk.tarif_ids.push_back(call.tarif_id);
+    chunk.durations.push_back(call.duration_seconds);
+    chunk.costs.push_back(call.cost.Micros());
+    chunk.call_id_codes.push_back(it->second);
+
+    chunk.min_call_time = std::min(chunk.min_call_time, call.call_time);
+    chunk.max_call_time = std::max(chunk.max_call_time, call.call_time);
+}
+
+std::shared_ptr<const CallChunk> CallChunkBuilder::Finish() {
+    dictionary_.clear();
+    return std::move(chunk_);
+}
+
+size_t CallColumns::MemoryBytes() const noexcept {
+    size_t bytes = 0;
+    for (const auto& chunk : chunks) {
+        bytes += chunk->MemoryBytes();
+    }
+    return bytes;
+}
+
+} // namespace analytics
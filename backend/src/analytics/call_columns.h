@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../ui/view.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace analytics {
+
+// Часть колоночного хранилища звонков (struct-of-arrays).
+// Агрегации читают только нужные столбцы подряд, не затрагивая call_id.
+// После построения не изменяется и может читаться из нескольких потоков
+struct CallChunk {
+    std::vector<int64_t> ids;
+    std::vector<int64_t> call_times; // микросекунды от эпохи (UTC)
+    std::vector<int32_t> trunk_ids;
+    std::vector<int32_t> tarif_ids;
+    std::vector<int32_t> durations;  // duration_seconds
+    std::vector<int64_t> costs;      // domain::Money в миллионных долях
+
+    // call_id в словарном кодировании: код строки -> [offsets[code], offsets[code + 1]) в call_id_chars
+    std::vector<uint32_t> call_id_codes;
+    std::vector<uint32_t> call_id_offsets;
+    std::string call_id_chars;
+
+    int64_t min_call_time = std::numeric_limits<int64_t>::max();
+    int64_t max_call_time = std::numeric_limits<int64_t>::min();
+
+    size_t Size() const noexcept {
+        return ids.size();
+    }
+
+    std::string_view CallId(size_t row) const noexcept {
+        uint32_t code = call_id_codes[row];
+        return std::string_view(call_id_chars).substr(call_id_offsets[code],
+                                                      call_id_offsets[code + 1] - call_id_offsets[code]);
+    }
+
+    // Восстановить строку в виде CallStatisticsInfo (для выдачи отдельных звонков)
+    ui::detail::CallStatisticsInfo Row(size_t row) const;
+
+    size_t MemoryBytes() const noexcept;
+};
+
+// Построение части по одному звонку
+class CallChunkBuilder {
+public:
+    explicit CallChunkBuilder(size_t capacity);
+    // Продолжить заполнение копии уже готовой (неполной) части
+    CallChunkBuilder(const CallChunk& base, size_t capacity);
+
+    void Add(const ui::detail::CallStatisticsInfo& call);
+
+    size_t Size() const noexcept {
+        return chunk_->Size();
+    }
+
+    bool Full() const noexcept {
+        return chunk_->Size() >= capacity_;
+    }
+
+    std::shared_ptr<const CallChunk> Finish();
+
+private:
+    size_t capacity_;
+    std::shared_ptr<CallChunk> chunk_;
+    // Словарь call_id текущей части (повторная загрузка того же звонка получает тот же код)
+    std::unordered_map<std::string, uint32_t> dictionary_;
+};
+
+// Снимок колоночного хранилища: последовательность неизменяемых частей в порядке
+// загрузки (по возрастанию id, кроме строк, зафиксированных позже строк с большим id)
+struct CallColumns {
+    std::vector<std::shared_ptr<const CallChunk>> chunks;
+    int64_t watermark = 0;    // наибольший загруженный id
+    int64_t covered_from = 0; // все звонки с call_time >= covered_from присутствуют в снимке
+    size_t rows = 0;
+
+    size_t MemoryBytes() const noexcept;
+};
+
+} // namespace analytics
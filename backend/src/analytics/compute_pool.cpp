@@ -0,0 +1,168 @@
+#include "compute_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace analytics {
+
+// Глобальный экземпляр
+ComputePool g_compute_pool;
+
+namespace {
+
+// Поток пула: вложенный ParallelFor выполняется на месте, а не ждёт
+// освобождения потоков, которые сам же и занимает
+thread_local bool t_pool_worker = false;
+
+// Общее состояние одного ParallelFor. Помощник, взявший задачу после того,
+// как все индексы разобраны, сразу выходит и не обращается к task
+struct ParallelState {
+    const std::function<void(size_t)>* task = nullptr;
+    size_t count = 0;
+    std::atomic<size_t> next{0};
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t done = 0;
+    std::exception_ptr error;
+
+    void Work() {
+        size_t index;
+        while ((index = next.fetch_add(1)) < count) {
+            std::exception_ptr task_error;
+            try {
+                (*task)(index);
+            }
+            catch (...) {
+                task_error = std::current_exception();
+            }
+
+            std::lock_guard lock{mutex};
+            if (task_error && !error) {
+                error = task_error;
+            }
+            if (++done == count) {
+                done_cv.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+ComputePool::~ComputePool() {
+    Stop();
+}
+
+void ComputePool::Start(Options options) {
+    if (running_) {
+        return;
+    }
+
+    options_ = options;
+    if (options_.threads == 0) {
+        options_.threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    options_.min_rows_per_task = std::max<size_t>(options_.min_rows_per_task, 1);
+
+    stop_requested_ = false;
+    for (size_t i = 0; i < options_.threads; ++i) {
+        threads_.emplace_back(&ComputePool::Run, this);
+    }
+    running_ = true;
+}
+
+void ComputePool::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        stop_requested_ = true;
+    }
+    cond_var_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    queue_.clear();
+    running_ = false;
+}
+
+bool ComputePool::IsRunning() const {
+    return running_;
+}
+
+size_t ComputePool::Partitions(size_t rows) const {
+    if (!running_) {
+        return 1;
+    }
+    size_t by_rows = rows / options_.min_rows_per_task;
+    return std::clamp<size_t>(by_rows, 1, options_.threads);
+}
+
+void ComputePool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    auto run_here = [&] {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+    };
+    if (!running_ || t_pool_worker) {
+        return run_here();
+    }
+
+    auto state = std::make_shared<ParallelState>();
+    state->task = &task;
+    state->count = count;
+
+    {
+        std::lock_guard lock{mutex_};
+        // Пул останавливается: задачи в очереди уже никто не возьмёт
+        if (stop_requested_) {
+            return run_here();
+        }
+        for (size_t i = 0; i < std::min(count, options_.threads); ++i) {
+            queue_.emplace_back([state] {
+                state->Work();
+            });
+        }
+    }
+    cond_var_.notify_all();
+
+    std::unique_lock lock{state->mutex};
+    state->done_cv.wait(lock, [&] {
+        return state->done == state->count;
+    });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ComputePool::Run() {
+    t_pool_worker = true;
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock{mutex_};
+            cond_var_.wait(lock, [this] {
+                return stop_requested_ || !queue_.empty();
+            });
+            // Поставленные задачи дорабатываются: их ждут вызывающие потоки
+            if (queue_.empty()) {
+                break;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace analytics
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace analytics {
+
+// Пул потоков для расчёта аналитики, отдельный от потоков Asio:
+// долгая агрегация не занимает потоки, обслуживающие HTTP.
+// ParallelFor отдаёт все задачи потокам пула, вызывающий поток только ждёт.
+// Без запущенного пула и внутри задач пула задачи выполняются на месте
+class ComputePool {
+public:
+    struct Options {
+        size_t threads = 0;                // 0 - по числу ядер
+        size_t min_rows_per_task = 262144; // меньшие объёмы считаются одной задачей
+    };
+
+    ComputePool() = default;
+    ~ComputePool();
+
+    ComputePool(const ComputePool&) = delete;
+    ComputePool& operator=(const ComputePool&) = delete;
+
+    void Start(Options options);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Число задач, на которое имеет смысл делить rows строк
+    size_t Partitions(size_t rows) const;
+
+    // Вызвать task(i) для i в [0, count) в потоках пула и дождаться завершения
+    // (при count == 1 тоже: расчёт не занимает поток Asio).
+    // Первое исключение из задач пробрасывается вызывающему
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void Run();
+
+    Options options_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<std::function<void()>> queue_;
+    bool stop_requested_ = false;
+    std::atomic<bool> running_{false};
+};
+
+// Глобальный экземпляр (запускается в main)
+extern ComputePool g_compute_pool;
+
+} // namespace analytics
@@ -0,0 +1,235 @@
+#include "group_by.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ANALYTICS_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define ANALYTICS_X86_KERNELS 0
+#endif
+
+namespace analytics {
+
+namespace {
+
+// Таблица строится, пока на один id приходится не больше 4 пустых ячеек
+constexpr int64_t DENSE_TABLE_MIN = 1024;
+constexpr int64_t DENSE_TABLE_FACTOR = 4;
+
+inline bool InWindow(const GroupByColumns& columns, size_t row, int64_t from, int64_t to) {
+    return !columns.call_times || (columns.call_times[row] >= from && columns.call_times[row] < to);
+}
+
+inline void AddRow(const GroupByColumns& columns, size_t row, int32_t slot, GroupTotals* totals) {
+    GroupTotals& group = totals[slot];
+    ++group.calls;
+    if (columns.durations) {
+        group.duration_seconds += columns.durations[row];
+    }
+    group.cost += columns.costs[row];
+}
+
+void AccumulateScalar(const GroupByColumns& columns, size_t begin, int64_t from, int64_t to,
+                      const DenseIndex& index, GroupTotals* totals) {
+    for (size_t row = begin; row < columns.size; ++row) {
+        if (!InWindow(columns, row, from, to)) {
+            continue;
+        }
+        int32_t slot = index.Slot(columns.keys[row]);
+        if (slot != DenseIndex::NO_SLOT) {
+            AddRow(columns, row, slot, totals);
+        }
+    }
+}
+
+#if ANALYTICS_X86_KERNELS
+
+// Маска строк из четырёх (SSE: две пары) с call_time в [from, to), по биту на строку
+__attribute__((target("sse4.2")))
+inline unsigned TimeMask4Sse(const int64_t* call_times, __m128i from_v, __m128i to_v) {
+    __m128i t0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(call_times));
+    __m128i t1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(call_times + 2));
+    __m128i m0 = _mm_andnot_si128(_mm_cmpgt_epi64(from_v, t0), _mm_cmpgt_epi64(to_v, t0));
+    __m128i m1 = _mm_andnot_si128(_mm_cmpgt_epi64(from_v, t1), _mm_cmpgt_epi64(to_v, t1));
+    return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m0)))
+           | (static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m1))) << 2);
+}
+
+// SSE4.2: проверка диапазона ключей и окна времени по 4 строки, чтение таблицы скалярное
+__attribute__((target("sse4.2")))
+void AccumulateSse42(const GroupByColumns& columns, int64_t from, int64_t to,
+                     const DenseIndex& index, GroupTotals* totals) {
+    const int32_t* table = index.Table().data();
+    const __m128i min_v = _mm_set1_epi32(index.MinId());
+    const __m128i size_v = _mm_set1_epi32(static_cast<int32_t>(index.Table().size()));
+    const __m128i minus_one = _mm_set1_epi32(-1);
+    const __m128i from_v = _mm_set1_epi64x(from);
+    const __m128i to_v = _mm_set1_epi64x(to);
+
+    alignas(16) int32_t offsets[4];
+    size_t row = 0;
+    for (; row + 4 <= columns.size; row += 4) {
+        __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(columns.keys + row));
+        __m128i rel = _mm_sub_epi32(keys, min_v);
+        __m128i in_range = _mm_and_si128(_mm_cmpgt_epi32(size_v, rel), _mm_cmpgt_epi32(rel, minus_one));
+
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(in_range)));
+        if (columns.call_times && mask) {
+            mask &= TimeMask4Sse(columns.call_times + row, from_v, to_v);
+        }
+        if (!mask) {
+            continue;
+        }
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets), rel);
+        while (mask) {
+            int lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+            int32_t slot = table[offsets[lane]];
+            if (slot != DenseIndex::NO_SLOT) {
+                AddRow(columns, row + lane, slot, totals);
+            }
+        }
+    }
+
+    AccumulateScalar(columns, row, from, to, index, totals);
+}
+
+// AVX2: по 8 строк, номера групп читаются из таблицы gather-ом
+__attribute__((target("avx2")))
+void AccumulateAvx2(const GroupByColumns& columns, int64_t from, int64_t to,
+                    const DenseIndex& index, GroupTotals* totals) {
+    const int32_t* table = index.Table().data();
+    const __m256i min_v = _mm256_set1_epi32(index.MinId());
+    const __m256i size_v = _mm256_set1_epi32(static_cast<int32_t>(index.Table().size()));
+    const __m256i minus_one = _mm256_set1_epi32(-1);
+    const __m256i no_slot = _mm256_set1_epi32(DenseIndex::NO_SLOT);
+    const __m256i from_v = _mm256_set1_epi64x(from);
+    const __m256i to_v = _mm256_set1_epi64x(to);
+
+    alignas(32) int32_t slots[8];
+    size_t row = 0;
+    for (; row + 8 <= columns.size; row += 8) {
+        __m256i keys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(columns.keys + row));
+        __m256i rel = _mm256_sub_epi32(keys, min_v);
+        __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi32(size_v, rel), _mm256_cmpgt_epi32(rel, minus_one));
+        __m256i slot_v = _mm256_mask_i32gather_epi32(no_slot, table, rel, in_range, 4);
+
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(slot_v, minus_one))));
+        if (columns.call_times && mask) {
+            const int64_t* times = columns.call_times + row;
+            __m256i t0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times));
+            __m256i t1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times + 4));
+            __m256i m0 = _mm256_andnot_si256(_mm256_cmpgt_epi64(from_v, t0), _mm256_cmpgt_epi64(to_v, t0));
+            __m256i m1 = _mm256_andnot_si256(_mm256_cmpgt_epi64(from_v, t1), _mm256_cmpgt_epi64(to_v, t1));
+            mask &= static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m0)))
+                    | (static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m1))) << 4);
+        }
+        if (!mask) {
+            continue;
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(slots), slot_v);
+        while (mask) {
+            int lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+            AddRow(columns, row + lane, slots[lane], totals);
+        }
+    }
+
+    AccumulateScalar(columns, row, from, to, index, totals);
+}
+
+#endif
+
+GroupByKernel DetectKernel() noexcept {
+#if ANALYTICS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return GroupByKernel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return GroupByKernel::SSE42;
+    }
+#endif
+    return GroupByKernel::SCALAR;
+}
+
+} // namespace
+
+DenseIndex::DenseIndex(const std::vector<std::pair<int32_t, int32_t>>& id_to_slot) {
+    if (id_to_slot.empty()) {
+        return;
+    }
+
+    auto [min_it, max_it] = std::minmax_element(id_to_slot.begin(), id_to_slot.end(),
+        [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+    int64_t range = static_cast<int64_t>(max_it->first) - min_it->first + 1;
+
+    if (range > std::max(DENSE_TABLE_MIN, DENSE_TABLE_FACTOR * static_cast<int64_t>(id_to_slot.size()))) {
+        for (const auto& [id, slot] : id_to_slot) {
+            sparse_[id] = slot;
+        }
+        return;
+    }
+
+    min_id_ = min_it->first;
+    table_.assign(static_cast<size_t>(range), NO_SLOT);
+    for (const auto& [id, slot] : id_to_slot) {
+        table_[static_cast<size_t>(static_cast<int64_t>(id) - min_id_)] = slot;
+    }
+}
+
+GroupByKernel ActiveGroupByKernel() noexcept {
+    static const GroupByKernel kernel = DetectKernel();
+    return kernel;
+}
+
+std::string_view ToString(GroupByKernel kernel) noexcept {
+    switch (kernel) {
+        case GroupByKernel::AVX2:
+            return "avx2";
+        case GroupByKernel::SSE42:
+            return "sse4.2";
+        case GroupByKernel::SCALAR:
+            break;
+    }
+    return "scalar";
+}
+
+void AccumulateGroups(const GroupByColumns& columns, int64_t from, int64_t to,
+                      const DenseIndex& index, std::vector<GroupTotals>& totals) {
+    AccumulateGroups(ActiveGroupByKernel(), columns, from, to, index, totals);
+}
+
+void AccumulateGroups(GroupByKernel kernel, const GroupByColumns& columns, int64_t from, int64_t to,
+                      const DenseIndex& index, std::vector<GroupTotals>& totals) {
+    if (columns.size == 0) {
+        return;
+    }
+
+    // Ядро, которого нет у процессора, не вызывается
+    if (static_cast<int>(kernel) > static_cast<int>(ActiveGroupByKernel()) || !index.IsDense()) {
+        kernel = GroupByKernel::SCALAR;
+    }
+
+    switch (kernel) {
+#if ANALYTICS_X86_KERNELS
+        case GroupByKernel::AVX2:
+            AccumulateAvx2(columns, from, to, index, totals.data());
+            return;
+        case GroupByKernel::SSE42:
+            AccumulateSse42(columns, from, to, index, totals.data());
+            return;
+#endif
+        default:
+            AccumulateScalar(columns, 0, from, to, index, totals.data());
+    }
+}
+
+} // namespace analytics
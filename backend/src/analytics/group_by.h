@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace analytics {
+
+// Отображение id справочника (транк, тариф) в компактный номер группы.
+// Для плотных id - таблица по смещению от наименьшего id, которую векторные
+// ядра читают gather-ом; для сильно разреженных id - хеш-таблица
+class DenseIndex {
+public:
+    static constexpr int32_t NO_SLOT = -1;
+
+    DenseIndex() = default;
+    // Пары id -> номер группы; несколько id могут вести в одну группу
+    explicit DenseIndex(const std::vector<std::pair<int32_t, int32_t>>& id_to_slot);
+
+    int32_t Slot(int32_t id) const noexcept {
+        if (!sparse_.empty()) {
+            auto it = sparse_.find(id);
+            return it != sparse_.end() ? it->second : NO_SLOT;
+        }
+        uint32_t offset = static_cast<uint32_t>(id) - static_cast<uint32_t>(min_id_);
+        return offset < table_.size() ? table_[offset] : NO_SLOT;
+    }
+
+    // Таблица доступна векторным ядрам только для плотных id
+    bool IsDense() const noexcept {
+        return sparse_.empty();
+    }
+
+    int32_t MinId() const noexcept {
+        return min_id_;
+    }
+
+    const std::vector<int32_t>& Table() const noexcept {
+        return table_;
+    }
+
+private:
+    int32_t min_id_ = 0;
+    std::vector<int32_t> table_;                   // id - min_id_ -> номер группы или NO_SLOT
+    std::unordered_map<int32_t, int32_t> sparse_;
+};
+
+// Суммы по одной группе (стоимость - domain::Money в миллионных долях)
+struct GroupTotals {
+    int64_t calls = 0;
+    int64_t duration_seconds = 0;
+    int64_t cost = 0;
+};
+
+// Реализация ядра группировки, выбранная по возможностям процессора
+enum class GroupByKernel {
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+GroupByKernel ActiveGroupByKernel() noexcept;
+std::string_view ToString(GroupByKernel kernel) noexcept;
+
+// Столбцы одной части колоночного хранилища для группировки
+struct GroupByColumns {
+    const int32_t* keys = nullptr;        // trunk_id или tarif_id
+    const int32_t* durations = nullptr;   // nullptr - длительность не суммируется
+    const int64_t* costs = nullptr;
+    const int64_t* call_times = nullptr;  // nullptr - все строки внутри окна
+    size_t size = 0;
+};
+
+// Сложить в totals строки с call_time в [from, to) и известным ключом.
+// totals должен содержать не меньше групп, чем номеров в index.
+// Ключи переводятся в номера групп векторно (AVX2 gather / SSE4.2), сложение
+// по группам скалярное: одинаковые ключи в соседних строках иначе конфликтуют
+void AccumulateGroups(const GroupByColumns& columns, int64_t from, int64_t to,
+                      const DenseIndex& index, std::vector<GroupTotals>& totals);
+
+// То же с явным выбором ядра (для сравнения реализаций); недоступное процессору ядро
+// заменяется скалярным
+void AccumulateGroups(GroupByKernel kernel, const GroupByColumns& columns, int64_t from, int64_t to,
+                      const DenseIndex& index, std::vector<GroupTotals>& totals);
+
+} // namespace analytics
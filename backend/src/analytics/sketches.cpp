@@ -0,0 +1,229 @@
+#include "sketches.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+namespace analytics {
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+// Финальное перемешивание MurmurHash3: FNV-1a плохо разносит старшие биты,
+// а по ним HyperLogLog выбирает регистр
+constexpr uint64_t Mix(uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Наименьшая вместимость уровня: на верхних уровнях значений мало, но сжатие
+// всё равно должно делить уровень пополам
+constexpr size_t MIN_LEVEL_CAPACITY = 8;
+
+} // namespace
+
+uint64_t HashCallId(std::string_view call_id) noexcept {
+    uint64_t hash = FNV_OFFSET;
+    for (char c : call_id) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= FNV_PRIME;
+    }
+    return Mix(hash);
+}
+
+// ============================================================================
+// HyperLogLog
+// ============================================================================
+
+void HyperLogLog::Add(uint64_t hash) {
+    if (registers_.empty()) {
+        registers_.resize(REGISTERS);
+    }
+    size_t index = hash >> (64 - PRECISION);
+    // Ограничивающая единица: при нулевом остатке ранг не выходит за 64 - PRECISION + 1
+    uint64_t rest = (hash << PRECISION) | (uint64_t{1} << (PRECISION - 1));
+    auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+}
+
+void HyperLogLog::Merge(const HyperLogLog& other) {
+    if (other.registers_.empty()) {
+        return;
+    }
+    if (registers_.empty()) {
+        registers_ = other.registers_;
+        return;
+    }
+    for (size_t i = 0; i < REGISTERS; ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+}
+
+uint64_t HyperLogLog::Estimate() const {
+    if (registers_.empty()) {
+        return 0;
+    }
+
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t rank : registers_) {
+        sum += std::ldexp(1.0, -rank);
+        zeros += rank == 0;
+    }
+
+    const double m = static_cast<double>(REGISTERS);
+    const double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    // Малые значения - линейный подсчёт по пустым регистрам (поправка Flajolet et al.)
+    if (estimate <= 2.5 * m && zeros != 0) {
+        estimate = m * std::log(m / static_cast<double>(zeros));
+    }
+    return static_cast<uint64_t>(std::llround(estimate));
+}
+
+// ============================================================================
+// QuantileSketch
+// ============================================================================
+
+QuantileSketch::QuantileSketch(uint32_t k)
+    : k_(std::max<uint32_t>(k, MIN_LEVEL_CAPACITY)) {}
+
+void QuantileSketch::Add(int64_t value) {
+    if (count_ == 0) {
+        min_ = max_ = value;
+        levels_.emplace_back();
+    }
+    else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    ++count_;
+
+    levels_[0].push_back(value);
+    ++retained_;
+    if (retained_ >= TotalCapacity()) {
+        Compress();
+    }
+}
+
+void QuantileSketch::Merge(const QuantileSketch& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    count_ += other.count_;
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (size_t level = 0; level < other.levels_.size(); ++level) {
+        levels_[level].insert(levels_[level].end(), other.levels_[level].begin(), other.levels_[level].end());
+    }
+    retained_ += other.retained_;
+    Compress();
+}
+
+int64_t QuantileSketch::Min() const noexcept {
+    return min_;
+}
+
+int64_t QuantileSketch::Max() const noexcept {
+    return max_;
+}
+
+std::vector<int64_t> QuantileSketch::Quantiles(const std::vector<double>& qs) const {
+    std::vector<int64_t> result(qs.size(), 0);
+    if (count_ == 0) {
+        return result;
+    }
+
+    std::vector<std::pair<int64_t, uint64_t>> weighted;
+    weighted.reserve(retained_);
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        for (int64_t value : levels_[level]) {
+            weighted.emplace_back(value, uint64_t{1} << level);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    for (size_t i = 0; i < qs.size(); ++i) {
+        double q = std::clamp(qs[i], 0.0, 1.0);
+        if (q == 0.0) {
+            result[i] = min_;
+            continue;
+        }
+        if (q == 1.0) {
+            result[i] = max_;
+            continue;
+        }
+        // Первое значение, накопленный вес которого достигает q * count_
+        double target = q * static_cast<double>(count_);
+        uint64_t cumulative = 0;
+        result[i] = max_;
+        for (const auto& [value, weight] : weighted) {
+            cumulative += weight;
+            if (static_cast<double>(cumulative) >= target) {
+                result[i] = value;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+size_t QuantileSketch::Capacity(size_t level) const {
+    // Верхний уровень вмещает k значений, каждый следующий вниз - в 1.5 раза меньше
+    size_t depth = levels_.size() - 1 - level;
+    auto capacity = static_cast<size_t>(std::ceil(k_ * std::pow(2.0 / 3.0, static_cast<double>(depth))));
+    return std::max(capacity, MIN_LEVEL_CAPACITY);
+}
+
+size_t QuantileSketch::TotalCapacity() const {
+    size_t result = 0;
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        result += Capacity(level);
+    }
+    return result;
+}
+
+void QuantileSketch::Compress() {
+    // Пока сумма уровней не укладывается в общую вместимость, сжимается нижний
+    // переполненный уровень: нижние уровни копят значения дольше, и точность выше
+    while (retained_ >= TotalCapacity()) {
+        size_t level = 0;
+        while (levels_[level].size() < Capacity(level)) {
+            ++level;
+        }
+        if (level + 1 == levels_.size()) {
+            levels_.emplace_back();
+        }
+
+        auto& current = levels_[level];
+        auto& next = levels_[level + 1];
+        std::sort(current.begin(), current.end());
+        // При нечётном размере наименьшее значение остаётся на уровне: вес сохраняется точно
+        size_t keep = current.size() % 2;
+        // Строгое чередование смещает оценку, если сжатия уровней идут в одном ритме
+        coin_state_ = Mix(coin_state_ + 0x9e3779b97f4a7c15ull);
+        size_t before = next.size();
+        for (size_t i = keep + (coin_state_ & 1); i < current.size(); i += 2) {
+            next.push_back(current[i]);
+        }
+        retained_ -= current.size() - keep - (next.size() - before);
+        current.resize(keep);
+    }
+}
+
+} // namespace analytics
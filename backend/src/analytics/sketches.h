@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace analytics {
+
+// 64-битный хеш call_id для HyperLogLog (FNV-1a с перемешиванием из MurmurHash3),
+// одинаковый во всех процессах и сборках
+uint64_t HashCallId(std::string_view call_id) noexcept;
+
+// Оценка числа различных значений: 2^PRECISION однобайтовых регистров,
+// относительная ошибка около 1.04 / sqrt(2^PRECISION) = 1.6%.
+// Регистры выделяются при первом Add(): пустая группа не занимает памяти.
+// Merge() - поэлементный максимум, результат не зависит от порядка слияния
+class HyperLogLog {
+public:
+    static constexpr unsigned PRECISION = 12;
+    static constexpr size_t REGISTERS = size_t{1} << PRECISION;
+
+    void Add(uint64_t hash);
+    void Merge(const HyperLogLog& other);
+    uint64_t Estimate() const;
+
+private:
+    std::vector<uint8_t> registers_;
+};
+
+// Квантили по потоку целых значений (KLL: Karnin, Lang, Liberty).
+// Уровень h хранит значения с весом 2^h; заполненный уровень сортируется,
+// и каждое второе значение переходит на следующий уровень. Вместимость уровней
+// убывает геометрически от верхнего к нижнему, поэтому память O(k) независимо от
+// числа значений, ошибка ранга - порядка 1.7 / k. Чётные или нечётные значения выбираются
+// псевдослучайно с фиксированным зерном: одинаковый поток даёт одинаковый результат
+class QuantileSketch {
+public:
+    static constexpr uint32_t DEFAULT_K = 200;
+
+    explicit QuantileSketch(uint32_t k = DEFAULT_K);
+
+    void Add(int64_t value);
+    void Merge(const QuantileSketch& other);
+
+    uint64_t Count() const noexcept {
+        return count_;
+    }
+
+    // Точные наименьшее и наибольшее значения; у пустого - 0
+    int64_t Min() const noexcept;
+    int64_t Max() const noexcept;
+
+    // Значения рангов qs (0..1) за одну сортировку; у пустого - нули
+    std::vector<int64_t> Quantiles(const std::vector<double>& qs) const;
+
+    // Сколько значений хранится сейчас (для оценки памяти)
+    size_t Retained() const noexcept {
+        return retained_;
+    }
+
+private:
+    size_t Capacity(size_t level) const;
+    size_t TotalCapacity() const;
+    void Compress();
+
+    uint32_t k_;
+    uint64_t count_ = 0;
+    size_t retained_ = 0;
+    int64_t min_ = 0;
+    int64_t max_ = 0;
+    uint64_t coin_state_ = 0;
+    std::vector<std::vector<int64_t>> levels_;
+};
+
+} // namespace analytics
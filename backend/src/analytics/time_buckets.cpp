@@ -0,0 +1,212 @@
+#include "time_buckets.h"
+#include "../domain/timestamp.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace analytics {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int64_t MICROS_PER_MINUTE = 60 * domain::MICROS_PER_SECOND;
+constexpr int64_t MICROS_PER_WEEK = 7 * domain::MICROS_PER_DAY;
+// 1970-01-01 - четверг, ближайший понедельник - 1970-01-05
+constexpr int64_t WEEK_ORIGIN = 4 * domain::MICROS_PER_DAY;
+// Не больше, чем MAX_BUCKETS недель: длина шага не переполняет int64
+constexpr int64_t MAX_STEP_COUNT = 100000;
+
+int64_t UnitMicros(StepUnit unit) {
+    switch (unit) {
+        case StepUnit::MINUTE:
+            return MICROS_PER_MINUTE;
+        case StepUnit::HOUR:
+            return domain::MICROS_PER_HOUR;
+        case StepUnit::DAY:
+            return domain::MICROS_PER_DAY;
+        case StepUnit::WEEK:
+            return MICROS_PER_WEEK;
+        case StepUnit::MONTH:
+            break;
+    }
+    return 0;
+}
+
+} // namespace
+
+std::optional<TimeStep> ParseTimeStep(std::string_view text) {
+    TimeStep step;
+    size_t pos = 0;
+    if (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+        step.count = 0;
+        for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+            step.count = step.count * 10 + (text[pos] - '0');
+            if (step.count > MAX_STEP_COUNT) {
+                return std::nullopt;
+            }
+        }
+    }
+    if (step.count == 0) {
+        return std::nullopt;
+    }
+
+    std::string_view unit = text.substr(pos);
+    if (unit == "m"sv || unit == "min"sv || unit == "minute"sv) {
+        step.unit = StepUnit::MINUTE;
+    }
+    else if (unit == "h"sv || unit == "hour"sv) {
+        step.unit = StepUnit::HOUR;
+    }
+    else if (unit == "d"sv || unit == "day"sv) {
+        step.unit = StepUnit::DAY;
+    }
+    else if (unit == "w"sv || unit == "week"sv) {
+        step.unit = StepUnit::WEEK;
+    }
+    else if (unit == "mo"sv || unit == "month"sv) {
+        step.unit = StepUnit::MONTH;
+    }
+    else {
+        return std::nullopt;
+    }
+    return step;
+}
+
+std::string ToString(const TimeStep& step) {
+    std::string result = std::to_string(step.count);
+    switch (step.unit) {
+        case StepUnit::MINUTE:
+            return result + "m"s;
+        case StepUnit::HOUR:
+            return result + "h"s;
+        case StepUnit::DAY:
+            return result + "d"s;
+        case StepUnit::WEEK:
+            return result + "w"s;
+        case StepUnit::MONTH:
+            return result + "mo"s;
+    }
+    return result;
+}
+
+std::optional<int64_t> ParseUtcOffset(std::string_view text) {
+    if (text.empty() || text == "UTC"sv || text == "utc"sv || text == "Z"sv || text == "z"sv) {
+        return 0;
+    }
+    if (text.size() > 3 && (text.substr(0, 3) == "UTC"sv || text.substr(0, 3) == "utc"sv)) {
+        text.remove_prefix(3);
+    }
+    // Неэкранированный '+' в query string приходит после декодирования URL пробелом
+    if (text.empty() || (text[0] != '+' && text[0] != '-' && text[0] != ' ')) {
+        return std::nullopt;
+    }
+    int sign = text[0] == '-' ? -1 : 1;
+    text.remove_prefix(1);
+
+    // Часы - одна или две цифры, минуты - через двоеточие или сразу за двумя цифрами часов
+    auto digits = [&text](size_t max_width, int& out) {
+        size_t width = 0;
+        out = 0;
+        while (width < max_width && width < text.size() && text[width] >= '0' && text[width] <= '9') {
+            out = out * 10 + (text[width] - '0');
+            ++width;
+        }
+        text.remove_prefix(width);
+        return width;
+    };
+
+    int hours = 0;
+    int minutes = 0;
+    size_t hour_width = digits(2, hours);
+    if (hour_width == 0) {
+        return std::nullopt;
+    }
+    if (!text.empty()) {
+        if (text[0] == ':') {
+            text.remove_prefix(1);
+        }
+        else if (hour_width != 2) {
+            return std::nullopt;
+        }
+        if (digits(2, minutes) != 2 || !text.empty()) {
+            return std::nullopt;
+        }
+    }
+    if (hours > 15 || minutes > 59) {
+        return std::nullopt;
+    }
+    return sign * (hours * domain::MICROS_PER_HOUR + minutes * MICROS_PER_MINUTE);
+}
+
+std::string FormatUtcOffset(int64_t offset_us) {
+    int64_t minutes = (offset_us < 0 ? -offset_us : offset_us) / MICROS_PER_MINUTE;
+    char result[6] = {offset_us < 0 ? '-' : '+',
+                      static_cast<char>('0' + minutes / 600),
+                      static_cast<char>('0' + minutes / 60 % 10),
+                      ':',
+                      static_cast<char>('0' + minutes % 60 / 10),
+                      static_cast<char>('0' + minutes % 10)};
+    return std::string(result, sizeof(result));
+}
+
+TimeBuckets::TimeBuckets(int64_t from, int64_t to, TimeStep step, int64_t tz_offset)
+    : step_(step)
+    , tz_offset_(tz_offset)
+    , step_us_(step.unit == StepUnit::MONTH ? 0 : step.count * UnitMicros(step.unit)) {
+    if (from >= to) {
+        throw std::invalid_argument("Начало интервала должно быть раньше конца"s);
+    }
+    if (step.count < 1 || step.count > MAX_STEP_COUNT) {
+        throw std::invalid_argument("Недопустимый шаг временного ряда"s);
+    }
+
+    int64_t first = Number(from);
+    int64_t last = Number(to - 1);
+    if (last - first >= static_cast<int64_t>(MAX_BUCKETS)) {
+        throw std::invalid_argument("Слишком много точек временного ряда: не больше "s
+                                    + std::to_string(MAX_BUCKETS) + ", увеличьте шаг"s);
+    }
+
+    starts_.reserve(static_cast<size_t>(last - first) + 2);
+    for (int64_t number = first; number <= last + 1; ++number) {
+        starts_.push_back(StartOf(number));
+    }
+}
+
+size_t TimeBuckets::IndexOf(int64_t time) const noexcept {
+    if (step_us_ != 0) {
+        return static_cast<size_t>((time - From()) / step_us_);
+    }
+    return static_cast<size_t>(std::upper_bound(starts_.begin(), starts_.end(), time) - starts_.begin()) - 1;
+}
+
+bool TimeBuckets::HourAligned() const noexcept {
+    return tz_offset_ % domain::MICROS_PER_HOUR == 0 && step_us_ % domain::MICROS_PER_HOUR == 0;
+}
+
+int64_t TimeBuckets::Number(int64_t time) const {
+    int64_t local = time + tz_offset_;
+    if (step_us_ != 0) {
+        int64_t origin = step_.unit == StepUnit::WEEK ? WEEK_ORIGIN : 0;
+        return domain::FloorDiv(local - origin, step_us_);
+    }
+
+    domain::CivilDate date = domain::CivilFromDays(domain::FloorDiv(local, domain::MICROS_PER_DAY));
+    int64_t month = static_cast<int64_t>(date.year) * 12 + date.month - 1;
+    return domain::FloorDiv(month, step_.count);
+}
+
+int64_t TimeBuckets::StartOf(int64_t number) const {
+    if (step_us_ != 0) {
+        int64_t origin = step_.unit == StepUnit::WEEK ? WEEK_ORIGIN : 0;
+        return number * step_us_ + origin - tz_offset_;
+    }
+
+    int64_t month = number * step_.count;
+    int64_t year = domain::FloorDiv(month, 12);
+    auto month_of_year = static_cast<unsigned>(month - year * 12 + 1);
+    return domain::DaysFromCivil(static_cast<int>(year), month_of_year, 1) * domain::MICROS_PER_DAY - tz_offset_;
+}
+
+} // namespace analytics
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace analytics {
+
+// Единица шага временного ряда
+enum class StepUnit {
+    MINUTE,
+    HOUR,
+    DAY,
+    WEEK,  // с понедельника
+    MONTH
+};
+
+struct TimeStep {
+    StepUnit unit = StepUnit::HOUR;
+    int64_t count = 1;
+};
+
+// "15m", "1h", "1d", "1w", "1mo" (кварталы и годы - "3mo" и "12mo"); число можно опустить.
+// nullopt - строка не является шагом
+std::optional<TimeStep> ParseTimeStep(std::string_view text);
+std::string ToString(const TimeStep& step);
+
+// Фиксированное смещение от UTC в микросекундах: "UTC", "Z", "+03:00", "-0530", "+3".
+// Именованные пояса (Europe/Moscow) не поддерживаются: в сборке нет базы tz
+std::optional<int64_t> ParseUtcOffset(std::string_view text);
+// "+03:00", "-05:30"
+std::string FormatUtcOffset(int64_t offset_us);
+
+// Разбиение [from, to) на интервалы шага step по местному времени пояса со смещением tz_offset.
+// Границы расширяются до целых интервалов: первый начинается не позже from, последний
+// заканчивается не раньше to. Интервалы выровнены от эпохи местного времени (недели -
+// от понедельника, месяцы - от начала года), номер интервала считается целочисленно
+class TimeBuckets {
+public:
+    static constexpr size_t MAX_BUCKETS = 100000;
+
+    // std::invalid_argument: пустой интервал, недопустимый шаг или больше MAX_BUCKETS интервалов
+    TimeBuckets(int64_t from, int64_t to, TimeStep step, int64_t tz_offset);
+
+    size_t Size() const noexcept {
+        return starts_.size() - 1;
+    }
+
+    // Начало интервала (UTC, микросекунды); Start(Size()) - конец последнего
+    int64_t Start(size_t index) const noexcept {
+        return starts_[index];
+    }
+
+    int64_t From() const noexcept {
+        return starts_.front();
+    }
+
+    int64_t To() const noexcept {
+        return starts_.back();
+    }
+
+    // Номер интервала момента time; nullopt - вне [From(), To())
+    std::optional<size_t> Find(int64_t time) const noexcept {
+        if (time < From() || time >= To()) {
+            return std::nullopt;
+        }
+        return IndexOf(time);
+    }
+
+    // Номер интервала момента time из [From(), To())
+    size_t IndexOf(int64_t time) const noexcept;
+
+    const TimeStep& Step() const noexcept {
+        return step_;
+    }
+
+    int64_t TzOffset() const noexcept {
+        return tz_offset_;
+    }
+
+    // Длина интервала в микросекундах; 0 - шаг в месяцах (длина меняется)
+    int64_t FixedStep() const noexcept {
+        return step_us_;
+    }
+
+    // Все границы интервалов совпадают с границами часов UTC
+    bool HourAligned() const noexcept;
+
+private:
+    // Номер интервала, в который попадает момент time, и начало интервала с номером number
+    int64_t Number(int64_t time) const;
+    int64_t StartOf(int64_t number) const;
+
+    TimeStep step_;
+    int64_t tz_offset_;
+    int64_t step_us_ = 0;
+    std::vector<int64_t> starts_; // Size() + 1 границ
+};
+
+} // namespace analytics
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace analytics {
+
+// Оставляет в items первые k элементов в порядке better (как после std::sort и усечения).
+// nth_element отделяет k лучших за O(n), сортируются только они: O(n + k log k)
+template <typename T, typename Better>
+void SelectTop(std::vector<T>& items, size_t k, Better better) {
+    if (k < items.size()) {
+        std::nth_element(items.begin(), items.begin() + static_cast<std::ptrdiff_t>(k), items.end(), better);
+        items.resize(k);
+    }
+    std::sort(items.begin(), items.end(), better);
+}
+
+// k лучших элементов потока в порядке better: куча с худшим из отобранных в вершине,
+// O(log k) на элемент и O(k) памяти. better должен задавать строгий полный порядок,
+// тогда результат не зависит от порядка добавления и разбиения потока на части
+template <typename T, typename Better>
+class TopK {
+public:
+    explicit TopK(size_t k, Better better = {})
+        : k_(k)
+        , better_(std::move(better)) {
+        heap_.reserve(k_);
+    }
+
+    // Элемент войдёт в отобранные; позволяет не заполнять дорогие поля у отброшенных
+    bool Accepts(const T& item) const {
+        return k_ > 0 && (heap_.size() < k_ || better_(item, heap_.front()));
+    }
+
+    void Push(T item) {
+        if (!Accepts(item)) {
+            return;
+        }
+        if (heap_.size() == k_) {
+            std::pop_heap(heap_.begin(), heap_.end(), better_);
+            heap_.back() = std::move(item);
+        }
+        else {
+            heap_.push_back(std::move(item));
+        }
+        std::push_heap(heap_.begin(), heap_.end(), better_);
+    }
+
+    void Merge(const TopK& other) {
+        for (const auto& item : other.heap_) {
+            Push(item);
+        }
+    }
+
+    // Первые limit отобранных по порядку better
+    std::vector<T> Sorted(size_t limit) const {
+        std::vector<T> result = heap_;
+        SelectTop(result, limit, better_);
+        return result;
+    }
+
+    size_t Capacity() const noexcept {
+        return k_;
+    }
+
+    size_t Size() const noexcept {
+        return heap_.size();
+    }
+
+private:
+    size_t k_;
+    Better better_;
+    std::vector<T> heap_;
+};
+
+} // namespace analytics
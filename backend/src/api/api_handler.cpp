@@ -1,17 +1,143 @@
 #include "api_handler.h"
+#include "../app/reference_cache.h"
+#include "../app/call_ingest_queue.h"
+#include "../app/rerate_job.h"
+#include "../app/call_store.h"
+#include "../app/call_aggregates.h"
+#include "../app/analytics_cache.h"
 #include "../call_simulator/call_generator.h"
+#include "../ingest/cdr_decoder.h"
+#include "../rating/rater.h"
+#include "../topology/topology.h"
 #include "../sync/thread_loader.h"
 #include "../analytics/analytics.h"
+#include "../domain/timestamp.h"
 #include "../config/dynamic_config.h"
 #include "../logger/logger.h"
 
 #include <pqxx/pqxx>
 
 #include <algorithm>
+#include <cctype>
 #include <string>
 #include <chrono>
 
 namespace {
+using namespace std::literals;
+
+// Сколько ошибок по отдельным записям возвращать в ответе /api/ingest/calls
+constexpr size_t MAX_REPORTED_INGEST_ERRORS = 100;
+
+// Ответ 503, когда очередь не подтвердила фиксацию звонков за ingest.commit_timeout_ms
+std::string CommitTimeoutMessage(int queued) {
+    return "Запись в БД не подтверждена вовремя, "s + std::to_string(queued)
+           + " звонков остаются в очереди и будут записаны позже"s;
+}
+
+// Рейтинги /api/analytics: размер по умолчанию и наибольший
+constexpr size_t DEFAULT_TOP_LIMIT = 20;
+constexpr size_t MAX_TOP_LIMIT = 1000;
+
+// Последние звонки в /api/dashboard/snapshot по умолчанию
+constexpr size_t DEFAULT_RECENT_CALLS = 100;
+
+// Конец окна /api/analytics/trunk-utilization по умолчанию округляется вниз до минуты:
+// иначе каждый запрос получал бы свой ключ кэша
+constexpr int64_t UTILIZATION_WINDOW_ALIGN_US = 60 * domain::MICROS_PER_SECOND;
+
+// Ключ кэша ответов аналитики: эндпоинт и параметры в фиксированном порядке
+std::string CacheKey(std::string_view endpoint, std::initializer_list<std::string> params) {
+    std::string key(endpoint);
+    for (const auto& param : params) {
+        key += '|';
+        key += param;
+    }
+    return key;
+}
+
+// Время параметра в микросекундах: разные записи одного момента дают один ключ
+std::string TimeKey(const std::optional<std::string>& time) {
+    if (!time) {
+        return {};
+    }
+    auto parsed = domain::ParseTimestamp(*time);
+    return parsed ? std::to_string(*parsed) : *time;
+}
+
+std::string LimitKey(std::optional<size_t> limit) {
+    return limit ? std::to_string(*limit) : std::string{};
+}
+
+// Группы аналитики уже отсортированы по выручке: первые limit - топ
+template <typename T>
+void KeepFirst(std::vector<T>& items, std::optional<size_t> limit) {
+    if (limit && *limit < items.size()) {
+        items.erase(items.begin() + static_cast<std::ptrdiff_t>(*limit), items.end());
+    }
+}
+
+// Сильный ETag по содержимому ответа (FNV-1a): совпадает у одинаковых тел
+// независимо от процесса, поэтому переживает перезапуск и балансировку
+std::string ETagOf(std::string_view body) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : body) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream out;
+    out << '"' << std::hex << std::setw(16) << std::setfill('0') << hash << '"';
+    return out.str();
+}
+
+// If-None-Match: список ETag через запятую или "*"; слабое сравнение (префикс W/ не учитывается)
+bool MatchesETag(std::string_view header, std::string_view etag) {
+    while (!header.empty()) {
+        size_t comma_pos = header.find(',');
+        std::string_view item = header.substr(0, comma_pos);
+        header = comma_pos == std::string_view::npos ? std::string_view{} : header.substr(comma_pos + 1);
+
+        while (!item.empty() && item.front() == ' ') {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && item.back() == ' ') {
+            item.remove_suffix(1);
+        }
+        if (item.substr(0, 2) == "W/"sv) {
+            item.remove_prefix(2);
+        }
+        if (item == "*"sv || item == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Число записей справочников: общий раздел /api/system/stats и /api/dashboard/snapshot
+boost::json::value ReferenceCountsToJson(const app::ReferenceData& reference) {
+    auto active = [](const auto& items) {
+        return static_cast<int>(std::count_if(items.begin(), items.end(), [](const auto& item) {
+            return item.is_active;
+        }));
+    };
+
+    return {
+        {"hubs"s, {
+            {"total"s, static_cast<int>(reference.hubs.size())},
+            {"active"s, active(reference.hubs)}
+        }},
+        {"servers"s, {
+            {"total"s, static_cast<int>(reference.servers.size())},
+            {"active"s, active(reference.servers)}
+        }},
+        {"trunks"s, static_cast<int>(reference.trunks.size())},
+        {"nas_ips"s, static_cast<int>(reference.nas_ips.size())},
+        {"tarifs"s, static_cast<int>(reference.tarifs.size())},
+        {"pricelists"s, {
+            {"total"s, static_cast<int>(reference.pricelists.size())},
+            {"active"s, active(reference.pricelists)}
+        }}
+    };
+}
 
 std::string CleanErrorMessage(const std::string& message) {
     std::string cleaned_message = message;
@@ -27,10 +153,122 @@ std::string CleanErrorMessage(const std::string& message) {
     return cleaned_message;
 }
 
+boost::json::value IngestQueueMetricsToJson() {
+    auto metrics = app::g_call_ingest_queue.GetMetrics();
+
+    return {
+        {"running"s, app::g_call_ingest_queue.IsRunning()},
+        {"depth"s, metrics.depth},
+        {"capacity"s, metrics.capacity},
+        {"enqueued"s, metrics.enqueued},
+        {"written"s, metrics.written},
+        {"failed"s, metrics.failed},
+        {"rejected"s, metrics.rejected},
+        {"flushes"s, metrics.flushes},
+        {"flush_errors"s, metrics.flush_errors},
+        {"last_flush_ms"s, metrics.last_flush_ms},
+        {"avg_flush_ms"s, metrics.avg_flush_ms},
+        {"max_flush_ms"s, metrics.max_flush_ms},
+        {"spooled"s, metrics.spooled}
+    };
+}
+
+boost::json::value CallSpoolStatsToJson() {
+    auto stats = app::g_call_ingest_queue.GetSpoolStats();
+    if (!stats) {
+        return nullptr;
+    }
+
+    return {
+        {"path"s, stats->path},
+        {"used_bytes"s, stats->used_bytes},
+        {"capacity_bytes"s, stats->capacity_bytes},
+        {"records"s, stats->records},
+        {"oldest_age_seconds"s, stats->oldest_age_seconds},
+        {"max_age_seconds"s, stats->max_age_seconds},
+        {"appended"s, stats->appended},
+        {"replayed"s, stats->replayed},
+        {"expired"s, stats->expired},
+        {"rejected"s, stats->rejected},
+        {"corrupted"s, stats->corrupted}
+    };
+}
+
+boost::json::value CallAggregatesStatsToJson() {
+    if (!app::g_call_aggregates.IsRunning()) {
+        return nullptr;
+    }
+
+    auto stats = app::g_call_aggregates.GetStats();
+    return {
+        {"ready"s, stats.ready},
+        {"watermark"s, stats.watermark},
+        {"cells"s, stats.cells},
+        {"hours"s, stats.hours},
+        {"leader_days"s, stats.leader_days},
+        {"applied_calls"s, stats.applied_calls},
+        {"late_calls"s, stats.late_calls},
+        {"rebuilds"s, stats.rebuilds},
+        {"checkpoints"s, stats.checkpoints},
+        {"restored"s, stats.restored},
+        {"errors"s, stats.errors},
+        {"last_refresh_ms"s, stats.last_refresh_ms},
+        {"last_error"s, stats.last_error}
+    };
+}
+
+boost::json::value AnalyticsCacheMetricsToJson() {
+    auto metrics = app::g_analytics_cache.GetMetrics();
+    uint64_t lookups = metrics.hits + metrics.misses + metrics.coalesced;
+
+    return {
+        {"hits"s, metrics.hits},
+        {"misses"s, metrics.misses},
+        {"coalesced"s, metrics.coalesced},
+        {"bypassed"s, metrics.bypassed},
+        {"hit_ratio"s, lookups > 0 ? static_cast<double>(metrics.hits + metrics.coalesced) / lookups : 0.0},
+        {"evictions"s, metrics.evictions},
+        {"invalidations"s, metrics.invalidations},
+        {"errors"s, metrics.errors},
+        {"entries"s, metrics.entries},
+        {"bytes"s, metrics.bytes},
+        {"max_bytes"s, metrics.max_bytes}
+    };
+}
+
+boost::json::value CallStoreStatsToJson() {
+    if (!app::g_call_store.IsRunning()) {
+        return nullptr;
+    }
+
+    auto stats = app::g_call_store.GetStats();
+    return {
+        {"ready"s, stats.ready},
+        {"rows"s, stats.rows},
+        {"chunks"s, stats.chunks},
+        {"memory_bytes"s, stats.memory_bytes},
+        {"watermark"s, stats.watermark},
+        {"covered_from"s, stats.ready ? boost::json::value(domain::FormatTimestamp(stats.covered_from)) : nullptr},
+        {"refreshes"s, stats.refreshes},
+        {"full_reloads"s, stats.full_reloads},
+        {"late_calls"s, stats.late_calls},
+        {"errors"s, stats.errors},
+        {"last_refresh_ms"s, stats.last_refresh_ms},
+        {"last_error"s, stats.last_error}
+    };
+}
+
 } // namespace
 
 namespace api_handler {
 
+db::Application& GetSharedApplication() {
+    // Если БД недоступна, конструктор бросит исключение, и инициализация
+    // повторится при следующем запросе
+    static db::Application application{GetConfigFromEnv()};
+    return application;
+}
+
 bool ApiHandler::CheckEndPath() {
     return req_info_.target == "/"sv || req_info_.target.empty();
 }
@@ -61,6 +299,101 @@ std::string ApiHandler::GetIdFromTarget(const std::string& target) {
     return target.substr(last_slash_pos + 1);
 }
 
+std::optional<std::string> ApiHandler::GetQueryParam(std::string_view name) const {
+    std::string_view query = req_info_.query;
+
+    while (!query.empty()) {
+        size_t amp_pos = query.find('&');
+        std::string_view pair = query.substr(0, amp_pos);
+        query = amp_pos == std::string_view::npos ? std::string_view{} : query.substr(amp_pos + 1);
+
+        size_t eq_pos = pair.find('=');
+        if (pair.substr(0, eq_pos) != name) {
+            continue;
+        }
+        if (eq_pos == std::string_view::npos) {
+            return ""s;
+        }
+
+        // Target уже декодирован в http_server (DecodeURL), повторно не декодируем:
+        // иначе '+' из %2B в смещении часового пояса превратился бы в пробел
+        return std::string(pair.substr(eq_pos + 1));
+    }
+
+    return std::nullopt;
+}
+
+domain::TimeRange ApiHandler::GetTimeRangeParams() const {
+    // Границы приводятся к UTC с явным смещением: время без пояса иначе
+    // читалось бы в БД в часовом поясе сессии, а в памяти - как UTC
+    auto bound = [this](std::string_view name) -> std::optional<std::string> {
+        auto value = GetQueryParam(name);
+        if (!value || value->empty()) {
+            return std::nullopt;
+        }
+        return domain::FormatTimestamp(GetTimestampParam(name, 0));
+    };
+
+    domain::TimeRange range;
+    range.from = bound("from"sv);
+    range.to = bound("to"sv);
+    return range;
+}
+
+int64_t ApiHandler::GetTimestampParam(std::string_view name, int64_t fallback) const {
+    auto value = GetQueryParam(name);
+    if (!value || value->empty()) {
+        return fallback;
+    }
+    auto time = domain::ParseTimestamp(*value);
+    if (!time) {
+        throw std::invalid_argument(std::string(name) + ": ожидается время YYYY-MM-DDTHH:MM:SS[±HH:MM]"s);
+    }
+    return *time;
+}
+
+std::optional<size_t> ApiHandler::GetLimitParam(size_t max_limit) const {
+    auto value = GetQueryParam("limit"sv);
+    if (!value || value->empty()) {
+        return std::nullopt;
+    }
+    size_t parsed = 0;
+    long long limit = 0;
+    try {
+        limit = std::stoll(*value, &parsed);
+    }
+    catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (parsed != value->size() || limit < 1 || static_cast<unsigned long long>(limit) > max_limit) {
+        throw std::invalid_argument("limit: ожидается целое число от 1 до "s + std::to_string(max_limit));
+    }
+    return static_cast<size_t>(limit);
+}
+
+std::vector<int> ApiHandler::GetIdListParam(std::string_view name) const {
+    std::vector<int> ids;
+    auto value = GetQueryParam(name);
+    if (!value) {
+        return ids;
+    }
+
+    std::string_view list = *value;
+    while (!list.empty()) {
+        size_t comma_pos = list.find(',');
+        std::string item(list.substr(0, comma_pos));
+        list = comma_pos == std::string_view::npos ? std::string_view{} : list.substr(comma_pos + 1);
+
+        size_t parsed = 0;
+        int id = std::stoi(item, &parsed);
+        if (parsed != item.size()) {
+            throw std::invalid_argument(std::string(name) + " must be a list of integers"s);
+        }
+        ids.push_back(id);
+    }
+    return ids;
+}
+
 void ApiHandler::HandleApiResponse() {
     // Обрабатываем OPTIONS запросы для всех путей (CORS preflight)
     if (req_info_.method == http::verb::options) {
@@ -81,6 +414,12 @@ void ApiHandler::HandleApiResponse() {
     else if (path_part == "/simulate"s) {
         HandleSimulate();
     }
+    else if (path_part == "/ingest"s) {
+        HandleIngest();
+    }
+    else if (path_part == "/rerate"s) {
+        HandleRerate();
+    }
     else if (path_part == "/sync"s) {
         HandleSync();
     }
@@ -90,6 +429,9 @@ void ApiHandler::HandleApiResponse() {
     else if (path_part == "/analytics"s) {
         HandleAnalytics();
     }
+    else if (path_part == "/dashboard"s) {
+        HandleDashboard();
+    }
     else if (path_part == "/config"s) {
         HandleConfig();
     }
@@ -240,11 +582,12 @@ void ApiHandler::HandleSimulateCalls() {
         
         LOG_INFO("Starting call simulation: " + std::to_string(call_count) + " calls");
 
-        auto hubs = application_.GetUseCases().GetHubs();
-        auto servers = application_.GetUseCases().GetServers();
-        auto trunks = application_.GetUseCases().GetTrunks();
-        auto tarifs = application_.GetUseCases().GetTarifs();
-        auto pricelists = application_.GetUseCases().GetPricelists();
+        auto reference = application_.GetUseCases().GetReferenceData();
+        const auto& hubs = reference->hubs;
+        const auto& servers = reference->servers;
+        const auto& trunks = reference->trunks;
+        const auto& tarifs = reference->tarifs;
+        const auto& pricelists = reference->pricelists;
 
         if (hubs.empty() || servers.empty() || trunks.empty() ||
             tarifs.empty() || pricelists.empty()) {
@@ -255,39 +598,55 @@ void ApiHandler::HandleSimulateCalls() {
 
         call_simulator::CallGenerator generator;
         auto generated_calls = generator.GenerateBatch(
-            call_count, hubs, servers, trunks, tarifs, pricelists
+            call_count, *topology::GetTopology(reference), tarifs, *rating::GetRater(reference)
         );
 
-        int saved_count = 0;
+        std::vector<ui::detail::CallStatisticsInfo> calls;
+        calls.reserve(generated_calls.size());
         for (const auto& call : generated_calls) {
-            try {
-                ui::detail::CallStatisticsInfo call_info{
-                    0, // id будет автоматически сгенерирован БД
-                    call.call_id,
-                    call.trunk_id,
-                    call.tarif_id,
-                    call.duration_seconds,
-                    call.cost,
-                    call.call_time
-                };
-                application_.GetUseCases().AddCallStatistics(call_info);
-                saved_count++;
-            }
-            catch (const std::exception& e) {
-                // Логируем ошибку, но продолжаем
-                LOG_ERROR("Failed to save call " + call.call_id + ": " + std::string(e.what()));
-            }
+            calls.push_back({
+                0, // id будет автоматически сгенерирован БД
+                call.call_id,
+                call.trunk_id,
+                call.tarif_id,
+                call.duration_seconds,
+                call.cost,
+                call.call_time
+            });
+        }
+
+        auto [result, queued_count, rejected, timed_out, unavailable] = SaveCalls(calls);
+        if (rejected) {
+            return SendServiceUnavailableResponse("Очередь записи звонков переполнена, повторите позже"s,
+                                                  "ingestQueueFull"s);
+        }
+        if (timed_out) {
+            return SendServiceUnavailableResponse(CommitTimeoutMessage(queued_count), "ingestCommitTimeout"s);
+        }
+        if (unavailable) {
+            return SendServiceUnavailableResponse("БД недоступна, звонки не сохранены, повторите позже"s,
+                                                  "ingestUnavailable"s);
         }
 
+        for (const auto& error : result.errors) {
+            // Логируем ошибку, но остальные звонки уже сохранены
+            LOG_ERROR("Failed to save call " + calls[error.index].call_id + ": " + error.message);
+        }
+        int saved_count = static_cast<int>(result.inserted);
+
         json::value response = {
             {"success"s, true},
             {"message"s, "Calls generated successfully"s},
             {"requested"s, call_count},
             {"generated"s, static_cast<int>(generated_calls.size())},
-            {"saved"s, saved_count}
+            {"saved"s, saved_count},
+            {"queued"s, queued_count},
+            {"spooled"s, static_cast<int>(result.spooled)},
+            {"failed"s, static_cast<int>(result.errors.size())}
         };
 
-        LOG_INFO("Call simulation completed: " + std::to_string(saved_count) + " calls saved");
+        LOG_INFO("Call simulation completed: " + std::to_string(saved_count) + " calls saved, "
+                 + std::to_string(queued_count) + " queued");
         return SendOkResponse(json::serialize(response));
     }
     catch (const std::exception& e) {
@@ -298,6 +657,255 @@ void ApiHandler::HandleSimulateCalls() {
     SendBadRequestResponseDefault();
 }
 
+ApiHandler::SaveCallsResult ApiHandler::SaveCalls(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    auto cfg = config::g_config.Get();
+    SaveCallsResult saved;
+
+    if (app::g_call_ingest_queue.IsRunning()) {
+        // Звонки пишет фоновая очередь; при переполнении клиент повторяет запрос позже
+        auto ticket = application_.GetUseCases().EnqueueCallStatistics(calls);
+        if (!ticket) {
+            LOG_WARNING("Ingest queue is full, rejecting " + std::to_string(calls.size()) + " calls");
+            saved.rejected = true;
+            return saved;
+        }
+
+        if (cfg->ingest_durability == "committed"s) {
+            // Поток ввода-вывода не ждёт БД дольше таймаута: звонки остаются в очереди
+            auto timeout = std::chrono::milliseconds(std::max(cfg->ingest_commit_timeout_ms, 1));
+            if (ticket->wait_for(timeout) != std::future_status::ready) {
+                LOG_WARNING("Ingest commit not confirmed in " + std::to_string(timeout.count()) + " ms for "
+                            + std::to_string(calls.size()) + " calls");
+                saved.timed_out = true;
+                saved.queued = static_cast<int>(calls.size());
+                return saved;
+            }
+            try {
+                saved.result = ticket->get();
+            }
+            catch (const app::CallIngestQueue::Unavailable& e) {
+                LOG_ERROR("Ingest failed for " + std::to_string(calls.size()) + " calls: " + e.what());
+                saved.unavailable = true;
+            }
+        }
+        else {
+            saved.queued = static_cast<int>(calls.size());
+        }
+    }
+    else {
+        // Весь пакет уходит в БД через COPY частями по ingest.batch_size
+        saved.result = application_.GetUseCases().AddCallStatisticsBatch(
+            calls, static_cast<size_t>(std::max(cfg->ingest_batch_size, 1)));
+    }
+
+    return saved;
+}
+
+void ApiHandler::HandleIngest() {
+    std::string path_part = FindAndCutTarget(req_info_);
+
+    if (path_part == "/calls"s) {
+        HandleIngestCalls();
+    }
+    else {
+        SendNotFoundResponse();
+    }
+}
+
+void ApiHandler::HandleIngestCalls() {
+    if (req_info_.method != http::verb::post) {
+        return SendWrongMethodResponseAllowedPost("Wrong method"s, true);
+    }
+
+    try {
+        auto cfg = config::g_config.Get();
+
+        auto format = ingest::FormatFromContentType(req_info_.content_type);
+        if (!format) {
+            return SendBadRequestResponse(
+                "Content-Type должен быть application/x-ndjson или application/x-cdr-binary"s,
+                "unsupportedContentType"s);
+        }
+
+        ingest::CdrBatch batch;
+        try {
+            batch = ingest::Decode(*format, req_info_.body);
+        }
+        catch (const std::invalid_argument& e) {
+            return SendBadRequestResponse(e.what(), "invalidBatch"s);
+        }
+
+        if (batch.total > static_cast<size_t>(std::max(cfg->ingest_max_calls_per_request, 1))) {
+            return SendBadRequestResponse(
+                "Пакет не должен превышать "s + std::to_string(cfg->ingest_max_calls_per_request) + " звонков"s,
+                "tooManyCalls"s);
+        }
+
+        auto rater = rating::GetRater(application_.GetUseCases().GetReferenceData());
+        ingest::RateCalls(*rater, batch);
+
+        SaveCallsResult saved;
+        if (!batch.calls.empty()) {
+            saved = SaveCalls(batch.calls);
+            if (saved.rejected) {
+                return SendServiceUnavailableResponse("Очередь записи звонков переполнена, повторите позже"s,
+                                                      "ingestQueueFull"s);
+            }
+            if (saved.timed_out) {
+                return SendServiceUnavailableResponse(CommitTimeoutMessage(saved.queued), "ingestCommitTimeout"s);
+            }
+            if (saved.unavailable) {
+                return SendServiceUnavailableResponse("БД недоступна, звонки не сохранены, повторите позже"s,
+                                                      "ingestUnavailable"s);
+            }
+        }
+
+        // Ошибки БД приходят с номерами в batch.calls - переводим в номера входного пакета
+        for (const auto& error : saved.result.errors) {
+            batch.errors.push_back({batch.indexes[error.index], error.message});
+        }
+
+        json::array errors;
+        size_t reported = std::min(batch.errors.size(), MAX_REPORTED_INGEST_ERRORS);
+        errors.reserve(reported);
+        for (size_t i = 0; i < reported; ++i) {
+            errors.push_back({
+                {"index"s, batch.errors[i].index},
+                {"message"s, batch.errors[i].message}
+            });
+        }
+
+        json::value response = {
+            {"success"s, true},
+            {"received"s, batch.total},
+            {"accepted"s, batch.calls.size()},
+            {"rejected"s, batch.errors.size() - saved.result.errors.size()},
+            {"saved"s, saved.result.inserted},
+            {"queued"s, saved.queued},
+            {"spooled"s, saved.result.spooled},
+            {"failed"s, saved.result.errors.size()},
+            {"errors"s, std::move(errors)}
+        };
+
+        if (!batch.errors.empty()) {
+            LOG_WARNING("CDR ingest: " + std::to_string(batch.errors.size()) + " of "
+                        + std::to_string(batch.total) + " records rejected, first: "
+                        + batch.errors.front().message);
+        }
+        return SendOkResponse(json::serialize(response));
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("CDR ingest failed: " + std::string(e.what()));
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
+
+void ApiHandler::HandleRerate() {
+    std::string path_part = FindAndCutTarget(req_info_);
+
+    if (path_part == "/start"s) {
+        HandleRerateStart();
+    }
+    else if (path_part == "/status"s) {
+        HandleRerateStatus();
+    }
+    else if (path_part == "/cancel"s) {
+        HandleRerateCancel();
+    }
+    else {
+        SendNotFoundResponse();
+    }
+}
+
+void ApiHandler::HandleRerateStart() {
+    if (req_info_.method != http::verb::post) {
+        return SendWrongMethodResponseAllowedPost("Wrong method"s, true);
+    }
+
+    if (!app::g_rerate_job.IsRunning()) {
+        return SendServiceUnavailableResponse("Пересчёт стоимости не запущен"s, "rerateUnavailable"s);
+    }
+
+    try {
+        // Область пересчёта: ?tarif_id=1,2&pricelist_id=3&trunk_id=4&from=...&to=...
+        // Без параметров пересчитываются все звонки
+        app::RerateScope scope;
+        scope.tarif_ids = GetIdListParam("tarif_id"sv);
+        scope.trunk_ids = GetIdListParam("trunk_id"sv);
+        scope.time_range = GetTimeRangeParams();
+
+        auto pricelist_ids = GetIdListParam("pricelist_id"sv);
+        if (!pricelist_ids.empty()) {
+            auto reference = application_.GetUseCases().GetReferenceData();
+            for (const auto& tarif : reference->tarifs) {
+                if (std::find(pricelist_ids.begin(), pricelist_ids.end(), tarif.pricelist_id) != pricelist_ids.end()) {
+                    scope.tarif_ids.push_back(tarif.id);
+                }
+            }
+            if (scope.tarif_ids.empty() && scope.trunk_ids.empty()) {
+                return SendBadRequestResponse("По прайс-листам не найдено ни одного тарифа"s, "noTarifs"s);
+            }
+        }
+        scope.reason = "manual"s;
+
+        uint64_t job_id = app::g_rerate_job.Submit(std::move(scope));
+        if (job_id == 0) {
+            return SendServiceUnavailableResponse("Пересчёт стоимости не запущен"s, "rerateUnavailable"s);
+        }
+
+        json::value response = {
+            {"success"s, true},
+            {"job_id"s, job_id}
+        };
+        return SendOkResponse(json::serialize(response));
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
+
+void ApiHandler::HandleRerateStatus() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
+
+    auto progress = app::g_rerate_job.GetProgress();
+    double percent = progress.total == 0
+        ? (progress.state == app::RerateJob::State::DONE ? 100.0 : 0.0)
+        : std::min(100.0, 100.0 * static_cast<double>(progress.scanned) / static_cast<double>(progress.total));
+
+    json::value response = {
+        {"running"s, app::g_rerate_job.IsRunning()},
+        {"job_id"s, progress.job_id},
+        {"state"s, app::ToString(progress.state)},
+        {"reason"s, progress.reason},
+        {"total"s, progress.total},
+        {"scanned"s, progress.scanned},
+        {"updated"s, progress.updated},
+        {"skipped"s, progress.skipped},
+        {"percent"s, percent},
+        {"reference_version"s, progress.reference_version},
+        {"elapsed_seconds"s, progress.elapsed_seconds},
+        {"pending"s, progress.pending},
+        {"error"s, progress.error}
+    };
+    return SendOkResponse(json::serialize(response));
+}
+
+void ApiHandler::HandleRerateCancel() {
+    if (req_info_.method != http::verb::post) {
+        return SendWrongMethodResponseAllowedPost("Wrong method"s, true);
+    }
+
+    app::g_rerate_job.CancelCurrent();
+
+    json::value response = {
+        {"success"s, true},
+        {"message"s, "Cancellation requested"s}
+    };
+    return SendOkResponse(json::serialize(response));
+}
+
 void ApiHandler::HandleSync() {
     std::string path_part = FindAndCutTarget(req_info_);
 
@@ -450,9 +1058,9 @@ void ApiHandler::HandleSystemHealth() {
     }
 
     try {
-        // Проверяем доступность БД
-        auto hubs = application_.GetUseCases().GetHubs();
-        
+        // Проверяем доступность БД: справочники отдаются из кэша, поэтому - прямой запрос
+        application_.PingDatabase();
+
         auto now = std::chrono::system_clock::now();
         auto time_t_now = std::chrono::system_clock::to_time_t(now);
         std::stringstream ss;
@@ -482,53 +1090,24 @@ void ApiHandler::HandleSystemStats() {
 
     try {
         // Получаем статистику из БД
-        auto hubs = application_.GetUseCases().GetHubs();
-        auto servers = application_.GetUseCases().GetServers();
-        auto trunks = application_.GetUseCases().GetTrunks();
-        auto tarifs = application_.GetUseCases().GetTarifs();
-        auto pricelists = application_.GetUseCases().GetPricelists();
-        auto call_stats = application_.GetUseCases().GetCallStatistics();
-        auto nas_ips = application_.GetUseCases().GetNasIps();
-
-        // Подсчитываем активные элементы
-        int active_hubs = std::count_if(hubs.begin(), hubs.end(),
-            [](const ui::detail::HubInfo& h) { return h.is_active; });
-        int active_servers = std::count_if(servers.begin(), servers.end(),
-            [](const ui::detail::ServerInfo& s) { return s.is_active; });
-        int active_pricelists = std::count_if(pricelists.begin(), pricelists.end(),
-            [](const ui::detail::PricelistInfo& p) { return p.is_active; });
-
-        // Подсчитываем общую стоимость звонков
-        double total_revenue = 0.0;
-        int total_duration = 0;
-        for (const auto& call : call_stats) {
-            total_revenue += call.cost;
-            total_duration += call.duration_seconds;
-        }
+        auto reference = application_.GetUseCases().GetReferenceData();
+
+        // Итоги звонков - из поддерживаемых счётчиков, без обхода call_statistics
+        domain::CallTotals totals = application_.GetUseCases().GetCallTotals();
 
         json::value response = {
-            {"database"s, {
-                {"hubs"s, {
-                    {"total"s, static_cast<int>(hubs.size())},
-                    {"active"s, active_hubs}
-                }},
-                {"servers"s, {
-                    {"total"s, static_cast<int>(servers.size())},
-                    {"active"s, active_servers}
-                }},
-                {"trunks"s, static_cast<int>(trunks.size())},
-                {"nas_ips"s, static_cast<int>(nas_ips.size())},
-                {"tarifs"s, static_cast<int>(tarifs.size())},
-                {"pricelists"s, {
-                    {"total"s, static_cast<int>(pricelists.size())},
-                    {"active"s, active_pricelists}
-                }}
-            }},
+            {"database"s, ReferenceCountsToJson(*reference)},
+            {"ingest_queue"s, IngestQueueMetricsToJson()},
+            {"spool"s, CallSpoolStatsToJson()},
+            {"call_store"s, CallStoreStatsToJson()},
+            {"aggregates"s, CallAggregatesStatsToJson()},
+            {"analytics_cache"s, AnalyticsCacheMetricsToJson()},
+            {"analytics_kernel"s, analytics::ToString(analytics::ActiveGroupByKernel())},
             {"calls"s, {
-                {"total"s, static_cast<int>(call_stats.size())},
-                {"total_revenue"s, total_revenue},
-                {"total_duration_seconds"s, total_duration},
-                {"total_duration_minutes"s, total_duration / 60}
+                {"total"s, totals.calls},
+                {"total_revenue"s, totals.revenue.ToDouble()},
+                {"total_duration_seconds"s, totals.duration_seconds},
+                {"total_duration_minutes"s, totals.duration_seconds / 60}
             }}
         };
 
@@ -554,6 +1133,21 @@ void ApiHandler::HandleAnalytics() {
     else if (path_part == "/revenue"s) {
         HandleAnalyticsRevenue();
     }
+    else if (path_part == "/series"s) {
+        HandleAnalyticsTimeSeries();
+    }
+    else if (path_part == "/distribution-by-trunk"s) {
+        HandleAnalyticsDistribution(true);
+    }
+    else if (path_part == "/distribution-by-tarif"s) {
+        HandleAnalyticsDistribution(false);
+    }
+    else if (path_part == "/trunk-utilization"s) {
+        HandleAnalyticsTrunkUtilization();
+    }
+    else if (path_part == "/top-calls"s) {
+        HandleAnalyticsTopCalls();
+    }
     else {
         SendNotFoundResponse();
     }
@@ -565,87 +1159,252 @@ void ApiHandler::HandleAnalyticsCallsByTrunk() {
     }
 
     try {
-        auto calls = application_.GetUseCases().GetCallStatistics();
-        auto trunks = application_.GetUseCases().GetTrunks();
+        // Агрегация выполняется в БД, в память попадают только итоговые строки
+        auto range = GetTimeRangeParams();
+        auto limit = GetLimitParam(MAX_TOP_LIMIT);
+        return SendCachedResponse(CacheKey("calls-by-trunk"sv, {TimeKey(range.from), TimeKey(range.to), LimitKey(limit)}), [&] {
+            auto analytics = application_.GetUseCases().GetTrunkAnalytics(range);
+            KeepFirst(analytics, limit);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(analytics));
+        });
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
 
-        auto analytics = analytics::AnalyticsCalculator::CalculateByTrunk(calls, trunks);
-        json::value jv = analytics::AnalyticsCalculator::ToJson(analytics);
+void ApiHandler::HandleAnalyticsCallsByTarif() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
 
-        return SendOkResponse(json::serialize(jv));
+    try {
+        auto range = GetTimeRangeParams();
+        auto limit = GetLimitParam(MAX_TOP_LIMIT);
+        return SendCachedResponse(CacheKey("calls-by-tarif"sv, {TimeKey(range.from), TimeKey(range.to), LimitKey(limit)}), [&] {
+            auto analytics = application_.GetUseCases().GetTarifAnalytics(range);
+            KeepFirst(analytics, limit);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(analytics));
+        });
     }
     catch (const std::exception& e) {
         return SendBadRequestResponse(CleanErrorMessage(e.what()));
     }
 }
 
-void ApiHandler::HandleAnalyticsCallsByTarif() {
+void ApiHandler::HandleAnalyticsCallsByHub() {
     if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
         return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
     }
 
     try {
-        auto calls = application_.GetUseCases().GetCallStatistics();
-        auto tarifs = application_.GetUseCases().GetTarifs();
+        auto range = GetTimeRangeParams();
+        auto limit = GetLimitParam(MAX_TOP_LIMIT);
+        return SendCachedResponse(CacheKey("calls-by-hub"sv, {TimeKey(range.from), TimeKey(range.to), LimitKey(limit)}), [&] {
+            auto analytics = application_.GetUseCases().GetHubAnalytics(range);
+            KeepFirst(analytics, limit);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(analytics));
+        });
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
 
-        auto analytics = analytics::AnalyticsCalculator::CalculateByTarif(calls, tarifs);
-        json::value jv = analytics::AnalyticsCalculator::ToJson(analytics);
+void ApiHandler::HandleAnalyticsRevenue() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
 
-        return SendOkResponse(json::serialize(jv));
+    try {
+        // Получаем параметр period из query string (по умолчанию hour)
+        auto period = GetQueryParam("period"sv).value_or("hour"s) == "day"s
+                      ? analytics::RevenuePeriod::DAY
+                      : analytics::RevenuePeriod::HOUR;
+
+        auto range = GetTimeRangeParams();
+        std::string key = CacheKey("revenue"sv, {period == analytics::RevenuePeriod::DAY ? "day"s : "hour"s,
+                                                 TimeKey(range.from), TimeKey(range.to)});
+        return SendCachedResponse(key, [&] {
+            auto analytics = application_.GetUseCases().GetRevenueAnalytics(period, range);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(analytics));
+        });
     }
     catch (const std::exception& e) {
         return SendBadRequestResponse(CleanErrorMessage(e.what()));
     }
 }
 
-void ApiHandler::HandleAnalyticsCallsByHub() {
+void ApiHandler::HandleAnalyticsTimeSeries() {
     if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
         return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
     }
 
     try {
-        auto calls = application_.GetUseCases().GetCallStatistics();
-        auto hubs = application_.GetUseCases().GetHubs();
-        auto servers = application_.GetUseCases().GetServers();
-        auto trunks = application_.GetUseCases().GetTrunks();
+        // По умолчанию - последние сутки по часам в UTC
+        int64_t to = GetTimestampParam("to"sv, domain::NowTimestamp());
+        int64_t from = GetTimestampParam("from"sv, to - domain::MICROS_PER_DAY);
 
-        auto analytics = analytics::AnalyticsCalculator::CalculateByHub(calls, hubs, servers, trunks);
-        json::value jv = analytics::AnalyticsCalculator::ToJson(analytics);
+        auto step = analytics::ParseTimeStep(GetQueryParam("step"sv).value_or("1h"s));
+        if (!step) {
+            throw std::invalid_argument("step: ожидается шаг вида 15m, 1h, 1d, 1w, 1mo"s);
+        }
+        auto tz_offset = analytics::ParseUtcOffset(GetQueryParam("tz"sv).value_or("UTC"s));
+        if (!tz_offset) {
+            throw std::invalid_argument("tz: ожидается смещение от UTC вида +03:00 (именованные пояса не поддерживаются)"s);
+        }
 
-        return SendOkResponse(json::serialize(jv));
+        // Ключ - выровненные границы: запросы "за последние сутки" в пределах одного шага совпадают
+        analytics::TimeBuckets buckets(from, to, *step, *tz_offset);
+        std::string key = CacheKey("series"sv, {std::to_string(buckets.From()), std::to_string(buckets.To()),
+                                                analytics::ToString(*step), std::to_string(*tz_offset)});
+        return SendCachedResponse(key, [&] {
+            auto series = application_.GetUseCases().GetTimeSeries(buckets);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(buckets, series));
+        });
     }
     catch (const std::exception& e) {
         return SendBadRequestResponse(CleanErrorMessage(e.what()));
     }
 }
 
-void ApiHandler::HandleAnalyticsRevenue() {
+void ApiHandler::HandleAnalyticsDistribution(bool by_trunk) {
     if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
         return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
     }
 
     try {
-        auto calls = application_.GetUseCases().GetCallStatistics();
+        auto range = GetTimeRangeParams();
+        std::string key = CacheKey(by_trunk ? "distribution-by-trunk"sv : "distribution-by-tarif"sv,
+                                   {TimeKey(range.from), TimeKey(range.to)});
+        return SendCachedResponse(key, [&] {
+            auto analytics = by_trunk ? application_.GetUseCases().GetTrunkDistribution(range)
+                                      : application_.GetUseCases().GetTarifDistribution(range);
+            return json::serialize(analytics::AnalyticsCalculator::ToJson(analytics));
+        });
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
 
-        // Получаем параметр period из query string (по умолчанию hour)
-        std::string period = "hour";
-        size_t query_pos = req_info_.target.find('?');
-        if (query_pos != std::string::npos) {
-            std::string query = req_info_.target.substr(query_pos + 1);
-            if (query.find("period=day") != std::string::npos) {
-                period = "day";
+void ApiHandler::HandleAnalyticsTrunkUtilization() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
+
+    try {
+        // По умолчанию - сутки до последней целой минуты, насыщение - все каналы заняты
+        int64_t now = domain::FloorDiv(domain::NowTimestamp(), UTILIZATION_WINDOW_ALIGN_US) * UTILIZATION_WINDOW_ALIGN_US;
+        int64_t to = GetTimestampParam("to"sv, now);
+        int64_t from = GetTimestampParam("from"sv, to - domain::MICROS_PER_DAY);
+        double threshold = 1.0;
+        if (auto value = GetQueryParam("threshold"sv); value && !value->empty()) {
+            size_t parsed = 0;
+            threshold = std::stod(*value, &parsed);
+            if (parsed != value->size() || !(threshold > 0.0 && threshold <= 1.0)) {
+                throw std::invalid_argument("threshold: ожидается доля ёмкости в (0, 1]"s);
             }
         }
 
-        json::value jv;
-        if (period == "day") {
-            auto analytics = analytics::AnalyticsCalculator::CalculateRevenueByDay(calls);
-            jv = analytics::AnalyticsCalculator::ToJson(analytics);
-        } else {
-            auto analytics = analytics::AnalyticsCalculator::CalculateRevenueByHour(calls);
-            jv = analytics::AnalyticsCalculator::ToJson(analytics);
+        std::string key = CacheKey("trunk-utilization"sv,
+                                   {std::to_string(from), std::to_string(to), std::to_string(threshold)});
+        return SendCachedResponse(key, [&] {
+            auto analytics = application_.GetUseCases().GetTrunkUtilization({from, to}, threshold);
+            json::value jv = {
+                {"from"s, domain::FormatTimestamp(from)},
+                {"to"s, domain::FormatTimestamp(to)},
+                {"threshold"s, threshold},
+                {"trunks"s, analytics::AnalyticsCalculator::ToJson(analytics)}
+            };
+            return json::serialize(jv);
+        });
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
+
+void ApiHandler::HandleAnalyticsTopCalls() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
+
+    try {
+        // По умолчанию - текущие сутки UTC: окно из целых суток читается из поддерживаемых рейтингов
+        int64_t today = domain::FloorDiv(domain::NowTimestamp(), domain::MICROS_PER_DAY) * domain::MICROS_PER_DAY;
+        int64_t from = GetTimestampParam("from"sv, today);
+        int64_t to = GetTimestampParam("to"sv, from + domain::MICROS_PER_DAY);
+        if (from >= to) {
+            throw std::invalid_argument("Начало интервала должно быть раньше конца"s);
         }
+        size_t limit = GetLimitParam(MAX_TOP_LIMIT).value_or(DEFAULT_TOP_LIMIT);
+
+        std::string key = CacheKey("top-calls"sv, {std::to_string(from), std::to_string(to), std::to_string(limit)});
+        return SendCachedResponse(key, [&] {
+            auto calls = application_.GetUseCases().GetTopCalls({from, to}, limit);
+            json::value jv = {
+                {"from"s, domain::FormatTimestamp(from)},
+                {"to"s, domain::FormatTimestamp(to)},
+                {"calls"s, analytics::AnalyticsCalculator::ToJson(calls)}
+            };
+            return json::serialize(jv);
+        });
+    }
+    catch (const std::exception& e) {
+        return SendBadRequestResponse(CleanErrorMessage(e.what()));
+    }
+}
 
-        return SendOkResponse(json::serialize(jv));
+void ApiHandler::SendCachedResponse(const std::string& key, const std::function<std::string()>& compute) {
+    auto body = app::g_analytics_cache.GetOrCompute(key, compute);
+    return SendOkResponse(*body);
+}
+
+void ApiHandler::HandleDashboard() {
+    std::string path_part = FindAndCutTarget(req_info_);
+
+    if (path_part == "/snapshot"s) {
+        HandleDashboardSnapshot();
+    }
+    else {
+        SendNotFoundResponse();
+    }
+}
+
+// Всё, что показывают панели мониторинга, одним ответом: справочники и суммы звонков
+// считаются по одному снимку справочников за один проход по звонкам. Ответ кэшируется
+// вместе с аналитикой, неизменившийся отдаётся клиенту как 304 по ETag
+void ApiHandler::HandleDashboardSnapshot() {
+    if (req_info_.method != http::verb::get && req_info_.method != http::verb::head) {
+        return SendWrongMethodResponseAllowedGetHead("Wrong method"s, true);
+    }
+
+    try {
+        domain::TimeRange range = GetTimeRangeParams();
+        auto tz_offset = analytics::ParseUtcOffset(GetQueryParam("tz"sv).value_or("UTC"s));
+        if (!tz_offset) {
+            throw std::invalid_argument("tz: ожидается смещение от UTC вида +03:00 (именованные пояса не поддерживаются)"s);
+        }
+        size_t recent_calls = GetLimitParam(MAX_TOP_LIMIT).value_or(DEFAULT_RECENT_CALLS);
+
+        std::string key = CacheKey("dashboard"sv, {TimeKey(range.from), TimeKey(range.to),
+                                                   std::to_string(*tz_offset), std::to_string(recent_calls)});
+        auto body = app::g_analytics_cache.GetOrCompute(key, [&] {
+            auto use_cases = application_.GetUseCases();
+            auto reference = use_cases.GetReferenceData();
+            auto summary = use_cases.GetDashboard(*reference, range, *tz_offset, recent_calls);
+
+            json::object jv = std::move(analytics::AnalyticsCalculator::ToJson(summary).as_object());
+            jv["tz"s] = analytics::FormatUtcOffset(*tz_offset);
+            jv["database"s] = ReferenceCountsToJson(*reference);
+            jv["hubs"s] = json::value_from(reference->hubs);
+            jv["servers"s] = json::value_from(reference->servers);
+            jv["trunks"s] = json::value_from(reference->trunks);
+            jv["tarifs"s] = json::value_from(reference->tarifs);
+            return json::serialize(jv);
+        });
+        return SendETaggedResponse(*body);
     }
     catch (const std::exception& e) {
         return SendBadRequestResponse(CleanErrorMessage(e.what()));
@@ -713,24 +1472,14 @@ void ApiHandler::HandleLogs() {
 
     try {
         int lines_count = 1000;
-        size_t query_pos = req_info_.target.find('?');
-        if (query_pos != std::string::npos) {
-            std::string query = req_info_.target.substr(query_pos + 1);
-            size_t lines_pos = query.find("lines=");
-            if (lines_pos != std::string::npos) {
-                std::string lines_str = query.substr(lines_pos + 6);
-                size_t amp_pos = lines_str.find('&');
-                if (amp_pos != std::string::npos) {
-                    lines_str = lines_str.substr(0, amp_pos);
-                }
-                try {
-                    lines_count = std::stoi(lines_str);
-                    if (lines_count <= 0) lines_count = 100;
-                    if (lines_count > 1000) lines_count = 1000; // Максимум 1000 строк
-                }
-                catch (...) {
-                    lines_count = 100;
-                }
+        if (auto lines_str = GetQueryParam("lines"sv)) {
+            try {
+                lines_count = std::stoi(*lines_str);
+                if (lines_count <= 0) lines_count = 100;
+                if (lines_count > 1000) lines_count = 1000; // Максимум 1000 строк
+            }
+            catch (...) {
+                lines_count = 100;
             }
         }
 
@@ -1187,6 +1936,21 @@ void ApiHandler::SendOkResponse(const std::string& body, bool no_cache) {
     send_(result);
 }
 
+void ApiHandler::SendETaggedResponse(const std::string& body) {
+    // no-cache: клиент хранит ответ, но каждый раз сверяет ETag
+    std::string etag = ETagOf(body);
+    if (!req_info_.if_none_match.empty() && MatchesETag(req_info_.if_none_match, etag)) {
+        ResponseInfo result = MakeResponse(http::status::not_modified, true);
+        result.additional_fields.emplace_back(http::field::etag, etag);
+        return send_(result);
+    }
+
+    ResponseInfo result = MakeResponse(http::status::ok, true);
+    result.body = body;
+    result.additional_fields.emplace_back(http::field::etag, etag);
+    send_(result);
+}
+
 void ApiHandler::SendBadRequestResponse(std::string message, std::string code, bool no_cache) {
     ResponseInfo result = MakeResponse(http::status::bad_request, no_cache);
 
@@ -1200,6 +1964,20 @@ void ApiHandler::SendBadRequestResponse(std::string message, std::string code, b
     send_(result);
 }
 
+void ApiHandler::SendServiceUnavailableResponse(std::string message, std::string code, bool no_cache) {
+    ResponseInfo result = MakeResponse(http::status::service_unavailable, no_cache);
+    result.additional_fields.emplace_back(http::field::retry_after, "1"s);
+
+    json::value body = {
+        {"code"s, code},
+        {"message"s, message}
+    };
+
+    result.body = json::serialize(body);
+
+    send_(result);
+}
+
 void ApiHandler::SendNotFoundResponse(const std::string& message, const std::string& key, bool no_cache) {
     ResponseInfo result = MakeResponse(http::status::not_found, no_cache);
 
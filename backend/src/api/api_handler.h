@@ -6,6 +6,9 @@
 #include "../resp_maker.h"
 
 #include <deque>
+#include <functional>
+#include <optional>
+#include <string_view>
 
 namespace api_handler {
 namespace net = boost::asio;
@@ -31,6 +34,10 @@ db::AppConfig GetConfigFromEnv() {
 
 }  // namespace
 
+// Общий на процесс экземпляр приложения: пул соединений с БД создаётся
+// при первом запросе, а не заново на каждый запрос
+db::Application& GetSharedApplication();
+
 class TimeTracker {
   public:
     TimeTracker() : start_time_(std::chrono::high_resolution_clock::now()) {}
@@ -123,12 +130,14 @@ struct Tokens {
 
 struct RequestInfo {
     std::string target;
+    std::string query; // часть target после '?', без самого '?'
     std::string body;
     http::verb method;
     std::string content_type;
     int version;
     bool keep_alive;
     std::string auth;
+    std::string if_none_match; // ETag ответа, уже сохранённого клиентом
 };
 
 inline std::unordered_map<Person, std::string, PersonHasher> persons_;
@@ -153,12 +162,25 @@ class ApiHandler : public std::enable_shared_from_this<ApiHandler> {
   private:
     std::function<void(ResponseInfo)> send_;
     RequestInfo req_info_{};
-    db::Application application_{GetConfigFromEnv()};
+    db::Application& application_{GetSharedApplication()};
 
     bool CheckEndPath();
     std::string FindAndCutTarget(RequestInfo& req);
     std::string GetIdFromTarget(const std::string& target);
 
+    // Значение параметра query string
+    std::optional<std::string> GetQueryParam(std::string_view name) const;
+    // Границы from/to для запросов по времени звонка, в UTC ("YYYY-MM-DD HH:MM:SS.ffffff+00").
+    // std::invalid_argument - не время
+    domain::TimeRange GetTimeRangeParams() const;
+    // Время из параметра (микросекунды от эпохи); fallback - параметр не задан.
+    // std::invalid_argument - не время
+    int64_t GetTimestampParam(std::string_view name, int64_t fallback) const;
+    // Параметр limit в [1, max_limit]; nullopt - не задан. std::invalid_argument - вне диапазона
+    std::optional<size_t> GetLimitParam(size_t max_limit) const;
+    // Список id через запятую ("1,2,3"). std::invalid_argument - не число
+    std::vector<int> GetIdListParam(std::string_view name) const;
+
     void HandleApiResponse();
 
     std::random_device random_device_;
@@ -189,6 +211,24 @@ class ApiHandler : public std::enable_shared_from_this<ApiHandler> {
     void HandleSimulate();
     void HandleSimulateCalls();
 
+    void HandleIngest();
+    void HandleIngestCalls();
+
+    void HandleRerate();
+    void HandleRerateStart();
+    void HandleRerateStatus();
+    void HandleRerateCancel();
+
+    // Результат сохранения пакета звонков через очередь записи или напрямую в БД
+    struct SaveCallsResult {
+        domain::BulkInsertResult result;
+        int queued = 0;
+        bool rejected = false; // очередь переполнена, ничего не сохранено
+        bool timed_out = false; // фиксация не подтверждена за ingest.commit_timeout_ms
+        bool unavailable = false; // очередь остановлена, звонки не сохранены
+    };
+    SaveCallsResult SaveCalls(const std::vector<ui::detail::CallStatisticsInfo>& calls);
+
     void HandleSync();
     void HandleSyncTrigger();
     void HandleSyncStatus();
@@ -218,6 +258,15 @@ class ApiHandler : public std::enable_shared_from_this<ApiHandler> {
     void HandleAnalyticsCallsByTarif();
     void HandleAnalyticsCallsByHub();
     void HandleAnalyticsRevenue();
+    void HandleAnalyticsTimeSeries();
+    void HandleAnalyticsDistribution(bool by_trunk);
+    void HandleAnalyticsTrunkUtilization();
+    void HandleAnalyticsTopCalls();
+    // Ответ аналитики через app::g_analytics_cache; key - эндпоинт и нормализованные параметры
+    void SendCachedResponse(const std::string& key, const std::function<std::string()>& compute);
+
+    void HandleDashboard();
+    void HandleDashboardSnapshot();
 
     void HandleUpdate();
     void HandleUpdatePricelist(int id);
@@ -237,11 +286,15 @@ class ApiHandler : public std::enable_shared_from_this<ApiHandler> {
     ResponseInfo MakeResponse(http::status status, bool no_cache);
 
     void SendOkResponse(const std::string& body, bool no_cache = true);
+    // 200 с ETag тела или 304 без тела, если клиент прислал тот же ETag в If-None-Match
+    void SendETaggedResponse(const std::string& body);
     void SendBadRequestResponse(std::string message, std::string code =
                                 "badRequest"s, bool no_cache = true);
     void SendBadRequestResponseDefault(bool no_cache = true) {
         SendBadRequestResponse("Bad request"s, "badRequest"s, no_cache);
     }
+    void SendServiceUnavailableResponse(std::string message, std::string code = "serviceUnavailable"s,
+                                        bool no_cache = true);
     void SendNotFoundResponse(const std::string& message =  "Table not found"s,
                               const std::string& key = "tableNotFound"s, bool no_cache = true);
 
@@ -261,6 +314,12 @@ void ApiHandler::Handle(const http::request<Body, http::basic_fields<Allocator>>
     req_info_ = ParseRequest(req);
     req_info_.target = req_info_.target.substr("/api"s.size());
 
+    // Query string отрезается до маршрутизации, чтобы не мешать сравнению путей
+    if (size_t query_pos = req_info_.target.find('?'); query_pos != std::string::npos) {
+        req_info_.query = req_info_.target.substr(query_pos + 1);
+        req_info_.target.resize(query_pos);
+    }
+
     HandleApiResponse();
 }
 
@@ -279,6 +338,9 @@ RequestInfo ApiHandler::ParseRequest(const http::request<Body, http::basic_field
     if (req.find(http::field::authorization) != req.end()) {
         result.auth = req.at(http::field::authorization);
     }
+    if (req.find(http::field::if_none_match) != req.end()) {
+        result.if_none_match = req.at(http::field::if_none_match);
+    }
 
     return result;
 }
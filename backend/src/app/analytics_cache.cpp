@@ -0,0 +1,171 @@
+#include "analytics_cache.h"
+#include "call_aggregates.h"
+#include "call_store.h"
+#include "reference_cache.h"
+
+#include <exception>
+
+namespace app {
+using namespace std::literals;
+
+// Глобальный экземпляр
+AnalyticsCache g_analytics_cache;
+
+namespace {
+
+// Служебные поля узлов списка и хеш-таблицы на одну запись (оценка)
+constexpr size_t ENTRY_OVERHEAD = 128;
+
+} // namespace
+
+void AnalyticsCache::Configure(Options options) {
+    std::lock_guard lock{mutex_};
+    options_ = options;
+    if (!options_.enabled) {
+        Clear();
+    }
+    EvictTo(options_.max_bytes);
+}
+
+AnalyticsCache::Body AnalyticsCache::GetOrCompute(const std::string& key, const Compute& compute) {
+    bool enabled;
+    {
+        std::lock_guard lock{mutex_};
+        enabled = options_.enabled;
+    }
+    auto version = enabled ? DataVersion() : std::nullopt;
+    if (!version) {
+        {
+            std::lock_guard lock{mutex_};
+            ++metrics_.bypassed;
+        }
+        return std::make_shared<const std::string>(compute());
+    }
+
+    std::string flight_key = *version + '\n' + key;
+    std::promise<Body> promise;
+    std::shared_future<Body> future;
+    {
+        std::lock_guard lock{mutex_};
+        if (*version != version_) {
+            if (!entries_.empty()) {
+                ++metrics_.invalidations;
+            }
+            Clear();
+            version_ = *version;
+        }
+
+        if (auto it = entries_.find(key); it != entries_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+            ++metrics_.hits;
+            return it->second.body;
+        }
+
+        if (auto it = in_flight_.find(flight_key); it != in_flight_.end()) {
+            future = it->second;
+            ++metrics_.coalesced;
+        }
+        else {
+            in_flight_.emplace(flight_key, promise.get_future().share());
+            ++metrics_.misses;
+        }
+    }
+
+    // Вычисление уже выполняет другой поток
+    if (future.valid()) {
+        return future.get();
+    }
+
+    Body body;
+    try {
+        body = std::make_shared<const std::string>(compute());
+    }
+    catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard lock{mutex_};
+        in_flight_.erase(flight_key);
+        ++metrics_.errors;
+        throw;
+    }
+
+    promise.set_value(body);
+    std::lock_guard lock{mutex_};
+    in_flight_.erase(flight_key);
+    // Пока считали, данные могли измениться: такой ответ в кэш не кладётся
+    if (options_.enabled && version_ == *version) {
+        Insert(key, body);
+    }
+    return body;
+}
+
+void AnalyticsCache::Invalidate() {
+    epoch_.fetch_add(1);
+}
+
+AnalyticsCache::Metrics AnalyticsCache::GetMetrics() const {
+    std::lock_guard lock{mutex_};
+    Metrics result = metrics_;
+    result.entries = entries_.size();
+    result.bytes = bytes_;
+    result.max_bytes = options_.max_bytes;
+    return result;
+}
+
+std::optional<std::string> AnalyticsCache::DataVersion() const {
+    bool aggregates = g_call_aggregates.IsRunning();
+    bool store = g_call_store.IsRunning();
+    if (!aggregates && !store) {
+        return std::nullopt;
+    }
+
+    std::string result = std::to_string(g_reference_cache.GetVersion()) + '.' + std::to_string(epoch_.load());
+    if (aggregates) {
+        result += ".a"s + std::to_string(g_call_aggregates.Watermark()) + ':'
+                  + std::to_string(g_call_aggregates.Generation());
+    }
+    if (store) {
+        result += ".s"s + std::to_string(g_call_store.Watermark()) + ':' + std::to_string(g_call_store.Generation());
+    }
+    return result;
+}
+
+void AnalyticsCache::Insert(const std::string& key, Body body) {
+    size_t bytes = EntryBytes(key, *body);
+    if (bytes > options_.max_bytes) {
+        return;
+    }
+
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        bytes_ -= EntryBytes(key, *it->second.body);
+        lru_.erase(it->second.lru_pos);
+        entries_.erase(it);
+    }
+    EvictTo(options_.max_bytes - bytes);
+
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{std::move(body), lru_.begin()});
+    bytes_ += bytes;
+}
+
+void AnalyticsCache::EvictTo(size_t max_bytes) {
+    while (bytes_ > max_bytes && !lru_.empty()) {
+        auto it = entries_.find(lru_.back());
+        bytes_ -= EntryBytes(it->first, *it->second.body);
+        entries_.erase(it);
+        lru_.pop_back();
+        ++metrics_.evictions;
+    }
+}
+
+void AnalyticsCache::Clear() {
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+size_t AnalyticsCache::EntryBytes(const std::string& key, const std::string& body) {
+    // Ключ хранится дважды: в хеш-таблице и в списке LRU
+    return 2 * key.size() + body.size() + ENTRY_OVERHEAD;
+}
+
+} // namespace app
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace app {
+
+// Кэш готовых ответов /api/analytics (сериализованный JSON).
+//
+// Ключ - эндпоинт и нормализованные параметры запроса (разобранные границы
+// времени, а не исходные строки). Ответ действителен, пока не изменилась версия
+// данных: watermark и число полных пересчётов поддерживаемых агрегатов и
+// колоночного хранилища, версия справочников и счётчик Invalidate(). Смена версии
+// сбрасывает кэш целиком; без запущенных агрегатов и хранилища версии нет, и
+// ответы не кэшируются. Звонки доходят до watermark за refresh_interval, поэтому
+// ответ может отставать от БД на тот же интервал, что и сами агрегаты.
+//
+// Одинаковые одновременные запросы считаются один раз (single-flight): первый
+// вычисляет, остальные ждут его результат или исключение. Память ограничена
+// max_bytes, при переполнении вытесняются давно не читавшиеся ответы (LRU)
+class AnalyticsCache {
+public:
+    using Body = std::shared_ptr<const std::string>;
+    using Compute = std::function<std::string()>;
+
+    struct Options {
+        bool enabled = true;
+        size_t max_bytes = 64 * 1024 * 1024;
+    };
+
+    struct Metrics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;        // вычислено заново
+        uint64_t coalesced = 0;     // дождались чужого вычисления
+        uint64_t bypassed = 0;      // кэш выключен или версия данных неизвестна
+        uint64_t evictions = 0;     // вытеснено по памяти
+        uint64_t invalidations = 0; // сбросов по смене версии данных
+        uint64_t errors = 0;        // вычислений с исключением
+        size_t entries = 0;
+        size_t bytes = 0;
+        size_t max_bytes = 0;
+    };
+
+    AnalyticsCache() = default;
+
+    AnalyticsCache(const AnalyticsCache&) = delete;
+    AnalyticsCache& operator=(const AnalyticsCache&) = delete;
+
+    void Configure(Options options);
+
+    // Ответ по ключу из кэша или от compute(); исключение compute() получают
+    // и все ожидавшие, в кэш оно не попадает
+    Body GetOrCompute(const std::string& key, const Compute& compute);
+
+    // Данные изменились без роста watermark (пересчёт стоимости, удаление секций)
+    void Invalidate();
+
+    Metrics GetMetrics() const;
+
+private:
+    struct Entry {
+        Body body;
+        std::list<std::string>::iterator lru_pos;
+    };
+
+    // nullopt - нет поддерживаемого состояния, по которому видно изменение данных
+    std::optional<std::string> DataVersion() const;
+    // Вызываются под mutex_
+    void Insert(const std::string& key, Body body);
+    // Вытеснять давние ответы, пока занято больше max_bytes
+    void EvictTo(size_t max_bytes);
+    void Clear();
+    static size_t EntryBytes(const std::string& key, const std::string& body);
+
+    mutable std::mutex mutex_;
+    Options options_;
+    std::string version_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_; // от недавно прочитанных к давним
+    size_t bytes_ = 0;
+    // Версия данных и ключ -> выполняющееся вычисление
+    std::unordered_map<std::string, std::shared_future<Body>> in_flight_;
+    std::atomic<uint64_t> epoch_{0};
+    Metrics metrics_;
+};
+
+// Глобальный экземпляр
+extern AnalyticsCache g_analytics_cache;
+
+} // namespace app
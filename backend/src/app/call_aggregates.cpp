@@ -0,0 +1,747 @@
+#include "call_aggregates.h"
+#include "../domain/timestamp.h"
+#include "../logger/logger.h"
+
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace app {
+using namespace std::literals;
+
+// Глобальный экземпляр
+CallAggregates g_call_aggregates;
+
+namespace {
+
+constexpr char CHECKPOINT_MAGIC[8] = {'C', 'A', 'L', 'L', 'A', 'G', 'G', 'R'};
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+// Формат контрольной точки: magic, версия u32, watermark i64, число ячеек u64,
+// ячейки [hour i64][trunk_id i32][tarif_id i32][calls i64][duration i64][cost i64],
+// в конце CRC32 всего предыдущего содержимого
+constexpr size_t CELL_SIZE = 3 * sizeof(int64_t) + 2 * sizeof(int32_t) + sizeof(int64_t);
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T Get(const std::string& data, size_t& pos) {
+    T value{};
+    std::memcpy(&value, data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+uint32_t Crc32(const char* data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+void AddTotals(analytics::GroupTotals& totals, const analytics::GroupTotals& other) {
+    totals.calls += other.calls;
+    totals.duration_seconds += other.duration_seconds;
+    totals.cost += other.cost;
+}
+
+uint64_t MakeKey(int32_t trunk_id, int32_t tarif_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(trunk_id)) << 32) | static_cast<uint32_t>(tarif_id);
+}
+
+int32_t KeyTrunk(uint64_t key) {
+    return static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+}
+
+int32_t KeyTarif(uint64_t key) {
+    return static_cast<int32_t>(static_cast<uint32_t>(key));
+}
+
+// Границы окна в часах; nullopt - граница не кратна часу
+std::optional<std::pair<int64_t, int64_t>> HourRange(const analytics::TimeWindow& window) {
+    constexpr int64_t unbounded_from = std::numeric_limits<int64_t>::min();
+    constexpr int64_t unbounded_to = std::numeric_limits<int64_t>::max();
+
+    if ((window.from != unbounded_from && window.from % domain::MICROS_PER_HOUR != 0)
+        || (window.to != unbounded_to && window.to % domain::MICROS_PER_HOUR != 0)) {
+        return std::nullopt;
+    }
+    return std::pair{window.from == unbounded_from ? unbounded_from : window.from / domain::MICROS_PER_HOUR,
+                     window.to == unbounded_to ? unbounded_to : window.to / domain::MICROS_PER_HOUR};
+}
+
+bool IsUnbounded(const analytics::TimeWindow& window) {
+    return window.from == std::numeric_limits<int64_t>::min() && window.to == std::numeric_limits<int64_t>::max();
+}
+
+} // namespace
+
+// ============================================================================
+// State
+// ============================================================================
+
+void CallAggregates::State::Add(const AggregateCell& cell) {
+    auto& hour = hours[cell.hour];
+    AddTotals(hour.totals, cell.totals);
+    AddTotals(hour.cells[MakeKey(cell.trunk_id, cell.tarif_id)], cell.totals);
+    AddTotals(by_trunk[cell.trunk_id], cell.totals);
+    AddTotals(by_tarif[cell.tarif_id], cell.totals);
+}
+
+size_t CallAggregates::State::Cells() const {
+    size_t result = 0;
+    for (const auto& [key, hour] : hours) {
+        result += hour.cells.size();
+    }
+    return result;
+}
+
+// ============================================================================
+// CallAggregates
+// ============================================================================
+
+CallAggregates::~CallAggregates() {
+    Stop();
+}
+
+void CallAggregates::Start(StoreFactory factory, Options options) {
+    if (running_) {
+        return;
+    }
+
+    factory_ = std::move(factory);
+    options_ = std::move(options);
+    gaps_.SetWindow(options_.late_commit_window);
+    gaps_.Clear();
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&CallAggregates::Run, this);
+}
+
+void CallAggregates::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        stop_requested_ = true;
+    }
+    cond_var_.notify_all();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    {
+        std::unique_lock lock{state_mutex_};
+        ready_ = false;
+        state_ = {};
+        watermark_ = 0;
+        ++generation_;
+    }
+    running_ = false;
+    LOG_INFO("CallAggregates stopped");
+}
+
+bool CallAggregates::IsRunning() const {
+    return running_;
+}
+
+void CallAggregates::Notify() {
+    {
+        std::lock_guard lock{mutex_};
+        notified_ = true;
+    }
+    cond_var_.notify_all();
+}
+
+void CallAggregates::Invalidate() {
+    {
+        std::lock_guard lock{mutex_};
+        rebuild_requested_ = true;
+    }
+    cond_var_.notify_all();
+}
+
+CallAggregates::Stats CallAggregates::GetStats() const {
+    Stats result;
+    {
+        std::lock_guard lock{mutex_};
+        result = stats_;
+    }
+
+    std::shared_lock lock{state_mutex_};
+    result.ready = ready_;
+    result.watermark = state_.watermark;
+    result.cells = state_.Cells();
+    result.hours = state_.hours.size();
+    result.leader_days = state_.leaders.size();
+    return result;
+}
+
+int64_t CallAggregates::Watermark() const {
+    return watermark_.load();
+}
+
+uint64_t CallAggregates::Generation() const {
+    return generation_.load();
+}
+
+void CallAggregates::Run() {
+    bool need_rebuild = true;
+    try {
+        need_rebuild = !LoadCheckpoint();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("CallAggregates checkpoint ignored: "s + e.what());
+    }
+
+    std::unique_ptr<CallAggregateStore> store;
+    bool verified = need_rebuild;
+    bool dirty = false;
+    auto last_rebuild = std::chrono::steady_clock::now();
+    auto last_checkpoint = last_rebuild;
+
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            if (!store) {
+                store = factory_();
+            }
+
+            // Контрольная точка от другой (пересозданной) БД: звонков меньше, чем учтено
+            if (!verified) {
+                std::shared_lock lock{state_mutex_};
+                need_rebuild = state_.watermark > store->MaxId();
+                verified = true;
+            }
+
+            if (need_rebuild) {
+                Rebuild(*store);
+                need_rebuild = false;
+                last_rebuild = start;
+                dirty = true;
+            }
+            else {
+                LoadLeaders(*store);
+                if (CatchUp(*store) > 0) {
+                    dirty = true;
+                }
+            }
+
+            std::lock_guard lock{mutex_};
+            stats_.last_refresh_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        catch (const std::exception& e) {
+            // Подключение пересоздаётся при следующей попытке
+            LOG_ERROR("CallAggregates refresh failed: "s + e.what());
+            store.reset();
+            std::lock_guard lock{mutex_};
+            ++stats_.errors;
+            stats_.last_error = e.what();
+        }
+
+        if (dirty && std::chrono::steady_clock::now() - last_checkpoint >= options_.checkpoint_interval) {
+            dirty = !SaveCheckpoint();
+            last_checkpoint = std::chrono::steady_clock::now();
+        }
+
+        std::unique_lock lock{mutex_};
+        cond_var_.wait_for(lock, options_.refresh_interval, [this] {
+            return stop_requested_ || notified_ || rebuild_requested_;
+        });
+        if (stop_requested_) {
+            break;
+        }
+
+        need_rebuild = need_rebuild || rebuild_requested_
+                       || (options_.full_rebuild_interval.count() > 0
+                           && std::chrono::steady_clock::now() - last_rebuild >= options_.full_rebuild_interval);
+        rebuild_requested_ = false;
+        notified_ = false;
+    }
+
+    // Перезапуск продолжит с сохранённого watermark
+    if (dirty) {
+        SaveCheckpoint();
+    }
+}
+
+void CallAggregates::Rebuild(CallAggregateStore& store) {
+    // Пересчёт учитывает все зафиксированные звонки до нового watermark
+    gaps_.Clear();
+
+    State fresh;
+    fresh.watermark = store.MaxId();
+    store.ForEachCell(fresh.watermark, [&fresh](const AggregateCell& cell) {
+        fresh.Add(cell);
+    });
+    if (options_.leader_days > 0) {
+        fresh.leaders_from = LeadersFrom();
+        fresh.leaders = ReadLeaders(store, fresh.watermark, fresh.leaders_from);
+    }
+
+    size_t cells = fresh.Cells();
+    {
+        std::unique_lock lock{state_mutex_};
+        state_ = std::move(fresh);
+        ready_ = true;
+        watermark_ = state_.watermark;
+        ++generation_;
+    }
+
+    std::lock_guard lock{mutex_};
+    ++stats_.rebuilds;
+    LOG_INFO("CallAggregates rebuilt: " + std::to_string(cells) + " cells");
+}
+
+size_t CallAggregates::CatchUp(CallAggregateStore& store) {
+    int64_t after_id;
+    bool with_leaders;
+    {
+        std::shared_lock lock{state_mutex_};
+        after_id = state_.watermark;
+        with_leaders = state_.leaders_from != NO_LEADERS;
+    }
+    int64_t from_day = LeadersFrom();
+
+    auto missing = gaps_.Begin(after_id);
+
+    // Звонки сворачиваются в ячейки до применения: читатели блокируются
+    // только на время слияния ячеек, а не на время чтения из БД
+    std::unordered_map<int64_t, std::unordered_map<uint64_t, analytics::GroupTotals>> delta;
+    Leaders leaders_delta;
+    int64_t watermark = after_id;
+    size_t applied = 0;
+
+    store.ForEachCall(after_id, missing, [&](const ui::detail::CallStatisticsInfo& call) {
+        int64_t hour = domain::FloorDiv(call.call_time, domain::MICROS_PER_HOUR);
+        auto& totals = delta[hour][MakeKey(call.trunk_id, call.tarif_id)];
+        ++totals.calls;
+        totals.duration_seconds += call.duration_seconds;
+        totals.cost += call.cost.Micros();
+        if (with_leaders) {
+            AddLeader(leaders_delta, from_day, call);
+        }
+        if (!gaps_.Visit(call.id)) {
+            watermark = call.id;
+        }
+        ++applied;
+    });
+
+    if (applied == 0) {
+        return 0;
+    }
+
+    size_t late = gaps_.Commit();
+
+    {
+        std::unique_lock lock{state_mutex_};
+        for (const auto& [hour, cells] : delta) {
+            for (const auto& [key, totals] : cells) {
+                state_.Add({hour, KeyTrunk(key), KeyTarif(key), totals});
+            }
+        }
+        if (with_leaders) {
+            // Сутки, вышедшие из поддерживаемых, больше не пополняются и удаляются
+            if (state_.leaders_from < from_day) {
+                state_.leaders.erase(state_.leaders.begin(), state_.leaders.lower_bound(from_day));
+                state_.leaders_from = from_day;
+            }
+            for (auto& [day, leaders] : leaders_delta) {
+                auto [it, inserted] = state_.leaders.try_emplace(day, std::move(leaders));
+                if (!inserted) {
+                    it->second.expensive.Merge(leaders.expensive);
+                }
+            }
+        }
+        state_.watermark = watermark;
+        watermark_ = watermark;
+        // Данные ниже watermark изменились: версия должна смениться и без его роста
+        if (late > 0) {
+            ++generation_;
+        }
+    }
+
+    std::lock_guard lock{mutex_};
+    stats_.applied_calls += applied;
+    stats_.late_calls += late;
+    return applied;
+}
+
+int64_t CallAggregates::LeadersFrom() const {
+    return domain::FloorDiv(domain::NowTimestamp(), domain::MICROS_PER_DAY) - (options_.leader_days - 1);
+}
+
+void CallAggregates::AddLeader(Leaders& leaders, int64_t from_day, const ui::detail::CallStatisticsInfo& call) const {
+    int64_t day = domain::FloorDiv(call.call_time, domain::MICROS_PER_DAY);
+    if (day < from_day) {
+        return;
+    }
+
+    auto it = leaders.find(day);
+    if (it == leaders.end()) {
+        it = leaders.emplace(day, DayLeaders{analytics::TopCallsAggregator(options_.top_calls)}).first;
+    }
+    it->second.expensive.Add(call);
+}
+
+CallAggregates::Leaders CallAggregates::ReadLeaders(CallAggregateStore& store, int64_t max_id, int64_t from_day) const {
+    Leaders leaders;
+    store.ForEachCallSince(from_day * domain::MICROS_PER_DAY, max_id,
+        [&](const ui::detail::CallStatisticsInfo& call) {
+            AddLeader(leaders, from_day, call);
+        });
+    return leaders;
+}
+
+void CallAggregates::LoadLeaders(CallAggregateStore& store) {
+    if (options_.leader_days <= 0) {
+        return;
+    }
+
+    // Состояние меняет только этот поток: watermark не сдвинется до установки рейтингов
+    int64_t watermark;
+    {
+        std::shared_lock lock{state_mutex_};
+        if (state_.leaders_from != NO_LEADERS) {
+            return;
+        }
+        watermark = state_.watermark;
+    }
+
+    int64_t from_day = LeadersFrom();
+    Leaders leaders = ReadLeaders(store, watermark, from_day);
+
+    std::unique_lock lock{state_mutex_};
+    state_.leaders = std::move(leaders);
+    state_.leaders_from = from_day;
+}
+
+bool CallAggregates::SaveCheckpoint() {
+    if (options_.checkpoint_path.empty()) {
+        return true;
+    }
+
+    std::string data;
+    data.append(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    Put(data, CHECKPOINT_VERSION);
+    {
+        std::shared_lock lock{state_mutex_};
+        if (!ready_) {
+            return true;
+        }
+
+        Put(data, state_.watermark);
+        Put(data, static_cast<uint64_t>(state_.Cells()));
+        data.reserve(data.size() + state_.Cells() * CELL_SIZE + sizeof(uint32_t));
+        for (const auto& [hour, cells] : state_.hours) {
+            for (const auto& [key, totals] : cells.cells) {
+                Put(data, hour);
+                Put(data, KeyTrunk(key));
+                Put(data, KeyTarif(key));
+                Put(data, totals.calls);
+                Put(data, totals.duration_seconds);
+                Put(data, totals.cost);
+            }
+        }
+    }
+    Put(data, Crc32(data.data(), data.size()));
+
+    try {
+        // Запись во временный файл и rename: прежняя точка остаётся целой при сбое
+        std::filesystem::path path(options_.checkpoint_path);
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path());
+        }
+        std::filesystem::path temp_path = path;
+        temp_path += ".tmp";
+        {
+            std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            out.flush();
+            if (!out) {
+                throw std::runtime_error("write to " + temp_path.string() + " failed");
+            }
+        }
+        std::filesystem::rename(temp_path, path);
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("CallAggregates checkpoint failed: "s + e.what());
+        std::lock_guard lock{mutex_};
+        ++stats_.errors;
+        stats_.last_error = e.what();
+        return false;
+    }
+
+    std::lock_guard lock{mutex_};
+    ++stats_.checkpoints;
+    return true;
+}
+
+bool CallAggregates::LoadCheckpoint() {
+    if (options_.checkpoint_path.empty() || !std::filesystem::exists(options_.checkpoint_path)) {
+        return false;
+    }
+
+    std::ifstream in(options_.checkpoint_path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    constexpr size_t header_size = sizeof(CHECKPOINT_MAGIC) + sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint64_t);
+    if (data.size() < header_size + sizeof(uint32_t)
+        || std::memcmp(data.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        throw std::runtime_error("not a checkpoint file: " + options_.checkpoint_path);
+    }
+
+    size_t crc_pos = data.size() - sizeof(uint32_t);
+    size_t pos = crc_pos;
+    if (Get<uint32_t>(data, pos) != Crc32(data.data(), crc_pos)) {
+        throw std::runtime_error("checkpoint CRC mismatch: " + options_.checkpoint_path);
+    }
+
+    pos = sizeof(CHECKPOINT_MAGIC);
+    if (Get<uint32_t>(data, pos) != CHECKPOINT_VERSION) {
+        throw std::runtime_error("unsupported checkpoint version: " + options_.checkpoint_path);
+    }
+
+    State restored;
+    restored.watermark = Get<int64_t>(data, pos);
+    auto cells = Get<uint64_t>(data, pos);
+    if (cells > (crc_pos - header_size) / CELL_SIZE || header_size + cells * CELL_SIZE != crc_pos) {
+        throw std::runtime_error("checkpoint size mismatch: " + options_.checkpoint_path);
+    }
+
+    for (uint64_t i = 0; i < cells; ++i) {
+        AggregateCell cell;
+        cell.hour = Get<int64_t>(data, pos);
+        cell.trunk_id = Get<int32_t>(data, pos);
+        cell.tarif_id = Get<int32_t>(data, pos);
+        cell.totals.calls = Get<int64_t>(data, pos);
+        cell.totals.duration_seconds = Get<int64_t>(data, pos);
+        cell.totals.cost = Get<int64_t>(data, pos);
+        restored.Add(cell);
+    }
+
+    {
+        std::unique_lock lock{state_mutex_};
+        state_ = std::move(restored);
+        ready_ = true;
+        watermark_ = state_.watermark;
+        ++generation_;
+    }
+
+    std::lock_guard lock{mutex_};
+    stats_.restored = true;
+    LOG_INFO("CallAggregates restored from checkpoint: " + std::to_string(cells) + " cells");
+    return true;
+}
+
+// ============================================================================
+// Чтение
+// ============================================================================
+
+template <typename Visitor>
+bool CallAggregates::ForEachGroup(const analytics::TimeWindow& window, bool by_trunk, Visitor&& visitor) const {
+    if (!ready_) {
+        return false;
+    }
+
+    if (IsUnbounded(window)) {
+        for (const auto& [id, totals] : by_trunk ? state_.by_trunk : state_.by_tarif) {
+            visitor(id, totals);
+        }
+        return true;
+    }
+
+    auto range = HourRange(window);
+    if (!range) {
+        return false;
+    }
+
+    for (auto it = state_.hours.lower_bound(range->first); it != state_.hours.end() && it->first < range->second; ++it) {
+        for (const auto& [key, totals] : it->second.cells) {
+            visitor(by_trunk ? KeyTrunk(key) : KeyTarif(key), totals);
+        }
+    }
+    return true;
+}
+
+std::optional<analytics::GroupTotals> CallAggregates::Totals() const {
+    analytics::GroupTotals result;
+
+    std::shared_lock lock{state_mutex_};
+    if (!ForEachGroup({}, true, [&result](int32_t, const analytics::GroupTotals& totals) {
+            AddTotals(result, totals);
+        })) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<std::vector<analytics::TrunkAnalytics>> CallAggregates::ByTrunk(
+    const analytics::TimeWindow& window, const ReferenceData& reference) const {
+    analytics::TrunkAggregator aggregator(reference.trunks);
+
+    std::shared_lock lock{state_mutex_};
+    if (!ForEachGroup(window, true, [&aggregator](int32_t id, const analytics::GroupTotals& totals) {
+            aggregator.Add(id, totals);
+        })) {
+        return std::nullopt;
+    }
+    return aggregator.Finish();
+}
+
+std::optional<std::vector<analytics::TarifAnalytics>> CallAggregates::ByTarif(
+    const analytics::TimeWindow& window, const ReferenceData& reference) const {
+    analytics::TarifAggregator aggregator(reference.tarifs);
+
+    std::shared_lock lock{state_mutex_};
+    if (!ForEachGroup(window, false, [&aggregator](int32_t id, const analytics::GroupTotals& totals) {
+            aggregator.Add(id, totals);
+        })) {
+        return std::nullopt;
+    }
+    return aggregator.Finish();
+}
+
+std::optional<std::vector<analytics::HubAnalytics>> CallAggregates::ByHub(
+    const analytics::TimeWindow& window, const topology::NetworkTopology& topology) const {
+    analytics::HubAggregator aggregator(topology);
+
+    std::shared_lock lock{state_mutex_};
+    if (!ForEachGroup(window, true, [&aggregator](int32_t id, const analytics::GroupTotals& totals) {
+            aggregator.Add(id, totals);
+        })) {
+        return std::nullopt;
+    }
+    return aggregator.Finish();
+}
+
+std::optional<std::vector<analytics::RevenueAnalytics>> CallAggregates::Revenue(
+    analytics::RevenuePeriod period, const analytics::TimeWindow& window) const {
+    auto range = HourRange(window);
+
+    std::shared_lock lock{state_mutex_};
+    if (!ready_ || !range) {
+        return std::nullopt;
+    }
+
+    analytics::RevenueAggregator aggregator(period);
+    for (auto it = state_.hours.lower_bound(range->first); it != state_.hours.end() && it->first < range->second; ++it) {
+        aggregator.Add(it->first * domain::MICROS_PER_HOUR, it->second.totals);
+    }
+    return aggregator.Finish();
+}
+
+std::optional<analytics::DashboardSummary> CallAggregates::Dashboard(const analytics::TimeWindow& window,
+                                                                     const ReferenceData& reference,
+                                                                     int64_t tz_offset) const {
+    auto range = HourRange(window);
+    if (!range || tz_offset % domain::MICROS_PER_HOUR != 0) {
+        return std::nullopt;
+    }
+
+    analytics::TrunkAggregator trunks(reference.trunks);
+    analytics::TarifAggregator tarifs(reference.tarifs);
+    analytics::DashboardSummary result;
+    result.by_hour.resize(analytics::DashboardAggregator::HOURS_PER_DAY);
+
+    // Все части сводки - из одного состояния
+    std::shared_lock lock{state_mutex_};
+    if (!ForEachGroup(window, true, [&trunks](int32_t id, const analytics::GroupTotals& totals) {
+            trunks.Add(id, totals);
+        })) {
+        return std::nullopt;
+    }
+    ForEachGroup(window, false, [&tarifs](int32_t id, const analytics::GroupTotals& totals) {
+        tarifs.Add(id, totals);
+    });
+
+    // Смещение кратно часу, поэтому каждый час UTC целиком попадает в один час местных суток
+    int64_t hours_per_day = static_cast<int64_t>(analytics::DashboardAggregator::HOURS_PER_DAY);
+    int64_t offset_hours = tz_offset / domain::MICROS_PER_HOUR;
+    for (auto it = state_.hours.lower_bound(range->first); it != state_.hours.end() && it->first < range->second; ++it) {
+        int64_t local = it->first + offset_hours;
+        AddTotals(result.by_hour[static_cast<size_t>(local - domain::FloorDiv(local, hours_per_day) * hours_per_day)],
+                  it->second.totals);
+        AddTotals(result.totals, it->second.totals);
+    }
+    lock.unlock();
+
+    result.by_trunk = trunks.Finish();
+    result.by_tarif = tarifs.Finish();
+    return result;
+}
+
+std::optional<std::vector<analytics::TimeSeriesPoint>> CallAggregates::Series(
+    const analytics::TimeBuckets& buckets) const {
+    if (!buckets.HourAligned()) {
+        return std::nullopt;
+    }
+
+    std::shared_lock lock{state_mutex_};
+    if (!ready_) {
+        return std::nullopt;
+    }
+
+    // Каждый час целиком попадает в один интервал ряда
+    analytics::TimeSeriesAggregator aggregator(buckets);
+    int64_t first = buckets.From() / domain::MICROS_PER_HOUR;
+    int64_t last = buckets.To() / domain::MICROS_PER_HOUR;
+    for (auto it = state_.hours.lower_bound(first); it != state_.hours.end() && it->first < last; ++it) {
+        aggregator.Add(it->first * domain::MICROS_PER_HOUR, it->second.totals);
+    }
+    return aggregator.Finish();
+}
+
+std::optional<std::pair<int64_t, int64_t>> CallAggregates::LeaderDays(const analytics::TimeWindow& window) const {
+    if (!ready_ || state_.leaders_from == NO_LEADERS
+        || window.from == std::numeric_limits<int64_t>::min() || window.to == std::numeric_limits<int64_t>::max()
+        || window.from % domain::MICROS_PER_DAY != 0 || window.to % domain::MICROS_PER_DAY != 0
+        || window.from >= window.to) {
+        return std::nullopt;
+    }
+
+    // Сутки до LeadersFrom() уже не пополняются, даже если ещё не удалены
+    int64_t first = window.from / domain::MICROS_PER_DAY;
+    if (first < std::max(state_.leaders_from, LeadersFrom())) {
+        return std::nullopt;
+    }
+    return std::pair{first, window.to / domain::MICROS_PER_DAY};
+}
+
+std::optional<std::vector<analytics::CallLeader>> CallAggregates::TopCalls(const analytics::TimeWindow& window,
+                                                                           size_t limit) const {
+    if (limit > options_.top_calls) {
+        return std::nullopt;
+    }
+
+    std::shared_lock lock{state_mutex_};
+    auto days = LeaderDays(window);
+    if (!days) {
+        return std::nullopt;
+    }
+
+    auto begin = state_.leaders.lower_bound(days->first);
+    auto end = state_.leaders.lower_bound(days->second);
+    if (begin != end && std::next(begin) == end) {
+        return begin->second.expensive.Top(limit);
+    }
+
+    analytics::TopCallsAggregator merged(limit);
+    for (auto it = begin; it != end; ++it) {
+        merged.Merge(it->second.expensive);
+    }
+    return merged.Top(limit);
+}
+
+} // namespace app
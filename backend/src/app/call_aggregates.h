@@ -0,0 +1,232 @@
+#pragma once
+
+#include "id_gaps.h"
+#include "reference_cache.h"
+#include "../analytics/analytics.h"
+#include "../domain/call_statistics_fwd.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace app {
+
+// Суммы звонков одного часа по паре (транк, тариф)
+struct AggregateCell {
+    int64_t hour = 0; // номер часа от эпохи (UTC)
+    int32_t trunk_id = 0;
+    int32_t tarif_id = 0;
+    analytics::GroupTotals totals;
+};
+
+// Чтение call_statistics для поддерживаемых агрегатов.
+// Владеет собственным подключением: компонент живёт дольше HTTP-запроса
+class CallAggregateStore {
+public:
+    virtual ~CallAggregateStore() = default;
+
+    // Наибольший id звонка (0 - звонков нет)
+    virtual int64_t MaxId() = 0;
+    // Суммы по ячейкам для всех звонков с id <= max_id (группировка на стороне БД)
+    virtual void ForEachCell(int64_t max_id, const std::function<void(const AggregateCell&)>& visitor) = 0;
+    // Звонки с id > after_id или с id из диапазонов missing, по возрастанию id
+    virtual void ForEachCall(int64_t after_id, const std::vector<domain::IdRange>& missing,
+                             const domain::CallStatisticsVisitor& visitor) = 0;
+    // Звонки с call_time >= from_time (микросекунды UTC) и id <= max_id, в любом порядке
+    virtual void ForEachCallSince(int64_t from_time, int64_t max_id, const domain::CallStatisticsVisitor& visitor) = 0;
+};
+
+// Поддерживаемые агрегаты по всем звонкам: суммы по транкам, тарифам и ячейкам
+// (час, транк, тариф). Аналитика без ограничения по времени читается за O(групп),
+// с окном, выровненным по часам, - за O(ячеек окна), без обхода звонков.
+//
+// Новые звонки догружаются по возрастанию id после watermark, откуда бы они
+// ни пришли (API, очередь записи, синхронизация, другой экземпляр сервера).
+// Запись звонков и синхронизация call_statistics будят догрузку через Notify().
+// Одновременные писатели фиксируют id не по порядку: звонок с меньшим id может
+// появиться после звонка с большим. Поэтому пропущенные при догрузке id
+// запоминаются и перечитываются при следующих догрузках в течение
+// late_commit_window; найденные звонки учитываются один раз и исключаются из
+// пропусков. Звонки из транзакций дольше этого окна, а также зафиксированные
+// во время полного пересчёта или до сохранения контрольной точки подбирает
+// пересчёт заново раз в full_rebuild_interval. Изменение или удаление уже
+// учтённых звонков (пересчёт стоимости, удаление секций) тоже требует
+// пересчёта - Invalidate().
+//
+// Состояние периодически сохраняется в файл контрольной точки; после
+// перезапуска догружаются только звонки после сохранённого watermark.
+//
+// Для последних leader_days суток UTC поддерживается рейтинг самых дорогих
+// звонков (TopK). Он не сворачиваются в ячейки и не входят в контрольную точку: после
+// восстановления или пересчёта звонки этих суток перечитываются из БД
+class CallAggregates {
+public:
+    using StoreFactory = std::function<std::unique_ptr<CallAggregateStore>()>;
+
+    struct Options {
+        std::string checkpoint_path;                  // "" - без контрольной точки
+        std::chrono::milliseconds refresh_interval{1000};
+        std::chrono::seconds checkpoint_interval{60};
+        std::chrono::hours full_rebuild_interval{24}; // 0 - только по Invalidate()
+        std::chrono::seconds late_commit_window{600}; // сколько перечитывать пропущенные id; 0 - не перечитывать
+        int leader_days = 2;                          // сегодня и вчера; 0 - без рейтингов
+        size_t top_calls = 100;                       // самых дорогих звонков на сутки
+    };
+
+    struct Stats {
+        bool ready = false;
+        int64_t watermark = 0;
+        size_t cells = 0;
+        size_t hours = 0;
+        size_t leader_days = 0;      // суток с загруженными рейтингами
+        uint64_t applied_calls = 0;  // учтено догрузками с момента запуска
+        uint64_t late_calls = 0;     // из них найдено в пропусках ниже watermark
+        uint64_t rebuilds = 0;
+        uint64_t checkpoints = 0;
+        bool restored = false;       // состояние восстановлено из контрольной точки
+        uint64_t errors = 0;
+        double last_refresh_ms = 0.0;
+        std::string last_error;
+    };
+
+    CallAggregates() = default;
+    ~CallAggregates();
+
+    CallAggregates(const CallAggregates&) = delete;
+    CallAggregates& operator=(const CallAggregates&) = delete;
+
+    void Start(StoreFactory factory, Options options);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Появились новые звонки: догрузить, не дожидаясь refresh_interval
+    void Notify();
+    // Учтённые звонки изменились или удалены: пересчитать заново
+    void Invalidate();
+
+    // Итоги всех учтённых звонков за O(транков); nullopt - состояние не готово
+    std::optional<analytics::GroupTotals> Totals() const;
+    // nullopt - состояние не готово или границы окна не кратны часу (считать иначе)
+    std::optional<std::vector<analytics::TrunkAnalytics>> ByTrunk(const analytics::TimeWindow& window,
+                                                                  const ReferenceData& reference) const;
+    std::optional<std::vector<analytics::TarifAnalytics>> ByTarif(const analytics::TimeWindow& window,
+                                                                  const ReferenceData& reference) const;
+    std::optional<std::vector<analytics::HubAnalytics>> ByHub(const analytics::TimeWindow& window,
+                                                              const topology::NetworkTopology& topology) const;
+    std::optional<std::vector<analytics::RevenueAnalytics>> Revenue(analytics::RevenuePeriod period,
+                                                                    const analytics::TimeWindow& window) const;
+    // Итоги, суммы по транкам, тарифам и часам суток местного времени (смещение tz_offset)
+    // для /api/dashboard/snapshot; гистограммы и последние звонки не заполняются.
+    // nullopt - состояние не готово, окно не выровнено по часам или смещение не кратно часу
+    std::optional<analytics::DashboardSummary> Dashboard(const analytics::TimeWindow& window,
+                                                         const ReferenceData& reference,
+                                                         int64_t tz_offset) const;
+    // nullopt - состояние не готово или границы интервалов не совпадают с границами часов
+    std::optional<std::vector<analytics::TimeSeriesPoint>> Series(const analytics::TimeBuckets& buckets) const;
+    // Рейтинги по целым суткам UTC внутри поддерживаемых; nullopt - рейтинги не загружены,
+    // окно не выровнено по суткам, выходит за поддерживаемые сутки или limit больше вместимости
+    std::optional<std::vector<analytics::CallLeader>> TopCalls(const analytics::TimeWindow& window,
+                                                               size_t limit) const;
+
+    Stats GetStats() const;
+
+    // Версия состояния за O(1) без блокировок: watermark и число изменений, не
+    // сдвигающих его (пересчёт, восстановление, остановка, звонки ниже watermark)
+    int64_t Watermark() const;
+    uint64_t Generation() const;
+
+private:
+    using CellKey = uint64_t; // trunk_id в старших 32 битах, tarif_id в младших
+
+    struct Hour {
+        analytics::GroupTotals totals;
+        std::unordered_map<CellKey, analytics::GroupTotals> cells;
+    };
+
+    // Рейтинги одних суток UTC
+    struct DayLeaders {
+        analytics::TopCallsAggregator expensive;
+    };
+
+    // Номер суток -> рейтинги; сутки без звонков отсутствуют
+    using Leaders = std::map<int64_t, DayLeaders>;
+
+    static constexpr int64_t NO_LEADERS = std::numeric_limits<int64_t>::max();
+
+    struct State {
+        int64_t watermark = 0;
+        std::map<int64_t, Hour> hours;
+        std::unordered_map<int32_t, analytics::GroupTotals> by_trunk;
+        std::unordered_map<int32_t, analytics::GroupTotals> by_tarif;
+        // Рейтинги поддерживаются с суток leaders_from; NO_LEADERS - не загружены
+        int64_t leaders_from = NO_LEADERS;
+        Leaders leaders;
+
+        void Add(const AggregateCell& cell);
+        size_t Cells() const;
+    };
+
+    void Run();
+    void Rebuild(CallAggregateStore& store);
+    // Догрузить звонки после watermark и из пропусков; возвращает число учтённых звонков
+    size_t CatchUp(CallAggregateStore& store);
+
+    // Первые сутки рейтингов на текущий момент
+    int64_t LeadersFrom() const;
+    void AddLeader(Leaders& leaders, int64_t from_day, const ui::detail::CallStatisticsInfo& call) const;
+    // Рейтинги по звонкам с id <= max_id начиная с суток from_day
+    Leaders ReadLeaders(CallAggregateStore& store, int64_t max_id, int64_t from_day) const;
+    // Загрузить рейтинги к восстановленному из контрольной точки состоянию
+    void LoadLeaders(CallAggregateStore& store);
+
+    // Окно из целых поддерживаемых суток; вызывается под state_mutex_
+    std::optional<std::pair<int64_t, int64_t>> LeaderDays(const analytics::TimeWindow& window) const;
+
+    bool SaveCheckpoint();
+    bool LoadCheckpoint();
+
+    // Суммы по транкам (by_trunk = true) или тарифам внутри окна; вызывается под state_mutex_
+    template <typename Visitor>
+    bool ForEachGroup(const analytics::TimeWindow& window, bool by_trunk, Visitor&& visitor) const;
+
+    StoreFactory factory_;
+    Options options_;
+
+    // Пропуски ниже watermark; меняются только потоком Run()
+    IdGaps gaps_;
+
+    mutable std::shared_mutex state_mutex_;
+    State state_;
+    bool ready_ = false;
+    // Копии для Watermark()/Generation(), меняются под state_mutex_ вместе с state_
+    std::atomic<int64_t> watermark_{0};
+    std::atomic<uint64_t> generation_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    bool notified_ = false;
+    bool rebuild_requested_ = false;
+    Stats stats_;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+};
+
+// Глобальный экземпляр (запускается в main при наличии DB_URL)
+extern CallAggregates g_call_aggregates;
+
+} // namespace app
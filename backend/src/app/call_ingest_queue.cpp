@@ -0,0 +1,293 @@
+#include "call_ingest_queue.h"
+#include "../logger/logger.h"
+
+#include <algorithm>
+
+namespace app {
+using namespace std::literals;
+
+namespace {
+
+constexpr auto MIN_RETRY_DELAY = 100ms;
+constexpr auto MAX_RETRY_DELAY = 5000ms;
+
+} // namespace
+
+// Глобальный экземпляр
+CallIngestQueue g_call_ingest_queue;
+
+CallIngestQueue::~CallIngestQueue() {
+    Stop();
+}
+
+void CallIngestQueue::Start(Writer writer, Writer retry_writer, Options options) {
+    if (running_) {
+        return;
+    }
+
+    writer_ = std::move(writer);
+    retry_writer_ = std::move(retry_writer);
+    options_ = options;
+    options_.max_batch = std::max<size_t>(options_.max_batch, 1);
+    {
+        std::lock_guard lock{mutex_};
+        metrics_.capacity = options_.capacity;
+    }
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&CallIngestQueue::Run, this);
+}
+
+void CallIngestQueue::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    stop_requested_ = true;
+    cond_var_.notify_all();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    running_ = false;
+    LOG_INFO("CallIngestQueue stopped");
+}
+
+bool CallIngestQueue::IsRunning() const {
+    return running_;
+}
+
+std::optional<std::future<domain::BulkInsertResult>> CallIngestQueue::Enqueue(std::vector<domain::CallStatistics> calls) {
+    Pending pending{std::move(calls), {}};
+    auto future = pending.promise.get_future();
+
+    {
+        std::lock_guard lock{mutex_};
+        if (!running_ || stop_requested_ || depth_ + pending.calls.size() > options_.capacity) {
+            ++metrics_.rejected;
+            return std::nullopt;
+        }
+
+        depth_ += pending.calls.size();
+        metrics_.enqueued += pending.calls.size();
+        queue_.push_back(std::move(pending));
+    }
+    cond_var_.notify_one();
+
+    return future;
+}
+
+CallIngestQueue::Metrics CallIngestQueue::GetMetrics() const {
+    std::lock_guard lock{mutex_};
+    Metrics result = metrics_;
+    result.depth = depth_;
+    return result;
+}
+
+void CallIngestQueue::SetSpool(std::shared_ptr<CallSpool> spool) {
+    spool_ = std::move(spool);
+}
+
+std::optional<CallSpool::Stats> CallIngestQueue::GetSpoolStats() const {
+    if (!spool_) {
+        return std::nullopt;
+    }
+    return spool_->GetStats();
+}
+
+bool CallIngestQueue::SpoolEmpty() const {
+    return !spool_ || spool_->Empty();
+}
+
+void CallIngestQueue::Run() {
+    auto retry_delay = MIN_RETRY_DELAY;
+
+    while (true) {
+        bool queue_empty = false;
+        {
+            std::unique_lock lock{mutex_};
+            // Ждём либо полного пакета, либо истечения интервала сброса:
+            // так под нагрузкой звонки разных запросов уходят одним COPY
+            cond_var_.wait_for(lock, options_.flush_interval, [this] {
+                return stop_requested_ || depth_ >= options_.max_batch;
+            });
+            queue_empty = queue_.empty();
+        }
+
+        if (queue_empty && (stop_requested_ || SpoolEmpty())) {
+            if (stop_requested_) {
+                break;
+            }
+            continue;
+        }
+
+        // Сначала журнал, чтобы звонки попадали в БД в порядке поступления.
+        // При остановке журнал не проигрывается - он дождётся следующего запуска
+        bool db_available = true;
+        if (!SpoolEmpty() && !stop_requested_) {
+            db_available = ReplaySpool();
+        }
+        if (!queue_empty) {
+            db_available = Flush() && db_available;
+        }
+
+        if (db_available) {
+            retry_delay = MIN_RETRY_DELAY;
+            continue;
+        }
+
+        // БД недоступна: при остановке не ждём бесконечно, остаток будет потерян
+        if (stop_requested_) {
+            std::lock_guard lock{mutex_};
+            if (!queue_.empty()) {
+                LOG_ERROR("CallIngestQueue stopped with " + std::to_string(depth_) + " unsaved calls");
+                // Ожидающие запросы получают явный отказ, а не broken_promise
+                for (auto& pending : queue_) {
+                    pending.promise.set_exception(std::make_exception_ptr(
+                        Unavailable("database unavailable, ingest queue stopped before the calls were saved")));
+                }
+                queue_.clear();
+                depth_ = 0;
+                break;
+            }
+            continue;
+        }
+
+        std::unique_lock lock{mutex_};
+        cond_var_.wait_for(lock, retry_delay, [this] {
+            return stop_requested_.load();
+        });
+        retry_delay = std::min(retry_delay * 2, MAX_RETRY_DELAY);
+    }
+}
+
+bool CallIngestQueue::ReplaySpool() {
+    auto calls = spool_->Peek(options_.max_batch);
+    if (calls.empty()) {
+        // Остались только устаревшие записи
+        spool_->Consume();
+        return true;
+    }
+
+    try {
+        auto result = retry_writer_(calls);
+        spool_->Consume();
+
+        // Отклонённые звонки из журнала уже некому вернуть: остаются только в логе
+        for (const auto& error : result.errors) {
+            LOG_ERROR("Failed to save spooled call " + calls[error.index].GetCallId() + ": " + error.message);
+        }
+
+        std::lock_guard lock{mutex_};
+        metrics_.written += result.inserted;
+        metrics_.failed += result.errors.size();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("CallIngestQueue spool replay failed: " + std::string(e.what()));
+        std::lock_guard lock{mutex_};
+        ++metrics_.flush_errors;
+        return false;
+    }
+
+    return true;
+}
+
+bool CallIngestQueue::Flush() {
+    // Забираем целые запросы из головы очереди, пока пакет не наберётся
+    std::vector<Pending> taken;
+    std::vector<domain::CallStatistics> batch;
+    {
+        std::lock_guard lock{mutex_};
+        while (!queue_.empty() && (batch.empty() || batch.size() + queue_.front().calls.size() <= options_.max_batch)) {
+            auto& pending = queue_.front();
+            batch.insert(batch.end(), pending.calls.begin(), pending.calls.end());
+            taken.push_back(std::move(pending));
+            queue_.pop_front();
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    domain::BulkInsertResult result;
+    bool db_available = true;
+
+    // Упавший пакет мог сохраниться частично (COPY фиксируется частями):
+    // повтор пропускает уже записанные call_id
+    bool retry = std::any_of(taken.begin(), taken.end(), [](const Pending& pending) {
+        return pending.retry;
+    });
+
+    // Пока журнал не проигран, новые звонки встают за ним, а не обгоняют его
+    bool write_to_spool = !SpoolEmpty();
+    if (!write_to_spool) {
+        try {
+            result = retry ? retry_writer_(batch) : writer_(batch);
+            // Повтор идёт уже после того, как запрос мог перестать ждать ответа
+            if (retry) {
+                for (const auto& error : result.errors) {
+                    LOG_ERROR("Failed to save retried call " + batch[error.index].GetCallId() + ": " + error.message);
+                }
+            }
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("CallIngestQueue flush failed: " + std::string(e.what()));
+            db_available = false;
+            write_to_spool = true;
+        }
+    }
+
+    if (write_to_spool) {
+        if (!spool_ || !spool_->Append(batch)) {
+            // Возвращаем запросы в голову очереди в исходном порядке
+            std::lock_guard lock{mutex_};
+            for (auto it = taken.rbegin(); it != taken.rend(); ++it) {
+                it->retry = true;
+                queue_.push_front(std::move(*it));
+            }
+            ++metrics_.flush_errors;
+            return false;
+        }
+
+        result.spooled = batch.size();
+    }
+
+    double flush_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard lock{mutex_};
+        depth_ -= batch.size();
+        // При повторе пропущенные звонки записала прошлая попытка
+        metrics_.written += result.inserted + result.duplicates;
+        metrics_.failed += result.errors.size();
+        metrics_.spooled += result.spooled;
+        ++metrics_.flushes;
+        metrics_.last_flush_ms = flush_ms;
+        metrics_.max_flush_ms = std::max(metrics_.max_flush_ms, flush_ms);
+        total_flush_ms_ += flush_ms;
+        metrics_.avg_flush_ms = total_flush_ms_ / metrics_.flushes;
+    }
+
+    // Раздаём результат запросам: ошибки пересчитываются в их собственные индексы
+    auto error = result.errors.begin();
+    size_t offset = 0;
+    for (auto& pending : taken) {
+        size_t size = pending.calls.size();
+        domain::BulkInsertResult own;
+        for (; error != result.errors.end() && error->index < offset + size; ++error) {
+            own.errors.push_back({error->index - offset, std::move(error->message)});
+        }
+        if (result.spooled > 0) {
+            own.spooled = size;
+        }
+        else {
+            own.inserted = size - own.errors.size();
+        }
+        pending.promise.set_value(std::move(own));
+        offset += size;
+    }
+
+    return db_available;
+}
+
+} // namespace app
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "call_spool.h"
+#include "../domain/call_statistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace app {
+
+// Когда подтверждать приём звонков клиенту
+enum class IngestDurability {
+    QUEUED,    // сразу после постановки в очередь
+    COMMITTED  // после фиксации пакета в БД
+};
+
+// Ограниченная очередь записи call_statistics (write-behind).
+// Запросы только кладут звонки в очередь, фоновый поток собирает
+// звонки нескольких запросов в один пакет и пишет его в БД (group commit).
+// Если очередь заполнена, Enqueue отказывает сразу - вызывающий
+// должен вернуть клиенту 503 и повторить позже.
+// С подключённым журналом (CallSpool) пакеты, которые не удалось записать
+// из-за недоступности БД, сохраняются на диск и проигрываются позже.
+class CallIngestQueue {
+public:
+    // Ошибка future из Enqueue: очередь остановлена, а звонки не записаны
+    // ни в БД, ни в журнал (клиенту - 503)
+    class Unavailable : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Запись пакета в БД. Исключение означает, что БД недоступна:
+    // пакет остаётся в очереди и повторяется позже. Часть пакета к этому
+    // моменту может быть уже зафиксирована, поэтому повтор идёт через
+    // идемпотентную запись (retry_writer в Start)
+    using Writer = std::function<domain::BulkInsertResult(const std::vector<domain::CallStatistics>&)>;
+
+    struct Options {
+        size_t capacity = 100000;                   // звонков в очереди
+        size_t max_batch = 5000;                    // звонков в одном сбросе
+        std::chrono::milliseconds flush_interval{50};
+    };
+
+    struct Metrics {
+        size_t depth = 0;
+        size_t capacity = 0;
+        uint64_t enqueued = 0;
+        uint64_t written = 0;
+        uint64_t failed = 0;
+        uint64_t rejected = 0;
+        uint64_t flushes = 0;
+        uint64_t flush_errors = 0;
+        uint64_t spooled = 0;
+        double last_flush_ms = 0.0;
+        double avg_flush_ms = 0.0;
+        double max_flush_ms = 0.0;
+    };
+
+    CallIngestQueue() = default;
+    ~CallIngestQueue();
+
+    CallIngestQueue(const CallIngestQueue&) = delete;
+    CallIngestQueue& operator=(const CallIngestQueue&) = delete;
+
+    // Подключить журнал до Start(). Журнал проигрывается через retry_writer
+    void SetSpool(std::shared_ptr<CallSpool> spool);
+
+    // retry_writer должен быть идемпотентным (пропускать уже сохранённые call_id):
+    // им повторяются упавшие пакеты и проигрывается журнал, который может
+    // проигрываться повторно
+    void Start(Writer writer, Writer retry_writer, Options options);
+    // Останавливает поток записи, предварительно сбросив очередь в БД
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Поставить звонки в очередь целиком. nullopt - очередь заполнена (backpressure).
+    // future завершается, когда пакет с этими звонками записан; индексы
+    // ошибок в результате относятся к переданному вектору. Если очередь
+    // остановлена при недоступной БД, future завершается исключением Unavailable
+    std::optional<std::future<domain::BulkInsertResult>> Enqueue(std::vector<domain::CallStatistics> calls);
+
+    Metrics GetMetrics() const;
+    std::optional<CallSpool::Stats> GetSpoolStats() const;
+
+private:
+    struct Pending {
+        std::vector<domain::CallStatistics> calls;
+        std::promise<domain::BulkInsertResult> promise;
+        bool retry = false; // запись уже падала, часть звонков могла сохраниться
+    };
+
+    void Run();
+    // Один сброс: до max_batch звонков из головы очереди. false - БД недоступна
+    bool Flush();
+    // Проигрывание части журнала. false - БД недоступна
+    bool ReplaySpool();
+    bool SpoolEmpty() const;
+
+    Writer writer_;
+    Writer retry_writer_;
+    std::shared_ptr<CallSpool> spool_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<Pending> queue_;
+    size_t depth_ = 0;
+
+    Metrics metrics_;
+    double total_flush_ms_ = 0.0;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+};
+
+// Глобальный экземпляр очереди (запускается в main при наличии DB_URL)
+extern CallIngestQueue g_call_ingest_queue;
+
+} // namespace app
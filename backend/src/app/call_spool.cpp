@@ -0,0 +1,389 @@
+#include "call_spool.h"
+#include "../logger/logger.h"
+
+#include <boost/crc.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+
+namespace app {
+using namespace std::literals;
+
+namespace {
+
+constexpr char SPOOL_MAGIC[8] = {'C', 'A', 'L', 'L', 'S', 'P', 'O', 'L'};
+// Стоимость - целое число миллионных долей, call_time - микросекунды от эпохи
+constexpr uint32_t SPOOL_VERSION = 3;
+
+// Длина и CRC записи
+constexpr size_t RECORD_PREFIX_SIZE = 2 * sizeof(uint32_t);
+// Запись больше этого размера считается повреждённой
+constexpr uint32_t MAX_RECORD_SIZE = 64 * 1024;
+
+int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint32_t Crc32(const char* data, size_t size) {
+    boost::crc_32_type crc;
+    crc.process_bytes(data, size);
+    return crc.checksum();
+}
+
+template <typename T>
+void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutString(std::string& out, const std::string& value) {
+    Put(out, static_cast<uint16_t>(value.size()));
+    out.append(value);
+}
+
+// Чтение полей записи с проверкой границ
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T Get() {
+        T value{};
+        Check(sizeof(T));
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string GetString() {
+        auto length = Get<uint16_t>();
+        Check(length);
+        std::string value(data_ + pos_, length);
+        pos_ += length;
+        return value;
+    }
+
+private:
+    void Check(size_t length) const {
+        if (pos_ + length > size_) {
+            throw std::runtime_error("Spool record is truncated"s);
+        }
+    }
+
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+std::string EncodeRecord(const domain::CallStatistics& call, int64_t spooled_at) {
+    std::string payload;
+    Put(payload, spooled_at);
+    Put(payload, static_cast<int32_t>(call.GetTrunkId()));
+    Put(payload, static_cast<int32_t>(call.GetTarifId()));
+    Put(payload, static_cast<int32_t>(call.GetDurationSeconds()));
+    Put(payload, call.GetCost().Micros());
+    PutString(payload, call.GetCallId());
+    Put(payload, call.GetCallTime());
+
+    std::string record;
+    record.reserve(RECORD_PREFIX_SIZE + payload.size());
+    Put(record, static_cast<uint32_t>(payload.size()));
+    Put(record, Crc32(payload.data(), payload.size()));
+    record += payload;
+    return record;
+}
+
+// Бросает std::runtime_error, если поля не помещаются в запись
+domain::CallStatistics DecodeRecord(const char* payload, size_t size, int64_t& spooled_at) {
+    Reader reader(payload, size);
+    spooled_at = reader.Get<int64_t>();
+    auto trunk_id = reader.Get<int32_t>();
+    auto tarif_id = reader.Get<int32_t>();
+    auto duration_seconds = reader.Get<int32_t>();
+    auto cost = domain::Money::FromMicros(reader.Get<int64_t>());
+    auto call_id = reader.GetString();
+    auto call_time = reader.Get<int64_t>();
+    return domain::CallStatistics{0, std::move(call_id), trunk_id, tarif_id, duration_seconds, cost, call_time};
+}
+
+} // namespace
+
+struct CallSpool::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;
+    uint64_t head;    // начало непроигранных записей
+    uint64_t tail;    // конец последней подтверждённой записи
+    uint64_t records; // непроигранных записей
+    uint64_t reserved[2];
+};
+
+CallSpool::CallSpool(Options options)
+    : options_(std::move(options)) {
+    static_assert(sizeof(Header) == 64);
+
+    std::filesystem::path path(options_.path);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+
+    fd_ = ::open(options_.path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open spool file "s + options_.path + ": "s + std::strerror(errno));
+    }
+
+    struct stat st{};
+    if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to stat spool file "s + options_.path + ": "s + std::strerror(errno));
+    }
+
+    // Размер существующего файла не меняем: в нём могут быть непроигранные записи
+    bool created = st.st_size == 0;
+    size_ = created ? std::max(options_.max_bytes, sizeof(Header) * 2) : static_cast<size_t>(st.st_size);
+
+    if (created && ::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to allocate spool file "s + options_.path + ": "s + std::strerror(errno));
+    }
+
+    void* mapped = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to map spool file "s + options_.path + ": "s + std::strerror(errno));
+    }
+    data_ = static_cast<char*>(mapped);
+
+    auto& header = GetHeader();
+    if (created) {
+        std::memcpy(header.magic, SPOOL_MAGIC, sizeof(SPOOL_MAGIC));
+        header.version = SPOOL_VERSION;
+        header.header_size = sizeof(Header);
+        header.capacity = size_;
+        header.head = sizeof(Header);
+        header.tail = sizeof(Header);
+        header.records = 0;
+        Sync(0, sizeof(Header));
+    }
+    else if (size_ < sizeof(Header) || std::memcmp(header.magic, SPOOL_MAGIC, sizeof(SPOOL_MAGIC)) != 0
+             || header.version != SPOOL_VERSION) {
+        ::munmap(data_, size_);
+        ::close(fd_);
+        throw std::runtime_error("File "s + options_.path + " is not a call spool"s);
+    }
+
+    stats_.path = options_.path;
+    stats_.capacity_bytes = size_;
+    stats_.max_age_seconds = options_.max_age.count();
+
+    Recover();
+}
+
+CallSpool::~CallSpool() {
+    if (data_) {
+        ::msync(data_, size_, MS_SYNC);
+        ::munmap(data_, size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+CallSpool::Header& CallSpool::GetHeader() const {
+    return *reinterpret_cast<Header*>(data_);
+}
+
+void CallSpool::Recover() {
+    auto& header = GetHeader();
+
+    if (header.head < sizeof(Header) || header.tail > size_ || header.head > header.tail) {
+        LOG_ERROR("Spool header is inconsistent, spool is reset: " + options_.path);
+        header.head = header.tail = sizeof(Header);
+        header.records = 0;
+        ++stats_.corrupted;
+        Sync(0, sizeof(Header));
+        return;
+    }
+
+    // Проверяем все непроигранные записи; с первой повреждённой журнал обрезается
+    uint64_t records = 0;
+    uint64_t pos = header.head;
+    while (pos < header.tail) {
+        uint32_t length = 0;
+        uint32_t crc = 0;
+        bool valid = pos + RECORD_PREFIX_SIZE <= header.tail;
+        if (valid) {
+            std::memcpy(&length, data_ + pos, sizeof(length));
+            std::memcpy(&crc, data_ + pos + sizeof(length), sizeof(crc));
+            valid = length <= MAX_RECORD_SIZE && pos + RECORD_PREFIX_SIZE + length <= header.tail
+                    && Crc32(data_ + pos + RECORD_PREFIX_SIZE, length) == crc;
+        }
+        if (!valid) {
+            LOG_ERROR("Spool record at offset " + std::to_string(pos) + " is corrupted, spool truncated");
+            ++stats_.corrupted;
+            header.tail = pos;
+            break;
+        }
+        pos += RECORD_PREFIX_SIZE + length;
+        ++records;
+    }
+
+    header.records = records;
+    if (header.head == header.tail) {
+        header.head = header.tail = sizeof(Header);
+    }
+    Sync(0, sizeof(Header));
+
+    if (records > 0) {
+        LOG_INFO("Spool " + options_.path + " contains " + std::to_string(records) + " unsaved calls");
+    }
+}
+
+void CallSpool::Sync(size_t offset, size_t length) {
+    if (!options_.sync_writes || length == 0) {
+        return;
+    }
+
+    // msync требует адрес, выровненный по странице
+    static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin = offset / page_size * page_size;
+    ::msync(data_ + begin, offset + length - begin, MS_SYNC);
+}
+
+bool CallSpool::Append(const std::vector<domain::CallStatistics>& calls) {
+    std::lock_guard lock{mutex_};
+    auto& header = GetHeader();
+
+    int64_t now = NowMicros();
+    std::string buffer;
+    for (const auto& call : calls) {
+        buffer += EncodeRecord(call, now);
+    }
+
+    if (header.tail + buffer.size() > size_) {
+        stats_.rejected += calls.size();
+        return false;
+    }
+
+    // Сначала данные, затем заголовок: после сбоя посередине записи
+    // tail указывает на последнюю целую запись
+    std::memcpy(data_ + header.tail, buffer.data(), buffer.size());
+    Sync(header.tail, buffer.size());
+
+    header.tail += buffer.size();
+    header.records += calls.size();
+    Sync(0, sizeof(Header));
+
+    stats_.appended += calls.size();
+    return true;
+}
+
+std::vector<domain::CallStatistics> CallSpool::Peek(size_t max_records) {
+    std::lock_guard lock{mutex_};
+    auto& header = GetHeader();
+
+    std::vector<domain::CallStatistics> result;
+    peek_records_ = 0;
+    peek_expired_ = 0;
+
+    int64_t expire_before = NowMicros()
+                            - std::chrono::duration_cast<std::chrono::microseconds>(options_.max_age).count();
+
+    uint64_t pos = header.head;
+    while (pos < header.tail && result.size() < max_records) {
+        uint32_t length = 0;
+        std::memcpy(&length, data_ + pos, sizeof(length));
+
+        // Запись с верной CRC, но неразборчивыми полями - как повреждённая при
+        // восстановлении: журнал обрезается перед ней, прочитанное до неё проигрывается
+        int64_t spooled_at = 0;
+        std::optional<domain::CallStatistics> call;
+        try {
+            call = DecodeRecord(data_ + pos + RECORD_PREFIX_SIZE, length, spooled_at);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Spool record at offset " + std::to_string(pos) + " is unreadable, spool truncated: "s
+                      + e.what());
+            ++stats_.corrupted;
+            header.tail = pos;
+            header.records = peek_records_ + peek_expired_;
+            Sync(0, sizeof(Header));
+            break;
+        }
+        pos += RECORD_PREFIX_SIZE + length;
+
+        if (spooled_at < expire_before) {
+            ++peek_expired_;
+            continue;
+        }
+        result.push_back(std::move(*call));
+        ++peek_records_;
+    }
+
+    peek_end_ = pos;
+    return result;
+}
+
+void CallSpool::Consume() {
+    std::lock_guard lock{mutex_};
+    auto& header = GetHeader();
+
+    if (peek_end_ <= header.head) {
+        return;
+    }
+
+    header.head = peek_end_;
+    header.records -= std::min(header.records, peek_records_ + peek_expired_);
+    if (header.head >= header.tail) {
+        // Журнал вычитан - следующая запись снова с начала файла
+        header.head = header.tail = sizeof(Header);
+        header.records = 0;
+        header.version = SPOOL_VERSION;
+    }
+    Sync(0, sizeof(Header));
+
+    stats_.replayed += peek_records_;
+    stats_.expired += peek_expired_;
+    if (peek_expired_ > 0) {
+        LOG_WARNING("Dropped " + std::to_string(peek_expired_) + " expired calls from spool");
+    }
+
+    peek_end_ = 0;
+    peek_records_ = 0;
+    peek_expired_ = 0;
+}
+
+bool CallSpool::Empty() const {
+    std::lock_guard lock{mutex_};
+    const auto& header = GetHeader();
+    return header.head == header.tail;
+}
+
+CallSpool::Stats CallSpool::GetStats() const {
+    std::lock_guard lock{mutex_};
+    const auto& header = GetHeader();
+
+    Stats result = stats_;
+    result.used_bytes = header.tail;
+    result.records = header.records;
+
+    if (header.head < header.tail) {
+        int64_t spooled_at = 0;
+        std::memcpy(&spooled_at, data_ + header.head + RECORD_PREFIX_SIZE, sizeof(spooled_at));
+        result.oldest_age_seconds = static_cast<double>(NowMicros() - spooled_at) / 1'000'000.0;
+    }
+
+    return result;
+}
+
+} // namespace app
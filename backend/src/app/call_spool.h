@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../domain/call_statistics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace app {
+
+// Локальный журнал звонков на время недоступности БД.
+// Файл фиксированного размера отображается в память (mmap), записи только
+// дописываются в конец и защищены CRC32. Очередь записи складывает сюда
+// пакеты, которые не удалось записать в БД, и по восстановлению связи
+// проигрывает их в исходном порядке. Когда журнал вычитан целиком,
+// запись снова начинается с начала файла.
+//
+// Формат: заголовок (64 байта) и записи [длина u32][crc32 u32][данные].
+class CallSpool {
+public:
+    struct Options {
+        std::string path;
+        size_t max_bytes = 256 * 1024 * 1024;
+        std::chrono::seconds max_age{72 * 3600}; // более старые записи при проигрывании отбрасываются
+        bool sync_writes = true;                 // msync после каждой записи
+    };
+
+    struct Stats {
+        std::string path;
+        uint64_t used_bytes = 0;
+        uint64_t capacity_bytes = 0;
+        uint64_t records = 0;
+        double oldest_age_seconds = 0.0;
+        int64_t max_age_seconds = 0;
+        uint64_t appended = 0;
+        uint64_t replayed = 0;
+        uint64_t expired = 0;
+        uint64_t rejected = 0;  // не поместились в файл
+        uint64_t corrupted = 0; // обрезаний журнала: неверная CRC или неразборчивая запись
+    };
+
+    // Открывает или создаёт файл и проверяет записи. Бросает std::runtime_error
+    explicit CallSpool(Options options);
+    ~CallSpool();
+
+    CallSpool(const CallSpool&) = delete;
+    CallSpool& operator=(const CallSpool&) = delete;
+
+    // Дописать пакет целиком. false - не хватает места
+    bool Append(const std::vector<domain::CallStatistics>& calls);
+
+    // Первые max_records записей журнала (устаревшие пропускаются).
+    // Журнал не меняется, пока не вызван Consume()
+    std::vector<domain::CallStatistics> Peek(size_t max_records);
+
+    // Отметить записи, возвращённые последним Peek(), как проигранные
+    void Consume();
+
+    bool Empty() const;
+
+    Stats GetStats() const;
+
+private:
+    struct Header;
+
+    Header& GetHeader() const;
+    void Recover();
+    void Sync(size_t offset, size_t length);
+
+    Options options_;
+    int fd_ = -1;
+    char* data_ = nullptr;
+    size_t size_ = 0;
+
+    mutable std::mutex mutex_;
+    uint64_t peek_end_ = 0;
+    uint64_t peek_records_ = 0;
+    uint64_t peek_expired_ = 0;
+    Stats stats_;
+};
+
+} // namespace app
@@ -0,0 +1,219 @@
+#include "call_store.h"
+#include "../domain/timestamp.h"
+#include "../logger/logger.h"
+
+#include <algorithm>
+#include <optional>
+
+namespace app {
+using namespace std::literals;
+
+// Глобальный экземпляр
+CallStore g_call_store;
+
+CallStore::~CallStore() {
+    Stop();
+}
+
+void CallStore::Start(Loader loader, Options options) {
+    if (running_) {
+        return;
+    }
+
+    loader_ = std::move(loader);
+    options_ = options;
+    options_.chunk_rows = std::max<size_t>(options_.chunk_rows, 1);
+    gaps_.SetWindow(options_.late_commit_window);
+    gaps_.Clear();
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&CallStore::Run, this);
+}
+
+void CallStore::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        stop_requested_ = true;
+    }
+    cond_var_.notify_all();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    snapshot_.store(nullptr);
+    watermark_ = 0;
+    ++generation_;
+    running_ = false;
+    LOG_INFO("CallStore stopped");
+}
+
+bool CallStore::IsRunning() const {
+    return running_;
+}
+
+std::shared_ptr<const analytics::CallColumns> CallStore::GetSnapshot() const {
+    return snapshot_.load();
+}
+
+std::shared_ptr<const analytics::CallColumns> CallStore::GetCovering(const analytics::TimeWindow& window) const {
+    auto snapshot = snapshot_.load();
+    if (!snapshot || window.from < snapshot->covered_from) {
+        return nullptr;
+    }
+    return snapshot;
+}
+
+void CallStore::Invalidate() {
+    {
+        std::lock_guard lock{mutex_};
+        reload_requested_ = true;
+    }
+    cond_var_.notify_all();
+}
+
+CallStore::Stats CallStore::GetStats() const {
+    std::lock_guard lock{mutex_};
+    Stats result = stats_;
+    if (auto snapshot = snapshot_.load()) {
+        result.ready = true;
+        result.rows = snapshot->rows;
+        result.chunks = snapshot->chunks.size();
+        result.memory_bytes = snapshot->MemoryBytes();
+        result.watermark = snapshot->watermark;
+        result.covered_from = snapshot->covered_from;
+    }
+    return result;
+}
+
+int64_t CallStore::Watermark() const {
+    return watermark_.load();
+}
+
+uint64_t CallStore::Generation() const {
+    return generation_.load();
+}
+
+void CallStore::Run() {
+    auto last_full_reload = std::chrono::steady_clock::now();
+    bool full = true;
+
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            auto current = snapshot_.load();
+            size_t late = 0;
+            auto fresh = Load(full || !current ? nullptr : current.get(), late);
+            snapshot_.store(fresh);
+            watermark_.store(fresh->watermark);
+            // Строки ниже watermark меняют данные без его роста
+            if (full || !current || late > 0) {
+                ++generation_;
+            }
+
+            std::lock_guard lock{mutex_};
+            ++stats_.refreshes;
+            stats_.late_calls += late;
+            if (full || !current) {
+                ++stats_.full_reloads;
+                last_full_reload = start;
+                LOG_INFO("CallStore loaded " + std::to_string(fresh->rows) + " calls");
+            }
+            stats_.last_refresh_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+        catch (const std::exception& e) {
+            // Остаётся прежний снимок, попытка повторится через refresh_interval
+            LOG_ERROR("CallStore refresh failed: "s + e.what());
+            std::lock_guard lock{mutex_};
+            ++stats_.errors;
+            stats_.last_error = e.what();
+        }
+
+        std::unique_lock lock{mutex_};
+        cond_var_.wait_for(lock, options_.refresh_interval, [this] {
+            return stop_requested_ || reload_requested_;
+        });
+        if (stop_requested_) {
+            break;
+        }
+
+        full = reload_requested_
+               || std::chrono::steady_clock::now() - last_full_reload >= options_.full_reload_interval;
+        reload_requested_ = false;
+    }
+}
+
+std::shared_ptr<const analytics::CallColumns> CallStore::Load(const analytics::CallColumns* base, size_t& late) {
+    int64_t cutoff = domain::NowTimestamp()
+                     - std::chrono::duration_cast<std::chrono::microseconds>(options_.retention).count();
+
+    auto result = std::make_shared<analytics::CallColumns>();
+    result->covered_from = cutoff;
+
+    int64_t after_id = 0;
+    std::vector<domain::IdRange> missing;
+    if (base) {
+        after_id = base->watermark;
+        result->covered_from = std::max(base->covered_from, cutoff);
+
+        // Часть отбрасывается, только когда все её звонки старше cutoff,
+        // поэтому звонки с call_time >= covered_from остаются в снимке
+        for (const auto& chunk : base->chunks) {
+            if (chunk->max_call_time >= cutoff) {
+                result->chunks.push_back(chunk);
+            }
+        }
+        missing = gaps_.Begin(after_id);
+    }
+    else {
+        // Полная загрузка читает всё до нового watermark. Пропуски в ней не
+        // запоминаются: без границы по id они покрывали бы строки старше cutoff
+        gaps_.Clear();
+    }
+
+    // Новые строки дописываются в копию последней неполной части,
+    // чтобы частые дозагрузки не дробили хранилище на мелкие части
+    std::optional<analytics::CallChunkBuilder> builder;
+    int64_t watermark = after_id;
+
+    loader_(after_id, missing, cutoff, [&](const ui::detail::CallStatisticsInfo& call) {
+        if (!builder) {
+            if (!result->chunks.empty() && result->chunks.back()->Size() < options_.chunk_rows) {
+                builder.emplace(*result->chunks.back(), options_.chunk_rows);
+                result->chunks.pop_back();
+            }
+            else {
+                builder.emplace(options_.chunk_rows);
+            }
+        }
+
+        builder->Add(call);
+        if (!base || !gaps_.Visit(call.id)) {
+            watermark = std::max(watermark, call.id);
+        }
+
+        if (builder->Full()) {
+            result->chunks.push_back(builder->Finish());
+            builder.reset();
+        }
+    });
+
+    if (builder && builder->Size() > 0) {
+        result->chunks.push_back(builder->Finish());
+    }
+
+    late = base ? gaps_.Commit() : 0;
+
+    result->watermark = watermark;
+    for (const auto& chunk : result->chunks) {
+        result->rows += chunk->Size();
+    }
+    return result;
+}
+
+} // namespace app
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "id_gaps.h"
+#include "../analytics/analytics.h"
+#include "../analytics/call_columns.h"
+#include "../domain/call_statistics_fwd.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace app {
+
+// Колоночная копия свежих звонков (за последние retention) в памяти для аналитики.
+// Фоновый поток дозагружает строки с id больше наибольшего загруженного (watermark)
+// и отбрасывает части, вышедшие за retention. Читатели получают неизменяемый
+// снимок через atomic shared_ptr без блокировок.
+//
+// Строки, чья транзакция зафиксирована позже строки с большим id, дозагрузка
+// находит по запомненным пропускам id (IdGaps) в течение late_commit_window.
+// Более долгие транзакции и строки, зафиксированные во время полной загрузки,
+// подбирает периодическая полная перезагрузка (full_reload_interval).
+// После пересчёта стоимости снимок перезагружается целиком
+class CallStore {
+public:
+    // Передать в visitor звонки с call_time >= since (микросекунды) и id > after_id
+    // или id из диапазонов missing, по возрастанию id
+    using Loader = std::function<void(int64_t after_id, const std::vector<domain::IdRange>& missing, int64_t since,
+                                      const domain::CallStatisticsVisitor& visitor)>;
+
+    struct Options {
+        std::chrono::hours retention{24 * 7};
+        std::chrono::milliseconds refresh_interval{2000};
+        std::chrono::minutes full_reload_interval{60};
+        std::chrono::seconds late_commit_window{600}; // сколько перечитывать пропущенные id; 0 - не перечитывать
+        size_t chunk_rows = 65536; // строк в одной части
+    };
+
+    struct Stats {
+        bool ready = false;           // первая загрузка завершена
+        size_t rows = 0;
+        size_t chunks = 0;
+        size_t memory_bytes = 0;
+        int64_t watermark = 0;
+        int64_t covered_from = 0;     // микросекунды от эпохи
+        uint64_t refreshes = 0;
+        uint64_t full_reloads = 0;
+        uint64_t late_calls = 0;      // найдено дозагрузками в пропусках ниже watermark
+        uint64_t errors = 0;
+        double last_refresh_ms = 0.0;
+        std::string last_error;
+    };
+
+    CallStore() = default;
+    ~CallStore();
+
+    CallStore(const CallStore&) = delete;
+    CallStore& operator=(const CallStore&) = delete;
+
+    void Start(Loader loader, Options options);
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Текущий снимок; nullptr - хранилище не запущено или первая загрузка не завершена
+    std::shared_ptr<const analytics::CallColumns> GetSnapshot() const;
+
+    // Снимок, если в нём есть все звонки окна; иначе nullptr (считать по БД)
+    std::shared_ptr<const analytics::CallColumns> GetCovering(const analytics::TimeWindow& window) const;
+
+    // Уже загруженные строки устарели (например, после пересчёта стоимости): перезагрузить целиком
+    void Invalidate();
+
+    Stats GetStats() const;
+
+    // Версия данных за O(1) без блокировок: наибольший загруженный id и число
+    // изменений, не сдвигающих его (полные перезагрузки, строки ниже watermark)
+    int64_t Watermark() const;
+    uint64_t Generation() const;
+
+private:
+    void Run();
+    // Новый снимок: base == nullptr - полная загрузка, иначе дозагрузка после
+    // base->watermark и из пропусков; late - число строк, найденных в пропусках
+    std::shared_ptr<const analytics::CallColumns> Load(const analytics::CallColumns* base, size_t& late);
+
+    Loader loader_;
+    Options options_;
+    // Пропуски ниже watermark; меняются только потоком Run()
+    IdGaps gaps_;
+
+    std::atomic<std::shared_ptr<const analytics::CallColumns>> snapshot_;
+    std::atomic<int64_t> watermark_{0};
+    std::atomic<uint64_t> generation_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    bool reload_requested_ = false;
+    Stats stats_;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+};
+
+// Глобальный экземпляр (запускается в main при наличии DB_URL)
+extern CallStore g_call_store;
+
+} // namespace app
@@ -0,0 +1,88 @@
+#include "id_gaps.h"
+
+#include <algorithm>
+
+namespace app {
+
+IdGaps::IdGaps(std::chrono::seconds window)
+    : window_(window) {}
+
+void IdGaps::SetWindow(std::chrono::seconds window) {
+    window_ = window;
+}
+
+std::vector<domain::IdRange> IdGaps::Begin(int64_t after_id) {
+    now_ = std::chrono::steady_clock::now();
+    after_id_ = after_id;
+    watermark_ = after_id;
+    late_.clear();
+    new_gaps_.clear();
+
+    std::erase_if(gaps_, [this](const Gap& gap) {
+        return now_ - gap.seen >= window_;
+    });
+
+    std::vector<domain::IdRange> missing;
+    missing.reserve(gaps_.size());
+    for (const auto& gap : gaps_) {
+        missing.push_back(gap.ids);
+    }
+    return missing;
+}
+
+bool IdGaps::Visit(int64_t id) {
+    if (id <= after_id_) {
+        late_.push_back(id);
+        return true;
+    }
+
+    if (id > watermark_ + 1) {
+        new_gaps_.push_back({{watermark_ + 1, id - 1}, now_});
+    }
+    watermark_ = id;
+    return false;
+}
+
+size_t IdGaps::Commit() {
+    // Найденные id исключаются из пропусков, новые пропуски - в конец (их id больше прежних)
+    if (!late_.empty()) {
+        std::vector<Gap> rest;
+        auto it = late_.begin();
+        for (const auto& gap : gaps_) {
+            int64_t from = gap.ids.from;
+            for (; it != late_.end() && *it <= gap.ids.to; ++it) {
+                if (*it > from) {
+                    rest.push_back({{from, *it - 1}, gap.seen});
+                }
+                from = std::max(from, *it + 1);
+            }
+            if (from <= gap.ids.to) {
+                rest.push_back({{from, gap.ids.to}, gap.seen});
+            }
+        }
+        gaps_ = std::move(rest);
+    }
+    if (window_.count() > 0) {
+        gaps_.insert(gaps_.end(), new_gaps_.begin(), new_gaps_.end());
+        if (gaps_.size() > MAX_GAPS) {
+            gaps_.erase(gaps_.begin(), gaps_.end() - MAX_GAPS);
+        }
+    }
+
+    size_t late = late_.size();
+    late_.clear();
+    new_gaps_.clear();
+    return late;
+}
+
+void IdGaps::Clear() {
+    gaps_.clear();
+    late_.clear();
+    new_gaps_.clear();
+}
+
+size_t IdGaps::Size() const {
+    return gaps_.size();
+}
+
+} // namespace app
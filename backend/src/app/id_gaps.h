@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../domain/call_statistics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace app {
+
+// Пропущенные id ниже watermark при догрузке звонков по возрастанию id.
+// Одновременные писатели фиксируют id не по порядку: звонок с меньшим id может
+// появиться после звонка с большим. Пропуски между прочитанными id запоминаются
+// и перечитываются при следующих догрузках в течение window; найденные id
+// исключаются из пропусков. Не потокобезопасен: используется одним потоком догрузки
+class IdGaps {
+public:
+    explicit IdGaps(std::chrono::seconds window = std::chrono::seconds{0});
+
+    void SetWindow(std::chrono::seconds window);
+
+    // Начать догрузку после after_id: пропуски, которые ещё стоит перечитать
+    // (старше window отбрасываются)
+    std::vector<domain::IdRange> Begin(int64_t after_id);
+    // Очередной прочитанный id (по возрастанию); true - id ниже after_id, найден в пропуске
+    bool Visit(int64_t id);
+    // Догрузка применена: исключить найденные id, запомнить новые пропуски.
+    // Возвращает число найденных в пропусках id
+    size_t Commit();
+
+    // Всё до watermark прочитано заново (полная загрузка)
+    void Clear();
+
+    size_t Size() const;
+
+private:
+    // Больше пропусков не перечитывается: старейшие отбрасываются
+    static constexpr size_t MAX_GAPS = 4096;
+
+    // Id ниже watermark, ещё не встреченные при догрузке, и когда пропуск замечен
+    struct Gap {
+        domain::IdRange ids;
+        std::chrono::steady_clock::time_point seen;
+    };
+
+    std::chrono::seconds window_;
+    // Пропуски по возрастанию id
+    std::vector<Gap> gaps_;
+
+    // Текущая догрузка
+    std::chrono::steady_clock::time_point now_;
+    int64_t after_id_ = 0;
+    int64_t watermark_ = 0;
+    std::vector<int64_t> late_;    // найденные в пропусках, по возрастанию
+    std::vector<Gap> new_gaps_;    // пропуски между новыми id
+};
+
+} // namespace app
@@ -0,0 +1,42 @@
+#include "reference_cache.h"
+
+namespace app {
+
+// Глобальный экземпляр
+ReferenceDataCache g_reference_cache;
+
+std::shared_ptr<const ReferenceData> ReferenceDataCache::GetOrLoad(const Loader& loader) {
+    // Быстрый путь: снимок актуален
+    auto data = data_.load();
+    if (data && data->version == version_.load()) {
+        return data;
+    }
+
+    std::lock_guard lock{load_mutex_};
+
+    // Снимок мог обновить другой поток, пока мы ждали блокировку
+    data = data_.load();
+    uint64_t version = version_.load();
+    if (data && data->version == version) {
+        return data;
+    }
+
+    auto fresh = std::make_shared<ReferenceData>(loader());
+    fresh->version = version;
+
+    // Если во время загрузки пришла инвалидация, версия снимка уже устарела
+    // и следующий читатель перечитает таблицы
+    data_.store(fresh);
+
+    return fresh;
+}
+
+void ReferenceDataCache::Invalidate() {
+    version_.fetch_add(1);
+}
+
+uint64_t ReferenceDataCache::GetVersion() const {
+    return version_.load();
+}
+
+} // namespace app
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../ui/view.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace app {
+
+// Неизменяемый снимок справочных таблиц (hub, server, nas_ip, trunk, pricelist, tarif)
+struct ReferenceData {
+    uint64_t version = 0;
+
+    std::vector<ui::detail::HubInfo> hubs;
+    std::vector<ui::detail::ServerInfo> servers;
+    std::vector<ui::detail::NasIpInfo> nas_ips;
+    std::vector<ui::detail::TrunkInfo> trunks;
+    std::vector<ui::detail::PricelistInfo> pricelists;
+    std::vector<ui::detail::TarifInfo> tarifs;
+};
+
+// Версионируемый кэш справочных данных (read-through).
+// Читатели получают снимок через atomic shared_ptr без блокировок,
+// загрузка из БД выполняется только после инвалидации.
+class ReferenceDataCache {
+public:
+    using Loader = std::function<ReferenceData()>;
+
+    ReferenceDataCache() = default;
+
+    ReferenceDataCache(const ReferenceDataCache&) = delete;
+    ReferenceDataCache& operator=(const ReferenceDataCache&) = delete;
+
+    // Получить актуальный снимок, при необходимости загрузив его через loader
+    std::shared_ptr<const ReferenceData> GetOrLoad(const Loader& loader);
+
+    // Пометить снимок устаревшим (вызывается после записи в справочные таблицы)
+    void Invalidate();
+
+    // Текущая версия справочных данных
+    uint64_t GetVersion() const;
+
+private:
+    std::atomic<std::shared_ptr<const ReferenceData>> data_;
+    std::atomic<uint64_t> version_{1};
+
+    // Не даём нескольким потокам одновременно перечитывать таблицы
+    std::mutex load_mutex_;
+};
+
+// Глобальный экземпляр кэша
+extern ReferenceDataCache g_reference_cache;
+
+} // namespace app
@@ -0,0 +1,306 @@
+#include "rerate_job.h"
+#include "analytics_cache.h"
+#include "call_store.h"
+#include "call_aggregates.h"
+#include "../rating/rater.h"
+#include "../logger/logger.h"
+
+#include <algorithm>
+
+namespace app {
+using namespace std::literals;
+
+namespace {
+
+// Шаг проверки остановки во время паузы
+constexpr auto THROTTLE_STEP = 100ms;
+
+} // namespace
+
+// Глобальный экземпляр
+RerateJob g_rerate_job;
+
+RerateJob::~RerateJob() {
+    Stop();
+}
+
+void RerateJob::Start(StoreFactory store_factory, ReferenceProvider reference_provider, Options options) {
+    if (running_) {
+        return;
+    }
+
+    store_factory_ = std::move(store_factory);
+    reference_provider_ = std::move(reference_provider);
+    options_ = options;
+    options_.chunk_size = std::max<size_t>(options_.chunk_size, 1);
+    options_.parallelism = std::max<size_t>(options_.parallelism, 1);
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&RerateJob::Run, this);
+}
+
+void RerateJob::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    stop_requested_ = true;
+    cancel_requested_ = true;
+    cond_var_.notify_all();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+        queue_.clear();
+    }
+
+    running_ = false;
+    LOG_INFO("RerateJob stopped");
+}
+
+bool RerateJob::IsRunning() const {
+    return running_;
+}
+
+uint64_t RerateJob::Submit(RerateScope scope) {
+    uint64_t job_id = 0;
+    {
+        std::lock_guard lock{mutex_};
+        if (!running_ || stop_requested_) {
+            return 0;
+        }
+
+        job_id = next_job_id_++;
+        LOG_INFO("Re-rating job #" + std::to_string(job_id) + " queued: " + scope.reason);
+        queue_.push_back({job_id, std::move(scope)});
+    }
+    cond_var_.notify_one();
+
+    return job_id;
+}
+
+void RerateJob::CancelCurrent() {
+    cancel_requested_ = true;
+}
+
+RerateJob::Progress RerateJob::GetProgress() const {
+    std::lock_guard lock{mutex_};
+    Progress result = progress_;
+    result.pending = queue_.size();
+    if (result.state == State::RUNNING) {
+        result.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at_).count();
+    }
+    return result;
+}
+
+bool RerateJob::Interrupted() const {
+    return stop_requested_ || cancel_requested_;
+}
+
+void RerateJob::Run() {
+    while (true) {
+        Queued job;
+        {
+            std::unique_lock lock{mutex_};
+            cond_var_.wait(lock, [this] {
+                return stop_requested_ || !queue_.empty();
+            });
+            if (stop_requested_) {
+                break;
+            }
+
+            job = std::move(queue_.front());
+            queue_.pop_front();
+
+            progress_ = {};
+            progress_.job_id = job.job_id;
+            progress_.state = State::RUNNING;
+            progress_.reason = job.scope.reason;
+            started_at_ = std::chrono::steady_clock::now();
+        }
+
+        cancel_requested_ = false;
+        State state = State::DONE;
+        std::string error;
+
+        try {
+            Execute(job.scope);
+            if (Interrupted()) {
+                state = State::CANCELLED;
+            }
+        }
+        catch (const std::exception& e) {
+            state = State::FAILED;
+            error = e.what();
+        }
+
+        std::lock_guard lock{mutex_};
+        progress_.state = state;
+        progress_.error = error;
+        progress_.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_at_).count();
+
+        std::string summary = "Re-rating job #" + std::to_string(job.job_id) + " " + ToString(state)
+                              + ": scanned " + std::to_string(progress_.scanned)
+                              + ", updated " + std::to_string(progress_.updated);
+        // Колоночная копия звонков, поддерживаемые агрегаты и кэш ответов хранят прежнюю стоимость
+        if (progress_.updated > 0) {
+            g_call_store.Invalidate();
+            g_call_aggregates.Invalidate();
+            g_analytics_cache.Invalidate();
+        }
+
+        if (state == State::FAILED) {
+            LOG_ERROR(summary + ": " + error);
+        }
+        else {
+            LOG_INFO(summary);
+        }
+    }
+}
+
+void RerateJob::Execute(const RerateScope& scope) {
+    auto reference = reference_provider_();
+    auto rater = rating::GetRater(reference);
+
+    uint64_t total = store_factory_()->Count(scope);
+    {
+        std::lock_guard lock{mutex_};
+        progress_.total = total;
+        progress_.reference_version = reference->version;
+    }
+
+    {
+        std::lock_guard lock{cursor_mutex_};
+        cursor_ = 0;
+        exhausted_ = false;
+    }
+    {
+        std::lock_guard lock{throttle_mutex_};
+        throttle_until_ = std::chrono::steady_clock::now();
+    }
+
+    // Первая ошибка любого потока прерывает задание целиком
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    std::vector<std::thread> workers;
+    workers.reserve(options_.parallelism);
+    for (size_t i = 0; i < options_.parallelism; ++i) {
+        workers.emplace_back([&] {
+            try {
+                ProcessChunks(scope, *rater);
+            }
+            catch (...) {
+                std::lock_guard lock{error_mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+                cancel_requested_ = true;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void RerateJob::ProcessChunks(const RerateScope& scope, const rating::Rater& rater) {
+    auto store = store_factory_();
+
+    while (!Interrupted()) {
+        // Чтение частей последовательно (курсор по id), тарификация и запись - параллельно
+        std::vector<ui::detail::CallStatisticsInfo> chunk;
+        {
+            std::lock_guard lock{cursor_mutex_};
+            if (exhausted_) {
+                break;
+            }
+            chunk = store->Fetch(scope, cursor_, options_.chunk_size);
+            if (chunk.size() < options_.chunk_size) {
+                exhausted_ = true;
+            }
+            if (!chunk.empty()) {
+                cursor_ = chunk.back().id;
+            }
+        }
+        if (chunk.empty()) {
+            break;
+        }
+
+        // Отправляем в БД только звонки, стоимость которых изменилась
+        std::vector<ui::detail::CallStatisticsInfo> changed;
+        uint64_t skipped = 0;
+        for (auto& call : chunk) {
+            domain::Money cost;
+            if (rater.Rate(call.trunk_id, call.tarif_id, call.duration_seconds, cost) != rating::RateStatus::OK) {
+                ++skipped;
+                continue;
+            }
+            if (call.cost != cost) {
+                call.cost = cost;
+                changed.push_back(std::move(call));
+            }
+        }
+
+        size_t updated = changed.empty() ? 0 : store->UpdateCosts(changed);
+
+        {
+            std::lock_guard lock{mutex_};
+            progress_.scanned += chunk.size();
+            progress_.updated += updated;
+            progress_.skipped += skipped;
+        }
+
+        Throttle(chunk.size());
+    }
+}
+
+void RerateJob::Throttle(size_t rows) {
+    if (options_.max_rows_per_second == 0) {
+        return;
+    }
+
+    // Общий для всех потоков график: каждая часть сдвигает его на rows / max_rows_per_second
+    auto cost = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(rows) / static_cast<double>(options_.max_rows_per_second)));
+
+    std::chrono::steady_clock::time_point until;
+    {
+        std::lock_guard lock{throttle_mutex_};
+        throttle_until_ = std::max(throttle_until_, std::chrono::steady_clock::now()) + cost;
+        until = throttle_until_;
+    }
+
+    while (!Interrupted()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= until) {
+            break;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(until - now, THROTTLE_STEP));
+    }
+}
+
+std::string ToString(RerateJob::State state) {
+    switch (state) {
+        case RerateJob::State::IDLE:
+            return "idle"s;
+        case RerateJob::State::RUNNING:
+            return "running"s;
+        case RerateJob::State::DONE:
+            return "done"s;
+        case RerateJob::State::FAILED:
+            return "failed"s;
+        case RerateJob::State::CANCELLED:
+            return "cancelled"s;
+    }
+    return "unknown"s;
+}
+
+} // namespace app
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "reference_cache.h"
+#include "../domain/call_statistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rating {
+class Rater;
+} // namespace rating
+
+namespace app {
+
+// Какие звонки пересчитывать: звонки по любому из тарифов или транков.
+// Если оба списка пусты - все звонки в пределах time_range
+struct RerateScope {
+    std::vector<int> tarif_ids;
+    std::vector<int> trunk_ids;
+    domain::TimeRange time_range;
+    std::string reason; // для журнала и статуса: "tarif 3 updated", "manual"
+};
+
+// Доступ к call_statistics для пересчёта стоимости.
+// Каждый поток задания получает свой экземпляр со своим подключением
+class RerateStore {
+public:
+    virtual ~RerateStore() = default;
+
+    // Сколько звонков попадает в область пересчёта (для индикации прогресса)
+    virtual uint64_t Count(const RerateScope& scope) = 0;
+    // До limit звонков с id > after_id по возрастанию id; call_id не заполняется
+    virtual std::vector<ui::detail::CallStatisticsInfo> Fetch(const RerateScope& scope,
+                                                              int64_t after_id, size_t limit) = 0;
+    // Записать новую стоимость (строка ищется по id и call_time). Возвращает число изменённых строк
+    virtual size_t UpdateCosts(const std::vector<ui::detail::CallStatisticsInfo>& calls) = 0;
+};
+
+// Фоновый пересчёт call_statistics.cost после изменения прайс-листа, тарифа или транка.
+// Задания выполняются по одному в порядке поступления. Звонки читаются частями
+// по возрастанию id, несколько потоков параллельно тарифицируют свои части
+// и записывают изменившуюся стоимость. Общая скорость ограничивается
+// max_rows_per_second, чтобы пересчёт не вытеснял рабочую нагрузку
+class RerateJob {
+public:
+    using StoreFactory = std::function<std::unique_ptr<RerateStore>()>;
+    // Актуальный снимок справочников (после изменения, вызвавшего пересчёт)
+    using ReferenceProvider = std::function<std::shared_ptr<const ReferenceData>()>;
+
+    struct Options {
+        size_t chunk_size = 5000;         // звонков в одной части
+        size_t parallelism = 2;           // потоков (и подключений к БД) на задание
+        size_t max_rows_per_second = 20000; // 0 - без ограничения
+    };
+
+    enum class State {
+        IDLE,
+        RUNNING,
+        DONE,
+        FAILED,
+        CANCELLED
+    };
+
+    // Состояние текущего (или последнего) задания
+    struct Progress {
+        uint64_t job_id = 0;
+        State state = State::IDLE;
+        std::string reason;
+        uint64_t total = 0;     // звонков в области пересчёта на момент запуска
+        uint64_t scanned = 0;
+        uint64_t updated = 0;   // строк с изменившейся стоимостью
+        uint64_t skipped = 0;   // звонки с удалёнными транком или тарифом - стоимость не трогаем
+        uint64_t reference_version = 0;
+        double elapsed_seconds = 0.0;
+        size_t pending = 0;     // заданий в очереди
+        std::string error;
+    };
+
+    RerateJob() = default;
+    ~RerateJob();
+
+    RerateJob(const RerateJob&) = delete;
+    RerateJob& operator=(const RerateJob&) = delete;
+
+    void Start(StoreFactory store_factory, ReferenceProvider reference_provider, Options options);
+    // Прерывает текущее задание, очередь отбрасывается
+    void Stop();
+
+    bool IsRunning() const;
+
+    // Поставить пересчёт в очередь. Возвращает номер задания, 0 - задание не запущено
+    uint64_t Submit(RerateScope scope);
+    // Прервать текущее задание; уже записанные части остаются пересчитанными
+    void CancelCurrent();
+
+    Progress GetProgress() const;
+
+private:
+    struct Queued {
+        uint64_t job_id;
+        RerateScope scope;
+    };
+
+    void Run();
+    void Execute(const RerateScope& scope);
+    // Поток задания: берёт очередную часть, тарифицирует и записывает
+    void ProcessChunks(const RerateScope& scope, const rating::Rater& rater);
+    // Выдержать паузу, чтобы общая скорость не превышала max_rows_per_second
+    void Throttle(size_t rows);
+    bool Interrupted() const;
+
+    StoreFactory store_factory_;
+    ReferenceProvider reference_provider_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+    std::deque<Queued> queue_;
+    uint64_t next_job_id_ = 1;
+    Progress progress_;
+    std::chrono::steady_clock::time_point started_at_;
+
+    // Курсор по id для текущего задания
+    std::mutex cursor_mutex_;
+    int64_t cursor_ = 0;
+    bool exhausted_ = false;
+
+    std::mutex throttle_mutex_;
+    std::chrono::steady_clock::time_point throttle_until_;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> cancel_requested_{false};
+};
+
+std::string ToString(RerateJob::State state);
+
+// Глобальный экземпляр (запускается в main при наличии DB_URL)
+extern RerateJob g_rerate_job;
+
+} // namespace app
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "../domain/call_statistics_fwd.h"
+
+#include <cstdint>
+#include <future>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_set>
@@ -21,10 +26,31 @@ struct CallStatisticsInfo;
 
 } // namespace ui
 
+namespace analytics {
+
+struct TrunkAnalytics;
+struct TarifAnalytics;
+struct HubAnalytics;
+struct RevenueAnalytics;
+enum class RevenuePeriod;
+struct TimeSeriesPoint;
+struct DistributionAnalytics;
+struct TrunkUtilization;
+struct CallLeader;
+struct DashboardSummary;
+struct TimeWindow;
+class TimeBuckets;
+
+} // namespace analytics
+
 namespace app {
 
+struct ReferenceData;
+
 class UseCases {
   public:
+    virtual std::shared_ptr<const ReferenceData> GetReferenceData() const = 0;
+
     virtual std::vector<ui::detail::HubInfo> GetHubs() const = 0;
     virtual std::vector<ui::detail::ServerInfo> GetServers() const = 0;
     virtual std::vector<ui::detail::NasIpInfo> GetNasIps() const = 0;
@@ -32,6 +58,25 @@ class UseCases {
     virtual std::vector<ui::detail::PricelistInfo> GetPricelists() const = 0;
     virtual std::vector<ui::detail::TarifInfo> GetTarifs() const = 0;
     virtual std::vector<ui::detail::CallStatisticsInfo> GetCallStatistics() const = 0;
+    virtual void ForEachCallStatistics(const domain::CallStatisticsFilter& filter,
+                                       const domain::CallStatisticsVisitor& visitor) const = 0;
+    // Итоги всех звонков за время, не зависящее от размера таблицы
+    virtual domain::CallTotals GetCallTotals() const = 0;
+
+    virtual std::vector<analytics::TrunkAnalytics> GetTrunkAnalytics(const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::TarifAnalytics> GetTarifAnalytics(const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::HubAnalytics> GetHubAnalytics(const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::RevenueAnalytics> GetRevenueAnalytics(analytics::RevenuePeriod period,
+                                                                         const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::TimeSeriesPoint> GetTimeSeries(const analytics::TimeBuckets& buckets) const = 0;
+    virtual std::vector<analytics::DistributionAnalytics> GetTrunkDistribution(const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::DistributionAnalytics> GetTarifDistribution(const domain::TimeRange& range) const = 0;
+    virtual std::vector<analytics::TrunkUtilization> GetTrunkUtilization(const analytics::TimeWindow& window,
+                                                                         double saturation_threshold) const = 0;
+    virtual std::vector<analytics::CallLeader> GetTopCalls(const analytics::TimeWindow& window, size_t limit) const = 0;
+    // Сводка панели мониторинга по справочникам reference (один снимок на весь ответ)
+    virtual analytics::DashboardSummary GetDashboard(const ReferenceData& reference, const domain::TimeRange& range,
+                                                     int64_t tz_offset, size_t recent_calls) const = 0;
 
     virtual void AddPricelist(const ui::detail::PricelistInfo& pricelist) = 0;
     virtual void UpdatePricelist(const ui::detail::PricelistInfo& pricelist, int id) = 0;
@@ -43,6 +88,11 @@ class UseCases {
     virtual void UpdateTrunk(const ui::detail::TrunkInfo& trunk, int id) = 0;
 
     virtual void AddCallStatistics(const ui::detail::CallStatisticsInfo& call_stat) = 0;
+    virtual domain::BulkInsertResult AddCallStatisticsBatch(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                                                            size_t batch_size) = 0;
+    // Постановка звонков в очередь записи. nullopt - очередь заполнена или не запущена
+    virtual std::optional<std::future<domain::BulkInsertResult>>
+    EnqueueCallStatistics(const std::vector<ui::detail::CallStatisticsInfo>& calls) = 0;
 
   protected:
     ~UseCases() = default;
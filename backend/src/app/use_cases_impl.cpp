@@ -1,4 +1,10 @@
 #include "use_cases_impl.h"
+#include "reference_cache.h"
+#include "call_ingest_queue.h"
+#include "rerate_job.h"
+#include "call_store.h"
+#include "call_aggregates.h"
+#include "../config/dynamic_config.h"
 #include "../domain/worker.h"
 #include "../domain/hub.h"
 #include "../domain/server.h"
@@ -7,8 +13,65 @@
 #include "../domain/pricelist.h"
 #include "../domain/tarif.h"
 #include "../domain/call_statistics.h"
+#include "../domain/call_analytics.h"
+#include "../domain/timestamp.h"
+#include "../topology/topology.h"
+
+#include <algorithm>
+#include <optional>
 
 namespace app {
+using namespace std::literals;
+
+namespace {
+
+std::vector<domain::CallStatistics> ToCallStatistics(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    std::vector<domain::CallStatistics> call_stats;
+    call_stats.reserve(calls.size());
+    for (const auto& call_stat : calls) {
+        call_stats.emplace_back(call_stat.id, call_stat.call_id, call_stat.trunk_id,
+                                call_stat.tarif_id, call_stat.duration_seconds,
+                                call_stat.cost, call_stat.call_time);
+    }
+    return call_stats;
+}
+
+// Пересчитать стоимость уже сохранённых звонков после изменения тарификации
+void SubmitRerate(RerateScope scope) {
+    if (g_rerate_job.IsRunning() && config::g_config.Get()->rerate_on_update) {
+        g_rerate_job.Submit(std::move(scope));
+    }
+}
+
+template <typename Info>
+const Info* FindById(const std::vector<Info>& items, int id) {
+    auto it = std::find_if(items.begin(), items.end(), [id](const Info& item) {
+        return item.id == id;
+    });
+    return it != items.end() ? &*it : nullptr;
+}
+
+// Границы TimeRange в микросекундах; nullopt - границу не разобрать, считать по БД
+std::optional<analytics::TimeWindow> ToTimeWindow(const domain::TimeRange& range) {
+    analytics::TimeWindow window;
+    if (range.from) {
+        auto from = domain::ParseTimestamp(*range.from);
+        if (!from) {
+            return std::nullopt;
+        }
+        window.from = *from;
+    }
+    if (range.to) {
+        auto to = domain::ParseTimestamp(*range.to);
+        if (!to) {
+            return std::nullopt;
+        }
+        window.to = *to;
+    }
+    return window;
+}
+
+} // namespace
 
 UseCasesImpl::UseCasesImpl(domain::HubRepository& hubs,
                            domain::ServerRepository& servers,
@@ -16,77 +79,308 @@ UseCasesImpl::UseCasesImpl(domain::HubRepository& hubs,
                            domain::TrunkRepository& trunks,
                            domain::PricelistRepository& pricelists,
                            domain::TarifRepository& tarifs,
-                           domain::CallStatisticsRepository& call_statistics)
+                           domain::CallStatisticsRepository& call_statistics,
+                           domain::CallAnalyticsRepository& call_analytics)
     : hubs_{hubs}
     , servers_{servers}
     , nas_ips_{nas_ips}
     , trunks_{trunks}
     , pricelists_{pricelists}
     , tarifs_{tarifs}
-    , call_statistics_{call_statistics} {}
+    , call_statistics_{call_statistics}
+    , call_analytics_{call_analytics} {}
+
+std::shared_ptr<const ReferenceData> UseCasesImpl::GetReferenceData() const {
+    return g_reference_cache.GetOrLoad([this] {
+        ReferenceData data;
+        data.hubs = hubs_.Get();
+        data.servers = servers_.Get();
+        data.nas_ips = nas_ips_.Get();
+        data.trunks = trunks_.Get();
+        data.pricelists = pricelists_.Get();
+        data.tarifs = tarifs_.Get();
+        return data;
+    });
+}
 
 std::vector<ui::detail::HubInfo> UseCasesImpl::GetHubs() const {
-    return hubs_.Get();
+    return GetReferenceData()->hubs;
 }
 
 std::vector<ui::detail::ServerInfo> UseCasesImpl::GetServers() const {
-    return servers_.Get();
+    return GetReferenceData()->servers;
 }
 
 std::vector<ui::detail::NasIpInfo> UseCasesImpl::GetNasIps() const {
-    return nas_ips_.Get();
+    return GetReferenceData()->nas_ips;
 }
 
 std::vector<ui::detail::TrunkInfo> UseCasesImpl::GetTrunks() const {
-    return trunks_.Get();
+    return GetReferenceData()->trunks;
 }
 
 std::vector<ui::detail::PricelistInfo> UseCasesImpl::GetPricelists() const {
-    return pricelists_.Get();
+    return GetReferenceData()->pricelists;
 }
 
 std::vector<ui::detail::TarifInfo> UseCasesImpl::GetTarifs() const {
-    return tarifs_.Get();
+    return GetReferenceData()->tarifs;
 }
 
 std::vector<ui::detail::CallStatisticsInfo> UseCasesImpl::GetCallStatistics() const {
     return call_statistics_.Get();
 }
 
+void UseCasesImpl::ForEachCallStatistics(const domain::CallStatisticsFilter& filter,
+                                         const domain::CallStatisticsVisitor& visitor) const {
+    call_statistics_.ForEach(filter, visitor);
+}
+
+// Поддерживаемые агрегаты уже держат суммы по транкам, иначе - итоги из БД
+domain::CallTotals UseCasesImpl::GetCallTotals() const {
+    if (auto totals = g_call_aggregates.Totals()) {
+        return {totals->calls, totals->duration_seconds, domain::Money::FromMicros(totals->cost)};
+    }
+    return call_statistics_.GetTotals();
+}
+
+// Порядок источников: поддерживаемые агрегаты (окно без границ или кратное часу),
+// колоночное хранилище свежих звонков, запрос к БД
+std::vector<analytics::TrunkAnalytics> UseCasesImpl::GetTrunkAnalytics(const domain::TimeRange& range) const {
+    if (auto window = ToTimeWindow(range)) {
+        auto reference = GetReferenceData();
+        if (auto result = g_call_aggregates.ByTrunk(*window, *reference)) {
+            return std::move(*result);
+        }
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateByTrunk(*calls, reference->trunks, *window);
+        }
+    }
+    return call_analytics_.GetByTrunk(range);
+}
+
+std::vector<analytics::TarifAnalytics> UseCasesImpl::GetTarifAnalytics(const domain::TimeRange& range) const {
+    if (auto window = ToTimeWindow(range)) {
+        auto reference = GetReferenceData();
+        if (auto result = g_call_aggregates.ByTarif(*window, *reference)) {
+            return std::move(*result);
+        }
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateByTarif(*calls, reference->tarifs, *window);
+        }
+    }
+    return call_analytics_.GetByTarif(range);
+}
+
+std::vector<analytics::HubAnalytics> UseCasesImpl::GetHubAnalytics(const domain::TimeRange& range) const {
+    if (auto window = ToTimeWindow(range)) {
+        auto network = topology::GetTopology(GetReferenceData());
+        if (auto result = g_call_aggregates.ByHub(*window, *network)) {
+            return std::move(*result);
+        }
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateByHub(*calls, *network, *window);
+        }
+    }
+    return call_analytics_.GetByHub(range);
+}
+
+std::vector<analytics::RevenueAnalytics> UseCasesImpl::GetRevenueAnalytics(analytics::RevenuePeriod period,
+                                                                           const domain::TimeRange& range) const {
+    if (auto window = ToTimeWindow(range)) {
+        if (auto result = g_call_aggregates.Revenue(period, *window)) {
+            return std::move(*result);
+        }
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateRevenue(*calls, period, *window);
+        }
+    }
+    return call_analytics_.GetRevenue(period, range);
+}
+
+std::vector<analytics::TimeSeriesPoint> UseCasesImpl::GetTimeSeries(const analytics::TimeBuckets& buckets) const {
+    if (auto result = g_call_aggregates.Series(buckets)) {
+        return std::move(*result);
+    }
+    if (auto calls = g_call_store.GetCovering({buckets.From(), buckets.To()})) {
+        return analytics::AnalyticsCalculator::CalculateTimeSeries(*calls, buckets);
+    }
+    return call_analytics_.GetTimeSeries(buckets);
+}
+
+// Скетчи не сворачиваются в часовые агрегаты: колоночное хранилище или потоковый обход БД.
+// В обоих случаях память - O(групп), а не O(звонков)
+std::vector<analytics::DistributionAnalytics> UseCasesImpl::GetTrunkDistribution(const domain::TimeRange& range) const {
+    auto reference = GetReferenceData();
+    if (auto window = ToTimeWindow(range)) {
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateDistributionByTrunk(*calls, reference->trunks, *window);
+        }
+    }
+
+    domain::CallStatisticsFilter filter;
+    filter.time_range = range;
+    analytics::DistributionAggregator aggregator(reference->trunks);
+    call_statistics_.ForEach(filter, [&aggregator](const ui::detail::CallStatisticsInfo& call) {
+        aggregator.Add(call);
+    });
+    return aggregator.Finish();
+}
+
+std::vector<analytics::DistributionAnalytics> UseCasesImpl::GetTarifDistribution(const domain::TimeRange& range) const {
+    auto reference = GetReferenceData();
+    if (auto window = ToTimeWindow(range)) {
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateDistributionByTarif(*calls, reference->tarifs, *window);
+        }
+    }
+
+    domain::CallStatisticsFilter filter;
+    filter.time_range = range;
+    analytics::DistributionAggregator aggregator(reference->tarifs);
+    call_statistics_.ForEach(filter, [&aggregator](const ui::detail::CallStatisticsInfo& call) {
+        aggregator.Add(call);
+    });
+    return aggregator.Finish();
+}
+
+// Нужны отдельные звонки (начало и длительность), поэтому часовые агрегаты не подходят
+std::vector<analytics::TrunkUtilization> UseCasesImpl::GetTrunkUtilization(const analytics::TimeWindow& window,
+                                                                           double saturation_threshold) const {
+    auto network = topology::GetTopology(GetReferenceData());
+    auto scan = analytics::UtilizationAggregator::ScanWindow(window);
+    if (auto calls = g_call_store.GetCovering(scan)) {
+        return analytics::AnalyticsCalculator::CalculateUtilization(*calls, *network, window, saturation_threshold);
+    }
+
+    domain::CallStatisticsFilter filter;
+    filter.time_range = {domain::FormatTimestamp(std::max<int64_t>(scan.from, 0)), domain::FormatTimestamp(scan.to)};
+    analytics::UtilizationAggregator aggregator(*network, window, saturation_threshold);
+    call_statistics_.ForEach(filter, [&aggregator](const ui::detail::CallStatisticsInfo& call) {
+        aggregator.Add(call);
+    });
+    return aggregator.Finish();
+}
+
+// Рейтинг целых суток UTC поддерживается в g_call_aggregates и читается без обхода звонков.
+// Иначе - колоночное хранилище или потоковый обход БД: память O(limit)
+std::vector<analytics::CallLeader> UseCasesImpl::GetTopCalls(const analytics::TimeWindow& window, size_t limit) const {
+    if (auto result = g_call_aggregates.TopCalls(window, limit)) {
+        return std::move(*result);
+    }
+    if (auto calls = g_call_store.GetCovering(window)) {
+        return analytics::AnalyticsCalculator::CalculateTopCalls(*calls, limit, window);
+    }
+
+    domain::CallStatisticsFilter filter;
+    filter.time_range = {domain::FormatTimestamp(std::max<int64_t>(window.from, 0)), domain::FormatTimestamp(window.to)};
+    analytics::TopCallsAggregator aggregator(limit);
+    call_statistics_.ForEach(filter, [&aggregator](const ui::detail::CallStatisticsInfo& call) {
+        aggregator.Add(call);
+    });
+    return aggregator.Top(limit);
+}
+
+// Гистограммы и последние звонки не сворачиваются в часовые агрегаты: колоночное
+// хранилище или один потоковый обход БД, все суммы - за этот единственный проход
+analytics::DashboardSummary UseCasesImpl::GetDashboard(const ReferenceData& reference, const domain::TimeRange& range,
+                                                       int64_t tz_offset, size_t recent_calls) const {
+    if (auto window = ToTimeWindow(range)) {
+        if (auto calls = g_call_store.GetCovering(*window)) {
+            return analytics::AnalyticsCalculator::CalculateDashboard(*calls, reference.trunks, reference.tarifs,
+                                                                      tz_offset, recent_calls, *window);
+        }
+        // Итоги и суммы по группам - из поддерживаемых агрегатов, из БД читаются только
+        // гистограммы (GROUP BY) и последние звонки (LIMIT), а не все звонки окна
+        if (auto summary = g_call_aggregates.Dashboard(*window, reference, tz_offset)) {
+            auto details = call_analytics_.GetDashboardDetails(range, recent_calls);
+            summary->duration_histogram = std::move(details.duration_histogram);
+            summary->cost_histogram = std::move(details.cost_histogram);
+            summary->recent_calls = std::move(details.recent_calls);
+            return std::move(*summary);
+        }
+    }
+
+    domain::CallStatisticsFilter filter;
+    filter.time_range = range;
+    analytics::DashboardAggregator aggregator(reference.trunks, reference.tarifs, tz_offset, recent_calls);
+    call_statistics_.ForEach(filter, [&aggregator](const ui::detail::CallStatisticsInfo& call) {
+        aggregator.Add(call);
+    });
+    return aggregator.Finish();
+}
+
 void UseCasesImpl::AddPricelist(const ui::detail::PricelistInfo& pricelist) {
     auto worker = pricelists_.GetWorker();
     worker->AddPricelist({pricelist.id, pricelist.name, pricelist.currency,
                           pricelist.rate_per_minute, pricelist.is_active});
+    g_reference_cache.Invalidate();
 }
 
 void UseCasesImpl::UpdatePricelist(const ui::detail::PricelistInfo& pricelist, int id) {
+    auto before = GetReferenceData();
+
     auto worker = pricelists_.GetWorker();
     worker->UpdatePricelist({pricelist.id, pricelist.name, pricelist.currency,
                              pricelist.rate_per_minute, pricelist.is_active}, id);
+    g_reference_cache.Invalidate();
+
+    const auto* old = FindById(before->pricelists, id);
+    if (old && (old->rate_per_minute != pricelist.rate_per_minute || old->is_active != pricelist.is_active)) {
+        RerateScope scope;
+        for (const auto& tarif : before->tarifs) {
+            if (tarif.pricelist_id == id) {
+                scope.tarif_ids.push_back(tarif.id);
+            }
+        }
+        scope.reason = "pricelist "s + std::to_string(id) + " updated"s;
+        if (!scope.tarif_ids.empty()) {
+            SubmitRerate(std::move(scope));
+        }
+    }
 }
 
 void UseCasesImpl::AddTarif(const ui::detail::TarifInfo& tarif) {
     auto worker = tarifs_.GetWorker();
     worker->AddTarif({tarif.id, tarif.name, tarif.pricelist_id,
                       tarif.markup_percent, tarif.free_minutes});
+    g_reference_cache.Invalidate();
 }
 
 void UseCasesImpl::UpdateTarif(const ui::detail::TarifInfo& tarif, int id) {
+    auto before = GetReferenceData();
+
     auto worker = tarifs_.GetWorker();
     worker->UpdateTarif({tarif.id, tarif.name, tarif.pricelist_id,
                          tarif.markup_percent, tarif.free_minutes}, id);
+    g_reference_cache.Invalidate();
+
+    const auto* old = FindById(before->tarifs, id);
+    if (old && (old->pricelist_id != tarif.pricelist_id || old->markup_percent != tarif.markup_percent
+                || old->free_minutes != tarif.free_minutes)) {
+        SubmitRerate({{id}, {}, {}, "tarif "s + std::to_string(id) + " updated"s});
+    }
 }
 
 void UseCasesImpl::AddTrunk(const ui::detail::TrunkInfo& trunk) {
     auto worker = trunks_.GetWorker();
     worker->AddTrunk({trunk.id, trunk.server_id, trunk.name,
                       trunk.capacity, trunk.cost_per_channel});
+    g_reference_cache.Invalidate();
 }
 
 void UseCasesImpl::UpdateTrunk(const ui::detail::TrunkInfo& trunk, int id) {
+    auto before = GetReferenceData();
+
     auto worker = trunks_.GetWorker();
     worker->UpdateTrunk({trunk.id, trunk.server_id, trunk.name,
                          trunk.capacity, trunk.cost_per_channel}, id);
+    g_reference_cache.Invalidate();
+
+    const auto* old = FindById(before->trunks, id);
+    if (old && old->cost_per_channel != trunk.cost_per_channel) {
+        SubmitRerate({{}, {id}, {}, "trunk "s + std::to_string(id) + " updated"s});
+    }
 }
 
 void UseCasesImpl::AddCallStatistics(const ui::detail::CallStatisticsInfo& call_stat) {
@@ -94,6 +388,20 @@ void UseCasesImpl::AddCallStatistics(const ui::detail::CallStatisticsInfo& call_
     worker->AddCallStatistics({call_stat.id, call_stat.call_id, call_stat.trunk_id,
                                call_stat.tarif_id, call_stat.duration_seconds,
                                call_stat.cost, call_stat.call_time});
+    g_call_aggregates.Notify();
+}
+
+domain::BulkInsertResult UseCasesImpl::AddCallStatisticsBatch(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                                                              size_t batch_size) {
+    auto worker = call_statistics_.GetWorker();
+    auto result = worker->AddCallStatisticsBatch(ToCallStatistics(calls), batch_size);
+    g_call_aggregates.Notify();
+    return result;
+}
+
+std::optional<std::future<domain::BulkInsertResult>>
+UseCasesImpl::EnqueueCallStatistics(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    return g_call_ingest_queue.Enqueue(ToCallStatistics(calls));
 }
 
 } // namespace app
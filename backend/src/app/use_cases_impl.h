@@ -8,6 +8,7 @@
 #include "../domain/pricelist_fwd.h"
 #include "../domain/tarif_fwd.h"
 #include "../domain/call_statistics_fwd.h"
+#include "../domain/call_analytics_fwd.h"
 
 namespace app {
 
@@ -19,7 +20,10 @@ class UseCasesImpl : public UseCases {
                           domain::TrunkRepository& trunks,
                           domain::PricelistRepository& pricelists,
                           domain::TarifRepository& tarifs,
-                          domain::CallStatisticsRepository& call_statistics);
+                          domain::CallStatisticsRepository& call_statistics,
+                          domain::CallAnalyticsRepository& call_analytics);
+
+    std::shared_ptr<const ReferenceData> GetReferenceData() const override;
 
     std::vector<ui::detail::HubInfo> GetHubs() const override;
     std::vector<ui::detail::ServerInfo> GetServers() const override;
@@ -28,6 +32,23 @@ class UseCasesImpl : public UseCases {
     std::vector<ui::detail::PricelistInfo> GetPricelists() const override;
     std::vector<ui::detail::TarifInfo> GetTarifs() const override;
     std::vector<ui::detail::CallStatisticsInfo> GetCallStatistics() const override;
+    void ForEachCallStatistics(const domain::CallStatisticsFilter& filter,
+                               const domain::CallStatisticsVisitor& visitor) const override;
+    domain::CallTotals GetCallTotals() const override;
+
+    std::vector<analytics::TrunkAnalytics> GetTrunkAnalytics(const domain::TimeRange& range) const override;
+    std::vector<analytics::TarifAnalytics> GetTarifAnalytics(const domain::TimeRange& range) const override;
+    std::vector<analytics::HubAnalytics> GetHubAnalytics(const domain::TimeRange& range) const override;
+    std::vector<analytics::RevenueAnalytics> GetRevenueAnalytics(analytics::RevenuePeriod period,
+                                                                 const domain::TimeRange& range) const override;
+    std::vector<analytics::TimeSeriesPoint> GetTimeSeries(const analytics::TimeBuckets& buckets) const override;
+    std::vector<analytics::DistributionAnalytics> GetTrunkDistribution(const domain::TimeRange& range) const override;
+    std::vector<analytics::DistributionAnalytics> GetTarifDistribution(const domain::TimeRange& range) const override;
+    std::vector<analytics::TrunkUtilization> GetTrunkUtilization(const analytics::TimeWindow& window,
+                                                                 double saturation_threshold) const override;
+    std::vector<analytics::CallLeader> GetTopCalls(const analytics::TimeWindow& window, size_t limit) const override;
+    analytics::DashboardSummary GetDashboard(const ReferenceData& reference, const domain::TimeRange& range,
+                                             int64_t tz_offset, size_t recent_calls) const override;
 
     void AddPricelist(const ui::detail::PricelistInfo& pricelist) override;
     void UpdatePricelist(const ui::detail::PricelistInfo& pricelist, int id) override;
@@ -39,6 +60,10 @@ class UseCasesImpl : public UseCases {
     void UpdateTrunk(const ui::detail::TrunkInfo& trunk, int id) override;
 
     void AddCallStatistics(const ui::detail::CallStatisticsInfo& call_stat) override;
+    domain::BulkInsertResult AddCallStatisticsBatch(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                                                    size_t batch_size) override;
+    std::optional<std::future<domain::BulkInsertResult>>
+    EnqueueCallStatistics(const std::vector<ui::detail::CallStatisticsInfo>& calls) override;
 
   private:
     domain::HubRepository& hubs_;
@@ -48,6 +73,7 @@ class UseCasesImpl : public UseCases {
     domain::PricelistRepository& pricelists_;
     domain::TarifRepository& tarifs_;
     domain::CallStatisticsRepository& call_statistics_;
+    domain::CallAnalyticsRepository& call_analytics_;
 };
 
 } // namespace app
@@ -9,4 +9,8 @@ app::UseCasesImpl Application::GetUseCases() const {
     return use_cases_;
 }
 
+void Application::PingDatabase() {
+    db_.Ping();
+}
+
 } // namespace db
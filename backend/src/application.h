@@ -17,12 +17,14 @@ class Application {
 
     app::UseCasesImpl GetUseCases() const;
 
+    void PingDatabase();
+
   private:
     postgres::DataBase db_;
     app::UseCasesImpl use_cases_{db_.GetHubs(), db_.GetServers(),
                                  db_.GetNasIps(), db_.GetTrunks(),
                                  db_.GetPricelists(), db_.GetTarifs(),
-                                 db_.GetCallStatistics()};
+                                 db_.GetCallStatistics(), db_.GetCallAnalytics()};
 };
 
 } // namespace db
@@ -0,0 +1,349 @@
+// Замеры пропускной способности горячих путей на синтетических данных:
+// ядра группировки (скалярное, SSE4.2, AVX2) против прежнего расчёта через
+// std::map по строкам звонков, масштабирование ComputePool по
+// числу потоков, тарификация Rater, разбор и форматирование call_time и
+// разбор пакетов CDR для /api/ingest/calls.
+//
+// Запуск: analytics_bench [строк]; по умолчанию 10 000 000 строк.
+// Каждый замер повторяется, выводится лучший результат
+
+#include "../analytics/analytics.h"
+#include "../analytics/call_columns.h"
+#include "../analytics/compute_pool.h"
+#include "../analytics/group_by.h"
+#include "../domain/timestamp.h"
+#include "../ingest/cdr_decoder.h"
+#include "../rating/rater.h"
+
+#include <boost/endian/conversion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int REPEATS = 5;
+constexpr int TRUNKS = 256;
+constexpr int TARIFS = 32;
+constexpr size_t CHUNK_ROWS = 65536;
+// 2026-01-01 00:00:00 UTC, звонки распределены по 30 суткам
+constexpr int64_t FIRST_CALL_TIME = 1'767'225'600'000'000;
+constexpr int64_t CALL_TIME_SPAN = 30 * domain::MICROS_PER_DAY;
+
+// Значение, которое компилятор не может выбросить вместе с замеряемым кодом
+volatile int64_t g_sink = 0;
+
+// Лучшее время из REPEATS прогонов body(), секунды
+template <typename Body>
+double Measure(Body&& body) {
+    double best = 0.0;
+    for (int i = 0; i < REPEATS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+void Report(std::string_view name, size_t items, double seconds) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(10) << items / seconds / 1e6 << " M/s"
+              << std::setprecision(2) << std::setw(12) << seconds * 1e3 << " ms" << std::endl;
+}
+
+std::vector<ui::detail::TrunkInfo> MakeTrunks() {
+    std::vector<ui::detail::TrunkInfo> trunks;
+    for (int id = 1; id <= TRUNKS; ++id) {
+        trunks.push_back({id, (id - 1) / 8 + 1, "trunk-"s + std::to_string(id), 30,
+                          domain::Money::FromMicros(id * 10'000)});
+    }
+    return trunks;
+}
+
+std::vector<ui::detail::TarifInfo> MakeTarifs() {
+    std::vector<ui::detail::TarifInfo> tarifs;
+    for (int id = 1; id <= TARIFS; ++id) {
+        tarifs.push_back({id, "tarif-"s + std::to_string(id), (id - 1) % 4 + 1, id % 20, id % 3});
+    }
+    return tarifs;
+}
+
+std::vector<ui::detail::PricelistInfo> MakePricelists() {
+    std::vector<ui::detail::PricelistInfo> pricelists;
+    for (int id = 1; id <= 4; ++id) {
+        pricelists.push_back({id, "pricelist-"s + std::to_string(id), "RUB"s,
+                              domain::Money::FromMicros(id * 1'500'000), true});
+    }
+    return pricelists;
+}
+
+std::vector<ui::detail::CallStatisticsInfo> MakeCalls(size_t rows) {
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<int> trunk(1, TRUNKS);
+    std::uniform_int_distribution<int> tarif(1, TARIFS);
+    std::uniform_int_distribution<int> duration(1, 1800);
+    std::uniform_int_distribution<int64_t> cost(0, 50'000'000);
+    std::uniform_int_distribution<int64_t> call_time(0, CALL_TIME_SPAN - 1);
+
+    std::vector<ui::detail::CallStatisticsInfo> calls(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        auto& call = calls[i];
+        call.id = static_cast<int64_t>(i) + 1;
+        call.call_id = "call-"s + std::to_string(i % 100'000);
+        call.trunk_id = trunk(random);
+        call.tarif_id = tarif(random);
+        call.duration_seconds = duration(random);
+        call.cost = domain::Money::FromMicros(cost(random));
+        call.call_time = FIRST_CALL_TIME + call_time(random);
+    }
+    return calls;
+}
+
+analytics::CallColumns MakeColumns(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    analytics::CallColumns columns;
+    columns.covered_from = FIRST_CALL_TIME;
+    for (size_t begin = 0; begin < calls.size(); begin += CHUNK_ROWS) {
+        analytics::CallChunkBuilder builder(CHUNK_ROWS);
+        for (size_t i = begin; i < std::min(calls.size(), begin + CHUNK_ROWS); ++i) {
+            builder.Add(calls[i]);
+        }
+        columns.chunks.push_back(builder.Finish());
+    }
+    columns.rows = calls.size();
+    columns.watermark = static_cast<int64_t>(calls.size());
+    return columns;
+}
+
+// Прежний расчёт по транкам: std::map по id транка и проход по строкам звонков.
+// Звонки вне [from, to) пропускаются; to == 0 - без окна
+std::vector<analytics::TrunkAnalytics> MapCalculateByTrunk(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                                                           const std::vector<ui::detail::TrunkInfo>& trunks,
+                                                           int64_t from, int64_t to) {
+    std::map<int, analytics::TrunkAnalytics> trunk_map;
+    for (const auto& trunk : trunks) {
+        trunk_map[trunk.id] = analytics::TrunkAnalytics{trunk.id, trunk.name, 0, {}, 0, 0.0, {}};
+    }
+
+    for (const auto& call : calls) {
+        if (to != 0 && (call.call_time < from || call.call_time >= to)) {
+            continue;
+        }
+        auto it = trunk_map.find(call.trunk_id);
+        if (it != trunk_map.end()) {
+            auto& analytics = it->second;
+            analytics.total_calls++;
+            analytics.total_revenue += call.cost;
+            analytics.total_duration_seconds += call.duration_seconds;
+        }
+    }
+
+    std::vector<analytics::TrunkAnalytics> result;
+    result.reserve(trunk_map.size());
+    for (auto& [id, analytics] : trunk_map) {
+        if (analytics.total_calls > 0) {
+            analytics.avg_duration_seconds = static_cast<double>(analytics.total_duration_seconds) / analytics.total_calls;
+            analytics.avg_cost = analytics.total_revenue.MulDiv(1, analytics.total_calls);
+        }
+        result.push_back(analytics);
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.total_revenue > b.total_revenue;
+    });
+    return result;
+}
+
+// Ядра группировки по trunk_id по всем частям колоночного хранилища
+// и прежний расчёт через std::map по тем же звонкам для сравнения
+void BenchGroupByKernels(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                         const analytics::CallColumns& columns,
+                         const std::vector<ui::detail::TrunkInfo>& trunks) {
+    std::cout << "\n# group-by kernels (active: " << analytics::ToString(analytics::ActiveGroupByKernel())
+              << ")" << std::endl;
+
+    std::vector<std::pair<int32_t, int32_t>> id_to_slot;
+    for (int id = 1; id <= TRUNKS; ++id) {
+        id_to_slot.emplace_back(id, id - 1);
+    }
+    analytics::DenseIndex index(id_to_slot);
+
+    // Окно - первая половина звонков: ядро проверяет call_time каждой строки
+    int64_t half = FIRST_CALL_TIME + CALL_TIME_SPAN / 2;
+    for (bool windowed : {false, true}) {
+        double seconds = Measure([&] {
+            auto result = MapCalculateByTrunk(calls, trunks, FIRST_CALL_TIME, windowed ? half : 0);
+            g_sink = g_sink + result.front().total_calls;
+        });
+        Report("std::map baseline"s + (windowed ? " (window)"s : ""s), calls.size(), seconds);
+    }
+
+    for (auto kernel : {analytics::GroupByKernel::SCALAR, analytics::GroupByKernel::SSE42,
+                        analytics::GroupByKernel::AVX2}) {
+        std::string name = "group-by "s + std::string(analytics::ToString(kernel));
+        if (static_cast<int>(kernel) > static_cast<int>(analytics::ActiveGroupByKernel())) {
+            std::cout << std::left << std::setw(40) << name << "  not supported by this CPU" << std::endl;
+            continue;
+        }
+
+        for (bool windowed : {false, true}) {
+            double seconds = Measure([&] {
+                std::vector<analytics::GroupTotals> totals(TRUNKS);
+                for (const auto& chunk : columns.chunks) {
+                    analytics::GroupByColumns group_columns{chunk->trunk_ids.data(), chunk->durations.data(),
+                                                            chunk->costs.data(),
+                                                            windowed ? chunk->call_times.data() : nullptr,
+                                                            chunk->Size()};
+                    analytics::AccumulateGroups(kernel, group_columns, FIRST_CALL_TIME, half, index, totals);
+                }
+                g_sink = g_sink + totals[0].calls;
+            });
+            Report(name + (windowed ? " (window)"s : ""s), columns.rows, seconds);
+        }
+    }
+}
+
+// Расчёт по транкам через ComputePool при разном числе потоков
+void BenchComputePool(const analytics::CallColumns& columns, const std::vector<ui::detail::TrunkInfo>& trunks) {
+    std::cout << "\n# ComputePool scaling (CalculateByTrunk)" << std::endl;
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    double single = 0.0;
+    for (size_t threads : {1u, 2u, 4u, 8u, 16u}) {
+        // Вся работа уходит в потоки пула, вызывающий поток только ждёт
+        analytics::g_compute_pool.Stop();
+        analytics::g_compute_pool.Start({threads, CHUNK_ROWS});
+
+        double seconds = Measure([&] {
+            auto result = analytics::AnalyticsCalculator::CalculateByTrunk(columns, trunks);
+            g_sink = g_sink + result.front().total_calls;
+        });
+        if (threads == 1) {
+            single = seconds;
+        }
+
+        Report("threads "s + std::to_string(threads), columns.rows, seconds);
+        std::cout << std::left << std::setw(40) << "" << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << single / seconds << " x" << std::endl;
+    }
+    analytics::g_compute_pool.Stop();
+}
+
+void BenchRater(std::vector<ui::detail::CallStatisticsInfo> calls, const std::vector<ui::detail::TrunkInfo>& trunks) {
+    std::cout << "\n# rating" << std::endl;
+
+    rating::Rater rater(trunks, MakeTarifs(), MakePricelists());
+    double seconds = Measure([&] {
+        g_sink = g_sink + static_cast<int64_t>(rater.RateBatch(calls));
+    });
+    Report("Rater::RateBatch", calls.size(), seconds);
+}
+
+void BenchTimestamps(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    std::cout << "\n# call_time text" << std::endl;
+
+    std::vector<std::string> texts;
+    texts.reserve(calls.size());
+    for (const auto& call : calls) {
+        texts.push_back(domain::FormatTimestamp(call.call_time));
+    }
+
+    double format_seconds = Measure([&] {
+        char buffer[64];
+        for (const auto& call : calls) {
+            char* end = domain::FormatTimestamp(call.call_time, buffer);
+            g_sink = g_sink + (end - buffer);
+        }
+    });
+    Report("FormatTimestamp", calls.size(), format_seconds);
+
+    double parse_seconds = Measure([&] {
+        for (const auto& text : texts) {
+            g_sink = g_sink + domain::ParseTimestamp(text).value_or(0);
+        }
+    });
+    Report("ParseTimestamp", texts.size(), parse_seconds);
+}
+
+template <typename T>
+void PutLittleEndian(std::string& out, T value) {
+    value = boost::endian::native_to_little(value);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Разбор и тарификация пакетов /api/ingest/calls в обоих форматах
+void BenchIngest(const std::vector<ui::detail::CallStatisticsInfo>& calls,
+                 const std::vector<ui::detail::TrunkInfo>& trunks) {
+    std::cout << "\n# ingest (decode + rate)" << std::endl;
+
+    rating::Rater rater(trunks, MakeTarifs(), MakePricelists());
+
+    std::string binary(ingest::BINARY_MAGIC, sizeof(ingest::BINARY_MAGIC));
+    std::string ndjson;
+    for (const auto& call : calls) {
+        auto call_id_size = static_cast<uint8_t>(call.call_id.size());
+        PutLittleEndian(binary, static_cast<uint16_t>(3 * sizeof(int32_t) + sizeof(int64_t) + 1 + call_id_size));
+        PutLittleEndian(binary, static_cast<int32_t>(call.trunk_id));
+        PutLittleEndian(binary, static_cast<int32_t>(call.tarif_id));
+        PutLittleEndian(binary, static_cast<int32_t>(call.duration_seconds));
+        PutLittleEndian(binary, call.call_time);
+        binary.push_back(static_cast<char>(call_id_size));
+        binary += call.call_id;
+
+        ndjson += R"({"call_id":")"s + call.call_id + R"(","trunk_id":)"s + std::to_string(call.trunk_id)
+                  + R"(,"tarif_id":)"s + std::to_string(call.tarif_id) + R"(,"duration_seconds":)"s
+                  + std::to_string(call.duration_seconds) + R"(,"call_time":")"s
+                  + domain::FormatTimestamp(call.call_time) + "\"}\n"s;
+    }
+
+    for (auto [format, name, body] : {std::tuple{ingest::CdrFormat::BINARY, "ingest binary"sv, std::string_view(binary)},
+                                      std::tuple{ingest::CdrFormat::NDJSON, "ingest ndjson"sv, std::string_view(ndjson)}}) {
+        size_t accepted = 0;
+        double seconds = Measure([&] {
+            auto batch = ingest::Decode(format, body);
+            ingest::RateCalls(rater, batch);
+            accepted = batch.calls.size();
+        });
+        Report(name, calls.size(), seconds);
+        if (accepted != calls.size()) {
+            std::cout << "  rejected " << calls.size() - accepted << " of " << calls.size() << " records" << std::endl;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::stoull(argv[1]) : 10'000'000;
+    // Построчная обработка медленнее группировки на порядки: её пакеты меньше
+    size_t text_rows = std::min<size_t>(rows, 1'000'000);
+    size_t ingest_rows = std::min<size_t>(rows, 100'000);
+
+    std::cout << "rows: " << rows << ", repeats: " << REPEATS << ", best run shown" << std::endl;
+
+    auto trunks = MakeTrunks();
+    auto calls = MakeCalls(rows);
+    auto columns = MakeColumns(calls);
+
+    BenchGroupByKernels(calls, columns, trunks);
+    BenchComputePool(columns, trunks);
+
+    calls.resize(text_rows);
+    BenchRater(calls, trunks);
+    BenchTimestamps(calls);
+
+    calls.resize(ingest_rows);
+    BenchIngest(calls, trunks);
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "call_generator.h"
 #include "../config/dynamic_config.h"
+#include "../rating/rater.h"
+#include "../topology/topology.h"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
@@ -11,31 +13,31 @@ namespace call_simulator {
 // CallCostCalculator Implementation
 // ============================================================================
 
-double CallCostCalculator::CalculateCost(
+domain::Money CallCostCalculator::CalculateCost(
     int duration_seconds,
-    double rate_per_minute,
-    double markup_percent,
-    double cost_per_channel
+    domain::Money rate_per_minute,
+    int markup_percent,
+    domain::Money cost_per_channel
 ) {
     // Формула из DB.md:
     // 1. Базовая стоимость = (duration_seconds / 60) × rate_per_minute
-    double base_cost = (duration_seconds / 60.0) * rate_per_minute;
-    
     // 2. Наценка = базовая_стоимость × (markup_percent / 100)
-    double markup = base_cost * (markup_percent / 100.0);
+    // Базовая стоимость с наценкой считается одним действием:
+    // rate_per_minute × duration_seconds × (100 + markup_percent) / 6000,
+    // поэтому округление до миллионных происходит один раз, как при записи в DECIMAL(10, 6)
+    domain::Money charged = rate_per_minute.MulDiv(
+        static_cast<int64_t>(duration_seconds) * (100 + markup_percent), 60 * 100);
     
     // 3. Стоимость транка = cost_per_channel
     // 4. Итого = базовая_стоимость + наценка + стоимость_транка
-    double total_cost = base_cost + markup + cost_per_channel;
-    
-    return total_cost;
+    return charged + cost_per_channel;
 }
 
-double CallCostCalculator::CalculateCostWithFreeMinutes(
+domain::Money CallCostCalculator::CalculateCostWithFreeMinutes(
     int duration_seconds,
-    double rate_per_minute,
-    double markup_percent,
-    double cost_per_channel,
+    domain::Money rate_per_minute,
+    int markup_percent,
+    domain::Money cost_per_channel,
     int free_minutes
 ) {
     // Вычитаем бесплатные минуты
@@ -74,25 +76,8 @@ int CallGenerator::GenerateDuration() {
     return dis(gen_);
 }
 
-std::string CallGenerator::GetCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t_now = std::chrono::system_clock::to_time_t(now);
-    
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time_t_now), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
-}
-
-const ui::detail::PricelistInfo* CallGenerator::FindPricelist(
-    int pricelist_id,
-    const std::vector<ui::detail::PricelistInfo>& pricelists
-) const {
-    auto it = std::find_if(pricelists.begin(), pricelists.end(),
-        [pricelist_id](const ui::detail::PricelistInfo& pl) {
-            return pl.id == pricelist_id;
-        });
-    
-    return (it != pricelists.end()) ? &(*it) : nullptr;
+int64_t CallGenerator::GetCurrentTimestamp() {
+    return domain::NowTimestamp();
 }
 
 CallRoute CallGenerator::BuildRoute(
@@ -100,9 +85,15 @@ CallRoute CallGenerator::BuildRoute(
     const std::vector<ui::detail::ServerInfo>& servers,
     const std::vector<ui::detail::TrunkInfo>& trunks
 ) {
+    return BuildRoute(topology::NetworkTopology(hubs, servers, trunks));
+}
+
+CallRoute CallGenerator::BuildRoute(const topology::NetworkTopology& topology) {
     CallRoute route;
     
-    if (hubs.empty() || servers.empty() || trunks.empty()) {
+    const auto& hubs = topology.Hubs();
+    const auto& trunks = topology.Trunks();
+    if (hubs.empty() || topology.Servers().empty() || trunks.empty()) {
         return route;
     }
     
@@ -112,54 +103,31 @@ CallRoute CallGenerator::BuildRoute(
     route.hub_id = selected_hub.id;
     route.hub_name = selected_hub.name;
     
-    // Находим серверы, принадлежащие выбранному хабу
-    std::vector<ui::detail::ServerInfo> hub_servers;
-    std::copy_if(servers.begin(), servers.end(), std::back_inserter(hub_servers),
-        [&selected_hub](const ui::detail::ServerInfo& s) {
-            return s.hub_id == selected_hub.id && s.is_active;
-        });
-    
-    if (hub_servers.empty()) {
-        // Если нет активных серверов в хабе, берем любой активный сервер
-        std::vector<ui::detail::ServerInfo> active_servers;
-        std::copy_if(servers.begin(), servers.end(), std::back_inserter(active_servers),
-            [](const ui::detail::ServerInfo& s) { return s.is_active; });
-        
-        if (!active_servers.empty()) {
-            std::uniform_int_distribution<size_t> srv_dis(0, active_servers.size() - 1);
-            const auto& selected_server = active_servers[srv_dis(gen_)];
-            route.server_id = selected_server.id;
-            route.server_name = selected_server.name;
-        } else {
-            return route;
-        }
-    } else {
-        // Выбираем случайный сервер из хаба
-        std::uniform_int_distribution<size_t> srv_dis(0, hub_servers.size() - 1);
-        const auto& selected_server = hub_servers[srv_dis(gen_)];
-        route.server_id = selected_server.id;
-        route.server_name = selected_server.name;
+    // Активные серверы выбранного хаба; если их нет, берем любой активный сервер
+    const auto* candidates = &topology.ActiveServersOfHub(selected_hub.id);
+    if (candidates->empty()) {
+        candidates = &topology.ActiveServers();
+    }
+    if (candidates->empty()) {
+        return route;
     }
     
-    // Находим транки, принадлежащие выбранному серверу
-    std::vector<ui::detail::TrunkInfo> server_trunks;
-    std::copy_if(trunks.begin(), trunks.end(), std::back_inserter(server_trunks),
-        [&route](const ui::detail::TrunkInfo& t) {
-            return t.server_id == route.server_id;
-        });
+    std::uniform_int_distribution<size_t> srv_dis(0, candidates->size() - 1);
+    const auto& selected_server = *(*candidates)[srv_dis(gen_)];
+    route.server_id = selected_server.id;
+    route.server_name = selected_server.name;
     
+    const auto& server_trunks = topology.TrunksOfServer(route.server_id);
     if (server_trunks.empty()) {
         // Если нет транков на сервере, берем любой транк
-        if (!trunks.empty()) {
-            std::uniform_int_distribution<size_t> trunk_dis(0, trunks.size() - 1);
-            const auto& selected_trunk = trunks[trunk_dis(gen_)];
-            route.trunk_id = selected_trunk.id;
-            route.trunk_name = selected_trunk.name;
-        }
+        std::uniform_int_distribution<size_t> trunk_dis(0, trunks.size() - 1);
+        const auto& selected_trunk = trunks[trunk_dis(gen_)];
+        route.trunk_id = selected_trunk.id;
+        route.trunk_name = selected_trunk.name;
     } else {
         // Выбираем случайный транк с сервера
         std::uniform_int_distribution<size_t> trunk_dis(0, server_trunks.size() - 1);
-        const auto& selected_trunk = server_trunks[trunk_dis(gen_)];
+        const auto& selected_trunk = *server_trunks[trunk_dis(gen_)];
         route.trunk_id = selected_trunk.id;
         route.trunk_name = selected_trunk.name;
     }
@@ -173,6 +141,15 @@ GeneratedCall CallGenerator::GenerateCall(
     const std::vector<ui::detail::TrunkInfo>& trunks,
     const std::vector<ui::detail::TarifInfo>& tarifs,
     const std::vector<ui::detail::PricelistInfo>& pricelists
+) {
+    return GenerateCall(topology::NetworkTopology(hubs, servers, trunks), tarifs,
+                        rating::Rater(trunks, tarifs, pricelists));
+}
+
+GeneratedCall CallGenerator::GenerateCall(
+    const topology::NetworkTopology& topology,
+    const std::vector<ui::detail::TarifInfo>& tarifs,
+    const rating::Rater& rater
 ) {
     GeneratedCall call;
     
@@ -182,7 +159,7 @@ GeneratedCall CallGenerator::GenerateCall(
     call.duration_seconds = GenerateDuration();
     
     // Строим маршрут (hub -> server -> trunk)
-    call.route = BuildRoute(hubs, servers, trunks);
+    call.route = BuildRoute(topology);
     call.trunk_id = call.route.trunk_id;
     
     // Выбираем случайный тариф
@@ -191,34 +168,11 @@ GeneratedCall CallGenerator::GenerateCall(
         const auto& selected_tarif = tarifs[tarif_dis(gen_)];
         call.tarif_id = selected_tarif.id;
         
-        // Находим прайс-лист для тарифа
-        const auto* pricelist = FindPricelist(selected_tarif.pricelist_id, pricelists);
-        
-        if (pricelist && pricelist->is_active) {
-            // Находим транк для получения cost_per_channel
-            auto trunk_it = std::find_if(trunks.begin(), trunks.end(),
-                [&call](const ui::detail::TrunkInfo& t) {
-                    return t.id == call.trunk_id;
-                });
-            
-            double cost_per_channel = (trunk_it != trunks.end()) 
-                ? trunk_it->cost_per_channel 
-                : 0.0;
-            
-            // Рассчитываем стоимость с учетом бесплатных минут
-            call.cost = CallCostCalculator::CalculateCostWithFreeMinutes(
-                call.duration_seconds,
-                pricelist->rate_per_minute,
-                selected_tarif.markup_percent,
-                cost_per_channel,
-                selected_tarif.free_minutes
-            );
-        } else {
-            call.cost = 0.0;
-        }
+        // Стоимость с учетом бесплатных минут; без активного прайс-листа - 0
+        rater.Rate(call.trunk_id, call.tarif_id, call.duration_seconds, call.cost);
     } else {
         call.tarif_id = 0;
-        call.cost = 0.0;
+        call.cost = {};
     }
     
     return call;
@@ -231,12 +185,23 @@ std::vector<GeneratedCall> CallGenerator::GenerateBatch(
     const std::vector<ui::detail::TrunkInfo>& trunks,
     const std::vector<ui::detail::TarifInfo>& tarifs,
     const std::vector<ui::detail::PricelistInfo>& pricelists
+) {
+    // Топологию и таблицы тарификации строим один раз на пакет
+    return GenerateBatch(count, topology::NetworkTopology(hubs, servers, trunks), tarifs,
+                         rating::Rater(trunks, tarifs, pricelists));
+}
+
+std::vector<GeneratedCall> CallGenerator::GenerateBatch(
+    int count,
+    const topology::NetworkTopology& topology,
+    const std::vector<ui::detail::TarifInfo>& tarifs,
+    const rating::Rater& rater
 ) {
     std::vector<GeneratedCall> calls;
     calls.reserve(count);
     
     for (int i = 0; i < count; ++i) {
-        calls.push_back(GenerateCall(hubs, servers, trunks, tarifs, pricelists));
+        calls.push_back(GenerateCall(topology, tarifs, rater));
     }
     
     return calls;
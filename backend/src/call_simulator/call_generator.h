@@ -6,6 +6,14 @@
 #include <vector>
 #include <chrono>
 
+namespace rating {
+class Rater;
+} // namespace rating
+
+namespace topology {
+class NetworkTopology;
+} // namespace topology
+
 namespace call_simulator {
 
 // Структура для представления маршрута звонка
@@ -24,28 +32,28 @@ struct GeneratedCall {
     int trunk_id;
     int tarif_id;
     int duration_seconds;
-    double cost;
-    std::string call_time;
+    domain::Money cost;
+    int64_t call_time; // микросекунды от эпохи (UTC)
     CallRoute route;
 };
 
-// Класс для расчета стоимости звонка
+// Класс для расчета стоимости звонка (в целых миллионных долях, без double)
 class CallCostCalculator {
 public:
     // Расчет стоимости звонка по формуле из DB.md
-    static double CalculateCost(
+    static domain::Money CalculateCost(
         int duration_seconds,
-        double rate_per_minute,
-        double markup_percent,
-        double cost_per_channel
+        domain::Money rate_per_minute,
+        int markup_percent,
+        domain::Money cost_per_channel
     );
     
     // Расчет с учетом бесплатных минут
-    static double CalculateCostWithFreeMinutes(
+    static domain::Money CalculateCostWithFreeMinutes(
         int duration_seconds,
-        double rate_per_minute,
-        double markup_percent,
-        double cost_per_channel,
+        domain::Money rate_per_minute,
+        int markup_percent,
+        domain::Money cost_per_channel,
         int free_minutes
     );
 };
@@ -74,12 +82,22 @@ public:
         const std::vector<ui::detail::PricelistInfo>& pricelists
     );
     
+    // Генерация пакета по готовым топологии и тарификатору снимка справочников
+    // (topology::GetTopology, rating::GetRater)
+    std::vector<GeneratedCall> GenerateBatch(
+        int count,
+        const topology::NetworkTopology& topology,
+        const std::vector<ui::detail::TarifInfo>& tarifs,
+        const rating::Rater& rater
+    );
+    
     // Построение маршрута звонка (hub -> server -> trunk)
     CallRoute BuildRoute(
         const std::vector<ui::detail::HubInfo>& hubs,
         const std::vector<ui::detail::ServerInfo>& servers,
         const std::vector<ui::detail::TrunkInfo>& trunks
     );
+    CallRoute BuildRoute(const topology::NetworkTopology& topology);
 
 private:
     std::random_device rd_;
@@ -91,14 +109,15 @@ private:
     // Генерация случайной длительности звонка (30-600 секунд)
     int GenerateDuration();
     
-    // Получение текущего времени в формате ISO 8601
-    std::string GetCurrentTimestamp();
+    // Текущее время в микросекундах от эпохи (UTC)
+    int64_t GetCurrentTimestamp();
     
-    // Поиск прайс-листа по ID
-    const ui::detail::PricelistInfo* FindPricelist(
-        int pricelist_id,
-        const std::vector<ui::detail::PricelistInfo>& pricelists
-    ) const;
+    // Генерация звонка с готовыми таблицами тарификации
+    GeneratedCall GenerateCall(
+        const topology::NetworkTopology& topology,
+        const std::vector<ui::detail::TarifInfo>& tarifs,
+        const rating::Rater& rater
+    );
 };
 
 } // namespace call_simulator
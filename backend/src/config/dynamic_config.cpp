@@ -136,6 +136,57 @@ std::shared_ptr<AppConfiguration> DynamicConfig::ParseConfigFile(const std::stri
                 else if (key == "max_call_duration") cfg->max_call_duration = std::stoi(value);
                 else if (key == "max_calls_per_request") cfg->max_calls_per_request = std::stoi(value);
             }
+            else if (current_section == "ingest") {
+                if (key == "batch_size") cfg->ingest_batch_size = std::stoi(value);
+                else if (key == "write_behind") cfg->ingest_write_behind = (value == "true");
+                else if (key == "durability") cfg->ingest_durability = value;
+                else if (key == "queue_capacity") cfg->ingest_queue_capacity = std::stoi(value);
+                else if (key == "flush_batch_size") cfg->ingest_flush_batch_size = std::stoi(value);
+                else if (key == "flush_interval_ms") cfg->ingest_flush_interval_ms = std::stoi(value);
+                else if (key == "commit_timeout_ms") cfg->ingest_commit_timeout_ms = std::stoi(value);
+                else if (key == "spool_path") cfg->ingest_spool_path = value;
+                else if (key == "spool_max_mb") cfg->ingest_spool_max_mb = std::stoi(value);
+                else if (key == "spool_max_age_hours") cfg->ingest_spool_max_age_hours = std::stoi(value);
+                else if (key == "spool_sync") cfg->ingest_spool_sync = (value == "true");
+                else if (key == "max_calls_per_request") cfg->ingest_max_calls_per_request = std::stoi(value);
+            }
+            else if (current_section == "call_statistics") {
+                if (key == "retention_months") cfg->retention_months = std::stoi(value);
+                else if (key == "archive_partitions") cfg->archive_partitions = (value == "true");
+                else if (key == "partitions_ahead") cfg->partitions_ahead = std::stoi(value);
+                else if (key == "maintenance_interval_seconds") cfg->partition_maintenance_interval_seconds = std::stoi(value);
+                else if (key == "totals_compact_seconds") cfg->totals_compact_seconds = std::stoi(value);
+            }
+            else if (current_section == "rerate") {
+                if (key == "on_update") cfg->rerate_on_update = (value == "true");
+                else if (key == "chunk_size") cfg->rerate_chunk_size = std::stoi(value);
+                else if (key == "parallelism") cfg->rerate_parallelism = std::stoi(value);
+                else if (key == "max_rows_per_second") cfg->rerate_max_rows_per_second = std::stoi(value);
+            }
+            else if (current_section == "call_store") {
+                if (key == "enabled") cfg->call_store_enabled = (value == "true");
+                else if (key == "retention_hours") cfg->call_store_retention_hours = std::stoi(value);
+                else if (key == "refresh_interval_ms") cfg->call_store_refresh_interval_ms = std::stoi(value);
+                else if (key == "full_reload_minutes") cfg->call_store_full_reload_minutes = std::stoi(value);
+                else if (key == "late_commit_seconds") cfg->call_store_late_commit_seconds = std::stoi(value);
+                else if (key == "chunk_rows") cfg->call_store_chunk_rows = std::stoi(value);
+            }
+            else if (current_section == "analytics") {
+                if (key == "threads") cfg->analytics_threads = std::stoi(value);
+                else if (key == "min_rows_per_task") cfg->analytics_min_rows_per_task = std::stoi(value);
+                else if (key == "cache_enabled") cfg->analytics_cache_enabled = (value == "true");
+                else if (key == "cache_max_mb") cfg->analytics_cache_max_mb = std::stoi(value);
+            }
+            else if (current_section == "aggregates") {
+                if (key == "enabled") cfg->aggregates_enabled = (value == "true");
+                else if (key == "checkpoint_path") cfg->aggregates_checkpoint_path = value;
+                else if (key == "refresh_interval_ms") cfg->aggregates_refresh_interval_ms = std::stoi(value);
+                else if (key == "checkpoint_interval_seconds") cfg->aggregates_checkpoint_interval_seconds = std::stoi(value);
+                else if (key == "full_rebuild_hours") cfg->aggregates_full_rebuild_hours = std::stoi(value);
+                else if (key == "late_commit_seconds") cfg->aggregates_late_commit_seconds = std::stoi(value);
+                else if (key == "leader_days") cfg->aggregates_leader_days = std::stoi(value);
+                else if (key == "top_calls") cfg->aggregates_top_calls = std::stoi(value);
+            }
         }
     }
     
@@ -178,6 +229,69 @@ std::string DynamicConfig::GenerateConfigFile(const AppConfiguration& cfg) const
     ss << "    max_call_duration = " << cfg.max_call_duration << "\n";
     ss << "    max_calls_per_request = " << cfg.max_calls_per_request << "\n";
     ss << "}\n";
+    ss << "\n";
+    ss << "# Загрузка звонков в БД\n";
+    ss << "ingest {\n";
+    ss << "    batch_size = " << cfg.ingest_batch_size << "\n";
+    ss << "    write_behind = " << (cfg.ingest_write_behind ? "true" : "false") << "\n";
+    ss << "    durability = \"" << cfg.ingest_durability << "\"\n";
+    ss << "    queue_capacity = " << cfg.ingest_queue_capacity << "\n";
+    ss << "    flush_batch_size = " << cfg.ingest_flush_batch_size << "\n";
+    ss << "    flush_interval_ms = " << cfg.ingest_flush_interval_ms << "\n";
+    ss << "    commit_timeout_ms = " << cfg.ingest_commit_timeout_ms << "\n";
+    ss << "    spool_path = \"" << cfg.ingest_spool_path << "\"\n";
+    ss << "    spool_max_mb = " << cfg.ingest_spool_max_mb << "\n";
+    ss << "    spool_max_age_hours = " << cfg.ingest_spool_max_age_hours << "\n";
+    ss << "    spool_sync = " << (cfg.ingest_spool_sync ? "true" : "false") << "\n";
+    ss << "    max_calls_per_request = " << cfg.ingest_max_calls_per_request << "\n";
+    ss << "}\n";
+    ss << "\n";
+    ss << "# Хранение статистики звонков (помесячные секции call_statistics)\n";
+    ss << "call_statistics {\n";
+    ss << "    retention_months = " << cfg.retention_months << "\n";
+    ss << "    archive_partitions = " << (cfg.archive_partitions ? "true" : "false") << "\n";
+    ss << "    partitions_ahead = " << cfg.partitions_ahead << "\n";
+    ss << "    maintenance_interval_seconds = " << cfg.partition_maintenance_interval_seconds << "\n";
+    ss << "    totals_compact_seconds = " << cfg.totals_compact_seconds << "\n";
+    ss << "}\n";
+    ss << "\n";
+    ss << "# Пересчёт стоимости звонков после изменения прайс-листа, тарифа или транка\n";
+    ss << "rerate {\n";
+    ss << "    on_update = " << (cfg.rerate_on_update ? "true" : "false") << "\n";
+    ss << "    chunk_size = " << cfg.rerate_chunk_size << "\n";
+    ss << "    parallelism = " << cfg.rerate_parallelism << "\n";
+    ss << "    max_rows_per_second = " << cfg.rerate_max_rows_per_second << "\n";
+    ss << "}\n";
+    ss << "\n";
+    ss << "# Колоночная копия свежих звонков в памяти для аналитики\n";
+    ss << "call_store {\n";
+    ss << "    enabled = " << (cfg.call_store_enabled ? "true" : "false") << "\n";
+    ss << "    retention_hours = " << cfg.call_store_retention_hours << "\n";
+    ss << "    refresh_interval_ms = " << cfg.call_store_refresh_interval_ms << "\n";
+    ss << "    full_reload_minutes = " << cfg.call_store_full_reload_minutes << "\n";
+    ss << "    late_commit_seconds = " << cfg.call_store_late_commit_seconds << "\n";
+    ss << "    chunk_rows = " << cfg.call_store_chunk_rows << "\n";
+    ss << "}\n";
+    ss << "\n";
+    ss << "# Расчёт аналитики в отдельном пуле потоков\n";
+    ss << "analytics {\n";
+    ss << "    threads = " << cfg.analytics_threads << "\n";
+    ss << "    min_rows_per_task = " << cfg.analytics_min_rows_per_task << "\n";
+    ss << "    cache_enabled = " << (cfg.analytics_cache_enabled ? "true" : "false") << "\n";
+    ss << "    cache_max_mb = " << cfg.analytics_cache_max_mb << "\n";
+    ss << "}\n";
+    ss << "\n";
+    ss << "# Поддерживаемые агрегаты по всем звонкам с контрольной точкой на диске\n";
+    ss << "aggregates {\n";
+    ss << "    enabled = " << (cfg.aggregates_enabled ? "true" : "false") << "\n";
+    ss << "    checkpoint_path = \"" << cfg.aggregates_checkpoint_path << "\"\n";
+    ss << "    refresh_interval_ms = " << cfg.aggregates_refresh_interval_ms << "\n";
+    ss << "    checkpoint_interval_seconds = " << cfg.aggregates_checkpoint_interval_seconds << "\n";
+    ss << "    full_rebuild_hours = " << cfg.aggregates_full_rebuild_hours << "\n";
+    ss << "    late_commit_seconds = " << cfg.aggregates_late_commit_seconds << "\n";
+    ss << "    leader_days = " << cfg.aggregates_leader_days << "\n";
+    ss << "    top_calls = " << cfg.aggregates_top_calls << "\n";
+    ss << "}\n";
     
     return ss.str();
 }
@@ -224,6 +338,45 @@ std::string DynamicConfig::ToJson() const {
         {"min_call_duration"s, cfg->min_call_duration},
         {"max_call_duration"s, cfg->max_call_duration},
         {"max_calls_per_request"s, cfg->max_calls_per_request},
+        {"ingest_batch_size"s, cfg->ingest_batch_size},
+        {"ingest_write_behind"s, cfg->ingest_write_behind},
+        {"ingest_durability"s, cfg->ingest_durability},
+        {"ingest_queue_capacity"s, cfg->ingest_queue_capacity},
+        {"ingest_flush_batch_size"s, cfg->ingest_flush_batch_size},
+        {"ingest_flush_interval_ms"s, cfg->ingest_flush_interval_ms},
+        {"ingest_commit_timeout_ms"s, cfg->ingest_commit_timeout_ms},
+        {"ingest_spool_path"s, cfg->ingest_spool_path},
+        {"ingest_spool_max_mb"s, cfg->ingest_spool_max_mb},
+        {"ingest_spool_max_age_hours"s, cfg->ingest_spool_max_age_hours},
+        {"ingest_spool_sync"s, cfg->ingest_spool_sync},
+        {"ingest_max_calls_per_request"s, cfg->ingest_max_calls_per_request},
+        {"retention_months"s, cfg->retention_months},
+        {"archive_partitions"s, cfg->archive_partitions},
+        {"partitions_ahead"s, cfg->partitions_ahead},
+        {"partition_maintenance_interval_seconds"s, cfg->partition_maintenance_interval_seconds},
+        {"totals_compact_seconds"s, cfg->totals_compact_seconds},
+        {"rerate_on_update"s, cfg->rerate_on_update},
+        {"rerate_chunk_size"s, cfg->rerate_chunk_size},
+        {"rerate_parallelism"s, cfg->rerate_parallelism},
+        {"rerate_max_rows_per_second"s, cfg->rerate_max_rows_per_second},
+        {"call_store_enabled"s, cfg->call_store_enabled},
+        {"call_store_retention_hours"s, cfg->call_store_retention_hours},
+        {"call_store_refresh_interval_ms"s, cfg->call_store_refresh_interval_ms},
+        {"call_store_full_reload_minutes"s, cfg->call_store_full_reload_minutes},
+        {"call_store_late_commit_seconds"s, cfg->call_store_late_commit_seconds},
+        {"call_store_chunk_rows"s, cfg->call_store_chunk_rows},
+        {"analytics_threads"s, cfg->analytics_threads},
+        {"analytics_min_rows_per_task"s, cfg->analytics_min_rows_per_task},
+        {"analytics_cache_enabled"s, cfg->analytics_cache_enabled},
+        {"analytics_cache_max_mb"s, cfg->analytics_cache_max_mb},
+        {"aggregates_enabled"s, cfg->aggregates_enabled},
+        {"aggregates_checkpoint_path"s, cfg->aggregates_checkpoint_path},
+        {"aggregates_refresh_interval_ms"s, cfg->aggregates_refresh_interval_ms},
+        {"aggregates_checkpoint_interval_seconds"s, cfg->aggregates_checkpoint_interval_seconds},
+        {"aggregates_full_rebuild_hours"s, cfg->aggregates_full_rebuild_hours},
+        {"aggregates_late_commit_seconds"s, cfg->aggregates_late_commit_seconds},
+        {"aggregates_leader_days"s, cfg->aggregates_leader_days},
+        {"aggregates_top_calls"s, cfg->aggregates_top_calls},
         {"version"s, cfg->version},
         {"last_updated"s, cfg->last_updated}
     };
@@ -281,6 +434,37 @@ void DynamicConfig::UpdateFromJson(const std::string& json_str) {
         if (obj.contains("max_calls_per_request"s)) {
             new_config->max_calls_per_request = obj.at("max_calls_per_request"s).as_int64();
         }
+        if (obj.contains("ingest_batch_size"s)) {
+            new_config->ingest_batch_size = obj.at("ingest_batch_size"s).as_int64();
+        }
+        if (obj.contains("ingest_durability"s)) {
+            new_config->ingest_durability = obj.at("ingest_durability"s).as_string().c_str();
+        }
+        if (obj.contains("ingest_commit_timeout_ms"s)) {
+            new_config->ingest_commit_timeout_ms = obj.at("ingest_commit_timeout_ms"s).as_int64();
+        }
+        if (obj.contains("ingest_max_calls_per_request"s)) {
+            new_config->ingest_max_calls_per_request = obj.at("ingest_max_calls_per_request"s).as_int64();
+        }
+        if (obj.contains("retention_months"s)) {
+            new_config->retention_months = obj.at("retention_months"s).as_int64();
+        }
+        if (obj.contains("archive_partitions"s)) {
+            new_config->archive_partitions = obj.at("archive_partitions"s).as_bool();
+        }
+        if (obj.contains("partitions_ahead"s)) {
+            new_config->partitions_ahead = obj.at("partitions_ahead"s).as_int64();
+        }
+        if (obj.contains("partition_maintenance_interval_seconds"s)) {
+            new_config->partition_maintenance_interval_seconds =
+                obj.at("partition_maintenance_interval_seconds"s).as_int64();
+        }
+        if (obj.contains("totals_compact_seconds"s)) {
+            new_config->totals_compact_seconds = obj.at("totals_compact_seconds"s).as_int64();
+        }
+        if (obj.contains("rerate_on_update"s)) {
+            new_config->rerate_on_update = obj.at("rerate_on_update"s).as_bool();
+        }
         
         Update(new_config);
         
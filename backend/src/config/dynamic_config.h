@@ -36,6 +36,57 @@ struct AppConfiguration {
     int min_call_duration = 30;
     int max_call_duration = 600;
     int max_calls_per_request = 1000;
+
+    // Загрузка звонков в БД (секция ingest)
+    int ingest_batch_size = 500;                    // строк в одном COPY
+    bool ingest_write_behind = true;                // писать через фоновую очередь
+    std::string ingest_durability = "queued";       // queued | committed - когда отвечать клиенту
+    int ingest_queue_capacity = 100000;             // звонков в очереди (при переполнении - 503)
+    int ingest_flush_batch_size = 5000;             // звонков в одном сбросе очереди
+    int ingest_flush_interval_ms = 50;
+    int ingest_commit_timeout_ms = 10000;           // ожидание фиксации при durability = committed (затем 503)
+    std::string ingest_spool_path = "spool/calls.spool"; // журнал на время недоступности БД ("" - отключён)
+    int ingest_spool_max_mb = 256;
+    int ingest_spool_max_age_hours = 72;
+    bool ingest_spool_sync = true;                  // msync после каждой записи в журнал
+    int ingest_max_calls_per_request = 200000;      // записей в одном запросе /api/ingest/calls
+
+    // Хранение статистики звонков (секция call_statistics)
+    int retention_months = 12;                      // 0 - хранить всё
+    bool archive_partitions = false;                // отсоединять старые секции вместо удаления
+    int partitions_ahead = 2;                       // сколько будущих месяцев создавать заранее
+    int partition_maintenance_interval_seconds = 3600;
+    int totals_compact_seconds = 60;                // период свёртки изменений итогов (миграция 006)
+
+    // Пересчёт стоимости звонков после изменения тарификации (секция rerate)
+    bool rerate_on_update = true;                   // запускать при изменении прайс-листа, тарифа, транка
+    int rerate_chunk_size = 5000;                   // звонков в одной части
+    int rerate_parallelism = 2;                     // потоков и подключений к БД
+    int rerate_max_rows_per_second = 20000;         // 0 - без ограничения
+
+    // Колоночная копия свежих звонков в памяти для аналитики (секция call_store)
+    bool call_store_enabled = true;
+    int call_store_retention_hours = 168;           // глубина хранения в памяти
+    int call_store_refresh_interval_ms = 2000;      // период дозагрузки новых звонков
+    int call_store_full_reload_minutes = 60;        // период полной перезагрузки
+    int call_store_late_commit_seconds = 600;       // сколько перечитывать пропущенные id, 0 - не перечитывать
+    int call_store_chunk_rows = 65536;              // строк в одной части
+
+    // Расчёт аналитики (секция analytics)
+    int analytics_threads = 0;                      // потоков расчёта, 0 - по числу ядер
+    int analytics_min_rows_per_task = 262144;       // меньшие объёмы считаются одной задачей
+    bool analytics_cache_enabled = true;            // кэш ответов /api/analytics по версии данных
+    int analytics_cache_max_mb = 64;
+
+    // Поддерживаемые агрегаты по всем звонкам (секция aggregates)
+    bool aggregates_enabled = true;
+    std::string aggregates_checkpoint_path = "state/call_aggregates.bin"; // "" - без контрольной точки
+    int aggregates_refresh_interval_ms = 1000;      // период догрузки новых звонков
+    int aggregates_checkpoint_interval_seconds = 60;
+    int aggregates_full_rebuild_hours = 24;         // 0 - только после пересчёта и удаления секций
+    int aggregates_late_commit_seconds = 600;       // сколько перечитывать пропущенные id, 0 - не перечитывать
+    int aggregates_leader_days = 2;                 // суток UTC с рейтингами звонков, 0 - без рейтингов
+    int aggregates_top_calls = 100;                 // самых дорогих звонков на сутки
     
     // Версия конфигурации (автоматически увеличивается)
     int version = 1;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <condition_variable>
+#include <functional>
 #include <pqxx/pqxx>
 #include <mutex>
 #include <thread>
@@ -45,23 +46,40 @@ class ConnectionPool {
     };
 
     template <typename ConnectionFactory>
-    ConnectionPool(size_t capacity, ConnectionFactory&& connection_factory) {
+    ConnectionPool(size_t capacity, ConnectionFactory&& connection_factory)
+        : connection_factory_{std::forward<ConnectionFactory>(connection_factory)} {
         pool_.reserve(capacity);
         for (size_t i = 0; i < capacity; ++i) {
-            pool_.emplace_back(connection_factory());
+            pool_.emplace_back(connection_factory_());
         }
     }
 
     ConnectionWrapper GetConnection() {
-        std::unique_lock lock{mutex_};
-        cond_var_.wait(lock, [this] {
-            return used_connections_ < pool_.size();
-        });
+        ConnectionPtr conn;
+        {
+            std::unique_lock lock{mutex_};
+            cond_var_.wait(lock, [this] {
+                return used_connections_ < pool_.size();
+            });
+            conn = std::move(pool_[used_connections_++]);
+        }
+
+        // Пул живёт всё время работы процесса: соединение, оборванное
+        // перезапуском БД, заменяем новым при следующей выдаче
+        if (!conn->is_open()) {
+            try {
+                conn = connection_factory_();
+            } catch (...) {
+                ReturnConnection(std::move(conn));
+                throw;
+            }
+        }
 
-        return {std::move(pool_[used_connections_++]), *this};
+        return {std::move(conn), *this};
     }
 
   private:
+    std::function<ConnectionPtr()> connection_factory_;
     std::mutex mutex_;
     std::condition_variable cond_var_;
     std::vector<ConnectionPtr> pool_;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "call_statistics.h"
+#include "../analytics/analytics.h"
+
+#include <vector>
+
+namespace domain {
+
+// Агрегаты по звонкам, которые считаются на стороне БД (GROUP BY)
+class CallAnalyticsRepository {
+  public:
+    virtual std::vector<analytics::TrunkAnalytics> GetByTrunk(const TimeRange& range) const = 0;
+    virtual std::vector<analytics::TarifAnalytics> GetByTarif(const TimeRange& range) const = 0;
+    virtual std::vector<analytics::HubAnalytics> GetByHub(const TimeRange& range) const = 0;
+    virtual std::vector<analytics::RevenueAnalytics> GetRevenue(analytics::RevenuePeriod period,
+                                                               const TimeRange& range) const = 0;
+    virtual std::vector<analytics::TimeSeriesPoint> GetTimeSeries(const analytics::TimeBuckets& buckets) const = 0;
+    // Гистограммы длительности и стоимости и recent_calls последних звонков (по убыванию id);
+    // остальные поля сводки не заполняются
+    virtual analytics::DashboardSummary GetDashboardDetails(const TimeRange& range, size_t recent_calls) const = 0;
+
+  protected:
+    ~CallAnalyticsRepository() = default;
+};
+
+} // namespace domain
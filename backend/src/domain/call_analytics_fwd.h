@@ -0,0 +1,7 @@
+#pragma once
+
+namespace domain {
+
+class CallAnalyticsRepository;
+
+} // namespace domain
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "call_statistics_fwd.h"
+#include "money.h"
+#include "timestamp.h"
 #include "../ui/view.h"
 
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace domain {
 
@@ -11,14 +17,14 @@ class Worker;
 class CallStatistics {
   public:
     CallStatistics(int64_t id, std::string call_id, int trunk_id, int tarif_id, 
-                   int duration_seconds, double cost, std::string call_time)
+                   int duration_seconds, Money cost, int64_t call_time)
         : id_(id)
         , call_id_(std::move(call_id))
         , trunk_id_(trunk_id)
         , tarif_id_(tarif_id)
         , duration_seconds_(duration_seconds)
         , cost_(cost)
-        , call_time_(std::move(call_time)) {}
+        , call_time_(call_time) {}
 
     int64_t GetId() const noexcept {
         return id_;
@@ -40,11 +46,12 @@ class CallStatistics {
         return duration_seconds_;
     }
 
-    double GetCost() const noexcept {
+    Money GetCost() const noexcept {
         return cost_;
     }
 
-    const std::string& GetCallTime() const noexcept {
+    // Микросекунды от эпохи (UTC)
+    int64_t GetCallTime() const noexcept {
         return call_time_;
     }
 
@@ -54,14 +61,64 @@ class CallStatistics {
     int trunk_id_;
     int tarif_id_;
     int duration_seconds_;
-    double cost_;
-    std::string call_time_;
+    Money cost_;
+    int64_t call_time_;
+};
+
+// Полуинтервал времени звонка [from, to) в формате timestamptz.
+// По границам Postgres отсекает лишние месячные секции call_statistics
+struct TimeRange {
+    std::optional<std::string> from;
+    std::optional<std::string> to;
+};
+
+// Диапазон id звонков [from, to] включительно
+struct IdRange {
+    int64_t from = 0;
+    int64_t to = 0;
+};
+
+// Условия выборки звонков для потокового обхода
+struct CallStatisticsFilter {
+    std::optional<int64_t> after_id; // только id > after_id, строки идут по возрастанию id
+    std::vector<IdRange> missing_ids; // вместе с after_id: ещё и id из этих диапазонов
+    std::optional<int> trunk_id;
+    std::optional<int> tarif_id;
+    TimeRange time_range;
+};
+
+// Итоги всех звонков: 64-битные счётчики и выручка в миллионных долях
+struct CallTotals {
+    int64_t calls = 0;
+    int64_t duration_seconds = 0;
+    Money revenue;
+};
+
+// Ошибка сохранения одной строки пакета
+struct BulkInsertError {
+    size_t index;        // номер строки во входном пакете
+    std::string message;
+};
+
+// Результат пакетной вставки звонков
+struct BulkInsertResult {
+    size_t inserted = 0;
+    size_t duplicates = 0; // пропущены как уже существующие (повторная загрузка)
+    size_t spooled = 0;    // отложены в локальный журнал до восстановления БД
+    std::vector<BulkInsertError> errors;
 };
 
 class CallStatisticsRepository {
   public:
     virtual std::vector<ui::detail::CallStatisticsInfo> Get() const = 0;
 
+    // Потоковый обход без материализации всей таблицы.
+    // Ссылка, переданная в visitor, действительна только на время вызова
+    virtual void ForEach(const CallStatisticsFilter& filter, const CallStatisticsVisitor& visitor) const = 0;
+
+    // Итоги по таблице call_statistics_totals (миграция 004), без неё - агрегатом по звонкам в БД
+    virtual CallTotals GetTotals() const = 0;
+
     virtual std::shared_ptr<domain::Worker> GetWorker() const = 0;
 
   protected:
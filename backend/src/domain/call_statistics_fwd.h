@@ -1,9 +1,29 @@
 #pragma once
 
+#include <functional>
+
+namespace ui {
+
+namespace detail {
+
+struct CallStatisticsInfo;
+
+} // namespace detail
+
+} // namespace ui
+
 namespace domain {
 
 class CallStatistics;
 
 class CallStatisticsRepository;
 
+struct TimeRange;
+struct IdRange;
+struct CallStatisticsFilter;
+struct BulkInsertResult;
+struct CallTotals;
+
+using CallStatisticsVisitor = std::function<void(const ui::detail::CallStatisticsInfo&)>;
+
 } // namespace domain
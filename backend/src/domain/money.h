@@ -0,0 +1,209 @@
+#pragma once
+
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace domain {
+
+// Денежная сумма с фиксированной точкой: целое число миллионных долей (1e-6).
+// Совпадает по точности с DECIMAL(10, 6) в БД, поэтому суммирование
+// стоимости звонков точное и не зависит от порядка слагаемых.
+// double используется только на границе JSON, где число уходит во фронтенд
+class Money {
+public:
+    static constexpr int64_t SCALE = 1'000'000;
+    static constexpr int FRACTION_DIGITS = 6;
+
+    constexpr Money() noexcept = default;
+
+    static constexpr Money FromMicros(int64_t micros) noexcept {
+        return Money{micros};
+    }
+
+    // Округление до ближайшей миллионной доли
+    static Money FromDouble(double value) {
+        double scaled = value * static_cast<double>(SCALE);
+        if (!std::isfinite(scaled) || std::fabs(scaled) >= 9.2e18) {
+            throw std::out_of_range("Money value is out of range");
+        }
+        return Money{std::llround(scaled)};
+    }
+
+    // Точный разбор десятичной записи: "12", "-0.5", "3.141593".
+    // Знаки после шестого округляются (половина - от нуля), как в NUMERIC
+    static Money Parse(std::string_view text) {
+        bool negative = false;
+        if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+            negative = text.front() == '-';
+            text.remove_prefix(1);
+        }
+        if (text.empty()) {
+            throw std::invalid_argument("Empty money value");
+        }
+
+        constexpr int64_t MAX_UNITS = std::numeric_limits<int64_t>::max() / SCALE;
+
+        int64_t units = 0;
+        int64_t fraction = 0;
+        int fraction_digits = 0;
+        bool round_up = false;
+        bool seen_digit = false;
+        bool seen_point = false;
+
+        for (char c : text) {
+            if (c == '.' && !seen_point) {
+                seen_point = true;
+                continue;
+            }
+            if (c < '0' || c > '9') {
+                throw std::invalid_argument("Invalid money value: " + std::string(text));
+            }
+            seen_digit = true;
+            int digit = c - '0';
+
+            if (!seen_point) {
+                if (units > (MAX_UNITS - digit) / 10) {
+                    throw std::out_of_range("Money value is out of range: " + std::string(text));
+                }
+                units = units * 10 + digit;
+            }
+            else if (fraction_digits < FRACTION_DIGITS) {
+                fraction = fraction * 10 + digit;
+                ++fraction_digits;
+            }
+            else if (fraction_digits == FRACTION_DIGITS) {
+                round_up = digit >= 5;
+                ++fraction_digits;
+            }
+        }
+        if (!seen_digit) {
+            throw std::invalid_argument("Invalid money value: " + std::string(text));
+        }
+
+        for (int i = std::min(fraction_digits, FRACTION_DIGITS); i < FRACTION_DIGITS; ++i) {
+            fraction *= 10;
+        }
+
+        int64_t micros = units * SCALE + fraction + (round_up ? 1 : 0);
+        return Money{negative ? -micros : micros};
+    }
+
+    constexpr int64_t Micros() const noexcept {
+        return micros_;
+    }
+
+    double ToDouble() const noexcept {
+        return static_cast<double>(micros_) / static_cast<double>(SCALE);
+    }
+
+    // Десятичная запись с шестью знаками после точки: "-1.250000"
+    std::string ToString() const {
+        char buffer[32];
+        char* end = buffer + sizeof(buffer);
+        char* pos = end;
+
+        // Модуль считаем в беззнаковом типе, чтобы не переполниться на INT64_MIN
+        uint64_t value = micros_ < 0 ? 0 - static_cast<uint64_t>(micros_) : static_cast<uint64_t>(micros_);
+        for (int i = 0; i < FRACTION_DIGITS; ++i) {
+            *--pos = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        *--pos = '.';
+        do {
+            *--pos = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        if (micros_ < 0) {
+            *--pos = '-';
+        }
+
+        return std::string(pos, end);
+    }
+
+    // value * numerator / denominator с одним округлением (половина - от нуля).
+    // Промежуточное произведение считается в 128 битах
+    Money MulDiv(int64_t numerator, int64_t denominator) const {
+        if (denominator == 0) {
+            throw std::invalid_argument("Money division by zero");
+        }
+
+        __int128 product = static_cast<__int128>(micros_) * numerator;
+        __int128 divisor = denominator;
+        if (divisor < 0) {
+            product = -product;
+            divisor = -divisor;
+        }
+
+        __int128 half = divisor / 2;
+        __int128 result = product >= 0 ? (product + half) / divisor : (product - half) / divisor;
+        if (result > std::numeric_limits<int64_t>::max() || result < std::numeric_limits<int64_t>::min()) {
+            throw std::out_of_range("Money value is out of range");
+        }
+        return Money{static_cast<int64_t>(result)};
+    }
+
+    constexpr Money& operator+=(Money other) noexcept {
+        micros_ += other.micros_;
+        return *this;
+    }
+
+    constexpr Money& operator-=(Money other) noexcept {
+        micros_ -= other.micros_;
+        return *this;
+    }
+
+    friend constexpr Money operator+(Money lhs, Money rhs) noexcept {
+        return lhs += rhs;
+    }
+
+    friend constexpr Money operator-(Money lhs, Money rhs) noexcept {
+        return lhs -= rhs;
+    }
+
+    friend constexpr Money operator-(Money value) noexcept {
+        return Money{-value.micros_};
+    }
+
+    friend constexpr Money operator*(Money value, int64_t factor) noexcept {
+        return Money{value.micros_ * factor};
+    }
+
+    friend constexpr auto operator<=>(Money lhs, Money rhs) noexcept = default;
+
+    // В JSON сумма передаётся числом, как и раньше
+    friend void tag_invoke(boost::json::value_from_tag, boost::json::value& jv, Money money) {
+        jv = money.ToDouble();
+    }
+
+    // Из JSON принимается целое, дробное число или строка с десятичной записью
+    friend Money tag_invoke(boost::json::value_to_tag<Money>, const boost::json::value& jv) {
+        constexpr int64_t MAX_UNITS = std::numeric_limits<int64_t>::max() / SCALE;
+        if (jv.is_int64() && std::llabs(jv.get_int64()) <= MAX_UNITS) {
+            return FromMicros(jv.get_int64() * SCALE);
+        }
+        if (jv.is_uint64() && jv.get_uint64() <= static_cast<uint64_t>(MAX_UNITS)) {
+            return FromMicros(static_cast<int64_t>(jv.get_uint64()) * SCALE);
+        }
+        if (jv.is_string()) {
+            return Parse(jv.get_string());
+        }
+        return FromDouble(jv.as_double());
+    }
+
+private:
+    constexpr explicit Money(int64_t micros) noexcept
+        : micros_(micros) {}
+
+    int64_t micros_ = 0;
+};
+
+} // namespace domain
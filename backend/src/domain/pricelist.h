@@ -1,5 +1,6 @@
 #pragma once
 
+#include "money.h"
 #include "../ui/view.h"
 
 #include <memory>
@@ -10,7 +11,7 @@ class Worker;
 
 class Pricelist {
   public:
-    Pricelist(int id, std::string name, std::string currency, double rate_per_minute, bool is_active)
+    Pricelist(int id, std::string name, std::string currency, Money rate_per_minute, bool is_active)
         : id_(id)
         , name_(std::move(name))
         , currency_(std::move(currency))
@@ -29,7 +30,7 @@ class Pricelist {
         return currency_;
     }
 
-    double GetRatePerMinute() const noexcept {
+    Money GetRatePerMinute() const noexcept {
         return rate_per_minute_;
     }
 
@@ -41,7 +42,7 @@ class Pricelist {
     int id_;
     std::string name_;
     std::string currency_;
-    double rate_per_minute_;
+    Money rate_per_minute_;
     bool is_active_;
 };
 
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace domain {
+
+// Время звонка хранится как число микросекунд от эпохи (UTC).
+// В строку оно превращается только на границе JSON и при записи в Postgres
+constexpr int64_t MICROS_PER_SECOND = 1'000'000;
+constexpr int64_t MICROS_PER_HOUR = 3600 * MICROS_PER_SECOND;
+constexpr int64_t MICROS_PER_DAY = 24 * MICROS_PER_HOUR;
+
+// Границы допустимого времени: 1970-01-01 .. 9999-12-31
+constexpr int64_t MAX_TIMESTAMP_US = 253402300799999999;
+
+// Длина "YYYY-MM-DD HH:MM:SS.ffffff+00"
+constexpr size_t TIMESTAMP_TEXT_SIZE = 29;
+
+struct CivilDate {
+    int year;
+    unsigned month; // 1..12
+    unsigned day;   // 1..31
+};
+
+// Номер дня от 1970-01-01 по дате григорианского календаря и обратно
+// (алгоритмы H. Hinnant, без таблиц и без обращения к tz)
+constexpr int64_t DaysFromCivil(int year, unsigned month, unsigned day) noexcept {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+constexpr CivilDate CivilFromDays(int64_t days) noexcept {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    return {static_cast<int>(static_cast<int64_t>(yoe) + era * 400 + (month <= 2)), month, day};
+}
+
+// Деление с округлением вниз (для моментов до эпохи)
+constexpr int64_t FloorDiv(int64_t value, int64_t divisor) noexcept {
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+namespace detail {
+
+inline char* PutDigits(char* out, uint64_t value, int width) noexcept {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+} // namespace detail
+
+// "YYYY-MM-DD" для дня с номером days от эпохи. out - не меньше 10 байт
+inline char* FormatDate(int64_t days, char* out) noexcept {
+    CivilDate date = CivilFromDays(days);
+    out = detail::PutDigits(out, static_cast<uint64_t>(date.year), 4);
+    *out++ = '-';
+    out = detail::PutDigits(out, date.month, 2);
+    *out++ = '-';
+    return detail::PutDigits(out, date.day, 2);
+}
+
+// "YYYY-MM-DD HH:MM:SS.ffffff+00" в формате timestamptz.
+// out - не меньше TIMESTAMP_TEXT_SIZE байт, возвращает конец записанного
+inline char* FormatTimestamp(int64_t epoch_us, char* out) noexcept {
+    int64_t days = FloorDiv(epoch_us, MICROS_PER_DAY);
+    int64_t in_day = epoch_us - days * MICROS_PER_DAY;
+    uint64_t seconds = static_cast<uint64_t>(in_day / MICROS_PER_SECOND);
+
+    out = FormatDate(days, out);
+    *out++ = ' ';
+    out = detail::PutDigits(out, seconds / 3600, 2);
+    *out++ = ':';
+    out = detail::PutDigits(out, seconds / 60 % 60, 2);
+    *out++ = ':';
+    out = detail::PutDigits(out, seconds % 60, 2);
+    *out++ = '.';
+    out = detail::PutDigits(out, static_cast<uint64_t>(in_day % MICROS_PER_SECOND), 6);
+    *out++ = '+';
+    *out++ = '0';
+    *out++ = '0';
+    return out;
+}
+
+inline std::string FormatTimestamp(int64_t epoch_us) {
+    char buffer[TIMESTAMP_TEXT_SIZE];
+    return std::string(buffer, FormatTimestamp(epoch_us, buffer));
+}
+
+// Разбор "YYYY-MM-DD[ T]HH:MM:SS[.f...][Z|+HH|+HH:MM|+HHMM]", '+' может быть пробелом.
+// Без часового пояса время считается UTC. nullopt - строка не является временем
+inline std::optional<int64_t> ParseTimestamp(std::string_view text) noexcept {
+    size_t pos = 0;
+    auto number = [&](size_t width, int& out) {
+        if (pos + width > text.size()) {
+            return false;
+        }
+        int value = 0;
+        for (size_t i = 0; i < width; ++i) {
+            char c = text[pos + i];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + (c - '0');
+        }
+        pos += width;
+        out = value;
+        return true;
+    };
+    auto expect = [&](std::string_view chars) {
+        if (pos < text.size() && chars.find(text[pos]) != std::string_view::npos) {
+            ++pos;
+            return true;
+        }
+        return false;
+    };
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (!number(4, year) || !expect("-") || !number(2, month) || !expect("-") || !number(2, day)
+        || !expect(" T") || !number(2, hour) || !expect(":") || !number(2, minute) || !expect(":")
+        || !number(2, second)) {
+        return std::nullopt;
+    }
+    if (month < 1 || month > 12 || day < 1 || hour > 23 || minute > 59 || second > 59) {
+        return std::nullopt;
+    }
+    CivilDate check = CivilFromDays(DaysFromCivil(year, month, day));
+    if (check.month != static_cast<unsigned>(month) || check.day != static_cast<unsigned>(day)) {
+        return std::nullopt;
+    }
+
+    // Доли секунды: учитываются первые шесть знаков, остальные отбрасываются
+    int64_t fraction = 0;
+    if (expect(".")) {
+        int digits = 0;
+        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+            if (digits < 6) {
+                fraction = fraction * 10 + (text[pos] - '0');
+            }
+            ++digits;
+            ++pos;
+        }
+        if (digits == 0) {
+            return std::nullopt;
+        }
+        for (; digits < 6; ++digits) {
+            fraction *= 10;
+        }
+    }
+
+    // Пробел вместо '+': неэкранированный '+' в строке запроса декодируется
+    // как пробел (DecodeURL), и "...T00:00:00+03:00" приходит как "...T00:00:00 03:00"
+    int64_t offset_seconds = 0;
+    if (!expect("Zz") && pos < text.size() && (text[pos] == '+' || text[pos] == '-' || text[pos] == ' ')) {
+        int sign = text[pos++] == '-' ? -1 : 1;
+        int offset_hours = 0;
+        int offset_minutes = 0;
+        if (!number(2, offset_hours)) {
+            return std::nullopt;
+        }
+        if (pos < text.size()) {
+            expect(":");
+            if (!number(2, offset_minutes)) {
+                return std::nullopt;
+            }
+        }
+        if (offset_hours > 15 || offset_minutes > 59) {
+            return std::nullopt;
+        }
+        offset_seconds = sign * (offset_hours * 3600 + offset_minutes * 60);
+    }
+    if (pos != text.size()) {
+        return std::nullopt;
+    }
+
+    int64_t seconds = DaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset_seconds;
+    int64_t result = seconds * MICROS_PER_SECOND + fraction;
+    if (result < 0 || result > MAX_TIMESTAMP_US) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+// Текущее время в микросекундах от эпохи
+inline int64_t NowTimestamp() noexcept {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace domain
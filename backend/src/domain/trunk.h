@@ -1,5 +1,6 @@
 #pragma once
 
+#include "money.h"
 #include "../ui/view.h"
 
 #include <memory>
@@ -10,7 +11,7 @@ class Worker;
 
 class Trunk {
   public:
-    Trunk(int id, int server_id, std::string name, int capacity, double cost_per_channel)
+    Trunk(int id, int server_id, std::string name, int capacity, Money cost_per_channel)
         : id_(id)
         , server_id_(server_id)
         , name_(std::move(name))
@@ -33,7 +34,7 @@ class Trunk {
         return capacity_;
     }
 
-    double GetCostPerChannel() const noexcept {
+    Money GetCostPerChannel() const noexcept {
         return cost_per_channel_;
     }
 
@@ -42,7 +43,7 @@ class Trunk {
     int server_id_;
     std::string name_;
     int capacity_;
-    double cost_per_channel_;
+    Money cost_per_channel_;
 };
 
 class TrunkRepository {
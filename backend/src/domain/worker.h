@@ -21,6 +21,16 @@ class Worker {
 
     virtual void AddCallStatistics(const domain::CallStatistics& call_stat) = 0;
 
+    // Пакетная вставка: строки пишутся частями по batch_size, каждая часть - один COPY.
+    // Ошибочные строки не прерывают загрузку остальных и возвращаются в result.errors
+    virtual BulkInsertResult AddCallStatisticsBatch(const std::vector<domain::CallStatistics>& calls,
+                                                    size_t batch_size) = 0;
+
+    // Идемпотентная вставка: звонки, чей call_id уже есть в call_statistics
+    // (или повторяется в пакете), пропускаются и учитываются в result.duplicates
+    virtual BulkInsertResult AddCallStatisticsIfAbsent(const std::vector<domain::CallStatistics>& calls,
+                                                       size_t batch_size) = 0;
+
   protected:
     virtual ~Worker() = default;
 };
@@ -16,19 +16,28 @@ void SessionBase::Run() {
 }
 
 void SessionBase::Read() {
-    request_ = {};
+    parser_.emplace();
+    parser_->body_limit(MAX_REQUEST_BODY_SIZE);
     stream_.expires_after(30s);
-    http::async_read(stream_, buffer_, request_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
+    http::async_read(stream_, buffer_, *parser_, beast::bind_front_handler(&SessionBase::OnRead, GetSharedThis()));
 }
 
 void SessionBase::OnRead(beast::error_code ec, [[maybe_unused]] size_t bytes_read) {
     if (ec == http::error::end_of_stream) {
         return Close();
     }
+    if (ec == http::error::body_limit) {
+        http::response<http::string_body> response{http::status::payload_too_large, 11};
+        response.set(http::field::content_type, "application/json"sv);
+        response.body() = R"({"code":"payloadTooLarge","message":"Request body is too large"})"s;
+        response.keep_alive(false);
+        response.prepare_payload();
+        return Write(std::move(response));
+    }
     if (ec) {
         return ReportError(ec, "read"sv);
     }
-    HandleRequest(std::move(request_));
+    HandleRequest(parser_->release());
 }
 
 void SessionBase::OnWrite(bool close, beast::error_code ec, [[maybe_unused]] size_t bytes_written) {
@@ -9,7 +9,9 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/beast/http.hpp>
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
@@ -29,6 +31,10 @@ using namespace std::literals;
 
 void ReportError(beast::error_code ec, std::string_view what);
 
+// Предел размера тела запроса. По умолчанию beast допускает 1 МБ, а пакеты
+// /api/ingest/calls по десяткам тысяч звонков заметно больше
+constexpr std::uint64_t MAX_REQUEST_BODY_SIZE = 64 * 1024 * 1024;
+
 class SessionBase {
   public:
     SessionBase(const SessionBase&) = delete;
@@ -58,7 +64,7 @@ class SessionBase {
   private:
     beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
-    HttpRequest request_;
+    std::optional<http::request_parser<http::string_body>> parser_;
 
     void Read();
     void OnRead(beast::error_code ec, [[maybe_unused]] size_t bytes_read);
@@ -0,0 +1,285 @@
+#include "cdr_decoder.h"
+#include "../domain/timestamp.h"
+
+#include <boost/endian/conversion.hpp>
+#include <boost/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+namespace ingest {
+using namespace std::literals;
+namespace json = boost::json;
+
+namespace {
+
+// call_statistics.call_id VARCHAR(100)
+constexpr size_t MAX_CALL_ID_LENGTH = 100;
+
+// trunk_id, tarif_id, duration_seconds, call_time, длина call_id
+constexpr size_t BINARY_FIXED_SIZE = 3 * sizeof(int32_t) + sizeof(int64_t) + sizeof(uint8_t);
+
+std::string_view Trim(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+// Общие проверки записи независимо от формата. Пустая строка - запись корректна
+std::string CheckCall(const ui::detail::CallStatisticsInfo& call) {
+    if (call.call_id.empty() || call.call_id.size() > MAX_CALL_ID_LENGTH) {
+        return "call_id must be 1.."s + std::to_string(MAX_CALL_ID_LENGTH) + " characters"s;
+    }
+    if (call.duration_seconds < 0) {
+        return "duration_seconds must not be negative"s;
+    }
+    return {};
+}
+
+bool ReadInt(const json::object& obj, std::string_view key, int& out, std::string& error) {
+    const auto* value = obj.if_contains(key);
+    if (!value) {
+        error = "missing field "s + std::string(key);
+        return false;
+    }
+
+    int64_t number = 0;
+    if (value->is_int64()) {
+        number = value->get_int64();
+    }
+    else if (value->is_uint64() && value->get_uint64() <= static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+        number = static_cast<int64_t>(value->get_uint64());
+    }
+    else {
+        error = std::string(key) + " must be an integer"s;
+        return false;
+    }
+
+    if (number < std::numeric_limits<int>::min() || number > std::numeric_limits<int>::max()) {
+        error = std::string(key) + " is out of range"s;
+        return false;
+    }
+    out = static_cast<int>(number);
+    return true;
+}
+
+// call_time: строка timestamptz или целое число микросекунд от эпохи.
+// Строка разбирается здесь же; без часового пояса время считается UTC
+bool ReadCallTime(const json::object& obj, int64_t& out, std::string& error) {
+    const auto* value = obj.if_contains("call_time"sv);
+    if (!value) {
+        error = "missing field call_time"s;
+        return false;
+    }
+
+    if (value->is_string()) {
+        auto parsed = domain::ParseTimestamp(value->get_string());
+        if (!parsed) {
+            error = "call_time must be a timestamp like 2024-01-31 12:00:00[+03]"s;
+            return false;
+        }
+        out = *parsed;
+        return true;
+    }
+
+    if (value->is_int64() && value->get_int64() >= 0 && value->get_int64() <= domain::MAX_TIMESTAMP_US) {
+        out = value->get_int64();
+        return true;
+    }
+
+    error = "call_time must be a timestamp string or epoch microseconds"s;
+    return false;
+}
+
+void AddCall(CdrBatch& batch, ui::detail::CallStatisticsInfo&& call, size_t index) {
+    if (auto error = CheckCall(call); !error.empty()) {
+        batch.errors.push_back({index, std::move(error)});
+        return;
+    }
+    batch.calls.push_back(std::move(call));
+    batch.indexes.push_back(index);
+}
+
+CdrBatch DecodeNdjson(std::string_view body) {
+    CdrBatch batch;
+    // Оценка числа записей по средней длине строки, чтобы не перераспределять память
+    batch.calls.reserve(body.size() / 96 + 1);
+    batch.indexes.reserve(body.size() / 96 + 1);
+
+    json::parser parser;
+
+    while (!body.empty()) {
+        size_t eol = body.find('\n');
+        std::string_view line = Trim(body.substr(0, eol));
+        body = eol == std::string_view::npos ? std::string_view{} : body.substr(eol + 1);
+
+        if (line.empty()) {
+            continue;
+        }
+        size_t index = batch.total++;
+
+        boost::system::error_code ec;
+        parser.reset();
+        parser.write(line.data(), line.size(), ec);
+        if (ec) {
+            batch.errors.push_back({index, "invalid JSON: "s + ec.message()});
+            continue;
+        }
+        json::value jv = parser.release();
+        if (!jv.is_object()) {
+            batch.errors.push_back({index, "record must be a JSON object"s});
+            continue;
+        }
+        const auto& obj = jv.get_object();
+
+        ui::detail::CallStatisticsInfo call{};
+        std::string error;
+
+        const auto* call_id = obj.if_contains("call_id"sv);
+        if (!call_id || !call_id->is_string()) {
+            batch.errors.push_back({index, "call_id must be a string"s});
+            continue;
+        }
+        call.call_id.assign(call_id->get_string());
+
+        if (!ReadInt(obj, "trunk_id"sv, call.trunk_id, error)
+            || !ReadInt(obj, "tarif_id"sv, call.tarif_id, error)
+            || !ReadInt(obj, "duration_seconds"sv, call.duration_seconds, error)
+            || !ReadCallTime(obj, call.call_time, error)) {
+            batch.errors.push_back({index, std::move(error)});
+            continue;
+        }
+
+        AddCall(batch, std::move(call), index);
+    }
+
+    return batch;
+}
+
+CdrBatch DecodeBinary(std::string_view body) {
+    if (body.size() < sizeof(BINARY_MAGIC)
+        || !std::equal(std::begin(BINARY_MAGIC), std::end(BINARY_MAGIC), body.begin())) {
+        throw std::invalid_argument("Binary CDR batch must start with \"CDR1\" header"s);
+    }
+
+    const auto* data = reinterpret_cast<const unsigned char*>(body.data());
+    size_t size = body.size();
+    size_t pos = sizeof(BINARY_MAGIC);
+
+    CdrBatch batch;
+    batch.calls.reserve(size / 40 + 1);
+    batch.indexes.reserve(size / 40 + 1);
+
+    while (pos < size) {
+        size_t index = batch.total++;
+
+        if (size - pos < sizeof(uint16_t)) {
+            throw std::invalid_argument("Truncated CDR frame #"s + std::to_string(index));
+        }
+        size_t length = boost::endian::load_little_u16(data + pos);
+        pos += sizeof(uint16_t);
+        if (size - pos < length) {
+            throw std::invalid_argument("Truncated CDR frame #"s + std::to_string(index));
+        }
+
+        const unsigned char* frame = data + pos;
+        pos += length;
+
+        if (length < BINARY_FIXED_SIZE) {
+            batch.errors.push_back({index, "frame is shorter than the fixed part"s});
+            continue;
+        }
+
+        ui::detail::CallStatisticsInfo call{};
+        call.trunk_id = boost::endian::load_little_s32(frame);
+        call.tarif_id = boost::endian::load_little_s32(frame + 4);
+        call.duration_seconds = boost::endian::load_little_s32(frame + 8);
+        int64_t call_time_us = boost::endian::load_little_s64(frame + 12);
+        size_t call_id_length = frame[20];
+
+        if (BINARY_FIXED_SIZE + call_id_length != length) {
+            batch.errors.push_back({index, "call_id length does not match frame length"s});
+            continue;
+        }
+        if (call_time_us < 0 || call_time_us > domain::MAX_TIMESTAMP_US) {
+            batch.errors.push_back({index, "call_time is out of range"s});
+            continue;
+        }
+
+        call.call_id.assign(reinterpret_cast<const char*>(frame + BINARY_FIXED_SIZE), call_id_length);
+        call.call_time = call_time_us;
+
+        AddCall(batch, std::move(call), index);
+    }
+
+    return batch;
+}
+
+} // namespace
+
+std::optional<CdrFormat> FormatFromContentType(std::string_view content_type) {
+    // Параметры вида "; charset=utf-8" не учитываем
+    content_type = Trim(content_type.substr(0, content_type.find(';')));
+
+    std::string type(content_type);
+    std::transform(type.begin(), type.end(), type.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (type == "application/x-ndjson"sv || type == "application/ndjson"sv
+        || type == "application/jsonl"sv) {
+        return CdrFormat::NDJSON;
+    }
+    if (type == "application/x-cdr-binary"sv || type == "application/octet-stream"sv) {
+        return CdrFormat::BINARY;
+    }
+    return std::nullopt;
+}
+
+CdrBatch Decode(CdrFormat format, std::string_view body) {
+    switch (format) {
+        case CdrFormat::NDJSON:
+            return DecodeNdjson(body);
+        case CdrFormat::BINARY:
+            return DecodeBinary(body);
+    }
+    throw std::invalid_argument("Unknown CDR format"s);
+}
+
+void RateCalls(const rating::Rater& rater, CdrBatch& batch) {
+    // Принятые записи сдвигаем к началу на место отбракованных
+    size_t accepted = 0;
+    for (size_t i = 0; i < batch.calls.size(); ++i) {
+        auto& call = batch.calls[i];
+
+        switch (rater.Rate(call.trunk_id, call.tarif_id, call.duration_seconds, call.cost)) {
+            case rating::RateStatus::UNKNOWN_TRUNK:
+                batch.errors.push_back({batch.indexes[i], "unknown trunk_id "s + std::to_string(call.trunk_id)});
+                continue;
+            case rating::RateStatus::UNKNOWN_TARIF:
+                batch.errors.push_back({batch.indexes[i], "unknown tarif_id "s + std::to_string(call.tarif_id)});
+                continue;
+            case rating::RateStatus::OK:
+                break;
+        }
+
+        if (accepted != i) {
+            batch.calls[accepted] = std::move(call);
+            batch.indexes[accepted] = batch.indexes[i];
+        }
+        ++accepted;
+    }
+
+    batch.calls.resize(accepted);
+    batch.indexes.resize(accepted);
+
+    std::sort(batch.errors.begin(), batch.errors.end(),
+              [](const CdrError& lhs, const CdrError& rhs) { return lhs.index < rhs.index; });
+}
+
+} // namespace ingest
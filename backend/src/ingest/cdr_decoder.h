@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../rating/rater.h"
+#include "../ui/view.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ingest {
+
+// Формат тела запроса /api/ingest/calls
+enum class CdrFormat {
+    NDJSON, // application/x-ndjson: по одному JSON-объекту на строку
+    BINARY  // application/x-cdr-binary: кадры фиксированной структуры
+};
+
+// Двоичный формат, все числа little-endian:
+//   заголовок: 4 байта "CDR1"
+//   кадр:      u16 len - длина кадра без этого поля,
+//              i32 trunk_id, i32 tarif_id, i32 duration_seconds,
+//              i64 call_time - микросекунды от эпохи (UTC),
+//              u8 n, n байт call_id
+// Кадр с неверным содержимым пропускается по длине, остальные кадры принимаются
+constexpr char BINARY_MAGIC[4] = {'C', 'D', 'R', '1'};
+
+// Определить формат по Content-Type (nullopt - формат не поддерживается)
+std::optional<CdrFormat> FormatFromContentType(std::string_view content_type);
+
+// Ошибка разбора или проверки одной записи
+struct CdrError {
+    size_t index; // номер записи во входном пакете (с нуля)
+    std::string message;
+};
+
+// Разобранный пакет записей о звонках (CDR)
+struct CdrBatch {
+    size_t total = 0;                                // записей во входном пакете
+    std::vector<ui::detail::CallStatisticsInfo> calls; // принятые записи, id = 0
+    std::vector<size_t> indexes;                     // номер каждой из calls во входном пакете
+    std::vector<CdrError> errors;                    // отбракованные записи
+};
+
+// Разобрать тело запроса. Пустые строки NDJSON записями не считаются.
+// Нарушение структуры всего пакета (нет заголовка, обрезанный кадр) - std::invalid_argument
+CdrBatch Decode(CdrFormat format, std::string_view body);
+
+// Проверить ссылки на транки и тарифы и рассчитать стоимость так же, как генератор звонков.
+// Записи с неизвестными id переносятся в errors
+void RateCalls(const rating::Rater& rater, CdrBatch& batch);
+
+} // namespace ingest
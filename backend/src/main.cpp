@@ -1,8 +1,20 @@
 #include "application.h"
+#include "app/reference_cache.h"
+#include "app/call_ingest_queue.h"
+#include "app/rerate_job.h"
+#include "app/call_store.h"
+#include "app/call_aggregates.h"
+#include "app/analytics_cache.h"
+#include "analytics/compute_pool.h"
 #include "http_server/http_server.h"
 #include "request_handler.h"
 #include "sync/thread_loader.h"
 #include "config/dynamic_config.h"
+#include "postgres/notify_listener.h"
+#include "postgres/partition_maintenance.h"
+#include "postgres/call_statistics_writer.h"
+#include "postgres/rerate_store.h"
+#include "postgres/call_aggregate_store.h"
 
 #include <boost/asio/signal_set.hpp>
 #include <filesystem>
@@ -115,6 +127,166 @@ int main(int argc, const char* argv[]) {
             std::cerr << "Server will continue without synchronization" << std::endl;
         }
 
+        std::unique_ptr<postgres::NotifyListener> notify_listener;
+        if (const char* db_url = std::getenv("DB_URL")) {
+            notify_listener = std::make_unique<postgres::NotifyListener>(db_url);
+
+            auto invalidate = [](const std::string&) {
+                app::g_reference_cache.Invalidate();
+            };
+            for (const auto* table : {"hub", "server", "nas_ip", "trunk", "pricelist", "tarif"}) {
+                notify_listener->Subscribe(postgres::ChangeChannel(table), invalidate);
+            }
+            notify_listener->OnReconnect([] {
+                app::g_reference_cache.Invalidate();
+            });
+
+            notify_listener->Start();
+            std::cout << "Reference cache invalidation via LISTEN/NOTIFY started" << std::endl;
+        }
+
+        std::unique_ptr<postgres::PartitionMaintenance> partition_maintenance;
+        if (const char* db_url = std::getenv("DB_URL")) {
+            partition_maintenance = std::make_unique<postgres::PartitionMaintenance>(db_url);
+            partition_maintenance->Start();
+            std::cout << "call_statistics partition maintenance started" << std::endl;
+        }
+
+        if (const char* db_url = std::getenv("DB_URL"); db_url && config::g_config.Get()->ingest_write_behind) {
+            auto cfg = config::g_config.Get();
+
+            auto writer = std::make_shared<postgres::CallStatisticsWriter>(
+                db_url, static_cast<size_t>(std::max(cfg->ingest_batch_size, 1)));
+
+            app::CallIngestQueue::Options options;
+            options.capacity = static_cast<size_t>(std::max(cfg->ingest_queue_capacity, 1));
+            options.max_batch = static_cast<size_t>(std::max(cfg->ingest_flush_batch_size, 1));
+            options.flush_interval = std::chrono::milliseconds(std::max(cfg->ingest_flush_interval_ms, 1));
+
+            // Журнал на диске сохраняет звонки, пока БД недоступна
+            if (!cfg->ingest_spool_path.empty()) {
+                try {
+                    std::filesystem::path spool_path(cfg->ingest_spool_path);
+                    if (spool_path.is_relative()) {
+                        spool_path = home_path / spool_path;
+                    }
+
+                    app::CallSpool::Options spool_options;
+                    spool_options.path = spool_path.string();
+                    spool_options.max_bytes = static_cast<size_t>(std::max(cfg->ingest_spool_max_mb, 1)) * 1024 * 1024;
+                    spool_options.max_age = std::chrono::hours(std::max(cfg->ingest_spool_max_age_hours, 1));
+                    spool_options.sync_writes = cfg->ingest_spool_sync;
+
+                    app::g_call_ingest_queue.SetSpool(std::make_shared<app::CallSpool>(spool_options));
+                    std::cout << "Call spool: " << spool_options.path << std::endl;
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Warning: Failed to open call spool: " << e.what() << std::endl;
+                }
+            }
+
+            app::g_call_ingest_queue.Start(
+                [writer](const std::vector<domain::CallStatistics>& calls) {
+                    auto result = writer->Write(calls);
+                    app::g_call_aggregates.Notify();
+                    return result;
+                },
+                [writer](const std::vector<domain::CallStatistics>& calls) {
+                    auto result = writer->WriteIfAbsent(calls);
+                    app::g_call_aggregates.Notify();
+                    return result;
+                },
+                options);
+
+            std::cout << "Call ingest queue started (capacity: " << options.capacity
+                      << ", durability: " << cfg->ingest_durability << ")" << std::endl;
+        }
+
+        if (const char* db_url = std::getenv("DB_URL")) {
+            auto cfg = config::g_config.Get();
+
+            app::RerateJob::Options options;
+            options.chunk_size = static_cast<size_t>(std::max(cfg->rerate_chunk_size, 1));
+            options.parallelism = static_cast<size_t>(std::max(cfg->rerate_parallelism, 1));
+            options.max_rows_per_second = static_cast<size_t>(std::max(cfg->rerate_max_rows_per_second, 0));
+
+            app::g_rerate_job.Start(
+                [url = std::string(db_url)] {
+                    return std::make_unique<postgres::RerateStoreImpl>(url);
+                },
+                [] {
+                    return api_handler::GetSharedApplication().GetUseCases().GetReferenceData();
+                },
+                options);
+            std::cout << "Call re-rating job started" << std::endl;
+        }
+
+        {
+            auto cfg = config::g_config.Get();
+
+            analytics::ComputePool::Options options;
+            options.threads = static_cast<size_t>(std::max(cfg->analytics_threads, 0));
+            options.min_rows_per_task = static_cast<size_t>(std::max(cfg->analytics_min_rows_per_task, 1));
+
+            analytics::g_compute_pool.Start(options);
+            std::cout << "Analytics compute pool started" << std::endl;
+
+            app::AnalyticsCache::Options cache_options;
+            cache_options.enabled = cfg->analytics_cache_enabled;
+            cache_options.max_bytes = static_cast<size_t>(std::max(cfg->analytics_cache_max_mb, 1)) * 1024 * 1024;
+            app::g_analytics_cache.Configure(cache_options);
+        }
+
+        if (const char* db_url = std::getenv("DB_URL"); db_url && config::g_config.Get()->call_store_enabled) {
+            auto cfg = config::g_config.Get();
+
+            app::CallStore::Options options;
+            options.retention = std::chrono::hours(std::max(cfg->call_store_retention_hours, 1));
+            options.refresh_interval = std::chrono::milliseconds(std::max(cfg->call_store_refresh_interval_ms, 100));
+            options.full_reload_interval = std::chrono::minutes(std::max(cfg->call_store_full_reload_minutes, 1));
+            options.late_commit_window = std::chrono::seconds(std::max(cfg->call_store_late_commit_seconds, 0));
+            options.chunk_rows = static_cast<size_t>(std::max(cfg->call_store_chunk_rows, 1024));
+
+            app::g_call_store.Start(
+                [](int64_t after_id, const std::vector<domain::IdRange>& missing, int64_t since,
+                   const domain::CallStatisticsVisitor& visitor) {
+                    domain::CallStatisticsFilter filter;
+                    filter.after_id = after_id;
+                    filter.missing_ids = missing;
+                    filter.time_range.from = domain::FormatTimestamp(since);
+                    api_handler::GetSharedApplication().GetUseCases().ForEachCallStatistics(filter, visitor);
+                },
+                options);
+            std::cout << "In-memory call store started (retention: " << options.retention.count()
+                      << " hours)" << std::endl;
+        }
+
+        if (const char* db_url = std::getenv("DB_URL"); db_url && config::g_config.Get()->aggregates_enabled) {
+            auto cfg = config::g_config.Get();
+
+            app::CallAggregates::Options options;
+            if (!cfg->aggregates_checkpoint_path.empty()) {
+                std::filesystem::path checkpoint_path(cfg->aggregates_checkpoint_path);
+                if (checkpoint_path.is_relative()) {
+                    checkpoint_path = home_path / checkpoint_path;
+                }
+                options.checkpoint_path = checkpoint_path.string();
+            }
+            options.refresh_interval = std::chrono::milliseconds(std::max(cfg->aggregates_refresh_interval_ms, 100));
+            options.checkpoint_interval = std::chrono::seconds(std::max(cfg->aggregates_checkpoint_interval_seconds, 1));
+            options.full_rebuild_interval = std::chrono::hours(std::max(cfg->aggregates_full_rebuild_hours, 0));
+            options.late_commit_window = std::chrono::seconds(std::max(cfg->aggregates_late_commit_seconds, 0));
+            options.leader_days = std::max(cfg->aggregates_leader_days, 0);
+            options.top_calls = static_cast<size_t>(std::max(cfg->aggregates_top_calls, 1));
+
+            app::g_call_aggregates.Start(
+                [url = std::string(db_url)] {
+                    return std::make_unique<postgres::CallAggregateStoreImpl>(url);
+                },
+                options);
+            std::cout << "Call aggregates maintenance started" << std::endl;
+        }
+
         std::cout << "Server has started..."sv << std::endl;
 
         RunWorkers(num_threads, [&ioc] {
@@ -128,6 +300,39 @@ int main(int argc, const char* argv[]) {
             std::cout << "Stopping database synchronization..." << std::endl;
             sync_loader->Stop();
         }
+
+        if (notify_listener) {
+            std::cout << "Stopping LISTEN/NOTIFY listener..." << std::endl;
+            notify_listener->Stop();
+        }
+
+        if (app::g_rerate_job.IsRunning()) {
+            std::cout << "Stopping call re-rating job..." << std::endl;
+            app::g_rerate_job.Stop();
+        }
+
+        if (app::g_call_aggregates.IsRunning()) {
+            std::cout << "Stopping call aggregates..." << std::endl;
+            app::g_call_aggregates.Stop();
+        }
+
+        if (app::g_call_store.IsRunning()) {
+            std::cout << "Stopping in-memory call store..." << std::endl;
+            app::g_call_store.Stop();
+        }
+
+        // Очередь сбрасывается в БД до остановки остальных компонентов
+        if (app::g_call_ingest_queue.IsRunning()) {
+            std::cout << "Flushing call ingest queue..." << std::endl;
+            app::g_call_ingest_queue.Stop();
+        }
+
+        if (partition_maintenance) {
+            std::cout << "Stopping partition maintenance..." << std::endl;
+            partition_maintenance->Stop();
+        }
+
+        analytics::g_compute_pool.Stop();
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,73 @@
+#include "call_aggregate_store.h"
+#include "postgres.h"
+
+#include <pqxx/pqxx>
+
+namespace postgres {
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+CallAggregateStoreImpl::CallAggregateStoreImpl(const std::string& db_url)
+    : conn_(db_url) {}
+
+int64_t CallAggregateStoreImpl::MaxId() {
+    pqxx::read_transaction tr(conn_);
+    return tr.query_value<int64_t>("SELECT COALESCE(MAX(id), 0) FROM call_statistics"_zv);
+}
+
+void CallAggregateStoreImpl::ForEachCell(int64_t max_id,
+                                         const std::function<void(const app::AggregateCell&)>& visitor) {
+    pqxx::read_transaction tr(conn_);
+
+    // Номер часа - целочисленное деление микросекунд с округлением вниз (как domain::FloorDiv)
+    std::string query = "SELECT floor("s + std::string(CALL_TIME_US) + " / 3600000000.0)::int8 AS hour, "
+                        "trunk_id, tarif_id, COUNT(*), COALESCE(SUM(duration_seconds), 0)::int8, SUM(cost) "
+                        "FROM call_statistics WHERE id <= "s + std::to_string(max_id)
+                        + " GROUP BY 1, 2, 3"s;
+
+    app::AggregateCell cell;
+    for (const auto& [hour, trunk_id, tarif_id, calls, duration, cost] :
+         tr.stream<int64_t, int, int, int64_t, int64_t, domain::Money>(query)) {
+        cell.hour = hour;
+        cell.trunk_id = trunk_id;
+        cell.tarif_id = tarif_id;
+        cell.totals = {calls, duration, cost.Micros()};
+        visitor(cell);
+    }
+}
+
+void CallAggregateStoreImpl::ForEachCall(int64_t after_id, const std::vector<domain::IdRange>& missing,
+                                         const domain::CallStatisticsVisitor& visitor) {
+    StreamCalls(WhereClause({AfterIdCondition(after_id, missing)}) + " ORDER BY id"s, visitor);
+}
+
+void CallAggregateStoreImpl::ForEachCallSince(int64_t from_time, int64_t max_id,
+                                              const domain::CallStatisticsVisitor& visitor) {
+    // Граница - начало суток UTC, целое число секунд
+    StreamCalls(" WHERE call_time >= to_timestamp("s + std::to_string(from_time / domain::MICROS_PER_SECOND)
+                + ") AND id <= "s + std::to_string(max_id), visitor);
+}
+
+void CallAggregateStoreImpl::StreamCalls(const std::string& condition, const domain::CallStatisticsVisitor& visitor) {
+    pqxx::read_transaction tr(conn_);
+
+    std::string query = "SELECT id, call_id, trunk_id, tarif_id, duration_seconds, cost, "s
+                        + std::string(CALL_TIME_US) + " FROM call_statistics"s + condition;
+
+    // call_id нужен рейтингам по суткам; строка переиспользует свой буфер
+    ui::detail::CallStatisticsInfo call_stat{};
+    for (const auto& [id, call_id, trunk_id, tarif_id, duration_seconds, cost, call_time] :
+         tr.stream<int64_t, std::string_view, int, int, int, domain::Money, int64_t>(query)) {
+        call_stat.id = id;
+        call_stat.call_id.assign(call_id);
+        call_stat.trunk_id = trunk_id;
+        call_stat.tarif_id = tarif_id;
+        call_stat.duration_seconds = duration_seconds;
+        call_stat.cost = cost;
+        call_stat.call_time = call_time;
+
+        visitor(call_stat);
+    }
+}
+
+} // namespace postgres
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../app/call_aggregates.h"
+
+#include <pqxx/connection>
+
+#include <string>
+
+namespace postgres {
+
+// Чтение call_statistics для поддерживаемых агрегатов (app::CallAggregates)
+class CallAggregateStoreImpl : public app::CallAggregateStore {
+public:
+    explicit CallAggregateStoreImpl(const std::string& db_url);
+
+    int64_t MaxId() override;
+    void ForEachCell(int64_t max_id, const std::function<void(const app::AggregateCell&)>& visitor) override;
+    void ForEachCall(int64_t after_id, const std::vector<domain::IdRange>& missing,
+                     const domain::CallStatisticsVisitor& visitor) override;
+    void ForEachCallSince(int64_t from_time, int64_t max_id, const domain::CallStatisticsVisitor& visitor) override;
+
+private:
+    // Звонки call_statistics с условием condition (" WHERE ...")
+    void StreamCalls(const std::string& condition, const domain::CallStatisticsVisitor& visitor);
+
+    pqxx::connection conn_;
+};
+
+} // namespace postgres
@@ -0,0 +1,38 @@
+#include "call_statistics_writer.h"
+#include "postgres.h"
+
+namespace postgres {
+
+CallStatisticsWriter::CallStatisticsWriter(std::string db_url, size_t batch_size)
+    : db_url_(std::move(db_url))
+    , batch_size_(batch_size) {}
+
+domain::BulkInsertResult CallStatisticsWriter::Write(const std::vector<domain::CallStatistics>& calls) {
+    return WithConnection([&](WorkerImpl& worker) {
+        return worker.AddCallStatisticsBatch(calls, batch_size_);
+    });
+}
+
+domain::BulkInsertResult CallStatisticsWriter::WriteIfAbsent(const std::vector<domain::CallStatistics>& calls) {
+    return WithConnection([&](WorkerImpl& worker) {
+        return worker.AddCallStatisticsIfAbsent(calls, batch_size_);
+    });
+}
+
+template <typename Fn>
+domain::BulkInsertResult CallStatisticsWriter::WithConnection(Fn&& fn) {
+    try {
+        if (!conn_ || !conn_->is_open()) {
+            conn_ = std::make_unique<pqxx::connection>(db_url_);
+        }
+
+        WorkerImpl worker(*conn_);
+        return fn(worker);
+    }
+    catch (const pqxx::broken_connection&) {
+        conn_.reset();
+        throw;
+    }
+}
+
+} // namespace postgres
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../domain/call_statistics.h"
+
+#include <pqxx/connection>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace postgres {
+
+// Запись пакетов call_statistics через собственное подключение,
+// которое живёт дольше одного HTTP-запроса (используется очередью записи).
+// После обрыва соединения переподключается при следующем вызове.
+class CallStatisticsWriter {
+public:
+    CallStatisticsWriter(std::string db_url, size_t batch_size);
+
+    // Бросает pqxx::broken_connection, если БД недоступна
+    domain::BulkInsertResult Write(const std::vector<domain::CallStatistics>& calls);
+    // Повторная загрузка (из журнала): уже сохранённые call_id пропускаются
+    domain::BulkInsertResult WriteIfAbsent(const std::vector<domain::CallStatistics>& calls);
+
+private:
+    std::string db_url_;
+    size_t batch_size_;
+    std::unique_ptr<pqxx::connection> conn_;
+
+    template <typename Fn>
+    domain::BulkInsertResult WithConnection(Fn&& fn);
+};
+
+} // namespace postgres
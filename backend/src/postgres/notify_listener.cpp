@@ -0,0 +1,166 @@
+#include "notify_listener.h"
+#include "../logger/logger.h"
+
+#include <pqxx/pqxx>
+
+#include <algorithm>
+
+namespace postgres {
+using namespace std::literals;
+
+namespace {
+
+constexpr auto MIN_RECONNECT_DELAY = 1s;
+constexpr auto MAX_RECONNECT_DELAY = 30s;
+
+} // namespace
+
+std::string ChangeChannel(const std::string& table) {
+    return table + "_changed"s;
+}
+
+class NotifyListener::Receiver : public pqxx::notification_receiver {
+public:
+    Receiver(pqxx::connection& conn, const std::string& channel, NotifyListener& listener)
+        : pqxx::notification_receiver(conn, channel)
+        , channel_name_(channel)
+        , listener_(listener) {}
+
+    void operator()(const std::string& payload, int /*backend_pid*/) override {
+        listener_.Dispatch(channel_name_, payload);
+    }
+
+private:
+    std::string channel_name_;
+    NotifyListener& listener_;
+};
+
+NotifyListener::NotifyListener(std::string db_url)
+    : db_url_(std::move(db_url)) {}
+
+NotifyListener::~NotifyListener() {
+    Stop();
+}
+
+void NotifyListener::Subscribe(const std::string& channel, Callback callback) {
+    std::lock_guard lock{mutex_};
+    callbacks_[channel].push_back(std::move(callback));
+}
+
+void NotifyListener::OnReconnect(ReconnectCallback callback) {
+    std::lock_guard lock{mutex_};
+    reconnect_callbacks_.push_back(std::move(callback));
+}
+
+void NotifyListener::Start() {
+    if (running_) {
+        return;
+    }
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&NotifyListener::Run, this);
+}
+
+void NotifyListener::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    stop_requested_ = true;
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    running_ = false;
+    LOG_INFO("NotifyListener stopped");
+}
+
+bool NotifyListener::IsConnected() const {
+    return connected_;
+}
+
+void NotifyListener::Run() {
+    auto delay = MIN_RECONNECT_DELAY;
+
+    while (!stop_requested_) {
+        try {
+            pqxx::connection conn(db_url_);
+
+            // Получатели должны разрушиться раньше подключения
+            std::vector<std::unique_ptr<Receiver>> receivers;
+            {
+                std::lock_guard lock{mutex_};
+                for (const auto& [channel, callbacks] : callbacks_) {
+                    receivers.push_back(std::make_unique<Receiver>(conn, channel, *this));
+                }
+            }
+
+            connected_ = true;
+            delay = MIN_RECONNECT_DELAY;
+            LOG_INFO("NotifyListener connected, listening on "
+                     + std::to_string(receivers.size()) + " channels");
+
+            NotifyReconnect();
+
+            // Ждём уведомления короткими интервалами, чтобы вовремя заметить Stop()
+            while (!stop_requested_) {
+                conn.await_notification(1, 0);
+            }
+        }
+        catch (const pqxx::broken_connection& e) {
+            LOG_WARNING("NotifyListener lost connection: " + std::string(e.what()));
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("NotifyListener error: " + std::string(e.what()));
+        }
+
+        connected_ = false;
+
+        if (!stop_requested_) {
+            WaitBeforeReconnect(delay);
+            delay = std::min(delay * 2, MAX_RECONNECT_DELAY);
+        }
+    }
+}
+
+void NotifyListener::Dispatch(const std::string& channel, const std::string& payload) {
+    std::vector<Callback> callbacks;
+    {
+        std::lock_guard lock{mutex_};
+        auto it = callbacks_.find(channel);
+        if (it == callbacks_.end()) {
+            return;
+        }
+        callbacks = it->second;
+    }
+
+    for (const auto& callback : callbacks) {
+        try {
+            callback(payload);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("NotifyListener callback for " + channel + " failed: " + std::string(e.what()));
+        }
+    }
+}
+
+void NotifyListener::NotifyReconnect() {
+    std::vector<ReconnectCallback> callbacks;
+    {
+        std::lock_guard lock{mutex_};
+        callbacks = reconnect_callbacks_;
+    }
+
+    for (const auto& callback : callbacks) {
+        callback();
+    }
+}
+
+void NotifyListener::WaitBeforeReconnect(std::chrono::seconds delay) {
+    for (auto waited = 0s; waited < delay && !stop_requested_; waited += 1s) {
+        std::this_thread::sleep_for(1s);
+    }
+}
+
+} // namespace postgres
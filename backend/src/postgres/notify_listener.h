@@ -0,0 +1,67 @@
+#pragma once
+
+#include <pqxx/connection>
+#include <pqxx/notification>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace postgres {
+
+// Канал уведомлений об изменении таблицы (см. migrations/001_reference_change_notify.sql)
+std::string ChangeChannel(const std::string& table);
+
+// Выделенное подключение, которое слушает LISTEN/NOTIFY и раздаёт
+// уведомления зарегистрированным обработчикам (например, кэшам).
+// При обрыве соединения переподключается и заново подписывается на каналы.
+class NotifyListener {
+public:
+    using Callback = std::function<void(const std::string& payload)>;
+    using ReconnectCallback = std::function<void()>;
+
+    explicit NotifyListener(std::string db_url);
+    ~NotifyListener();
+
+    NotifyListener(const NotifyListener&) = delete;
+    NotifyListener& operator=(const NotifyListener&) = delete;
+
+    // Подписка на канал. Новые каналы начинают слушаться после (пере)подключения
+    void Subscribe(const std::string& channel, Callback callback);
+
+    // Вызывается после каждого подключения: уведомления, пришедшие
+    // во время обрыва, потеряны, поэтому кэши нужно сбросить целиком
+    void OnReconnect(ReconnectCallback callback);
+
+    void Start();
+    void Stop();
+
+    bool IsConnected() const;
+
+private:
+    class Receiver;
+
+    void Run();
+    void Dispatch(const std::string& channel, const std::string& payload);
+    void NotifyReconnect();
+    void WaitBeforeReconnect(std::chrono::seconds delay);
+
+    std::string db_url_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::vector<Callback>> callbacks_;
+    std::vector<ReconnectCallback> reconnect_callbacks_;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> connected_{false};
+};
+
+} // namespace postgres
@@ -0,0 +1,121 @@
+#include "partition_maintenance.h"
+#include "../config/dynamic_config.h"
+#include "../app/analytics_cache.h"
+#include "../app/call_aggregates.h"
+#include "../logger/logger.h"
+
+#include <pqxx/pqxx>
+
+#include <algorithm>
+
+namespace postgres {
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+PartitionMaintenance::PartitionMaintenance(std::string db_url)
+    : db_url_(std::move(db_url)) {}
+
+PartitionMaintenance::~PartitionMaintenance() {
+    Stop();
+}
+
+void PartitionMaintenance::Start() {
+    if (running_) {
+        return;
+    }
+
+    stop_requested_ = false;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&PartitionMaintenance::Run, this);
+}
+
+void PartitionMaintenance::Stop() {
+    if (!running_) {
+        return;
+    }
+
+    stop_requested_ = true;
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+
+    running_ = false;
+    LOG_INFO("PartitionMaintenance stopped");
+}
+
+int PartitionMaintenance::RunOnce() {
+    auto cfg = config::g_config.Get();
+
+    pqxx::connection conn(db_url_);
+    pqxx::work txn(conn);
+
+    txn.exec_params("SELECT ensure_call_statistics_partitions($1)", cfg->partitions_ahead);
+
+    int removed = 0;
+    if (cfg->retention_months > 0) {
+        auto result = txn.exec_params("SELECT drop_call_statistics_partitions($1, $2)",
+                                      cfg->retention_months, cfg->archive_partitions);
+        for (const auto& row : result) {
+            LOG_INFO((cfg->archive_partitions ? "Archived partition: "s : "Dropped partition: "s)
+                     + row[0].as<std::string>());
+        }
+        removed = static_cast<int>(result.size());
+    }
+
+    txn.commit();
+    return removed;
+}
+
+int64_t PartitionMaintenance::CompactTotals() {
+    pqxx::connection conn(db_url_);
+    pqxx::work txn(conn);
+
+    if (!txn.query_value<bool>("SELECT to_regclass('call_statistics_totals_delta') IS NOT NULL"_zv)) {
+        return 0;
+    }
+
+    auto compacted = txn.query_value<int64_t>("SELECT compact_call_statistics_totals()"_zv);
+    txn.commit();
+    return compacted;
+}
+
+void PartitionMaintenance::Run() {
+    auto next_maintenance = std::chrono::steady_clock::now();
+
+    while (!stop_requested_) {
+        if (std::chrono::steady_clock::now() >= next_maintenance) {
+            try {
+                // Удалённые секции были учтены в поддерживаемых агрегатах
+                if (RunOnce() > 0) {
+                    app::g_call_aggregates.Invalidate();
+                    app::g_analytics_cache.Invalidate();
+                }
+            }
+            catch (const std::exception& e) {
+                LOG_ERROR("PartitionMaintenance error: " + std::string(e.what()));
+            }
+
+            auto interval = config::g_config.Get()->partition_maintenance_interval_seconds;
+            next_maintenance = std::chrono::steady_clock::now() + std::chrono::seconds(std::max(interval, 60));
+        }
+
+        try {
+            CompactTotals();
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Call totals compaction error: " + std::string(e.what()));
+        }
+
+        // Изменения итогов копятся между проходами, поэтому сворачиваем их чаще обслуживания секций
+        auto compact_interval = config::g_config.Get()->totals_compact_seconds;
+        WaitFor(std::chrono::seconds(std::max(compact_interval, 1)));
+    }
+}
+
+void PartitionMaintenance::WaitFor(std::chrono::seconds delay) {
+    for (auto waited = 0s; waited < delay && !stop_requested_; waited += 1s) {
+        std::this_thread::sleep_for(1s);
+    }
+}
+
+} // namespace postgres
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace postgres {
+
+// Фоновое обслуживание помесячных секций call_statistics
+// (см. migrations/002_call_statistics_partitioning.sql):
+// заранее создаёт секции будущих месяцев и удаляет либо архивирует
+// секции старше срока хранения. Чаще сворачивает строки изменений итогов
+// (migrations/006_call_statistics_totals_deltas.sql) в помесячные итоги.
+// Параметры берутся из config::g_config на каждом проходе, поэтому меняются
+// без перезапуска.
+class PartitionMaintenance {
+public:
+    explicit PartitionMaintenance(std::string db_url);
+    ~PartitionMaintenance();
+
+    PartitionMaintenance(const PartitionMaintenance&) = delete;
+    PartitionMaintenance& operator=(const PartitionMaintenance&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Один проход обслуживания, возвращает количество удалённых/архивированных секций
+    int RunOnce();
+    // Свернуть изменения итогов, возвращает количество свёрнутых строк (0 без миграции 006)
+    int64_t CompactTotals();
+
+private:
+    void Run();
+    void WaitFor(std::chrono::seconds delay);
+
+    std::string db_url_;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_requested_{false};
+};
+
+} // namespace postgres
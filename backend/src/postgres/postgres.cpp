@@ -4,6 +4,7 @@
 #include <pqxx/zview.hxx>
 #include <pqxx/pqxx>
 
+#include <algorithm>
 #include <stdexcept>
 
 #include <iostream>
@@ -12,6 +13,40 @@ namespace postgres {
 using namespace std::literals;
 using pqxx::operator"" _zv;
 
+// Условия на call_time подставляются литералами, а не параметрами: так
+// планировщик отсекает секции call_statistics ещё при построении плана.
+// Границы приходят с явным смещением (см. ApiHandler::GetTimeRangeParams),
+// поэтому не зависят от часового пояса сессии
+std::vector<std::string> TimeRangeConditions(const pqxx::transaction_base& tr, const domain::TimeRange& range) {
+    std::vector<std::string> conditions;
+    if (range.from) {
+        conditions.push_back("call_time >= "s + tr.quote(*range.from) + "::timestamptz"s);
+    }
+    if (range.to) {
+        conditions.push_back("call_time < "s + tr.quote(*range.to) + "::timestamptz"s);
+    }
+    return conditions;
+}
+
+std::string AfterIdCondition(int64_t after_id, const std::vector<domain::IdRange>& missing) {
+    std::string condition = "id > "s + std::to_string(after_id);
+    if (missing.empty()) {
+        return condition;
+    }
+    for (const auto& range : missing) {
+        condition += " OR id BETWEEN "s + std::to_string(range.from) + " AND "s + std::to_string(range.to);
+    }
+    return "("s + condition + ")"s;
+}
+
+std::string WhereClause(const std::vector<std::string>& conditions) {
+    std::string result;
+    for (size_t i = 0; i < conditions.size(); ++i) {
+        result += (i == 0 ? " WHERE "s : " AND "s) + conditions[i];
+    }
+    return result;
+}
+
 std::vector<ui::detail::HubInfo> HubRepositoryImpl::Get() const {
     auto conn = pool_.GetConnection();
     pqxx::read_transaction tr(*conn);
@@ -72,7 +107,7 @@ std::vector<ui::detail::TrunkInfo> TrunkRepositoryImpl::Get() const {
 
     std::string query = "SELECT * FROM trunk ORDER BY id;"s;
 
-    auto resp = tr.query<int, int, std::string, int, double>(query);
+    auto resp = tr.query<int, int, std::string, int, domain::Money>(query);
 
     std::vector<ui::detail::TrunkInfo> result;
 
@@ -90,7 +125,7 @@ std::vector<ui::detail::PricelistInfo> PricelistRepositoryImpl::Get() const {
 
     std::string query = "SELECT * FROM pricelist ORDER BY id;"s;
 
-    auto resp = tr.query<int, std::string, std::string, double, bool>(query);
+    auto resp = tr.query<int, std::string, std::string, domain::Money, bool>(query);
 
     std::vector<ui::detail::PricelistInfo> result;
 
@@ -124,9 +159,10 @@ std::vector<ui::detail::CallStatisticsInfo> CallStatisticsRepositoryImpl::Get()
     auto conn = pool_.GetConnection();
     pqxx::read_transaction tr(*conn);
 
-    std::string query = "SELECT * FROM call_statistics ORDER BY id;"s;
+    std::string query = "SELECT id, call_id, trunk_id, tarif_id, duration_seconds, cost, "s
+                        + std::string(CALL_TIME_US) + " FROM call_statistics ORDER BY id;"s;
 
-    auto resp = tr.query<int64_t, std::string, int, int, int, double, std::string>(query);
+    auto resp = tr.query<int64_t, std::string, int, int, int, domain::Money, int64_t>(query);
 
     std::vector<ui::detail::CallStatisticsInfo> result;
 
@@ -138,19 +174,309 @@ std::vector<ui::detail::CallStatisticsInfo> CallStatisticsRepositoryImpl::Get()
     return result;
 }
 
+void CallStatisticsRepositoryImpl::ForEach(const domain::CallStatisticsFilter& filter,
+                                           const domain::CallStatisticsVisitor& visitor) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    // COPY не поддерживает параметры запроса, поэтому условия подставляются
+    // в текст запроса: числа как есть, время - через quote()
+    auto conditions = TimeRangeConditions(tr, filter.time_range);
+    if (filter.after_id) {
+        conditions.push_back(AfterIdCondition(*filter.after_id, filter.missing_ids));
+    }
+    if (filter.trunk_id) {
+        conditions.push_back("trunk_id = "s + std::to_string(*filter.trunk_id));
+    }
+    if (filter.tarif_id) {
+        conditions.push_back("tarif_id = "s + std::to_string(*filter.tarif_id));
+    }
+
+    std::string query = "SELECT id, call_id, trunk_id, tarif_id, duration_seconds, cost, "s
+                        + std::string(CALL_TIME_US) + " FROM call_statistics"s + WhereClause(conditions);
+    if (filter.after_id) {
+        query += " ORDER BY id"s;
+    }
+
+    // Одна запись на весь обход: строка call_id переиспользует свой буфер
+    ui::detail::CallStatisticsInfo call_stat{};
+
+    for (const auto& [id, call_id, trunk_id, tarif_id, duration_seconds, cost, call_time] :
+         tr.stream<int64_t, std::string_view, int, int, int, domain::Money, int64_t>(query)) {
+        call_stat.id = id;
+        call_stat.call_id.assign(call_id);
+        call_stat.trunk_id = trunk_id;
+        call_stat.tarif_id = tarif_id;
+        call_stat.duration_seconds = duration_seconds;
+        call_stat.cost = cost;
+        call_stat.call_time = call_time;
+
+        visitor(call_stat);
+    }
+}
+
+domain::CallTotals CallStatisticsRepositoryImpl::GetTotals() const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    // Помесячные итоги поддерживаются триггерами: строк столько, сколько месяцев хранится,
+    // плюс ещё не свёрнутые строки изменений (миграция 006).
+    // Без миграции 004 считаем в БД, не передавая звонки по сети
+    bool has_totals = tr.query_value<bool>("SELECT to_regclass('call_statistics_totals') IS NOT NULL"_zv);
+    bool has_deltas = tr.query_value<bool>("SELECT to_regclass('call_statistics_totals_delta') IS NOT NULL"_zv);
+    std::string query;
+    if (has_totals && has_deltas) {
+        query = "SELECT COALESCE(SUM(calls), 0)::int8, COALESCE(SUM(duration_seconds), 0)::int8, "
+                "COALESCE(SUM(revenue), 0) FROM ("
+                "SELECT calls, duration_seconds, revenue FROM call_statistics_totals "
+                "UNION ALL SELECT calls, duration_seconds, revenue FROM call_statistics_totals_delta) t;"s;
+    }
+    else if (has_totals) {
+        query = "SELECT COALESCE(SUM(calls), 0)::int8, COALESCE(SUM(duration_seconds), 0)::int8, "
+                "COALESCE(SUM(revenue), 0) FROM call_statistics_totals;"s;
+    }
+    else {
+        query = "SELECT COUNT(*), COALESCE(SUM(duration_seconds), 0)::int8, COALESCE(SUM(cost), 0) "
+                "FROM call_statistics;"s;
+    }
+
+    domain::CallTotals result;
+    for (const auto& [calls, duration_seconds, revenue] : tr.query<int64_t, int64_t, domain::Money>(query)) {
+        result = {calls, duration_seconds, revenue};
+    }
+    return result;
+}
+
+std::vector<analytics::TrunkAnalytics> CallAnalyticsRepositoryImpl::GetByTrunk(const domain::TimeRange& range) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    std::string query = R"(
+    SELECT t.id, t.name, COALESCE(cs.total_calls, 0), COALESCE(cs.total_revenue, 0),
+           COALESCE(cs.total_duration, 0)
+    FROM trunk t
+    LEFT JOIN (SELECT trunk_id, COUNT(*) AS total_calls, SUM(cost) AS total_revenue,
+                      SUM(duration_seconds) AS total_duration
+               FROM call_statistics)"s + WhereClause(TimeRangeConditions(tr, range)) + R"(
+               GROUP BY trunk_id) cs ON cs.trunk_id = t.id
+    ORDER BY 4 DESC;
+    )"s;
+
+    auto resp = tr.query<int, std::string, int64_t, domain::Money, int64_t>(query);
+
+    std::vector<analytics::TrunkAnalytics> result;
+
+    for (const auto& [id, name, total_calls, total_revenue, total_duration] : resp) {
+        analytics::TrunkAnalytics trunk{id, name, total_calls, total_revenue, total_duration, 0.0, {}};
+        if (total_calls > 0) {
+            trunk.avg_duration_seconds = static_cast<double>(total_duration) / total_calls;
+            trunk.avg_cost = total_revenue.MulDiv(1, total_calls);
+        }
+        result.push_back(trunk);
+    }
+
+    return result;
+}
+
+std::vector<analytics::TarifAnalytics> CallAnalyticsRepositoryImpl::GetByTarif(const domain::TimeRange& range) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    std::string query = R"(
+    SELECT tf.id, tf.name, COALESCE(cs.total_calls, 0), COALESCE(cs.total_revenue, 0),
+           COALESCE(cs.total_duration, 0)
+    FROM tarif tf
+    LEFT JOIN (SELECT tarif_id, COUNT(*) AS total_calls, SUM(cost) AS total_revenue,
+                      SUM(duration_seconds) AS total_duration
+               FROM call_statistics)"s + WhereClause(TimeRangeConditions(tr, range)) + R"(
+               GROUP BY tarif_id) cs ON cs.tarif_id = tf.id
+    ORDER BY 4 DESC;
+    )"s;
+
+    auto resp = tr.query<int, std::string, int64_t, domain::Money, int64_t>(query);
+
+    std::vector<analytics::TarifAnalytics> result;
+
+    for (const auto& [id, name, total_calls, total_revenue, total_duration] : resp) {
+        analytics::TarifAnalytics tarif{id, name, total_calls, total_revenue, total_duration, {}};
+        if (total_calls > 0) {
+            tarif.avg_cost = total_revenue.MulDiv(1, total_calls);
+        }
+        result.push_back(tarif);
+    }
+
+    return result;
+}
+
+std::vector<analytics::HubAnalytics> CallAnalyticsRepositoryImpl::GetByHub(const domain::TimeRange& range) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    // Звонки сначала сворачиваются по транкам, затем по цепочке trunk -> server -> hub
+    std::string query = R"(
+    SELECT h.id, h.name, COALESCE(calls.total_calls, 0), COALESCE(calls.total_revenue, 0),
+           (SELECT COUNT(*) FROM server s WHERE s.hub_id = h.id),
+           (SELECT COUNT(*) FROM trunk t JOIN server s ON s.id = t.server_id WHERE s.hub_id = h.id)
+    FROM hub h
+    LEFT JOIN (SELECT s.hub_id, SUM(cs.total_calls) AS total_calls, SUM(cs.total_revenue) AS total_revenue
+               FROM (SELECT trunk_id, COUNT(*) AS total_calls, SUM(cost) AS total_revenue
+                     FROM call_statistics)"s + WhereClause(TimeRangeConditions(tr, range)) + R"(
+                     GROUP BY trunk_id) cs
+               JOIN trunk t ON t.id = cs.trunk_id
+               JOIN server s ON s.id = t.server_id
+               GROUP BY s.hub_id) calls ON calls.hub_id = h.id
+    ORDER BY 4 DESC;
+    )"s;
+
+    auto resp = tr.query<int, std::string, int64_t, domain::Money, int64_t, int64_t>(query);
+
+    std::vector<analytics::HubAnalytics> result;
+
+    for (const auto& [id, name, total_calls, total_revenue, server_count, trunk_count] : resp) {
+        analytics::HubAnalytics hub{id, name, total_calls, total_revenue,
+                                    static_cast<int>(server_count), static_cast<int>(trunk_count)};
+        result.push_back(hub);
+    }
+
+    return result;
+}
+
+std::vector<analytics::RevenueAnalytics> CallAnalyticsRepositoryImpl::GetRevenue(analytics::RevenuePeriod period,
+                                                                                 const domain::TimeRange& range) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    std::string period_expr = period == analytics::RevenuePeriod::DAY
+                              ? "to_char(call_time AT TIME ZONE 'UTC', 'YYYY-MM-DD')"s
+                              : "to_char(call_time AT TIME ZONE 'UTC', 'HH24') || ':00'"s;
+
+    std::string query = "SELECT "s + period_expr + " AS period, SUM(cost), COUNT(*) FROM call_statistics"s
+                        + WhereClause(TimeRangeConditions(tr, range)) + " GROUP BY 1 ORDER BY 1;"s;
+
+    auto resp = tr.query<std::string, domain::Money, int64_t>(query);
+
+    std::vector<analytics::RevenueAnalytics> result;
+
+    for (const auto& [period_name, revenue, call_count] : resp) {
+        result.push_back({period_name, revenue, call_count});
+    }
+
+    return result;
+}
+
+std::vector<analytics::TimeSeriesPoint> CallAnalyticsRepositoryImpl::GetTimeSeries(
+    const analytics::TimeBuckets& buckets) const {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    // БД группирует по началу интервала (UTC, микросекунды), раскладка по точкам - TimeSeriesAggregator.
+    // Месяцы - date_trunc по местному времени фиксированного смещения
+    std::string bucket_expr;
+    if (int64_t step = buckets.FixedStep(); step != 0) {
+        std::string from = std::to_string(buckets.From());
+        bucket_expr = from + " + floor(("s + std::string(CALL_TIME_US) + " - "s + from + ") / "s
+                      + std::to_string(step) + ".0)::int8 * "s + std::to_string(step);
+    } else {
+        std::string offset_seconds = std::to_string(buckets.TzOffset() / domain::MICROS_PER_SECOND);
+        bucket_expr = "(EXTRACT(EPOCH FROM date_trunc('month', (call_time AT TIME ZONE 'UTC') + make_interval(secs => "s
+                      + offset_seconds + "))) * 1000000)::int8 - "s + std::to_string(buckets.TzOffset());
+    }
+
+    domain::TimeRange range{domain::FormatTimestamp(buckets.From()), domain::FormatTimestamp(buckets.To())};
+    std::string query = "SELECT "s + bucket_expr + ", COUNT(*), COALESCE(SUM(duration_seconds), 0)::int8, SUM(cost) "
+                        "FROM call_statistics"s + WhereClause(TimeRangeConditions(tr, range)) + " GROUP BY 1;"s;
+
+    analytics::TimeSeriesAggregator aggregator(buckets);
+    for (const auto& [start, calls, duration, cost] : tr.stream<int64_t, int64_t, int64_t, domain::Money>(query)) {
+        aggregator.Add(start, analytics::GroupTotals{calls, duration, cost.Micros()});
+    }
+
+    return aggregator.Finish();
+}
+
+namespace {
+
+// ARRAY[...] границ гистограммы для width_bucket: номер интервала совпадает с DashboardAggregator
+template <size_t N, typename Format>
+std::string BoundsArray(const std::array<int64_t, N>& bounds, Format format) {
+    std::string result = "ARRAY["s;
+    for (size_t i = 0; i < N; ++i) {
+        result += (i == 0 ? ""s : ", "s) + format(bounds[i]);
+    }
+    return result + "]"s;
+}
+
+} // namespace
+
+analytics::DashboardSummary CallAnalyticsRepositoryImpl::GetDashboardDetails(const domain::TimeRange& range,
+                                                                           size_t recent_calls) const {
+    using analytics::DashboardAggregator;
+
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+
+    analytics::DashboardSummary result;
+    result.duration_histogram.resize(DashboardAggregator::DURATION_BOUNDS.size() + 1);
+    result.cost_histogram.resize(DashboardAggregator::COST_BOUNDS.size() + 1);
+
+    // Обе гистограммы за один проход: GROUPING(d) = 1 у строк интервалов стоимости
+    std::string where = WhereClause(TimeRangeConditions(tr, range));
+    std::string duration_bounds = BoundsArray(DashboardAggregator::DURATION_BOUNDS, [](int64_t bound) {
+        return std::to_string(bound);
+    });
+    std::string cost_bounds = BoundsArray(DashboardAggregator::COST_BOUNDS, [](int64_t bound) {
+        return domain::Money::FromMicros(bound).ToString();
+    }) + "::numeric[]"s;
+    std::string query = "SELECT GROUPING(d), COALESCE(d, c), COUNT(*), COALESCE(SUM(duration_seconds), 0)::int8, "
+                        "COALESCE(SUM(cost), 0) FROM (SELECT width_bucket(duration_seconds, "s + duration_bounds
+                        + ") AS d, width_bucket(cost, "s + cost_bounds + ") AS c, duration_seconds, cost "
+                        "FROM call_statistics"s + where + ") t GROUP BY GROUPING SETS ((d), (c));"s;
+
+    for (const auto& [by_cost, bin, calls, duration, cost] : tr.query<int, int, int64_t, int64_t, domain::Money>(query)) {
+        auto& histogram = by_cost ? result.cost_histogram : result.duration_histogram;
+        if (bin >= 0 && static_cast<size_t>(bin) < histogram.size()) {
+            histogram[bin] = analytics::GroupTotals{calls, duration, cost.Micros()};
+        }
+    }
+
+    // Последние звонки - обратный проход по первичному ключу секций, без чтения остальных строк
+    if (recent_calls > 0) {
+        query = "SELECT id, call_id, "s + std::string(CALL_TIME_US) + ", trunk_id, tarif_id, duration_seconds, cost "
+                "FROM call_statistics"s + where + " ORDER BY id DESC LIMIT "s + std::to_string(recent_calls) + ";"s;
+        for (const auto& [id, call_id, call_time, trunk_id, tarif_id, duration, cost] :
+             tr.query<int64_t, std::string, int64_t, int, int, int, domain::Money>(query)) {
+            result.recent_calls.push_back({id, call_id, call_time, trunk_id, tarif_id, duration, cost});
+        }
+    }
+
+    return result;
+}
+
 DataBase::DataBase(const std::string& db_url)
     : pool_{std::thread::hardware_concurrency(),
-  [&db_url](){ return std::make_shared<pqxx::connection>(db_url); } }
+  [db_url](){ return std::make_shared<pqxx::connection>(db_url); } }
     , hubs_{pool_}
     , servers_{pool_}
     , nas_ips_{pool_}
     , trunks_{pool_}
     , pricelists_{pool_}
     , tarifs_{pool_}
-    , call_statistics_{pool_} {}
+    , call_statistics_{pool_}
+    , call_analytics_{pool_} {}
+
+void DataBase::Ping() {
+    auto conn = pool_.GetConnection();
+    pqxx::read_transaction tr(*conn);
+    tr.query_value<int>("SELECT 1;"_zv);
+}
 
 WorkerImpl::WorkerImpl(pqxx::connection& conn) : conn_(conn), nontr_(conn) {}
 
+WorkerImpl::WorkerImpl(connection_pool::ConnectionPool::ConnectionWrapper&& conn)
+    : pooled_conn_(std::move(conn))
+    , conn_(**pooled_conn_)
+    , nontr_(conn_) {}
+
 void WorkerImpl::AddPricelist(const domain::Pricelist& pricelist) {
     nontr_.exec_params(
         R"(
@@ -215,7 +541,139 @@ void WorkerImpl::AddCallStatistics(const domain::CallStatistics& call_stat) {
     VALUES ($1, $2, $3, $4, $5, $6);
     )"_zv,
         call_stat.GetCallId(), call_stat.GetTrunkId(), call_stat.GetTarifId(),
-        call_stat.GetDurationSeconds(), call_stat.GetCost(), call_stat.GetCallTime());
+        call_stat.GetDurationSeconds(), call_stat.GetCost(), CallTimeText(call_stat.GetCallTime()).View());
+}
+
+domain::BulkInsertResult WorkerImpl::AddCallStatisticsBatch(const std::vector<domain::CallStatistics>& calls,
+                                                            size_t batch_size) {
+    domain::BulkInsertResult result;
+    batch_size = std::max<size_t>(batch_size, 1);
+
+    for (size_t begin = 0; begin < calls.size(); begin += batch_size) {
+        CopyCallStatistics(calls, begin, std::min(begin + batch_size, calls.size()), result);
+    }
+
+    return result;
+}
+
+void WorkerImpl::CopyCallStatistics(const std::vector<domain::CallStatistics>& calls,
+                                    size_t begin, size_t end, domain::BulkInsertResult& result) {
+    try {
+        auto stream = pqxx::stream_to::table(nontr_, {"call_statistics"},
+                                             {"call_id", "trunk_id", "tarif_id", "duration_seconds", "cost", "call_time"});
+        for (size_t i = begin; i < end; ++i) {
+            const auto& call_stat = calls[i];
+            stream.write_values(call_stat.GetCallId(), call_stat.GetTrunkId(), call_stat.GetTarifId(),
+                                call_stat.GetDurationSeconds(), call_stat.GetCost(), CallTimeText(call_stat.GetCallTime()).View());
+        }
+        stream.complete();
+        result.inserted += end - begin;
+        return;
+    }
+    catch (const pqxx::broken_connection&) {
+        // Недоступность БД - не ошибка строк, решение о повторе принимает вызывающий
+        throw;
+    }
+    catch (const std::exception&) {
+        // COPY атомарен: одна плохая строка отменяет всю часть.
+        // Повторяем её построчно, чтобы сохранить корректные строки и найти ошибочные
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+        try {
+            AddCallStatistics(calls[i]);
+            ++result.inserted;
+        }
+        catch (const pqxx::broken_connection&) {
+            throw;
+        }
+        catch (const std::exception& e) {
+            result.errors.push_back({i, e.what()});
+        }
+    }
+}
+
+domain::BulkInsertResult WorkerImpl::AddCallStatisticsIfAbsent(const std::vector<domain::CallStatistics>& calls,
+                                                               size_t batch_size) {
+    domain::BulkInsertResult result;
+    batch_size = std::max<size_t>(batch_size, 1);
+
+    nontr_.exec(R"(
+    CREATE TEMP TABLE IF NOT EXISTS call_statistics_incoming (
+        call_id VARCHAR(100),
+        trunk_id INT,
+        tarif_id INT,
+        duration_seconds INT,
+        cost DECIMAL(10, 6),
+        call_time TIMESTAMP WITH TIME ZONE
+    );
+    )"_zv);
+
+    for (size_t begin = 0; begin < calls.size(); begin += batch_size) {
+        CopyCallStatisticsIfAbsent(calls, begin, std::min(begin + batch_size, calls.size()), result);
+    }
+
+    return result;
+}
+
+void WorkerImpl::CopyCallStatisticsIfAbsent(const std::vector<domain::CallStatistics>& calls,
+                                            size_t begin, size_t end, domain::BulkInsertResult& result) {
+    try {
+        nontr_.exec("TRUNCATE call_statistics_incoming;"_zv);
+
+        auto stream = pqxx::stream_to::table(nontr_, {"call_statistics_incoming"},
+                                             {"call_id", "trunk_id", "tarif_id", "duration_seconds", "cost", "call_time"});
+        for (size_t i = begin; i < end; ++i) {
+            const auto& call_stat = calls[i];
+            stream.write_values(call_stat.GetCallId(), call_stat.GetTrunkId(), call_stat.GetTarifId(),
+                                call_stat.GetDurationSeconds(), call_stat.GetCost(), CallTimeText(call_stat.GetCallTime()).View());
+        }
+        stream.complete();
+
+        // Поиск по call_id использует индекс из migrations/003_call_statistics_call_id_index.sql
+        auto inserted = nontr_.exec(R"(
+        INSERT INTO call_statistics (call_id, trunk_id, tarif_id, duration_seconds, cost, call_time)
+        SELECT DISTINCT ON (i.call_id) i.call_id, i.trunk_id, i.tarif_id, i.duration_seconds, i.cost, i.call_time
+        FROM call_statistics_incoming i
+        WHERE NOT EXISTS (SELECT 1 FROM call_statistics c WHERE c.call_id = i.call_id);
+        )"_zv).affected_rows();
+
+        result.inserted += inserted;
+        result.duplicates += (end - begin) - inserted;
+        return;
+    }
+    catch (const pqxx::broken_connection&) {
+        throw;
+    }
+    catch (const std::exception&) {
+        // Построчный повтор, как и в CopyCallStatistics
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+        const auto& call_stat = calls[i];
+        try {
+            auto inserted = nontr_.exec_params(
+                R"(
+            INSERT INTO call_statistics (call_id, trunk_id, tarif_id, duration_seconds, cost, call_time)
+            SELECT $1, $2, $3, $4, $5, $6
+            WHERE NOT EXISTS (SELECT 1 FROM call_statistics WHERE call_id = $1);
+            )"_zv,
+                call_stat.GetCallId(), call_stat.GetTrunkId(), call_stat.GetTarifId(),
+                call_stat.GetDurationSeconds(), call_stat.GetCost(), CallTimeText(call_stat.GetCallTime()).View()).affected_rows();
+            if (inserted > 0) {
+                ++result.inserted;
+            }
+            else {
+                ++result.duplicates;
+            }
+        }
+        catch (const pqxx::broken_connection&) {
+            throw;
+        }
+        catch (const std::exception& e) {
+            result.errors.push_back({i, e.what()});
+        }
+    }
 }
 
 WorkerImpl::~WorkerImpl() = default;
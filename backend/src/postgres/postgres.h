@@ -9,19 +9,91 @@
 #include "../domain/pricelist.h"
 #include "../domain/tarif.h"
 #include "../domain/call_statistics.h"
+#include "../domain/call_analytics.h"
+#include "../domain/timestamp.h"
 #include "../ui/view.h"
 
 #include <pqxx/connection>
 #include <pqxx/transaction>
 
+#include <cstring>
 #include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
+namespace pqxx {
+
+// Денежные суммы передаются в БД и читаются из неё десятичным текстом,
+// поэтому DECIMAL/NUMERIC и domain::Money преобразуются без потери точности
+template <>
+struct nullness<domain::Money> : no_null<domain::Money> {};
+
+template <>
+struct string_traits<domain::Money> {
+    static constexpr bool converts_to_string{true};
+    static constexpr bool converts_from_string{true};
+
+    static domain::Money from_string(std::string_view text) {
+        return domain::Money::Parse(text);
+    }
+
+    static char* into_buf(char* begin, char* end, const domain::Money& value) {
+        std::string text = value.ToString();
+        if (static_cast<size_t>(end - begin) < text.size() + 1) {
+            throw conversion_overrun{"Not enough buffer space for a money value"};
+        }
+        std::memcpy(begin, text.data(), text.size());
+        begin[text.size()] = '\0';
+        return begin + text.size() + 1;
+    }
+
+    static zview to_buf(char* begin, char* end, const domain::Money& value) {
+        char* next = into_buf(begin, end, value);
+        return zview{begin, static_cast<size_t>(next - begin - 1)};
+    }
+
+    // Знак, 19 цифр, точка и завершающий ноль
+    static size_t size_buffer(const domain::Money&) noexcept {
+        return 24;
+    }
+};
+
+} // namespace pqxx
+
 namespace postgres {
 
+// Условия на call_time для WHERE (литералами, чтобы работало отсечение секций)
+std::vector<std::string> TimeRangeConditions(const pqxx::transaction_base& tr, const domain::TimeRange& range);
+// id > after_id или id из диапазонов missing (каждый диапазон - проход по первичному ключу)
+std::string AfterIdCondition(int64_t after_id, const std::vector<domain::IdRange>& missing);
+// " WHERE c1 AND c2 ..." или пустая строка
+std::string WhereClause(const std::vector<std::string>& conditions);
+
+// call_time целым числом микросекунд от эпохи: из БД приходит int8, а не текст timestamptz
+constexpr std::string_view CALL_TIME_US = "(EXTRACT(EPOCH FROM call_time) * 1000000)::int8";
+
+// Текст timestamptz для записи call_time в БД без выделения памяти на строку
+class CallTimeText {
+public:
+    explicit CallTimeText(int64_t epoch_us) noexcept
+        : end_(domain::FormatTimestamp(epoch_us, buffer_)) {}
+
+    std::string_view View() const noexcept {
+        return {buffer_, static_cast<size_t>(end_ - buffer_)};
+    }
+
+private:
+    char buffer_[domain::TIMESTAMP_TEXT_SIZE];
+    char* end_;
+};
+
 class WorkerImpl : public domain::Worker {
   public:
     explicit WorkerImpl(pqxx::connection& conn);
+    // Соединение из пула: удерживается, пока жив WorkerImpl
+    explicit WorkerImpl(connection_pool::ConnectionPool::ConnectionWrapper&& conn);
 
     void AddPricelist(const domain::Pricelist& pricelist) override;
     void UpdatePricelist(const domain::Pricelist& pricelist, int id) override;
@@ -33,10 +105,22 @@ class WorkerImpl : public domain::Worker {
     void UpdateTrunk(const domain::Trunk& trunk, int id) override;
 
     void AddCallStatistics(const domain::CallStatistics& call_stat) override;
+    domain::BulkInsertResult AddCallStatisticsBatch(const std::vector<domain::CallStatistics>& calls,
+                                                    size_t batch_size) override;
+    domain::BulkInsertResult AddCallStatisticsIfAbsent(const std::vector<domain::CallStatistics>& calls,
+                                                       size_t batch_size) override;
 
     ~WorkerImpl() override;
 
   private:
+    // COPY части пакета [begin, end), при ошибке - построчная вставка этой части
+    void CopyCallStatistics(const std::vector<domain::CallStatistics>& calls,
+                            size_t begin, size_t end, domain::BulkInsertResult& result);
+    // То же для идемпотентной вставки: COPY во временную таблицу и INSERT ... WHERE NOT EXISTS
+    void CopyCallStatisticsIfAbsent(const std::vector<domain::CallStatistics>& calls,
+                                    size_t begin, size_t end, domain::BulkInsertResult& result);
+
+    std::optional<connection_pool::ConnectionPool::ConnectionWrapper> pooled_conn_;
     pqxx::connection& conn_;
     pqxx::nontransaction nontr_;
 };
@@ -48,8 +132,7 @@ class HubRepositoryImpl : public domain::HubRepository {
     std::vector<ui::detail::HubInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -63,8 +146,7 @@ class ServerRepositoryImpl : public domain::ServerRepository {
     std::vector<ui::detail::ServerInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -78,8 +160,7 @@ class NasIpRepositoryImpl : public domain::NasIpRepository {
     std::vector<ui::detail::NasIpInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -93,8 +174,7 @@ class TrunkRepositoryImpl : public domain::TrunkRepository {
     std::vector<ui::detail::TrunkInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -108,8 +188,7 @@ class PricelistRepositoryImpl : public domain::PricelistRepository {
     std::vector<ui::detail::PricelistInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -123,8 +202,7 @@ class TarifRepositoryImpl : public domain::TarifRepository {
     std::vector<ui::detail::TarifInfo> Get() const override;
 
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
@@ -137,19 +215,42 @@ class CallStatisticsRepositoryImpl : public domain::CallStatisticsRepository {
 
     std::vector<ui::detail::CallStatisticsInfo> Get() const override;
 
+    void ForEach(const domain::CallStatisticsFilter& filter,
+                 const domain::CallStatisticsVisitor& visitor) const override;
+
+    domain::CallTotals GetTotals() const override;
+
     std::shared_ptr<domain::Worker> GetWorker() const override {
-        auto conn = pool_.GetConnection();
-        return std::make_shared<WorkerImpl>(*conn);
+        return std::make_shared<WorkerImpl>(pool_.GetConnection());
     }
 
   private:
     connection_pool::ConnectionPool& pool_;
 };
 
+class CallAnalyticsRepositoryImpl : public domain::CallAnalyticsRepository {
+  public:
+    explicit CallAnalyticsRepositoryImpl(connection_pool::ConnectionPool& pool) : pool_{pool} {}
+
+    std::vector<analytics::TrunkAnalytics> GetByTrunk(const domain::TimeRange& range) const override;
+    std::vector<analytics::TarifAnalytics> GetByTarif(const domain::TimeRange& range) const override;
+    std::vector<analytics::HubAnalytics> GetByHub(const domain::TimeRange& range) const override;
+    std::vector<analytics::RevenueAnalytics> GetRevenue(analytics::RevenuePeriod period,
+                                                       const domain::TimeRange& range) const override;
+    std::vector<analytics::TimeSeriesPoint> GetTimeSeries(const analytics::TimeBuckets& buckets) const override;
+    analytics::DashboardSummary GetDashboardDetails(const domain::TimeRange& range, size_t recent_calls) const override;
+
+  private:
+    connection_pool::ConnectionPool& pool_;
+};
+
 class DataBase {
   public:
     explicit DataBase(const std::string& db_url);
 
+    // Проверка доступности БД запросом через пул соединений, минуя кэши
+    void Ping();
+
     HubRepositoryImpl& GetHubs() & {
         return hubs_;
     }
@@ -178,6 +279,10 @@ class DataBase {
         return call_statistics_;
     }
 
+    CallAnalyticsRepositoryImpl& GetCallAnalytics() & {
+        return call_analytics_;
+    }
+
   private:
     connection_pool::ConnectionPool pool_;
 
@@ -188,6 +293,7 @@ class DataBase {
     PricelistRepositoryImpl pricelists_;
     TarifRepositoryImpl tarifs_;
     CallStatisticsRepositoryImpl call_statistics_;
+    CallAnalyticsRepositoryImpl call_analytics_;
 };
 
 }  // namespace postgres
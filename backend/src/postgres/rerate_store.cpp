@@ -0,0 +1,105 @@
+#include "rerate_store.h"
+#include "postgres.h"
+
+#include <pqxx/pqxx>
+
+namespace postgres {
+using namespace std::literals;
+using pqxx::operator"" _zv;
+
+namespace {
+
+std::string IdList(const std::vector<int>& ids) {
+    std::string result;
+    for (int id : ids) {
+        if (!result.empty()) {
+            result += ',';
+        }
+        result += std::to_string(id);
+    }
+    return result;
+}
+
+std::vector<std::string> ScopeConditions(const pqxx::transaction_base& tr, const app::RerateScope& scope) {
+    auto conditions = TimeRangeConditions(tr, scope.time_range);
+
+    std::vector<std::string> references;
+    if (!scope.tarif_ids.empty()) {
+        references.push_back("tarif_id IN ("s + IdList(scope.tarif_ids) + ")"s);
+    }
+    if (!scope.trunk_ids.empty()) {
+        references.push_back("trunk_id IN ("s + IdList(scope.trunk_ids) + ")"s);
+    }
+    if (references.size() == 1) {
+        conditions.push_back(references.front());
+    }
+    else if (references.size() == 2) {
+        conditions.push_back("("s + references[0] + " OR "s + references[1] + ")"s);
+    }
+
+    return conditions;
+}
+
+} // namespace
+
+RerateStoreImpl::RerateStoreImpl(const std::string& db_url)
+    : conn_(db_url) {
+    pqxx::nontransaction tr(conn_);
+    // ON COMMIT DELETE ROWS: каждая часть пишется в своей транзакции и не видит предыдущих
+    tr.exec(R"(
+    CREATE TEMP TABLE IF NOT EXISTS call_statistics_rerate (
+        id BIGINT NOT NULL,
+        call_time TIMESTAMP WITH TIME ZONE NOT NULL,
+        cost DECIMAL(10, 6) NOT NULL
+    ) ON COMMIT DELETE ROWS;
+    )"_zv);
+}
+
+uint64_t RerateStoreImpl::Count(const app::RerateScope& scope) {
+    pqxx::read_transaction tr(conn_);
+    std::string query = "SELECT count(*) FROM call_statistics"s + WhereClause(ScopeConditions(tr, scope));
+    return tr.query_value<int64_t>(query);
+}
+
+std::vector<ui::detail::CallStatisticsInfo> RerateStoreImpl::Fetch(const app::RerateScope& scope,
+                                                                   int64_t after_id, size_t limit) {
+    pqxx::read_transaction tr(conn_);
+
+    auto conditions = ScopeConditions(tr, scope);
+    conditions.push_back("id > "s + std::to_string(after_id));
+
+    std::string query = "SELECT id, trunk_id, tarif_id, duration_seconds, cost, "s + std::string(CALL_TIME_US)
+                        + " FROM call_statistics"s + WhereClause(conditions)
+                        + " ORDER BY id LIMIT "s + std::to_string(limit);
+
+    std::vector<ui::detail::CallStatisticsInfo> result;
+    result.reserve(limit);
+    for (auto [id, trunk_id, tarif_id, duration_seconds, cost, call_time] :
+         tr.query<int64_t, int, int, int, domain::Money, int64_t>(query)) {
+        result.push_back({id, {}, trunk_id, tarif_id, duration_seconds, cost, call_time});
+    }
+    return result;
+}
+
+size_t RerateStoreImpl::UpdateCosts(const std::vector<ui::detail::CallStatisticsInfo>& calls) {
+    pqxx::work tr(conn_);
+
+    auto stream = pqxx::stream_to::table(tr, {"call_statistics_rerate"}, {"id", "call_time", "cost"});
+    for (const auto& call : calls) {
+        stream.write_values(call.id, CallTimeText(call.call_time).View(), call.cost);
+    }
+    stream.complete();
+
+    // call_time в условии позволяет искать строку только в её месячной секции
+    auto updated = tr.exec(R"(
+    UPDATE call_statistics c
+    SET cost = r.cost
+    FROM call_statistics_rerate r
+    WHERE c.id = r.id AND c.call_time = r.call_time AND c.cost IS DISTINCT FROM r.cost;
+    )"_zv).affected_rows();
+
+    tr.commit();
+    return updated;
+}
+
+} // namespace postgres
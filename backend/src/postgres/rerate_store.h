@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../app/rerate_job.h"
+
+#include <pqxx/connection>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace postgres {
+
+// Чтение и обновление call_statistics для фонового пересчёта стоимости.
+// Владеет собственным подключением: задание пересчёта живёт дольше HTTP-запроса
+class RerateStoreImpl : public app::RerateStore {
+public:
+    explicit RerateStoreImpl(const std::string& db_url);
+
+    uint64_t Count(const app::RerateScope& scope) override;
+    std::vector<ui::detail::CallStatisticsInfo> Fetch(const app::RerateScope& scope,
+                                                      int64_t after_id, size_t limit) override;
+    // COPY во временную таблицу и один UPDATE ... FROM на часть
+    size_t UpdateCosts(const std::vector<ui::detail::CallStatisticsInfo>& calls) override;
+
+private:
+    pqxx::connection conn_;
+};
+
+} // namespace postgres
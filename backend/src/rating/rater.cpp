@@ -0,0 +1,146 @@
+#include "rater.h"
+#include "../call_simulator/call_generator.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace rating {
+
+namespace {
+
+// Массив по индексу используем, пока он не слишком разрежен
+constexpr size_t DENSE_SLACK = 1024;
+constexpr size_t DENSE_FACTOR = 4;
+
+struct CachedRater {
+    std::shared_ptr<const app::ReferenceData> reference;
+    std::shared_ptr<const Rater> rater;
+};
+
+std::atomic<std::shared_ptr<const CachedRater>> g_cached_rater;
+
+} // namespace
+
+template <typename T>
+void IdTable<T>::Build(const std::vector<std::pair<int, T>>& entries) {
+    dense_.clear();
+    present_.clear();
+    sparse_.clear();
+
+    int max_id = -1;
+    bool has_negative = false;
+    for (const auto& [id, value] : entries) {
+        max_id = std::max(max_id, id);
+        has_negative = has_negative || id < 0;
+    }
+
+    // Размер массива в int64_t: max_id + 1 в int переполняется при id = INT_MAX
+    int64_t dense_size = static_cast<int64_t>(max_id) + 1;
+    if (!has_negative && static_cast<uint64_t>(dense_size) <= entries.size() * DENSE_FACTOR + DENSE_SLACK) {
+        dense_.resize(static_cast<size_t>(dense_size));
+        present_.resize(static_cast<size_t>(dense_size), false);
+        for (const auto& [id, value] : entries) {
+            dense_[id] = value;
+            present_[id] = true;
+        }
+        return;
+    }
+
+    sparse_.reserve(entries.size());
+    for (const auto& [id, value] : entries) {
+        sparse_.insert_or_assign(id, value);
+    }
+}
+
+template class IdTable<domain::Money>;
+template class IdTable<TarifRate>;
+
+Rater::Rater(const app::ReferenceData& reference)
+    : Rater(reference.trunks, reference.tarifs, reference.pricelists) {
+    version_ = reference.version;
+}
+
+Rater::Rater(const std::vector<ui::detail::TrunkInfo>& trunks,
+             const std::vector<ui::detail::TarifInfo>& tarifs,
+             const std::vector<ui::detail::PricelistInfo>& pricelists) {
+    std::vector<std::pair<int, domain::Money>> trunk_entries;
+    trunk_entries.reserve(trunks.size());
+    for (const auto& trunk : trunks) {
+        trunk_entries.emplace_back(trunk.id, trunk.cost_per_channel);
+    }
+    trunks_.Build(trunk_entries);
+
+    std::vector<std::pair<int, const ui::detail::PricelistInfo*>> pricelist_entries;
+    pricelist_entries.reserve(pricelists.size());
+    for (const auto& pricelist : pricelists) {
+        pricelist_entries.emplace_back(pricelist.id, &pricelist);
+    }
+    IdTable<const ui::detail::PricelistInfo*> pricelists_by_id;
+    pricelists_by_id.Build(pricelist_entries);
+
+    // Прайс-лист разворачиваем в тариф, чтобы расчёт обходился одним поиском
+    std::vector<std::pair<int, TarifRate>> tarif_entries;
+    tarif_entries.reserve(tarifs.size());
+    for (const auto& tarif : tarifs) {
+        TarifRate rate;
+        rate.markup_percent = tarif.markup_percent;
+        rate.free_minutes = tarif.free_minutes;
+
+        const auto* pricelist = pricelists_by_id.Find(tarif.pricelist_id);
+        if (pricelist && (*pricelist)->is_active) {
+            rate.rate_per_minute = (*pricelist)->rate_per_minute;
+            rate.billable = true;
+        }
+        tarif_entries.emplace_back(tarif.id, rate);
+    }
+    tarifs_.Build(tarif_entries);
+}
+
+RateStatus Rater::Rate(int trunk_id, int tarif_id, int duration_seconds, domain::Money& cost) const {
+    const auto* tarif = tarifs_.Find(tarif_id);
+    if (!tarif) {
+        cost = {};
+        return RateStatus::UNKNOWN_TARIF;
+    }
+
+    const auto* cost_per_channel = trunks_.Find(trunk_id);
+    if (!tarif->billable) {
+        cost = {};
+    }
+    else {
+        cost = call_simulator::CallCostCalculator::CalculateCostWithFreeMinutes(
+            duration_seconds,
+            tarif->rate_per_minute,
+            tarif->markup_percent,
+            cost_per_channel ? *cost_per_channel : domain::Money{},
+            tarif->free_minutes
+        );
+    }
+
+    return cost_per_channel ? RateStatus::OK : RateStatus::UNKNOWN_TRUNK;
+}
+
+size_t Rater::RateBatch(std::vector<ui::detail::CallStatisticsInfo>& calls) const {
+    size_t unknown = 0;
+    for (auto& call : calls) {
+        if (Rate(call.trunk_id, call.tarif_id, call.duration_seconds, call.cost) != RateStatus::OK) {
+            ++unknown;
+        }
+    }
+    return unknown;
+}
+
+std::shared_ptr<const Rater> GetRater(const std::shared_ptr<const app::ReferenceData>& reference) {
+    auto cached = g_cached_rater.load();
+    if (cached && cached->reference == reference) {
+        return cached->rater;
+    }
+
+    // Построение дешевле обращения к БД, поэтому гонку двух потоков не предотвращаем:
+    // в худшем случае таблицы одной версии будут построены дважды
+    auto fresh = std::make_shared<const CachedRater>(CachedRater{reference, std::make_shared<const Rater>(*reference)});
+    g_cached_rater.store(fresh);
+    return fresh->rater;
+}
+
+} // namespace rating
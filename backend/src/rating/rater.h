@@ -0,0 +1,92 @@
+#pragma once
+
+#include "../app/reference_cache.h"
+#include "../ui/view.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rating {
+
+// Параметры тарифа, нужные для расчёта стоимости звонка
+struct TarifRate {
+    domain::Money rate_per_minute;
+    int markup_percent = 0;
+    int free_minutes = 0;
+    bool billable = false; // прайс-лист тарифа существует и активен
+};
+
+enum class RateStatus {
+    OK,
+    UNKNOWN_TRUNK, // стоимость посчитана без cost_per_channel
+    UNKNOWN_TARIF  // стоимость 0
+};
+
+// Таблица "id -> значение" с поиском за O(1).
+// Компактные id (обычный случай для SERIAL) хранятся в массиве по индексу,
+// разреженные - в хеш-таблице
+template <typename T>
+class IdTable {
+public:
+    void Build(const std::vector<std::pair<int, T>>& entries);
+
+    const T* Find(int id) const {
+        if (id >= 0 && static_cast<size_t>(id) < dense_.size()) {
+            return present_[id] ? &dense_[id] : nullptr;
+        }
+        if (sparse_.empty()) {
+            return nullptr;
+        }
+        auto it = sparse_.find(id);
+        return it != sparse_.end() ? &it->second : nullptr;
+    }
+
+private:
+    std::vector<T> dense_;
+    std::vector<bool> present_;
+    std::unordered_map<int, T> sparse_;
+};
+
+// Тарификатор: таблицы поиска строятся один раз по снимку справочников,
+// после чего расчёт стоимости звонка не требует обхода pricelist/trunk.
+// Неизменяем после построения, поэтому безопасен для использования из нескольких потоков
+class Rater {
+public:
+    explicit Rater(const app::ReferenceData& reference);
+    Rater(const std::vector<ui::detail::TrunkInfo>& trunks,
+          const std::vector<ui::detail::TarifInfo>& tarifs,
+          const std::vector<ui::detail::PricelistInfo>& pricelists);
+
+    // Версия снимка справочников, по которому построены таблицы
+    uint64_t GetVersion() const noexcept {
+        return version_;
+    }
+
+    const TarifRate* FindTarif(int tarif_id) const {
+        return tarifs_.Find(tarif_id);
+    }
+
+    bool HasTrunk(int trunk_id) const {
+        return trunks_.Find(trunk_id) != nullptr;
+    }
+
+    // Стоимость одного звонка по CallCostCalculator::CalculateCostWithFreeMinutes.
+    // Тариф без активного прайс-листа не тарифицируется (стоимость 0), как в CallGenerator
+    RateStatus Rate(int trunk_id, int tarif_id, int duration_seconds, domain::Money& cost) const;
+
+    // Пересчитать cost для всего пакета. Возвращает число звонков с неизвестным транком или тарифом
+    size_t RateBatch(std::vector<ui::detail::CallStatisticsInfo>& calls) const;
+
+private:
+    uint64_t version_ = 0;
+    IdTable<domain::Money> trunks_; // trunk_id -> cost_per_channel
+    IdTable<TarifRate> tarifs_;
+};
+
+// Тарификатор для снимка справочников. Строится один раз на версию снимка
+// и переиспользуется всеми запросами, пока справочники не изменятся
+std::shared_ptr<const Rater> GetRater(const std::shared_ptr<const app::ReferenceData>& reference);
+
+} // namespace rating
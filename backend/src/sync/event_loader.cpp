@@ -1,4 +1,6 @@
 #include "event_loader.h"
+#include "../app/reference_cache.h"
+#include "../app/call_aggregates.h"
 #include "../logger/logger.h"
 
 #include <stdexcept>
@@ -197,6 +199,15 @@ void EventLoader::HandleEvent(const std::string& event_name, long long version,
         // Выполняем синхронизацию
         handler_it->second(target_conn, source_conn_str);
         
+        // Справочные таблицы изменились - сбрасываем кэш,
+        // новые звонки - догружаем в поддерживаемые агрегаты
+        if (event_name != "call_statistics") {
+            app::g_reference_cache.Invalidate();
+        }
+        else {
+            app::g_call_aggregates.Notify();
+        }
+        
         // Удаляем обработанное событие
         pqxx::work txn(is_central_to_regional ? *central_conn_ : *regional_conn_);
         std::string delete_query;
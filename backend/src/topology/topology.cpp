@@ -0,0 +1,127 @@
+#include "topology.h"
+
+#include <atomic>
+
+namespace topology {
+
+namespace {
+
+struct CachedTopology {
+    std::shared_ptr<const app::ReferenceData> reference;
+    std::shared_ptr<const NetworkTopology> topology;
+};
+
+std::atomic<std::shared_ptr<const CachedTopology>> g_cached_topology;
+
+const NetworkTopology::ServerList EMPTY_SERVERS;
+const NetworkTopology::TrunkList EMPTY_TRUNKS;
+
+template <typename Info>
+const Info* FindIn(const std::unordered_map<int, const Info*>& index, int id) {
+    auto it = index.find(id);
+    return it != index.end() ? it->second : nullptr;
+}
+
+} // namespace
+
+NetworkTopology::NetworkTopology(const app::ReferenceData& reference)
+    : NetworkTopology(reference.hubs, reference.servers, reference.trunks) {
+    version_ = reference.version;
+}
+
+NetworkTopology::NetworkTopology(std::vector<ui::detail::HubInfo> hubs,
+                                 std::vector<ui::detail::ServerInfo> servers,
+                                 std::vector<ui::detail::TrunkInfo> trunks)
+    : hubs_(std::move(hubs))
+    , servers_(std::move(servers))
+    , trunks_(std::move(trunks)) {
+    Build();
+}
+
+void NetworkTopology::Build() {
+    hub_by_id_.reserve(hubs_.size());
+    for (const auto& hub : hubs_) {
+        hub_by_id_.try_emplace(hub.id, &hub);
+    }
+
+    server_by_id_.reserve(servers_.size());
+    for (const auto& server : servers_) {
+        server_by_id_.try_emplace(server.id, &server);
+    }
+
+    trunk_by_id_.reserve(trunks_.size());
+    server_trunks_.reserve(servers_.size());
+    for (const auto& trunk : trunks_) {
+        trunk_by_id_.try_emplace(trunk.id, &trunk);
+        server_trunks_[trunk.server_id].push_back(&trunk);
+    }
+
+    // Серверы без хаба в справочнике тоже попадают в списки: маршрут строится по hub_id сервера
+    for (const auto& server : servers_) {
+        auto& node = hub_nodes_[server.hub_id];
+        node.servers.push_back(&server);
+        node.trunk_count += static_cast<int>(TrunksOfServer(server.id).size());
+        if (server.is_active) {
+            node.active_servers.push_back(&server);
+            active_servers_.push_back(&server);
+        }
+    }
+}
+
+const ui::detail::HubInfo* NetworkTopology::FindHub(int hub_id) const {
+    return FindIn(hub_by_id_, hub_id);
+}
+
+const ui::detail::ServerInfo* NetworkTopology::FindServer(int server_id) const {
+    return FindIn(server_by_id_, server_id);
+}
+
+const ui::detail::TrunkInfo* NetworkTopology::FindTrunk(int trunk_id) const {
+    return FindIn(trunk_by_id_, trunk_id);
+}
+
+const NetworkTopology::ServerList& NetworkTopology::ServersOfHub(int hub_id) const {
+    auto it = hub_nodes_.find(hub_id);
+    return it != hub_nodes_.end() ? it->second.servers : EMPTY_SERVERS;
+}
+
+const NetworkTopology::ServerList& NetworkTopology::ActiveServersOfHub(int hub_id) const {
+    auto it = hub_nodes_.find(hub_id);
+    return it != hub_nodes_.end() ? it->second.active_servers : EMPTY_SERVERS;
+}
+
+const NetworkTopology::TrunkList& NetworkTopology::TrunksOfServer(int server_id) const {
+    auto it = server_trunks_.find(server_id);
+    return it != server_trunks_.end() ? it->second : EMPTY_TRUNKS;
+}
+
+int NetworkTopology::TrunkCountOfHub(int hub_id) const {
+    auto it = hub_nodes_.find(hub_id);
+    return it != hub_nodes_.end() ? it->second.trunk_count : 0;
+}
+
+const ui::detail::ServerInfo* NetworkTopology::ServerOfTrunk(int trunk_id) const {
+    const auto* trunk = FindTrunk(trunk_id);
+    return trunk ? FindServer(trunk->server_id) : nullptr;
+}
+
+const ui::detail::HubInfo* NetworkTopology::HubOfTrunk(int trunk_id) const {
+    const auto* server = ServerOfTrunk(trunk_id);
+    return server ? FindHub(server->hub_id) : nullptr;
+}
+
+std::shared_ptr<const NetworkTopology> GetTopology(const std::shared_ptr<const app::ReferenceData>& reference) {
+    auto cached = g_cached_topology.load();
+    if (cached && cached->reference == reference) {
+        return cached->topology;
+    }
+
+    // Как и для тарификатора, гонку двух потоков не предотвращаем:
+    // в худшем случае топология одной версии будет построена дважды
+    auto fresh = std::make_shared<const CachedTopology>(
+        CachedTopology{reference, std::make_shared<const NetworkTopology>(*reference)});
+    g_cached_topology.store(fresh);
+    return fresh->topology;
+}
+
+} // namespace topology
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../app/reference_cache.h"
+#include "../ui/view.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace topology {
+
+// Сетевая топология снимка справочников: hub -> servers -> trunks и обратно
+// trunk -> server -> hub. Строится за O(хабов + серверов + транков), после чего
+// все обходы идут по готовым спискам без вложенных циклов по справочникам.
+// Неизменяема после построения, поэтому безопасна для использования из нескольких потоков.
+// Указатели, которые возвращают методы, живут столько же, сколько сама топология
+class NetworkTopology {
+public:
+    using ServerList = std::vector<const ui::detail::ServerInfo*>;
+    using TrunkList = std::vector<const ui::detail::TrunkInfo*>;
+
+    explicit NetworkTopology(const app::ReferenceData& reference);
+    NetworkTopology(std::vector<ui::detail::HubInfo> hubs,
+                    std::vector<ui::detail::ServerInfo> servers,
+                    std::vector<ui::detail::TrunkInfo> trunks);
+
+    NetworkTopology(const NetworkTopology&) = delete;
+    NetworkTopology& operator=(const NetworkTopology&) = delete;
+
+    // Версия снимка справочников, по которому построена топология
+    uint64_t GetVersion() const noexcept {
+        return version_;
+    }
+
+    const std::vector<ui::detail::HubInfo>& Hubs() const noexcept {
+        return hubs_;
+    }
+
+    const std::vector<ui::detail::ServerInfo>& Servers() const noexcept {
+        return servers_;
+    }
+
+    const std::vector<ui::detail::TrunkInfo>& Trunks() const noexcept {
+        return trunks_;
+    }
+
+    // Поиск по id (при повторяющихся id - первая запись); nullptr - не найден
+    const ui::detail::HubInfo* FindHub(int hub_id) const;
+    const ui::detail::ServerInfo* FindServer(int server_id) const;
+    const ui::detail::TrunkInfo* FindTrunk(int trunk_id) const;
+
+    // Серверы хаба: все и только активные
+    const ServerList& ServersOfHub(int hub_id) const;
+    const ServerList& ActiveServersOfHub(int hub_id) const;
+    // Активные серверы всех хабов
+    const ServerList& ActiveServers() const noexcept {
+        return active_servers_;
+    }
+
+    // Транки сервера
+    const TrunkList& TrunksOfServer(int server_id) const;
+    // Число транков на серверах хаба
+    int TrunkCountOfHub(int hub_id) const;
+
+    // Сервер и хаб транка; nullptr - сервер транка или его хаб не найден
+    const ui::detail::ServerInfo* ServerOfTrunk(int trunk_id) const;
+    const ui::detail::HubInfo* HubOfTrunk(int trunk_id) const;
+
+private:
+    struct HubNode {
+        ServerList servers;
+        ServerList active_servers;
+        int trunk_count = 0;
+    };
+
+    void Build();
+
+    uint64_t version_ = 0;
+
+    std::vector<ui::detail::HubInfo> hubs_;
+    std::vector<ui::detail::ServerInfo> servers_;
+    std::vector<ui::detail::TrunkInfo> trunks_;
+
+    std::unordered_map<int, const ui::detail::HubInfo*> hub_by_id_;
+    std::unordered_map<int, const ui::detail::ServerInfo*> server_by_id_;
+    std::unordered_map<int, const ui::detail::TrunkInfo*> trunk_by_id_;
+
+    std::unordered_map<int, HubNode> hub_nodes_;      // hub_id -> серверы хаба
+    std::unordered_map<int, TrunkList> server_trunks_; // server_id -> транки сервера
+    ServerList active_servers_;
+};
+
+// Топология снимка справочников. Строится один раз на версию снимка
+// и переиспользуется всеми запросами, пока справочники не изменятся
+std::shared_ptr<const NetworkTopology> GetTopology(const std::shared_ptr<const app::ReferenceData>& reference);
+
+} // namespace topology
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "../domain/money.h"
+#include "../domain/timestamp.h"
+
 #include <boost/json.hpp>
 #include <chrono>
 #include <iosfwd>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <variant>
 #include <vector>
@@ -113,7 +117,7 @@ struct TrunkInfo {
     int server_id;
     std::string name;
     int capacity;
-    double cost_per_channel;
+    domain::Money cost_per_channel;
 
     friend void tag_invoke(json::value_from_tag, json::value& jv,
                            const ui::detail::TrunkInfo& trunk) {
@@ -122,7 +126,7 @@ struct TrunkInfo {
             {"server_id"s, trunk.server_id},
             {"name"s, trunk.name},
             {"capacity"s, trunk.capacity},
-            {"cost_per_channel"s, trunk.cost_per_channel}
+            {"cost_per_channel"s, trunk.cost_per_channel.ToDouble()}
         };
     }
 
@@ -134,7 +138,7 @@ struct TrunkInfo {
         trunk_info.server_id = trunk.at("server_id").as_int64();
         trunk_info.name = trunk.at("name").as_string();
         trunk_info.capacity = trunk.at("capacity").as_int64();
-        trunk_info.cost_per_channel = trunk.at("cost_per_channel").as_double();
+        trunk_info.cost_per_channel = json::value_to<domain::Money>(trunk.at("cost_per_channel"));
 
         return trunk_info;
     }
@@ -144,7 +148,7 @@ struct PricelistInfo {
     int id;
     std::string name;
     std::string currency;
-    double rate_per_minute;
+    domain::Money rate_per_minute;
     bool is_active;
 
     friend void tag_invoke(json::value_from_tag, json::value& jv,
@@ -153,7 +157,7 @@ struct PricelistInfo {
             {"id"s, pricelist.id},
             {"name"s, pricelist.name},
             {"currency"s, pricelist.currency},
-            {"rate_per_minute"s, pricelist.rate_per_minute},
+            {"rate_per_minute"s, pricelist.rate_per_minute.ToDouble()},
             {"is_active"s, pricelist.is_active}
         };
     }
@@ -165,7 +169,7 @@ struct PricelistInfo {
         pricelist_info.id = pricelist.at("id").as_int64();
         pricelist_info.name = pricelist.at("name").as_string();
         pricelist_info.currency = pricelist.at("currency").as_string();
-        pricelist_info.rate_per_minute = pricelist.at("rate_per_minute").as_double();
+        pricelist_info.rate_per_minute = json::value_to<domain::Money>(pricelist.at("rate_per_minute"));
         pricelist_info.is_active = pricelist.at("is_active").as_bool();
 
         return pricelist_info;
@@ -210,8 +214,8 @@ struct CallStatisticsInfo {
     int trunk_id;
     int tarif_id;
     int duration_seconds;
-    double cost;
-    std::string call_time;
+    domain::Money cost;
+    int64_t call_time; // микросекунды от эпохи (UTC)
 
     friend void tag_invoke(json::value_from_tag, json::value& jv,
                            const ui::detail::CallStatisticsInfo& call_stat) {
@@ -221,8 +225,8 @@ struct CallStatisticsInfo {
             {"trunk_id"s, call_stat.trunk_id},
             {"tarif_id"s, call_stat.tarif_id},
             {"duration_seconds"s, call_stat.duration_seconds},
-            {"cost"s, call_stat.cost},
-            {"call_time"s, call_stat.call_time}
+            {"cost"s, call_stat.cost.ToDouble()},
+            {"call_time"s, domain::FormatTimestamp(call_stat.call_time)}
         };
     }
 
@@ -235,8 +239,19 @@ struct CallStatisticsInfo {
         call_statistics_info.trunk_id = call_stat.at("trunk_id").as_int64();
         call_statistics_info.tarif_id = call_stat.at("tarif_id").as_int64();
         call_statistics_info.duration_seconds = call_stat.at("duration_seconds").as_int64();
-        call_statistics_info.cost = call_stat.at("cost").as_double();
-        call_statistics_info.call_time = call_stat.at("call_time").as_string();
+        call_statistics_info.cost = json::value_to<domain::Money>(call_stat.at("cost"));
+        // Строка timestamptz или целое число микросекунд от эпохи
+        const auto& call_time = call_stat.at("call_time");
+        if (call_time.is_string()) {
+            auto parsed = domain::ParseTimestamp(call_time.get_string());
+            if (!parsed) {
+                throw std::invalid_argument("Invalid call_time: "s + std::string(call_time.get_string()));
+            }
+            call_statistics_info.call_time = *parsed;
+        }
+        else {
+            call_statistics_info.call_time = call_time.as_int64();
+        }
 
         return call_statistics_info;
     }
@@ -1,5 +1,5 @@
 import axios from 'axios';
-import type { PricelistInfo, TarifInfo, TrunkInfo, LoginResponse, SystemStats } from '../types';
+import type { PricelistInfo, TarifInfo, TrunkInfo, LoginResponse, SystemStats, DashboardSnapshot } from '../types';
 
 const api = axios.create({
   baseURL: '/api',
@@ -17,6 +17,14 @@ api.interceptors.request.use((config) => {
   return config;
 });
 
+// Смещение часового пояса браузера вида +03:00
+export function localUtcOffset(): string {
+  const minutes = -new Date().getTimezoneOffset();
+  const abs = Math.abs(minutes);
+  const sign = minutes < 0 ? '-' : '+';
+  return `${sign}${String(Math.floor(abs / 60)).padStart(2, '0')}:${String(abs % 60).padStart(2, '0')}`;
+}
+
 export const apiClient = {
   // Аутентификация
   login: (email: string, password: string) =>
@@ -69,6 +77,11 @@ export const apiClient = {
   systemHealth: () => api.get('/system/health'),
   systemStats: () => api.get<SystemStats>('/system/stats'),
 
+  // Панели мониторинга: справочники и суммы звонков одним запросом.
+  // Неизменившийся ответ сервер возвращает как 304, браузер берёт его из своего кэша
+  dashboardSnapshot: (tz: string = localUtcOffset()) =>
+    api.get<DashboardSnapshot>('/dashboard/snapshot', { params: { tz } }),
+
   // Логи
   getLogs: (lines: number = 100) => api.get(`/logs`),
 };
@@ -1,6 +1,5 @@
 import { useQuery } from '@tanstack/react-query';
 import { apiClient } from '../api/client';
-import type { CallStatisticsInfo, TarifInfo, TrunkInfo } from '../types';
 import {
   LineChart, Line, BarChart, Bar, PieChart, Pie, Cell,
   XAxis, YAxis, CartesianGrid, Tooltip, Legend, ResponsiveContainer
@@ -14,27 +13,18 @@ interface CallStatsAggregated {
 }
 
 export function CallStatsDashboard() {
-  const { data: callsResponse, isLoading } = useQuery({
-    queryKey: ['callStatistics'],
-    queryFn: apiClient.getCallStatistics,
+  // Суммы считает сервер за один проход по звонкам; неизменившийся снимок приходит как 304
+  const { data: snapshotResponse, isLoading } = useQuery({
+    queryKey: ['dashboardSnapshot'],
+    queryFn: () => apiClient.dashboardSnapshot(),
     refetchInterval: 5000,
   });
 
-  const { data: tarifsResponse } = useQuery({
-    queryKey: ['tarifs'],
-    queryFn: apiClient.getTarifs,
-  });
-
-  const { data: trunksResponse } = useQuery({
-    queryKey: ['trunks'],
-    queryFn: apiClient.getTrunks,
-  });
-
   if (isLoading) return <div className="loading">Загрузка статистики...</div>;
 
-  const calls = (callsResponse?.data || []) as CallStatisticsInfo[];
-  const tarifs = (tarifsResponse?.data || []) as TarifInfo[];
-  const trunks = (trunksResponse?.data || []) as TrunkInfo[];
+  const snapshot = snapshotResponse?.data;
+  const tarifs = snapshot?.tarifs || [];
+  const trunks = snapshot?.trunks || [];
 
   // Создаем мапы для быстрого поиска названий
   const tarifMap = tarifs.reduce((acc, tarif) => {
@@ -47,30 +37,24 @@ export function CallStatsDashboard() {
     return acc;
   }, {} as Record<number, string>);
 
-  // Агрегируем данные
+  // Группы без звонков не показываются
   const stats: CallStatsAggregated = {
-    totalCalls: calls.length,
-    totalRevenue: calls.reduce((sum, call) => sum + call.cost, 0),
+    totalCalls: snapshot?.calls.total || 0,
+    totalRevenue: snapshot?.calls.total_revenue || 0,
     callsByTarif: {},
     callsByTrunk: {},
   };
 
-  // Группируем по тарифам
-  calls.forEach(call => {
-    if (!stats.callsByTarif[call.tarif_id]) {
-      stats.callsByTarif[call.tarif_id] = { count: 0, revenue: 0 };
+  snapshot?.by_tarif.forEach(group => {
+    if (group.total_calls > 0) {
+      stats.callsByTarif[group.tarif_id] = { count: group.total_calls, revenue: group.total_revenue };
     }
-    stats.callsByTarif[call.tarif_id].count++;
-    stats.callsByTarif[call.tarif_id].revenue += call.cost;
   });
 
-  // Группируем по транкам
-  calls.forEach(call => {
-    if (!stats.callsByTrunk[call.trunk_id]) {
-      stats.callsByTrunk[call.trunk_id] = { count: 0, revenue: 0 };
+  snapshot?.by_trunk.forEach(group => {
+    if (group.total_calls > 0) {
+      stats.callsByTrunk[group.trunk_id] = { count: group.total_calls, revenue: group.total_revenue };
     }
-    stats.callsByTrunk[call.trunk_id].count++;
-    stats.callsByTrunk[call.trunk_id].revenue += call.cost;
   });
 
   const formatCurrency = (amount: number) => {
@@ -100,58 +84,31 @@ export function CallStatsDashboard() {
       revenue: data.revenue
     }));
 
-  // Данные для графика по времени (группировка по часам)
-  const callsByTime = calls.reduce((acc, call) => {
-    const hour = new Date(call.call_time).getHours();
-    const key = `${hour.toString().padStart(2, '0')}:00`;
-    if (!acc[key]) {
-      acc[key] = { time: key, calls: 0, revenue: 0, duration: 0 };
-    }
-    acc[key].calls++;
-    acc[key].revenue += call.cost;
-    acc[key].duration += call.duration_seconds;
-    return acc;
-  }, {} as Record<string, { time: string; calls: number; revenue: number; duration: number }>);
-
-  const timeChartData = Object.values(callsByTime).sort((a, b) => a.time.localeCompare(b.time));
-
-  // Данные для графика распределения по длительности
-  const durationRanges = [
-    { label: '0-30с', min: 0, max: 30 },
-    { label: '30-60с', min: 30, max: 60 },
-    { label: '1-2м', min: 60, max: 120 },
-    { label: '2-5м', min: 120, max: 300 },
-    { label: '5-10м', min: 300, max: 600 },
-    { label: '10+м', min: 600, max: Infinity }
-  ];
+  // Данные для графика по времени (часы суток по местному времени браузера)
+  const timeChartData = (snapshot?.by_hour || [])
+    .filter(item => item.calls > 0)
+    .map(item => ({
+      time: `${item.hour.toString().padStart(2, '0')}:00`,
+      calls: item.calls,
+      revenue: item.revenue,
+      duration: item.duration_seconds,
+    }));
 
-  const durationChartData = durationRanges.map(range => {
-    const callsInRange = calls.filter(c => c.duration_seconds >= range.min && c.duration_seconds < range.max);
-    return {
-      range: range.label,
-      calls: callsInRange.length,
-      revenue: callsInRange.reduce((sum, c) => sum + c.cost, 0)
-    };
-  });
+  // Данные для графика распределения по длительности (интервалы гистограммы сервера)
+  const durationLabels = ['0-30с', '30-60с', '1-2м', '2-5м', '5-10м', '10+м'];
+  const durationChartData = (snapshot?.duration_histogram || []).map((bin, index) => ({
+    range: durationLabels[index] || `${bin.from}+с`,
+    calls: bin.calls,
+    revenue: bin.revenue
+  }));
 
   // Данные для графика распределения по стоимости
-  const costRanges = [
-    { label: '0-1₽', min: 0, max: 1 },
-    { label: '1-5₽', min: 1, max: 5 },
-    { label: '5-10₽', min: 5, max: 10 },
-    { label: '10-20₽', min: 10, max: 20 },
-    { label: '20-50₽', min: 20, max: 50 },
-    { label: '50+₽', min: 50, max: Infinity }
-  ];
-
-  const costChartData = costRanges.map(range => {
-    const callsInRange = calls.filter(c => c.cost >= range.min && c.cost < range.max);
-    return {
-      range: range.label,
-      calls: callsInRange.length,
-      revenue: callsInRange.reduce((sum, c) => sum + c.cost, 0)
-    };
-  });
+  const costLabels = ['0-1₽', '1-5₽', '5-10₽', '10-20₽', '20-50₽', '50+₽'];
+  const costChartData = (snapshot?.cost_histogram || []).map((bin, index) => ({
+    range: costLabels[index] || `${bin.from}+₽`,
+    calls: bin.calls,
+    revenue: bin.revenue
+  }));
 
   return (
     <div>
@@ -1,7 +1,7 @@
 import { useState } from 'react';
 import { useQuery, useMutation, useQueryClient } from '@tanstack/react-query';
 import { apiClient } from '../api/client';
-import type { SystemStats, CallStatisticsInfo, TrunkInfo, TarifInfo, ServerInfo } from '../types';
+import type { TrunkInfo } from '../types';
 
 export function Dashboard() {
   const queryClient = useQueryClient();
@@ -12,38 +12,18 @@ export function Dashboard() {
   const [hoursPage, setHoursPage] = useState(0);
   const itemsPerPage = 10;
 
-  const { data: statsResponse, isLoading: statsLoading } = useQuery({
-    queryKey: ['systemStats'],
-    queryFn: () => apiClient.systemStats(),
+  // Статистика, справочники и последние звонки - одним запросом
+  const { data: snapshotResponse, isLoading: snapshotLoading } = useQuery({
+    queryKey: ['dashboardSnapshot'],
+    queryFn: () => apiClient.dashboardSnapshot(),
     refetchInterval: 30000, // Обновление каждые 30 сек
   });
 
-  const { data: callsResponse } = useQuery({
-    queryKey: ['callStatistics'],
-    queryFn: () => apiClient.getCallStatistics(),
-    refetchInterval: 30000,
-  });
-
-  const { data: trunksResponse } = useQuery({
-    queryKey: ['trunks'],
-    queryFn: () => apiClient.getTrunks(),
-  });
-
-  const { data: tarifsResponse } = useQuery({
-    queryKey: ['tarifs'],
-    queryFn: () => apiClient.getTarifs(),
-  });
-
-  const { data: serversResponse } = useQuery({
-    queryKey: ['servers'],
-    queryFn: () => apiClient.getServers(),
-  });
-
   const addMutation = useMutation({
     mutationFn: apiClient.addTrunk,
     onSuccess: () => {
       queryClient.invalidateQueries({ queryKey: ['trunks'] });
-      queryClient.invalidateQueries({ queryKey: ['systemStats'] });
+      queryClient.invalidateQueries({ queryKey: ['dashboardSnapshot'] });
       setEditingId(null);
       setFormData({});
     },
@@ -54,17 +34,17 @@ export function Dashboard() {
       apiClient.updateTrunk(id, data),
     onSuccess: () => {
       queryClient.invalidateQueries({ queryKey: ['trunks'] });
-      queryClient.invalidateQueries({ queryKey: ['systemStats'] });
+      queryClient.invalidateQueries({ queryKey: ['dashboardSnapshot'] });
       setEditingId(null);
       setFormData({});
     },
   });
 
-  const stats = statsResponse?.data as SystemStats | undefined;
-  const calls = callsResponse?.data as CallStatisticsInfo[] | undefined;
-  const trunks = trunksResponse?.data as TrunkInfo[] | undefined;
-  const tarifs = tarifsResponse?.data as TarifInfo[] | undefined;
-  const servers = serversResponse?.data as ServerInfo[] | undefined;
+  const stats = snapshotResponse?.data;
+  const calls = stats?.recent_calls;
+  const trunks = stats?.trunks;
+  const tarifs = stats?.tarifs;
+  const servers = stats?.servers;
 
   // Создаем мапы для быстрого поиска названий
   const trunkMap = trunks?.reduce((acc, trunk) => {
@@ -175,20 +155,17 @@ export function Dashboard() {
     );
   };
 
-  if (statsLoading) {
+  if (snapshotLoading) {
     return <div className="loading">Загрузка...</div>;
   }
 
-  // Группировка звонков по часам для графика
-  const callsByHour = calls?.reduce((acc, call) => {
-    const hour = call.call_time.substring(11, 13);
-    if (!acc[hour]) {
-      acc[hour] = { count: 0, revenue: 0 };
-    }
-    acc[hour].count++;
-    acc[hour].revenue += call.cost;
-    return acc;
-  }, {} as Record<string, { count: number; revenue: number }>);
+  // Звонки по часам суток (местное время браузера), часы без звонков не показываются
+  const callsByHour = stats?.by_hour
+    .filter((item) => item.calls > 0)
+    .reduce((acc, item) => {
+      acc[item.hour.toString().padStart(2, '0')] = { count: item.calls, revenue: item.revenue };
+      return acc;
+    }, {} as Record<string, { count: number; revenue: number }>);
 
   return (
     <div className="dashboard">
@@ -385,9 +362,7 @@ export function Dashboard() {
           </thead>
           <tbody>
             {calls
-              ?.slice()
-              .reverse()
-              .slice(callsPage * itemsPerPage, (callsPage + 1) * itemsPerPage)
+              ?.slice(callsPage * itemsPerPage, (callsPage + 1) * itemsPerPage)
               .map((call) => (
                 <tr key={call.id}>
                   <td>{call.call_id}</td>
@@ -26,6 +26,7 @@ export function Simulator() {
     onSuccess: (response) => {
       queryClient.invalidateQueries({ queryKey: ['callStatistics'] });
       queryClient.invalidateQueries({ queryKey: ['systemStats'] });
+      queryClient.invalidateQueries({ queryKey: ['dashboardSnapshot'] });
     },
   });
 
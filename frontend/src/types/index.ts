@@ -71,6 +71,39 @@ export interface SystemStats {
   };
 }
 
+export interface DashboardTotals {
+  calls: number;
+  revenue: number;
+  duration_seconds: number;
+}
+
+export interface DashboardHistogramBin extends DashboardTotals {
+  from: number;
+  to: number | null;
+}
+
+export interface DashboardGroup {
+  total_calls: number;
+  total_revenue: number;
+  total_duration_seconds: number;
+}
+
+export interface DashboardSnapshot {
+  tz: string;
+  database: SystemStats['database'];
+  calls: SystemStats['calls'];
+  hubs: HubInfo[];
+  servers: ServerInfo[];
+  trunks: TrunkInfo[];
+  tarifs: TarifInfo[];
+  by_trunk: (DashboardGroup & { trunk_id: number; trunk_name: string })[];
+  by_tarif: (DashboardGroup & { tarif_id: number; tarif_name: string })[];
+  by_hour: (DashboardTotals & { hour: number })[];
+  duration_histogram: DashboardHistogramBin[];
+  cost_histogram: DashboardHistogramBin[];
+  recent_calls: CallStatisticsInfo[];
+}
+
 export interface LoginResponse {
   success: boolean;
   accessToken: string;